@@ -5,10 +5,19 @@
 // GitHub: https://github.com/neil3d/UAnimatedTexture5
 
 #include "AnimatedTexture2D.h"
+#include "AnimatedTextureModule.h"
 #include "AnimatedTextureResource.h"
 #include "GIFDecoder.h"
 #include "WebpDecoder.h"
 
+DECLARE_STATS_GROUP(TEXT("AnimatedTexture"), STATGROUP_AnimatedTexture, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT(TEXT("Decoder Load"), STAT_AnimatedTexture_DecoderLoad, STATGROUP_AnimatedTexture);
+DECLARE_CYCLE_STAT(TEXT("Frame Decode"), STAT_AnimatedTexture_FrameDecode, STATGROUP_AnimatedTexture);
+DECLARE_CYCLE_STAT(TEXT("Frame Upload"), STAT_AnimatedTexture_FrameUpload, STATGROUP_AnimatedTexture);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Frames Decoded"), STAT_AnimatedTexture_FramesDecoded, STATGROUP_AnimatedTexture);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Bytes Uploaded"), STAT_AnimatedTexture_BytesUploaded, STATGROUP_AnimatedTexture);
+
 float UAnimatedTexture2D::GetSurfaceWidth() const
 {
     if (Decoder) return Decoder->GetWidth();
@@ -39,6 +48,8 @@ FTextureResource* UAnimatedTexture2D::CreateResource()
     }
 
     check(Decoder);
+    SCOPE_CYCLE_COUNTER(STAT_AnimatedTexture_DecoderLoad);
+    LLM_SCOPE_BYTAG(AnimatedTexture);
     if (Decoder->LoadFromMemory(FileBlob.GetData(), FileBlob.Num()))
     {
         AnimationLength = Decoder->GetDuration(DefaultFrameDelay * 1000) / 1000.0f;
@@ -113,16 +124,53 @@ void UAnimatedTexture2D::PostEditChangeProperty(FPropertyChangedEvent& PropertyC
 
 void UAnimatedTexture2D::ImportFile(EAnimatedTextureType InFileType, const uint8* InBuffer, uint32 InBufferSize)
 {
+    LLM_SCOPE_BYTAG(AnimatedTexture);
     FileType = InFileType;
     FileBlob = TArray<uint8>(InBuffer, InBufferSize);
 }
 
+UAnimatedTexture2D::FMemoryUsage UAnimatedTexture2D::GetMemoryUsage() const
+{
+    FMemoryUsage Usage;
+    Usage.FileBlob = FileBlob.GetAllocatedSize();
+    if (Decoder)
+    {
+        Usage.Decoder = Decoder->GetAllocatedSize();
+        Usage.FrameBuffer = Decoder->GetFrameBufferSize();
+    }
+    if (GetResource())
+    {
+        Usage.Texture = SIZE_T(GetSurfaceWidth()) * SIZE_T(GetSurfaceHeight()) * sizeof(FColor);
+    }
+    return Usage;
+}
+
+void UAnimatedTexture2D::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+    Super::GetResourceSizeEx(CumulativeResourceSize);
+
+    const FMemoryUsage Usage = GetMemoryUsage();
+    CumulativeResourceSize.AddDedicatedSystemMemoryBytes(Usage.FileBlob + Usage.Decoder);
+    CumulativeResourceSize.AddDedicatedVideoMemoryBytes(Usage.Texture);
+}
+
 float UAnimatedTexture2D::RenderFrameToTexture()
 {
+    FAnimatedTextureCounters& Counters = FAnimatedTextureCounters::Get();
+
     // Decode a new frame to memory buffer
-    int nFrameDelay = Decoder->NextFrame(DefaultFrameDelay * 1000, bLooping);
+    int nFrameDelay;
+    {
+        SCOPE_CYCLE_COUNTER(STAT_AnimatedTexture_FrameDecode);
+        const uint64 StartCycles = FPlatformTime::Cycles64();
+        nFrameDelay = Decoder->NextFrame(DefaultFrameDelay * 1000, bLooping);
+        Counters.DecodeCycles.fetch_add(FPlatformTime::Cycles64() - StartCycles, std::memory_order_relaxed);
+    }
+    INC_DWORD_STAT(STAT_AnimatedTexture_FramesDecoded);
+    Counters.FramesDecoded.fetch_add(1, std::memory_order_relaxed);
 
     // Copy frame to RHI texture
+    LLM_SCOPE_BYTAG(AnimatedTexture_FrameBuffers);
     struct FRenderCommandData
     {
         FTextureResource* RHIResource;
@@ -139,6 +187,9 @@ float UAnimatedTexture2D::RenderFrameToTexture()
     ENQUEUE_RENDER_COMMAND(AnimTexture2D_RenderFrame)(
         [CommandData](FRHICommandListImmediate& RHICmdList)
         {
+            SCOPE_CYCLE_COUNTER(STAT_AnimatedTexture_FrameUpload);
+            const uint64 StartCycles = FPlatformTime::Cycles64();
+
             if (!CommandData->RHIResource || !CommandData->RHIResource->TextureRHI)
                 return;
 
@@ -157,6 +208,12 @@ float UAnimatedTexture2D::RenderFrameToTexture()
             Region.Height = TexHeight;
 
             RHIUpdateTexture2D(TextureRHI, 0, Region, SrcPitch, CommandData->FrameBuffer);
+            INC_DWORD_STAT_BY(STAT_AnimatedTexture_BytesUploaded, SrcPitch * TexHeight);
+
+            FAnimatedTextureCounters& Counters = FAnimatedTextureCounters::Get();
+            Counters.UploadCycles.fetch_add(FPlatformTime::Cycles64() - StartCycles, std::memory_order_relaxed);
+            Counters.FramesUploaded.fetch_add(1, std::memory_order_relaxed);
+            Counters.BytesUploaded.fetch_add(uint64(SrcPitch) * TexHeight, std::memory_order_relaxed);
         });
 
     return nFrameDelay / 1000.0f;
@@ -34,6 +34,11 @@ public:
 	virtual uint32 GetDuration(uint32 defaultFrameDelay) const = 0;
 	virtual bool SupportsTransparency() const = 0;
 
+	/** Decoded frame buffer only */
+	virtual SIZE_T GetFrameBufferSize() const = 0;
+	/** Everything the decoder holds, including the frame buffer */
+	virtual SIZE_T GetAllocatedSize() const = 0;
+
 public:
 	FAnimatedTextureDecoder(const FAnimatedTextureDecoder&) = delete;
 	FAnimatedTextureDecoder& operator=(const FAnimatedTextureDecoder&) = delete;
@@ -26,4 +26,15 @@ void FAnimatedTextureModule::ShutdownModule()
 #undef LOCTEXT_NAMESPACE
 	
 DEFINE_LOG_CATEGORY(LogAnimTexture);
+
+FAnimatedTextureCounters& FAnimatedTextureCounters::Get()
+{
+	static FAnimatedTextureCounters Counters;
+	return Counters;
+}
+
+LLM_DEFINE_TAG(AnimatedTexture, TEXT("AnimatedTexture"));
+LLM_DEFINE_TAG(AnimatedTexture_GIFDecoder, TEXT("GIF Decoder"), TEXT("AnimatedTexture"));
+LLM_DEFINE_TAG(AnimatedTexture_WebPDecoder, TEXT("WebP Decoder"), TEXT("AnimatedTexture"));
+LLM_DEFINE_TAG(AnimatedTexture_FrameBuffers, TEXT("Frame Buffers"), TEXT("AnimatedTexture"));
 IMPLEMENT_MODULE(FAnimatedTextureModule, AnimatedTexture)
\ No newline at end of file
@@ -26,6 +26,8 @@ static int _GIF_InputFunc(GifFileType* gifFile, GifByteType* buffer, int length)
 
 bool FGIFDecoder::LoadFromMemory(const uint8* InBuffer, uint32 InBufferSize)
 {
+	LLM_SCOPE_BYTAG(AnimatedTexture_GIFDecoder);
+
 	int gifError = 0;
 	mGIF = DGifOpen((void*)InBuffer, _GIF_InputFunc, &gifError);
 	if (mGIF == nullptr)
@@ -43,7 +45,10 @@ bool FGIFDecoder::LoadFromMemory(const uint8* InBuffer, uint32 InBufferSize)
 		return false;
 	}
 
-	mFrameBuffer.SetNum(mGIF->SWidth * mGIF->SHeight);
+	{
+		LLM_SCOPE_BYTAG(AnimatedTexture_FrameBuffers);
+		mFrameBuffer.SetNum(mGIF->SWidth * mGIF->SHeight);
+	}
 	ClearFrameBuffer(mGIF->SColorMap, true);
 	return true;
 }
@@ -242,6 +247,28 @@ bool FGIFDecoder::SupportsTransparency() const
 	return false;
 }
 
+SIZE_T FGIFDecoder::GetFrameBufferSize() const
+{
+	return mFrameBuffer.GetAllocatedSize();
+}
+
+SIZE_T FGIFDecoder::GetAllocatedSize() const
+{
+	SIZE_T Size = GetFrameBufferSize();
+	if (mGIF)
+	{
+		// DGifSlurp keeps every frame's raster (one byte per pixel) plus its color map
+		for (int i = 0; i < mGIF->ImageCount; i++)
+		{
+			const GifImageDesc& desc = mGIF->SavedImages[i].ImageDesc;
+			Size += SIZE_T(desc.Width) * desc.Height;
+			if (desc.ColorMap)
+				Size += desc.ColorMap->ColorCount * sizeof(GifColorType);
+		}
+	}
+	return Size;
+}
+
 void FGIFDecoder::ClearFrameBuffer(ColorMapObject* ColorMap,
 	bool bTransparent) 
 {
@@ -33,6 +33,9 @@ public:
 	virtual uint32 GetDuration(uint32 DefaultFrameDelay) const override;
 	virtual bool SupportsTransparency() const override;
 
+	virtual SIZE_T GetFrameBufferSize() const override;
+	virtual SIZE_T GetAllocatedSize() const override;
+
 private:
 	void ClearFrameBuffer(ColorMapObject* ColorMap, bool bTransparent);
 	void GCB_Background(int left, int top, int width, int height,
@@ -18,6 +18,8 @@ FWebpDecoder::~FWebpDecoder()
 
 bool FWebpDecoder::LoadFromMemory(const uint8* InBuffer, uint32 InBufferSize)
 {
+	LLM_SCOPE_BYTAG(AnimatedTexture_WebPDecoder);
+
 	// get image width height
 	int ret = WebPGetFeatures(InBuffer, InBufferSize, &Features);
 	if (ret != VP8_STATUS_OK)
@@ -116,4 +118,15 @@ bool FWebpDecoder::SupportsTransparency() const
 	return Features.has_alpha != 0;
 }
 
+SIZE_T FWebpDecoder::GetFrameBufferSize() const
+{
+	return Decoder ? SIZE_T(AnimInfo.canvas_width) * AnimInfo.canvas_height * 4 : 0;
+}
+
+SIZE_T FWebpDecoder::GetAllocatedSize() const
+{
+	// WebPAnimDecoder keeps the current canvas and the previous, disposed one
+	return GetFrameBufferSize() * 2;
+}
+
 
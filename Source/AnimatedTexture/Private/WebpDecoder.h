@@ -37,6 +37,9 @@ public:
 	virtual uint32 GetDuration(uint32 DefaultFrameDelay) const override;
 	virtual bool SupportsTransparency() const override;
 
+	virtual SIZE_T GetFrameBufferSize() const override;
+	virtual SIZE_T GetAllocatedSize() const override;
+
 private:
 	int PrevFrameTimestamp = 0;
 	uint32 Duration = 0;
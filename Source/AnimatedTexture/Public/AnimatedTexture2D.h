@@ -119,6 +119,18 @@ public:	// UObject Interface.
 public: // Internal APIs
 	void ImportFile(EAnimatedTextureType InFileType, const uint8* InBuffer, uint32 InBufferSize);
 
+	struct FMemoryUsage
+	{
+		SIZE_T FileBlob = 0;
+		SIZE_T Decoder = 0;		// includes FrameBuffer
+		SIZE_T FrameBuffer = 0;
+		SIZE_T Texture = 0;		// RHI texture, one B8G8R8A8 mip
+	};
+	FMemoryUsage GetMemoryUsage() const;
+	EAnimatedTextureType GetFileType() const { return FileType; }
+
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
+
 	float RenderFrameToTexture();
 
 private:
@@ -12,6 +12,8 @@
 
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
+#include "HAL/LowLevelMemTracker.h"
+#include <atomic>
 
 class FAnimatedTextureModule : public IModuleInterface
 {
@@ -23,3 +25,23 @@ public:
 };
 
 DECLARE_LOG_CATEGORY_EXTERN(LogAnimTexture, Log, All);
+
+// LLM tags (-llm). giflib and libwebp allocate with malloc, so their internals are reported
+// by UAnimatedTexture2D::GetMemoryUsage rather than by these tags.
+LLM_DECLARE_TAG_API(AnimatedTexture, ANIMATEDTEXTURE_API);
+LLM_DECLARE_TAG_API(AnimatedTexture_GIFDecoder, ANIMATEDTEXTURE_API);
+LLM_DECLARE_TAG_API(AnimatedTexture_WebPDecoder, ANIMATEDTEXTURE_API);
+LLM_DECLARE_TAG_API(AnimatedTexture_FrameBuffers, ANIMATEDTEXTURE_API);
+
+// Running totals for live diagnostics. Unlike `stat AnimatedTexture` these exist in every build
+// configuration; all updates are relaxed atomic adds from the game and render threads.
+struct ANIMATEDTEXTURE_API FAnimatedTextureCounters
+{
+	std::atomic<uint64> FramesDecoded{ 0 };
+	std::atomic<uint64> DecodeCycles{ 0 };
+	std::atomic<uint64> FramesUploaded{ 0 };
+	std::atomic<uint64> UploadCycles{ 0 };
+	std::atomic<uint64> BytesUploaded{ 0 };
+
+	static FAnimatedTextureCounters& Get();
+};
@@ -2,6 +2,13 @@
 #include "TwitchChat.h"
 #include "TwitchChatSettings.h"
 #include "TwitchChatWindow.h"
+#include "TwitchChatDiagnostics.h"
+#include "TwitchChatHistoryLog.h"
+#include "TwitchChatMetrics.h"
+#include "TwitchChatAuth.h"
+#include "TwitchChatHelix.h"
+#include "TwitchChatOutbox.h"
+#include "TwitchChatImages.h"
 
 
 #include "Misc/Paths.h"
@@ -32,6 +39,12 @@ void FTwitchChatModule::StartupModule()
    
     FModuleManager::Get().LoadModuleChecked("WebSockets");
 
+    FTwitchChatMetrics::Get().StartSampling();
+    if (const UTwitchChatSettings* S = GetDefault<UTwitchChatSettings>(); S->bEnableMetricsEndpoint)
+    {
+        FTwitchChatMetrics::Get().StartEndpoint(S->MetricsPort);
+    }
+
     static TSharedPtr<FSlateStyleSet> TwitchChatStyle;
     if (!TwitchChatStyle.IsValid())
     {
@@ -96,6 +109,16 @@ void FTwitchChatModule::StartupModule()
                             FGlobalTabmanager::Get()->TryInvokeTab(TwitchChatTabName);
                         }))
                 );
+                Section.AddMenuEntry(
+                    "TwitchChatDiagnostics",
+                    LOCTEXT("TwitchChatDiagnosticsMenuLabel", "Twitch Chat Diagnostics"),
+                    LOCTEXT("TwitchChatDiagnosticsMenuTip", "Open live graphs of the chat pipeline."),
+                    FSlateIcon(FAppStyle::GetAppStyleSetName(), "Icons.Tabs.OutputLog"),
+                    FUIAction(FExecuteAction::CreateStatic([]()
+                        {
+                            FGlobalTabmanager::Get()->TryInvokeTab(STwitchChatDiagnostics::TabName);
+                        }))
+                );
             })
     );
 #endif
@@ -117,10 +140,42 @@ void FTwitchChatModule::StartupModule()
             TwitchChatStyle->GetStyleSetName(),
             TEXT("TwitchChat.OpenPluginWindow.Small")
         ));
+
+    FGlobalTabmanager::Get()->RegisterNomadTabSpawner(
+        STwitchChatDiagnostics::TabName,
+        FOnSpawnTab::CreateLambda([](const FSpawnTabArgs&)
+            {
+                return SNew(SDockTab)
+                    .TabRole(ETabRole::NomadTab)[
+                        SNew(STwitchChatDiagnostics)
+                    ];
+            })
+    )
+        .SetDisplayName(LOCTEXT("TwitchChatDiagnosticsTabTitle", "Twitch Chat Diagnostics"))
+        .SetMenuType(ETabSpawnerMenuType::Hidden)
+        .SetIcon(FSlateIcon(
+            TwitchChatStyle->GetStyleSetName(),
+            TEXT("TwitchChat.OpenPluginWindow.Small")
+        ));
 }
 
 void FTwitchChatModule::ShutdownModule()
 {
+    // Joins the conduit shard workers and the frame parser before the module goes away
+    FTwitchChatConnection::Get()->Shutdown();
+    FTwitchChatAuth::Get()->Shutdown();
+    FTwitchChatHelix::Get()->Shutdown();
+    FTwitchChatOutbox::Get()->Shutdown();
+    FTwitchChatImages::Get()->Shutdown();
+
+    FTwitchChatMetrics::Get().StopEndpoint();
+    FTwitchChatMetrics::Get().StopSampling();
+
+    if (TSharedPtr<FTwitchChatHistoryLog> History = FTwitchChatHistoryLog::GetIfCreated())
+    {
+        History->Shutdown();
+    }
+
 #if WITH_EDITOR
    
     if (FModuleManager::Get().IsModuleLoaded("PropertyEditor"))
@@ -143,6 +198,7 @@ void FTwitchChatModule::ShutdownModule()
 #endif
 
     FGlobalTabmanager::Get()->UnregisterNomadTabSpawner(TwitchChatTabName);
+    FGlobalTabmanager::Get()->UnregisterNomadTabSpawner(STwitchChatDiagnostics::TabName);
     if (auto Style = FSlateStyleRegistry::FindSlateStyle("TwitchChatStyle"))
     {
         FSlateStyleRegistry::UnRegisterSlateStyle(*Style);
@@ -0,0 +1,469 @@
+#include "TwitchChatAuth.h"
+#include "TwitchChatConnection.h"
+#include "TwitchChatSettings.h"
+#include "TwitchChatMetrics.h"
+#include "TwitchChatWarmStart.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpRequest.h"
+#include "Interfaces/IHttpResponse.h"
+#include "GenericPlatform/GenericPlatformHttp.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "HAL/IConsoleManager.h"
+
+namespace TwitchChatAuth
+{
+    static TSharedPtr<FJsonObject> ParseBody(const FHttpResponsePtr& Resp)
+    {
+        TSharedPtr<FJsonObject> Json;
+        if (Resp.IsValid())
+        {
+            TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Resp->GetContentAsString());
+            FJsonSerializer::Deserialize(Reader, Json);
+        }
+        return Json;
+    }
+}
+
+TSharedRef<FTwitchChatAuth> FTwitchChatAuth::Get()
+{
+    static TSharedRef<FTwitchChatAuth> Instance = MakeShared<FTwitchChatAuth>();
+    return Instance;
+}
+
+void FTwitchChatAuth::LoadFromSettings()
+{
+    const UTwitchChatSettings* S = GetDefault<UTwitchChatSettings>();
+    FString Token = S->GetAccessToken().TrimStartAndEnd();
+    Token.RemoveFromStart(TEXT("oauth:"));
+    RefreshToken = S->GetRefreshToken().TrimStartAndEnd();
+
+    if (Token != AccessToken)
+    {
+        AccessToken = Token;
+        bValidated = false;
+        bWarm = false;
+        ExpiresAt = 0.0;
+        Login.Empty();
+        UserId.Empty();
+        Scopes.Empty();
+
+        // Enough to open the session on; WhenValid still confirms it with Twitch
+        FTwitchChatWarmStart::FToken Warm;
+        if (FTwitchChatWarmStart::Get().FindToken(AccessToken, Warm))
+        {
+            const bool bNeverExpires = Warm.ExpiresUtc.GetTicks() == 0;
+            const double ToExpiry = (Warm.ExpiresUtc - FDateTime::UtcNow()).GetTotalSeconds();
+            if (bNeverExpires || ToExpiry > 0.0)
+            {
+                bWarm = true;
+                Login = Warm.Login;
+                UserId = Warm.UserId;
+                Scopes = Warm.Scopes;
+                ExpiresAt = bNeverExpires ? 0.0 : FPlatformTime::Seconds() + ToExpiry;
+            }
+        }
+    }
+    EnsureTicker();
+}
+
+double FTwitchChatAuth::GetSecondsToExpiry() const
+{
+    return bValidated && ExpiresAt > 0.0 ? ExpiresAt - FPlatformTime::Seconds() : -1.0;
+}
+
+void FTwitchChatAuth::EnsureTicker()
+{
+    if (!TickHandle.IsValid())
+    {
+        TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateSP(this, &FTwitchChatAuth::Tick), 1.f);
+    }
+}
+
+void FTwitchChatAuth::Shutdown()
+{
+    if (TickHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+        TickHandle.Reset();
+    }
+}
+
+bool FTwitchChatAuth::Tick(float /*DeltaTime*/)
+{
+    const double Now = FPlatformTime::Seconds();
+
+    if (!DeviceCode.IsEmpty() && !bPollInFlight)
+    {
+        if (Now > DeviceFlowExpiry)
+        {
+            UE_LOG(LogTwitchChat, Error, TEXT("Device flow expired before the code was entered"));
+            FinishDeviceFlow(false);
+        }
+        else if (Now >= NextPollTime)
+        {
+            PollDeviceToken();
+        }
+    }
+
+    // Background upkeep only; WhenValid covers callers that need the result
+    if (HasToken() && bValidated && !bBusy)
+    {
+        if (ExpiresAt > 0.0 && Now >= ExpiresAt - RenewAheadSeconds && Now >= NextRefreshTime && !RefreshToken.IsEmpty())
+        {
+            UE_LOG(LogTwitchChat, Log, TEXT("Access token expires in %.0f s; renewing"), ExpiresAt - Now);
+            StartRefresh();
+        }
+        else if (Now >= NextValidateTime)
+        {
+            Validate();
+        }
+    }
+    return true;
+}
+
+void FTwitchChatAuth::WhenValid(TFunction<void(bool)> OnReady)
+{
+    if (!HasToken())
+    {
+        OnReady(false);
+        return;
+    }
+    const double ToExpiry = GetSecondsToExpiry();
+    if (bValidated && !bBusy && (ToExpiry < 0.0 || ToExpiry > RenewAheadSeconds || RefreshToken.IsEmpty()))
+    {
+        OnReady(true);
+        return;
+    }
+
+    Waiters.Add(MoveTemp(OnReady));
+    if (!bBusy)
+    {
+        if (bValidated)
+            StartRefresh();
+        else
+            Validate();
+    }
+}
+
+void FTwitchChatAuth::Refresh(TFunction<void(bool)> OnComplete, const FString& RejectedToken)
+{
+    if (!RejectedToken.IsEmpty() && RejectedToken != AccessToken && HasToken())
+    {
+        // Someone else already replaced the token this request was made with
+        OnComplete(true);
+        return;
+    }
+
+    Waiters.Add(MoveTemp(OnComplete));
+    if (!bBusy)
+    {
+        StartRefresh();
+    }
+}
+
+void FTwitchChatAuth::CompleteWaiters(bool bSuccess)
+{
+    bBusy = false;
+    TArray<TFunction<void(bool)>> Ready = MoveTemp(Waiters);
+    for (TFunction<void(bool)>& Waiter : Ready)
+    {
+        if (Waiter)
+            Waiter(bSuccess);
+    }
+}
+
+void FTwitchChatAuth::Validate()
+{
+    bBusy = true;
+    const UTwitchChatSettings* S = GetDefault<UTwitchChatSettings>();
+    auto Req = FHttpModule::Get().CreateRequest();
+    Req->SetURL(S->GetAuthBaseUrl() + TEXT("/oauth2/validate"));
+    Req->SetVerb(TEXT("GET"));
+    Req->SetHeader(TEXT("Authorization"), TEXT("OAuth ") + AccessToken);
+
+    Req->OnProcessRequestComplete().BindLambda(
+        [this, Token = AccessToken](FHttpRequestPtr, FHttpResponsePtr Resp, bool bOK)
+        {
+            if (Token != AccessToken)
+            {
+                // Replaced while validating; the new token is fresh from the token endpoint
+                CompleteWaiters(HasToken());
+                return;
+            }
+
+            const int32 Code = bOK && Resp.IsValid() ? Resp->GetResponseCode() : -1;
+            TSharedPtr<FJsonObject> Json = TwitchChatAuth::ParseBody(Resp);
+            if (Code == 200 && Json.IsValid())
+            {
+                const double Now = FPlatformTime::Seconds();
+                const double ExpiresIn = Json->GetNumberField(TEXT("expires_in"));
+                ExpiresAt = ExpiresIn > 0.0 ? Now + ExpiresIn : 0.0;
+                NextValidateTime = Now + ValidateIntervalSeconds;
+                bValidated = true;
+                Json->TryGetStringField(TEXT("login"), Login);
+                Json->TryGetStringField(TEXT("user_id"), UserId);
+                Json->TryGetStringArrayField(TEXT("scopes"), Scopes);
+                bWarm = false;
+                RememberToken();
+
+                if (ExpiresAt > 0.0 && ExpiresIn <= RenewAheadSeconds && !RefreshToken.IsEmpty())
+                {
+                    StartRefresh();     // waiters ride along
+                    return;
+                }
+                CompleteWaiters(true);
+                return;
+            }
+
+            if (Code == 401)
+            {
+                UE_LOG(LogTwitchChat, Warning, TEXT("Access token is no longer valid"));
+                bValidated = false;
+                bWarm = false;
+                if (!RefreshToken.IsEmpty())
+                {
+                    StartRefresh();
+                    return;
+                }
+                CompleteWaiters(false);
+                return;
+            }
+
+            // Twitch unreachable: trust the token for now and try again later
+            UE_LOG(LogTwitchChat, Warning, TEXT("Token validation failed (%d); retrying in a minute"), Code);
+            NextValidateTime = FPlatformTime::Seconds() + 60.0;
+            bValidated = true;
+            CompleteWaiters(true);
+        });
+    Req->ProcessRequest();
+}
+
+void FTwitchChatAuth::StartRefresh()
+{
+    bBusy = true;
+    if (RefreshToken.IsEmpty())
+    {
+        UE_LOG(LogTwitchChat, Error, TEXT("No refresh token available"));
+        CompleteWaiters(false);
+        return;
+    }
+
+    FTwitchChatMetrics::Inc(ETwitchChatCounter::TokenRefreshes);
+    const UTwitchChatSettings* S = GetDefault<UTwitchChatSettings>();
+    auto Req = FHttpModule::Get().CreateRequest();
+    Req->SetURL(S->GetAuthBaseUrl() + TEXT("/oauth2/token"));
+    Req->SetVerb(TEXT("POST"));
+    Req->SetHeader(TEXT("Content-Type"), TEXT("application/x-www-form-urlencoded"));
+    Req->SetContentAsString(FString::Printf(
+        TEXT("grant_type=refresh_token&refresh_token=%s&client_id=%s&client_secret=%s"),
+        *FGenericPlatformHttp::UrlEncode(RefreshToken), *S->ClientId, *S->ClientSecret));
+
+    Req->OnProcessRequestComplete().BindLambda(
+        [this](FHttpRequestPtr, FHttpResponsePtr Resp, bool bOK)
+        {
+            TSharedPtr<FJsonObject> Json = TwitchChatAuth::ParseBody(Resp);
+            if (bOK && Resp.IsValid() && Resp->GetResponseCode() == 200 && Json.IsValid() && Json->HasField(TEXT("access_token")))
+            {
+                StoreTokens(*Json);
+                UE_LOG(LogTwitchChat, Log, TEXT("Tokens saved to INI after refresh."));
+                CompleteWaiters(true);
+                return;
+            }
+
+            UE_LOG(LogTwitchChat, Error, TEXT("Failed to refresh OAuth token: %s"),
+                Resp.IsValid() ? *Resp->GetContentAsString() : TEXT("no-response"));
+            NextRefreshTime = FPlatformTime::Seconds() + 60.0;
+            CompleteWaiters(false);
+        });
+    Req->ProcessRequest();
+}
+
+void FTwitchChatAuth::StoreTokens(const FJsonObject& Json)
+{
+    const double Now = FPlatformTime::Seconds();
+    AccessToken = Json.GetStringField(TEXT("access_token"));
+    Json.TryGetStringField(TEXT("refresh_token"), RefreshToken);
+    Json.TryGetStringArrayField(TEXT("scope"), Scopes);
+
+    double ExpiresIn = 0.0;
+    Json.TryGetNumberField(TEXT("expires_in"), ExpiresIn);
+    ExpiresAt = ExpiresIn > 0.0 ? Now + ExpiresIn : 0.0;
+    bValidated = true;
+    NextValidateTime = Now;     // learn login and user id in the background
+
+    if (UTwitchChatSettings* M = GetMutableDefault<UTwitchChatSettings>())
+    {
+        M->StoreTokens(AccessToken, RefreshToken);
+    }
+    RememberToken();
+}
+
+void FTwitchChatAuth::RememberToken() const
+{
+    const double ToExpiry = ExpiresAt > 0.0 ? ExpiresAt - FPlatformTime::Seconds() : 0.0;
+
+    FTwitchChatWarmStart::FToken Saved;
+    Saved.Login = Login;
+    Saved.UserId = UserId;
+    Saved.Scopes = Scopes;
+    Saved.ExpiresUtc = ExpiresAt > 0.0 ? FDateTime::UtcNow() + FTimespan::FromSeconds(ToExpiry) : FDateTime(0);
+    Saved.ValidatedUtc = FDateTime::UtcNow();
+    FTwitchChatWarmStart::Get().StoreToken(AccessToken, Saved);
+}
+
+void FTwitchChatAuth::StartDeviceFlow(TFunction<void(bool)> OnComplete)
+{
+    if (IsDeviceFlowActive())
+    {
+        // Second caller joins the flow already started, whether or not its code is on screen yet
+        TFunction<void(bool)> Previous = MoveTemp(OnDeviceFlowDone);
+        OnDeviceFlowDone = [Previous, OnComplete](bool bSuccess)
+            {
+                if (Previous)
+                    Previous(bSuccess);
+                if (OnComplete)
+                    OnComplete(bSuccess);
+            };
+        return;
+    }
+
+    OnDeviceFlowDone = MoveTemp(OnComplete);
+    bDeviceFlowActive = true;
+    const uint32 Flow = ++DeviceFlowSerial;
+    EnsureTicker();
+
+    const UTwitchChatSettings* S = GetDefault<UTwitchChatSettings>();
+    auto Req = FHttpModule::Get().CreateRequest();
+    Req->SetURL(S->GetAuthBaseUrl() + TEXT("/oauth2/device"));
+    Req->SetVerb(TEXT("POST"));
+    Req->SetHeader(TEXT("Content-Type"), TEXT("application/x-www-form-urlencoded"));
+
+    // Conduit subscriptions are made with an app token, which needs the user to have granted user:bot
+    Req->SetContentAsString(FString::Printf(TEXT("client_id=%s&scopes=user%%3Aread%%3Achat%s%s"),
+        *S->ClientId, S->bUseConduit ? TEXT("+user%3Abot") : TEXT(""), S->bEnableSendChat ? TEXT("+user%3Awrite%3Achat") : TEXT("")));
+
+    Req->OnProcessRequestComplete().BindLambda(
+        [this, Flow](FHttpRequestPtr, FHttpResponsePtr Resp, bool bOK)
+        {
+            if (Flow != DeviceFlowSerial || !bDeviceFlowActive)
+                return;     // cancelled meanwhile
+
+            TSharedPtr<FJsonObject> Json = TwitchChatAuth::ParseBody(Resp);
+            if (!bOK || !Resp.IsValid() || Resp->GetResponseCode() != 200 || !Json.IsValid())
+            {
+                UE_LOG(LogTwitchChat, Error, TEXT("Device flow start failed: %s"),
+                    Resp.IsValid() ? *Resp->GetContentAsString() : TEXT("no-response"));
+                FinishDeviceFlow(false);
+                return;
+            }
+
+            DeviceCode = Json->GetStringField(TEXT("device_code"));
+            UserCode = Json->GetStringField(TEXT("user_code"));
+            VerificationUri = Json->GetStringField(TEXT("verification_uri"));
+            PollIntervalSeconds = FMath::Max(1.0, Json->GetNumberField(TEXT("interval")));
+            DeviceFlowExpiry = FPlatformTime::Seconds() + Json->GetNumberField(TEXT("expires_in"));
+            NextPollTime = FPlatformTime::Seconds() + PollIntervalSeconds;
+
+            UE_LOG(LogTwitchChat, Log, TEXT("Device auth: go to %s and enter code %s"), *VerificationUri, *UserCode);
+            FPlatformProcess::LaunchURL(*VerificationUri, nullptr, nullptr);
+        });
+    Req->ProcessRequest();
+}
+
+void FTwitchChatAuth::CancelDeviceFlow()
+{
+    if (IsDeviceFlowActive())
+    {
+        UE_LOG(LogTwitchChat, Log, TEXT("Device flow cancelled"));
+        FinishDeviceFlow(false);
+    }
+}
+
+void FTwitchChatAuth::PollDeviceToken()
+{
+    bPollInFlight = true;
+    const UTwitchChatSettings* S = GetDefault<UTwitchChatSettings>();
+    auto Req = FHttpModule::Get().CreateRequest();
+    Req->SetURL(S->GetAuthBaseUrl() + TEXT("/oauth2/token"));
+    Req->SetVerb(TEXT("POST"));
+    Req->SetHeader(TEXT("Content-Type"), TEXT("application/x-www-form-urlencoded"));
+    Req->SetContentAsString(FString::Printf(
+        TEXT("client_id=%s&client_secret=%s&grant_type=urn:ietf:params:oauth:grant-type:device_code&device_code=%s"),
+        *S->ClientId, *S->ClientSecret, *DeviceCode));
+
+    Req->OnProcessRequestComplete().BindLambda(
+        [this, PolledCode = DeviceCode](FHttpRequestPtr, FHttpResponsePtr Resp, bool bOK)
+        {
+            bPollInFlight = false;
+            if (PolledCode != DeviceCode)
+                return;     // cancelled or restarted meanwhile
+
+            TSharedPtr<FJsonObject> Json = TwitchChatAuth::ParseBody(Resp);
+            const int32 Code = bOK && Resp.IsValid() ? Resp->GetResponseCode() : -1;
+            if (Code == 200 && Json.IsValid() && Json->HasField(TEXT("access_token")))
+            {
+                StoreTokens(*Json);
+                UE_LOG(LogTwitchChat, Log, TEXT("Device flow succeeded; tokens saved to DefaultEditorPerProjectUserSettings.ini"));
+                FinishDeviceFlow(true);
+                return;
+            }
+
+            FString Message;
+            if (Json.IsValid())
+                Json->TryGetStringField(TEXT("message"), Message);
+
+            if (Message == TEXT("authorization_pending") || Code < 0)
+            {
+                NextPollTime = FPlatformTime::Seconds() + PollIntervalSeconds;
+            }
+            else if (Message == TEXT("slow_down"))
+            {
+                PollIntervalSeconds += 5.0;
+                NextPollTime = FPlatformTime::Seconds() + PollIntervalSeconds;
+            }
+            else
+            {
+                UE_LOG(LogTwitchChat, Error, TEXT("Device flow failed: %s"), Resp.IsValid() ? *Resp->GetContentAsString() : TEXT("no-response"));
+                FinishDeviceFlow(false);
+            }
+        });
+    Req->ProcessRequest();
+}
+
+void FTwitchChatAuth::FinishDeviceFlow(bool bSuccess)
+{
+    bDeviceFlowActive = false;
+    DeviceCode.Empty();
+    UserCode.Empty();
+    VerificationUri.Empty();
+    if (TFunction<void(bool)> Done = MoveTemp(OnDeviceFlowDone))
+    {
+        Done(bSuccess);
+    }
+}
+
+static FAutoConsoleCommand GTwitchChatAuthCmd(
+    TEXT("twitchchat.auth"),
+    TEXT("Token status. Usage: twitchchat.auth [validate | refresh]"),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+        {
+            TSharedRef<FTwitchChatAuth> Auth = FTwitchChatAuth::Get();
+            if (Args.Num() > 0 && Args[0] == TEXT("refresh"))
+            {
+                Auth->Refresh([](bool bOk) { UE_LOG(LogTwitchChat, Display, TEXT("Refresh %s"), bOk ? TEXT("succeeded") : TEXT("failed")); });
+                return;
+            }
+            if (Args.Num() > 0 && Args[0] == TEXT("validate"))
+            {
+                Auth->LoadFromSettings();
+                Auth->WhenValid([](bool bOk) { UE_LOG(LogTwitchChat, Display, TEXT("Token %s"), bOk ? TEXT("valid") : TEXT("invalid")); });
+                return;
+            }
+            UE_LOG(LogTwitchChat, Display, TEXT("Token: %s, login '%s' (%s), expires in %.0f s, scopes: %s%s"),
+                Auth->HasToken() ? TEXT("present") : TEXT("none"), *Auth->GetLogin(), *Auth->GetUserId(),
+                Auth->GetSecondsToExpiry(), *FString::Join(Auth->GetScopes(), TEXT(" ")),
+                Auth->IsDeviceFlowActive() ? TEXT(", device flow waiting") : TEXT(""));
+        })
+);
@@ -0,0 +1,174 @@
+#include "TwitchChatBenchCommandlet.h"
+#include "TwitchChatBenchmark.h"
+#include "TwitchChatConnection.h"
+#include "TwitchChatHistoryLog.h"
+#include "TwitchChatSettings.h"
+#include "TwitchChatStats.h"
+
+#include "Async/TaskGraphInterfaces.h"
+#include "Containers/Ticker.h"
+#include "IImageWrapperModule.h"
+#include "IImageWrapper.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Modules/ModuleManager.h"
+
+UTwitchChatBenchCommandlet::UTwitchChatBenchCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = true;
+    LogToConsole = true;
+    ShowErrorCount = true;
+    HelpDescription = TEXT("Headless TwitchChat ingest benchmark (parse, emote fetch and decode, history)");
+    HelpUsage = TEXT("-run=TwitchChatBench -nullrhi [-replay=File] [-scenarios=a,b] [-rates=250,0] [-seconds=5] [-out=File] [-history] [-nodecode] [-noemulator]");
+}
+
+int32 UTwitchChatBenchCommandlet::Main(const FString& Params)
+{
+    TArray<FString> Tokens, Switches;
+    TMap<FString, FString> ParamMap;
+    ParseCommandLine(*Params, Tokens, Switches, ParamMap);
+
+    TArray<FString> Args;
+    for (const TPair<FString, FString>& Pair : ParamMap)
+    {
+        Args.Add(Pair.Key.ToLower() + TEXT("=") + Pair.Value);
+    }
+    FTwitchChatBenchmark::FOptions Options = FTwitchChatBenchmark::FOptions::FromArgs(Args);
+    Options.bUseEmulator = !Switches.Contains(TEXT("noemulator"));
+
+    const bool bHistory = Switches.Contains(TEXT("history"));
+    const bool bDecode = !Switches.Contains(TEXT("nodecode"));
+
+    // Process-local overrides; nothing is written back to config. The shared history log stays off:
+    // -history writes to a private log in a temporary directory instead of the user's own.
+    if (UTwitchChatSettings* S = GetMutableDefault<UTwitchChatSettings>())
+    {
+        S->bEnableHistoryLog = false;
+        S->bEnableSearchIndex = false;
+    }
+
+    TSharedPtr<FTwitchChatHistoryLog> History;
+    const FString HistoryDirectory = FPaths::CreateTempFilename(*FPaths::ProjectIntermediateDir(), TEXT("TwitchChatBenchHistory-"));
+    if (bHistory)
+    {
+        FTwitchChatHistoryLog::FOptions HistoryOptions = FTwitchChatHistoryLog::FOptions::FromSettings();
+        HistoryOptions.Directory = HistoryDirectory;
+        History = MakeShared<FTwitchChatHistoryLog>(HistoryOptions);
+    }
+
+    TSharedPtr<FTwitchChatBenchmark> Bench = FTwitchChatBenchmark::StartActive(Options);
+    if (!Bench.IsValid())
+    {
+        UE_LOG(LogTwitchChat, Error, TEXT("TwitchChatBench: nothing to run"));
+        return 1;
+    }
+
+    // Emote decode mirrors the CPU half of UTwitchChatLibrary::TwitchChat_GetEmoteTexture
+    TSet<FString> SeenEmotes;
+    TArray<FString> PendingEmotes;
+    int32 NumDecoded = 0;
+    double DecodeSeconds = 0.0;
+    IImageWrapperModule& ImageWrapper = FModuleManager::LoadModuleChecked<IImageWrapperModule>(TEXT("ImageWrapper"));
+
+    FDelegateHandle Handle = FTwitchChatConnection::Get()->OnMessage.AddLambda([&](const FTwitchChatMessage& Msg)
+        {
+            if (History)
+            {
+                History->Append(Msg);
+            }
+            for (const FString& Id : Msg.EmoteIds)
+            {
+                bool bSeen = false;
+                SeenEmotes.Add(Id, &bSeen);
+                if (!bSeen)
+                    PendingEmotes.Add(Id);
+            }
+        });
+
+    auto DecodePending = [&]()
+        {
+            for (int32 i = PendingEmotes.Num() - 1; i >= 0; --i)
+            {
+                const FString Path = FPaths::ProjectSavedDir() / TEXT("FetchedEmotes") / (PendingEmotes[i] + TEXT(".png"));
+                TArray<uint8> FileData;
+                if (!FFileHelper::LoadFileToArray(FileData, *Path, FILEREAD_Silent))
+                    continue;
+
+                SCOPE_CYCLE_COUNTER(STAT_TwitchChat_EmoteDecode);
+                const double Start = FPlatformTime::Seconds();
+                TSharedPtr<IImageWrapper> Wrapper = ImageWrapper.CreateImageWrapper(EImageFormat::PNG);
+                TArray<uint8> RawBGRA;
+                if (Wrapper.IsValid() && Wrapper->SetCompressed(FileData.GetData(), FileData.Num()) && Wrapper->GetRaw(ERGBFormat::BGRA, 8, RawBGRA))
+                {
+                    ++NumDecoded;
+                }
+                DecodeSeconds += FPlatformTime::Seconds() - Start;
+                PendingEmotes.RemoveAtSwap(i);
+            }
+        };
+
+    double LastTime = FPlatformTime::Seconds();
+    while (Bench->IsRunning() && !IsEngineExitRequested())
+    {
+        const double Now = FPlatformTime::Seconds();
+        const float DeltaTime = float(Now - LastTime);
+        LastTime = Now;
+
+        FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+        FTSTicker::GetCoreTicker().Tick(DeltaTime);
+        if (bDecode)
+        {
+            DecodePending();
+        }
+        FPlatformProcess::Sleep(0.001f);
+    }
+    if (bDecode)
+    {
+        DecodePending();
+    }
+    FTwitchChatConnection::Get()->OnMessage.Remove(Handle);
+
+    int64 HistoryWritten = 0, HistoryBytes = 0;
+    if (History)
+    {
+        History->Flush();
+        HistoryWritten = History->GetNumMessagesWritten();
+        HistoryBytes = History->GetBytesWritten();
+        History->Shutdown();
+        IFileManager::Get().DeleteDirectory(*HistoryDirectory, /*RequireExists=*/false, /*Tree=*/true);
+        History.Reset();
+    }
+
+    int32 Sent = 0, Delivered = 0;
+    UE_LOG(LogTwitchChat, Display, TEXT("==== TwitchChat ingest report ===="));
+    UE_LOG(LogTwitchChat, Display, TEXT("%-10s %8s %8s %8s %10s %9s %9s %9s %8s %9s"),
+        TEXT("scenario"), TEXT("rate"), TEXT("sent"), TEXT("recv"), TEXT("msg/s"),
+        TEXT("p50 ms"), TEXT("p99 ms"), TEXT("p999 ms"), TEXT("allocs"), TEXT("peak MB"));
+    for (const FTwitchChatBenchmark::FStepResult& R : Bench->GetResults())
+    {
+        UE_LOG(LogTwitchChat, Display, TEXT("%-10s %8s %8d %8d %10.0f %9.2f %9.2f %9.2f %8.1f %9.1f"),
+            *R.Scenario, R.TargetRate > 0.f ? *FString::SanitizeFloat(R.TargetRate) : TEXT("max"),
+            R.Sent, R.Delivered, R.Throughput, R.P50Ms, R.P99Ms, R.P999Ms, R.AllocsPerMessage,
+            R.PeakDeltaBytes / (1024.0 * 1024.0));
+        Sent += R.Sent;
+        Delivered += R.Delivered;
+    }
+    if (bDecode)
+    {
+        UE_LOG(LogTwitchChat, Display, TEXT("emotes: %d seen, %d decoded, %.3f ms/decode"),
+            SeenEmotes.Num(), NumDecoded, NumDecoded > 0 ? DecodeSeconds * 1000.0 / NumDecoded : 0.0);
+    }
+    if (bHistory)
+    {
+        UE_LOG(LogTwitchChat, Display, TEXT("history: %lld messages, %.2f MB on disk"),
+            HistoryWritten, HistoryBytes / (1024.0 * 1024.0));
+    }
+    UE_LOG(LogTwitchChat, Display, TEXT("results: %s"), *Bench->GetOutputPath());
+
+    // Replays may legitimately contain non-chat frames; only a synthetic run must deliver everything
+    const bool bComplete = !Options.ReplayPath.IsEmpty() || Delivered == Sent;
+    return bComplete ? 0 : 1;
+}
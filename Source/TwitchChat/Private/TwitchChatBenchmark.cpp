@@ -0,0 +1,455 @@
+#include "TwitchChatBenchmark.h"
+#include "TwitchChatConnection.h"
+#include "TwitchChatEmulator.h"
+#include "TwitchChatReplaySource.h"
+#include "TwitchChatSyntheticChat.h"
+
+#include "Async/Async.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+#include "Policies/PrettyJsonPrintPolicy.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/MemoryBase.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace TwitchChatBenchmark
+{
+    static TSharedPtr<FTwitchChatBenchmark> GActive;
+
+    // Process-wide allocator call count; only maintained by the allocator in stats-enabled builds.
+    static bool CountAllocs(uint64& Out)
+    {
+#if STATS
+        Out = uint64(FMalloc::TotalMallocCalls) + uint64(FMalloc::TotalReallocCalls);
+        return true;
+#else
+        Out = 0;
+        return false;
+#endif
+    }
+
+    static double Percentile(const TArray<double>& Sorted, double P)
+    {
+        if (Sorted.Num() == 0)
+            return 0.0;
+        const int32 Index = FMath::Clamp(FMath::CeilToInt(P * Sorted.Num()) - 1, 0, Sorted.Num() - 1);
+        return Sorted[Index];
+    }
+}
+
+FTwitchChatBenchmark::FOptions FTwitchChatBenchmark::FOptions::FromArgs(const TArray<FString>& Args)
+{
+    FOptions Out;
+    for (const FString& Arg : Args)
+    {
+        FString Key, Value;
+        if (!Arg.Split(TEXT("="), &Key, &Value))
+            continue;
+
+        if (Key == TEXT("scenarios"))
+        {
+            Out.Scenarios.Reset();
+            Value.ParseIntoArray(Out.Scenarios, TEXT(","));
+        }
+        else if (Key == TEXT("rates"))
+        {
+            TArray<FString> Parts;
+            Value.ParseIntoArray(Parts, TEXT(","));
+            Out.Rates.Reset();
+            for (const FString& Part : Parts)
+                Out.Rates.Add(FCString::Atof(*Part));
+        }
+        else if (Key == TEXT("seconds"))  Out.StepSeconds = FMath::Max(0.5f, FCString::Atof(*Value));
+        else if (Key == TEXT("messages")) Out.MaxSpeedMessages = FMath::Max(1, FCString::Atoi(*Value));
+        else if (Key == TEXT("inflight")) Out.MaxInFlight = FMath::Max(1, FCString::Atoi(*Value));
+        else if (Key == TEXT("replay"))   Out.ReplayPath = Value;
+        else if (Key == TEXT("out"))      Out.OutputPath = Value;
+        else if (Key == TEXT("emulator")) Out.bUseEmulator = FCString::ToBool(*Value);
+    }
+    return Out;
+}
+
+TSharedPtr<FTwitchChatBenchmark> FTwitchChatBenchmark::GetActive()
+{
+    return TwitchChatBenchmark::GActive;
+}
+
+TSharedPtr<FTwitchChatBenchmark> FTwitchChatBenchmark::StartActive(const FOptions& InOptions)
+{
+    if (TwitchChatBenchmark::GActive.IsValid() && TwitchChatBenchmark::GActive->IsRunning())
+    {
+        UE_LOG(LogTwitchChat, Warning, TEXT("Benchmark already running"));
+        return nullptr;
+    }
+
+    TSharedPtr<FTwitchChatBenchmark> Bench = MakeShared<FTwitchChatBenchmark>(FTwitchChatConnection::Get(), InOptions);
+    if (!Bench->Start())
+        return nullptr;
+
+    TwitchChatBenchmark::GActive = Bench;
+    return Bench;
+}
+
+FTwitchChatBenchmark::FTwitchChatBenchmark(TSharedRef<FTwitchChatConnection> InConnection, const FOptions& InOptions)
+    : Connection(InConnection)
+    , Options(InOptions)
+{
+    if (Options.OutputPath.IsEmpty())
+    {
+        Options.OutputPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("TwitchChatBench"),
+            FString::Printf(TEXT("Bench_%s.json"), *FDateTime::Now().ToString(TEXT("%Y%m%d_%H%M%S"))));
+    }
+}
+
+FTwitchChatBenchmark::~FTwitchChatBenchmark()
+{
+    if (TickHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+    }
+}
+
+bool FTwitchChatBenchmark::Start()
+{
+    if (bRunning)
+        return false;
+
+    if (!Options.ReplayPath.IsEmpty())
+    {
+        TArray<FTwitchChatReplaySource::FFrame> Frames;
+        if (!FTwitchChatReplaySource::LoadFile(Options.ReplayPath, Frames))
+            return false;
+
+        for (FTwitchChatReplaySource::FFrame& Frame : Frames)
+            ReplayFrames.Add(MoveTemp(Frame.Payload));
+    }
+
+    const TArray<FString> Scenarios = ReplayFrames.Num() > 0
+        ? TArray<FString>{ FPaths::GetBaseFilename(Options.ReplayPath) }
+        : Options.Scenarios;
+
+    for (const FString& Scenario : Scenarios)
+    {
+        FTwitchChatSyntheticChat::FConfig Unused;
+        if (ReplayFrames.Num() == 0 && !FTwitchChatSyntheticChat::FConfig::FromName(Scenario, Unused))
+        {
+            UE_LOG(LogTwitchChat, Warning, TEXT("Benchmark: unknown scenario '%s'"), *Scenario);
+            continue;
+        }
+        for (float Rate : Options.Rates)
+            Steps.Add({ Scenario, Rate });
+    }
+    if (Steps.Num() == 0)
+        return false;
+
+    if (Options.bUseEmulator && !FTwitchChatEmulator::GetActive().IsValid())
+    {
+        bStartedEmulator = FTwitchChatEmulator::StartActive(FTwitchChatEmulator::FConfig()).IsValid();
+    }
+
+    Connection->BeginReplay();
+    MessageHandle = Connection->OnMessage.AddSP(this, &FTwitchChatBenchmark::HandleMessage);
+    TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateSP(this, &FTwitchChatBenchmark::Tick));
+
+    bRunning = true;
+    bCancelled = false;
+    StepIndex = INDEX_NONE;
+    Results.Reset();
+
+    UE_LOG(LogTwitchChat, Display, TEXT("Benchmark: %d steps of %.1fs"), Steps.Num(), Options.StepSeconds);
+    BeginStep();
+    return true;
+}
+
+void FTwitchChatBenchmark::Cancel()
+{
+    bCancelled = true;
+}
+
+TSharedRef<TArray<FString>> FTwitchChatBenchmark::BuildFrames(const FStep& Step) const
+{
+    const int32 Count = Step.Rate > 0.f
+        ? FMath::Max(1, FMath::RoundToInt(Step.Rate * Options.StepSeconds))
+        : Options.MaxSpeedMessages;
+
+    TSharedRef<TArray<FString>> Frames = MakeShared<TArray<FString>>();
+    Frames->Reserve(Count);
+
+    if (ReplayFrames.Num() > 0)
+    {
+        for (int32 i = 0; i < Count; ++i)
+            Frames->Add(ReplayFrames[i % ReplayFrames.Num()]);
+    }
+    else
+    {
+        FTwitchChatSyntheticChat::FConfig Config;
+        FTwitchChatSyntheticChat::FConfig::FromName(Step.Scenario, Config);
+        FTwitchChatSyntheticChat Chat(Config);
+
+        const FString SessionId = TEXT("benchmark");
+        const FTwitchChatSyntheticChat::FChannel Channel;
+        for (int32 i = 0; i < Count; ++i)
+            Frames->Add(Chat.NextChatMessage(SessionId, Channel));
+    }
+    return Frames;
+}
+
+void FTwitchChatBenchmark::BeginStep()
+{
+    ++StepIndex;
+    if (bCancelled || !Steps.IsValidIndex(StepIndex))
+    {
+        Finish();
+        return;
+    }
+
+    const FStep Step = Steps[StepIndex];
+    TSharedRef<TArray<FString>> Frames = BuildFrames(Step);   // generated up front so it is not measured
+
+    FStepResult& Result = Results.AddDefaulted_GetRef();
+    Result.Scenario = Step.Scenario;
+    Result.TargetRate = Step.Rate;
+
+    Latencies.Reset(Frames->Num());
+    Sent = 0;
+    bProducerDone = false;
+    DrainTicks = 0;
+    StepBaseMemory = StepPeakMemory = FPlatformMemory::GetStats().UsedPhysical;
+    TwitchChatBenchmark::CountAllocs(StepAllocs);
+    StepStart = LastDelivery = FPlatformTime::Seconds();
+
+    TSharedRef<FTwitchChatBenchmark> Self = AsShared();
+    const int32 MaxInFlight = Options.MaxInFlight;
+    Async(EAsyncExecution::Thread, [Self, Frames, Rate = Step.Rate, MaxInFlight]()
+        {
+            const double Start = FPlatformTime::Seconds();
+            for (int32 i = 0; i < Frames->Num() && !Self->bCancelled; ++i)
+            {
+                if (Rate > 0.f)
+                {
+                    const double Wait = Start + i / Rate - FPlatformTime::Seconds();
+                    if (Wait > 0.0)
+                        FPlatformProcess::Sleep(float(Wait));
+                }
+
+                // A pipeline that cannot keep up shows as lower throughput, not unbounded threads
+                while (Self->Connection->GetNumFramesInFlight() >= MaxInFlight && !Self->bCancelled)
+                {
+                    FPlatformProcess::Sleep(0.0005f);
+                }
+
+                Self->Connection->IngestFrame((*Frames)[i]);
+                ++Self->Sent;
+            }
+            Self->bProducerDone = true;
+        });
+}
+
+void FTwitchChatBenchmark::HandleMessage(const FTwitchChatMessage& Msg)
+{
+    if (!bRunning || Msg.ReceivedTime <= 0.0)
+        return;
+
+    LastDelivery = FPlatformTime::Seconds();
+    Latencies.Add((LastDelivery - Msg.ReceivedTime) * 1000.0);
+}
+
+bool FTwitchChatBenchmark::Tick(float /*DeltaTime*/)
+{
+    if (!bRunning)
+        return true;
+
+    StepPeakMemory = FMath::Max<uint64>(StepPeakMemory, FPlatformMemory::GetStats().UsedPhysical);
+
+    // Once the producer is done and nothing is left in the parse stage, the remaining
+    // broadcasts are already queued on the game thread; give them a couple of frames.
+    if (bProducerDone && Connection->GetNumFramesInFlight() == 0)
+    {
+        if (++DrainTicks > 2)
+        {
+            EndStep();
+            BeginStep();
+        }
+    }
+    return true;
+}
+
+void FTwitchChatBenchmark::EndStep()
+{
+    FStepResult& Result = Results.Last();
+    Result.Sent = Sent;
+    Result.Delivered = Latencies.Num();
+    Result.Seconds = FMath::Max(LastDelivery - StepStart, 1e-6);
+    Result.Throughput = Result.Delivered / Result.Seconds;
+
+    uint64 AllocsNow = 0;
+    if (TwitchChatBenchmark::CountAllocs(AllocsNow) && Result.Delivered > 0)
+    {
+        Result.AllocsPerMessage = double(AllocsNow - StepAllocs) / Result.Delivered;
+    }
+    Result.PeakUsedPhysical = StepPeakMemory;
+    Result.PeakDeltaBytes = int64(StepPeakMemory) - int64(StepBaseMemory);
+
+    Latencies.Sort();
+    Result.P50Ms = TwitchChatBenchmark::Percentile(Latencies, 0.50);
+    Result.P99Ms = TwitchChatBenchmark::Percentile(Latencies, 0.99);
+    Result.P999Ms = TwitchChatBenchmark::Percentile(Latencies, 0.999);
+    Result.MaxMs = Latencies.Num() > 0 ? Latencies.Last() : 0.0;
+
+    UE_LOG(LogTwitchChat, Display,
+        TEXT("Benchmark %-8s rate %6s: %6d/%6d msgs, %8.0f msg/s, p50 %7.2f ms, p99 %7.2f ms, p999 %7.2f ms, %.1f allocs/msg, peak +%.1f MB"),
+        *Result.Scenario,
+        Result.TargetRate > 0.f ? *FString::SanitizeFloat(Result.TargetRate) : TEXT("max"),
+        Result.Delivered, Result.Sent, Result.Throughput,
+        Result.P50Ms, Result.P99Ms, Result.P999Ms, Result.AllocsPerMessage,
+        Result.PeakDeltaBytes / (1024.0 * 1024.0));
+}
+
+void FTwitchChatBenchmark::Finish()
+{
+    if (!bRunning)
+        return;
+
+    if (bCancelled && Results.Num() > 0 && Results.Last().Delivered == 0 && Results.Last().Sent == 0)
+    {
+        Results.Pop();
+    }
+
+    bRunning = false;
+    Connection->OnMessage.Remove(MessageHandle);
+    Connection->EndReplay();
+    FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+    TickHandle.Reset();
+
+    if (bStartedEmulator)
+    {
+        FTwitchChatEmulator::StopActive();
+        bStartedEmulator = false;
+    }
+
+    if (FFileHelper::SaveStringToFile(ToJson(), *Options.OutputPath))
+    {
+        UE_LOG(LogTwitchChat, Display, TEXT("Benchmark results written to %s"), *Options.OutputPath);
+    }
+
+    OnFinished.ExecuteIfBound(*this);
+}
+
+FString FTwitchChatBenchmark::ToJson() const
+{
+    TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+    Root->SetStringField(TEXT("timestamp"), FDateTime::UtcNow().ToIso8601());
+    Root->SetStringField(TEXT("platform"), FPlatformProperties::IniPlatformName());
+    Root->SetStringField(TEXT("build"), LexToString(FApp::GetBuildConfiguration()));
+    Root->SetStringField(TEXT("source"), Options.ReplayPath.IsEmpty() ? TEXT("synthetic") : *Options.ReplayPath);
+    Root->SetNumberField(TEXT("step_seconds"), Options.StepSeconds);
+    Root->SetBoolField(TEXT("cancelled"), bCancelled.load());
+
+    TArray<TSharedPtr<FJsonValue>> Steps;
+    for (const FStepResult& R : Results)
+    {
+        TSharedRef<FJsonObject> Step = MakeShared<FJsonObject>();
+        Step->SetStringField(TEXT("scenario"), R.Scenario);
+        Step->SetNumberField(TEXT("target_rate"), R.TargetRate);
+        Step->SetNumberField(TEXT("sent"), R.Sent);
+        Step->SetNumberField(TEXT("delivered"), R.Delivered);
+        Step->SetNumberField(TEXT("seconds"), R.Seconds);
+        Step->SetNumberField(TEXT("throughput"), R.Throughput);
+        Step->SetNumberField(TEXT("latency_p50_ms"), R.P50Ms);
+        Step->SetNumberField(TEXT("latency_p99_ms"), R.P99Ms);
+        Step->SetNumberField(TEXT("latency_p999_ms"), R.P999Ms);
+        Step->SetNumberField(TEXT("latency_max_ms"), R.MaxMs);
+        Step->SetNumberField(TEXT("allocs_per_message"), R.AllocsPerMessage);
+        Step->SetNumberField(TEXT("peak_used_physical"), double(R.PeakUsedPhysical));
+        Step->SetNumberField(TEXT("peak_delta_bytes"), double(R.PeakDeltaBytes));
+        Steps.Add(MakeShared<FJsonValueObject>(Step));
+    }
+    Root->SetArrayField(TEXT("steps"), Steps);
+
+    FString Out;
+    TSharedRef<TJsonWriter<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>> Writer =
+        TJsonWriterFactory<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>::Create(&Out);
+    FJsonSerializer::Serialize(Root, Writer);
+    return Out;
+}
+
+//-----------------------------------------------------------------------------
+// Console
+//-----------------------------------------------------------------------------
+static FAutoConsoleCommand GTwitchChatBenchCmd(
+    TEXT("twitchchat.bench"),
+    TEXT("Run the end-to-end ingest benchmark and write JSON results. Usage: twitchchat.bench ")
+    TEXT("[scenarios=default,emote,long,reply] [rates=250,1000,4000,0] [seconds=5] [messages=20000] [inflight=1024] [replay=Path] [out=Path] [emulator=1]"),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+        {
+            FTwitchChatBenchmark::StartActive(FTwitchChatBenchmark::FOptions::FromArgs(Args));
+        })
+);
+
+static FAutoConsoleCommand GTwitchChatAllocBenchCmd(
+    TEXT("twitchchat.allocbench"),
+    TEXT("Heap allocations and time per parsed chat message, JSON object tree vs arena parse, on synthetic frames. ")
+    TEXT("Allocations are counted process-wide in stats builds, so run it on an idle session. Usage: twitchchat.allocbench [messages=5000] [scenario=default]"),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+        {
+            const int32 NumMessages = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 5000;
+            FTwitchChatSyntheticChat::FConfig Config;
+            if (Args.Num() > 1 && !FTwitchChatSyntheticChat::FConfig::FromName(Args[1], Config))
+            {
+                UE_LOG(LogTwitchChat, Warning, TEXT("Unknown scenario %s"), *Args[1]);
+                return;
+            }
+
+            FTwitchChatSyntheticChat Synthetic(Config);
+            const FTwitchChatSyntheticChat::FChannel Channel;
+            TArray<FString> Frames;
+            Frames.Reserve(NumMessages);
+            for (int32 i = 0; i < NumMessages; ++i)
+            {
+                Frames.Add(Synthetic.NextChatMessage(TEXT("allocbench"), Channel));
+            }
+
+            // Untimed pass first, so both runs find the chatters cached and the arena pages allocated, as on
+            // the connection's long-lived parse worker
+            for (const FString& Frame : Frames)
+            {
+                FTwitchChatMessage M;
+                FTwitchChatConnection::ParseChatFrame(Frame, M, true);
+            }
+
+            for (const bool bArena : { false, true })
+            {
+                uint64 AllocsBefore = 0, AllocsAfter = 0;
+                const bool bCounted = TwitchChatBenchmark::CountAllocs(AllocsBefore);
+                int32 Parsed = 0;
+                const double Start = FPlatformTime::Seconds();
+                for (const FString& Frame : Frames)
+                {
+                    FTwitchChatMessage M;
+                    Parsed += FTwitchChatConnection::ParseChatFrame(Frame, M, bArena) ? 1 : 0;
+                }
+                const double Seconds = FPlatformTime::Seconds() - Start;
+                TwitchChatBenchmark::CountAllocs(AllocsAfter);
+
+                UE_LOG(LogTwitchChat, Display, TEXT("%s: %d/%d parsed, %.2f us/msg, %s allocs/msg"),
+                    bArena ? TEXT("arena") : TEXT("tree "), Parsed, Frames.Num(), Seconds * 1e6 / Frames.Num(),
+                    bCounted ? *FString::Printf(TEXT("%.1f"), double(AllocsAfter - AllocsBefore) / Frames.Num()) : TEXT("n/a (needs STATS)"));
+            }
+        })
+);
+
+static FAutoConsoleCommand GTwitchChatBenchStopCmd(
+    TEXT("twitchchat.bench.stop"),
+    TEXT("Cancel the running ingest benchmark; finished steps are still written."),
+    FConsoleCommandDelegate::CreateLambda([]()
+        {
+            if (TSharedPtr<FTwitchChatBenchmark> Bench = FTwitchChatBenchmark::GetActive())
+            {
+                Bench->Cancel();
+            }
+        })
+);
@@ -0,0 +1,194 @@
+#include "TwitchChatChatters.h"
+#include "TwitchChatConnection.h"
+#include "TwitchChatSettings.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/ScopeLock.h"
+
+namespace TwitchChatChatters
+{
+    // Calls Visit for each "set_id/id" in a comma separated list; stops early when Visit returns false
+    template<typename TVisit>
+    static bool ForEachBadge(FStringView Badges, TVisit Visit)
+    {
+        while (!Badges.IsEmpty())
+        {
+            int32 Comma = INDEX_NONE;
+            Badges.FindChar(TEXT(','), Comma);
+            const FStringView Badge = Comma == INDEX_NONE ? Badges : Badges.Left(Comma);
+            Badges.RightChopInline(Comma == INDEX_NONE ? Badges.Len() : Comma + 1);
+            if (!Badge.IsEmpty() && !Visit(Badge))
+                return false;
+        }
+        return true;
+    }
+}
+
+bool FTwitchChatChatter::HasBadge(const FString& SetId) const
+{
+    return Badges.ContainsByPredicate([&SetId](const FString& Badge)
+        {
+            return Badge.Len() > SetId.Len() && Badge[SetId.Len()] == TEXT('/') && Badge.StartsWith(SetId, ESearchCase::CaseSensitive);
+        });
+}
+
+FTwitchChatChatters& FTwitchChatChatters::Get()
+{
+    static FTwitchChatChatters Instance;
+    return Instance;
+}
+
+FTwitchChatChatters::FTwitchChatChatters()
+    : Cache(FMath::Max(1, GetDefault<UTwitchChatSettings>()->ChatterCacheSize))
+{
+}
+
+FTwitchChatChatterRef FTwitchChatChatters::Make(const FString& UserId, FStringView UserName, FStringView ColorHex, FStringView Badges,
+    const FDateTime& FirstSeen)
+{
+    TSharedRef<FTwitchChatChatter, ESPMode::ThreadSafe> Chatter = MakeShared<FTwitchChatChatter, ESPMode::ThreadSafe>();
+    Chatter->UserId = UserId;
+    Chatter->UserName = FString(UserName);
+    Chatter->ColorHex = FString(ColorHex);
+    Chatter->Color = FLinearColor(FColor::FromHex(ColorHex.IsEmpty() ? FString(DefaultColor) : Chatter->ColorHex));
+    TwitchChatChatters::ForEachBadge(Badges, [&Chatter](FStringView Badge)
+        {
+            Chatter->Badges.Emplace(Badge);
+            return true;
+        });
+    Chatter->FirstSeen = FirstSeen;
+    return Chatter;
+}
+
+bool FTwitchChatChatters::Matches(const FTwitchChatChatter& Chatter, FStringView UserName, FStringView ColorHex, FStringView Badges)
+{
+    if (!UserName.Equals(Chatter.UserName, ESearchCase::CaseSensitive) || !ColorHex.Equals(Chatter.ColorHex, ESearchCase::CaseSensitive))
+        return false;
+
+    int32 Index = 0;
+    const bool bSamePrefix = TwitchChatChatters::ForEachBadge(Badges, [&Chatter, &Index](FStringView Badge)
+        {
+            return Chatter.Badges.IsValidIndex(Index) && Badge.Equals(Chatter.Badges[Index++], ESearchCase::CaseSensitive);
+        });
+    return bSamePrefix && Index == Chatter.Badges.Num();
+}
+
+FTwitchChatChatterRef FTwitchChatChatters::Touch(const FString& UserId, FStringView UserName, FStringView ColorHex, FStringView Badges,
+    const FDateTime& SeenAt)
+{
+    const int32 Capacity = GetDefault<UTwitchChatSettings>()->ChatterCacheSize;
+    FTwitchChatChatterPtr Chatter;
+    {
+        FScopeLock ScopeLock(&Lock);
+        const FTwitchChatChatterPtr* Cached = Capacity > 0 && !UserId.IsEmpty() ? Cache.FindAndTouch(UserId) : nullptr;
+        if (Cached && Matches(**Cached, UserName, ColorHex, Badges))
+        {
+            ++Stats.Hits;
+            Chatter = *Cached;
+        }
+        else
+        {
+            ++Stats.Misses;
+            Chatter = Make(UserId, UserName, ColorHex, Badges, Cached ? (*Cached)->FirstSeen : SeenAt);
+            if (Cached)
+            {
+                Chatter->MessageCount.store((*Cached)->GetMessageCount(), std::memory_order_relaxed);
+                Cache.Add(UserId, Chatter);
+            }
+            else if (Capacity > 0 && !UserId.IsEmpty())
+            {
+                if (Cache.Max() != Capacity)
+                {
+                    // Resized in the settings; start over rather than rehash under the parse workers
+                    Cache.Empty(Capacity);
+                }
+                if (Cache.Num() == Cache.Max())
+                {
+                    ++Stats.Evictions;
+                }
+                Cache.Add(UserId, Chatter);
+            }
+        }
+    }
+
+    Chatter->LastSeenTicks.store(SeenAt.GetTicks(), std::memory_order_relaxed);
+    Chatter->MessageCount.fetch_add(1, std::memory_order_relaxed);
+    return Chatter.ToSharedRef();
+}
+
+FTwitchChatChatterPtr FTwitchChatChatters::Find(const FString& UserId) const
+{
+    FScopeLock ScopeLock(&Lock);
+    const FTwitchChatChatterPtr* Cached = Cache.Find(UserId);
+    return Cached ? *Cached : nullptr;
+}
+
+void FTwitchChatChatters::Clear()
+{
+    FScopeLock ScopeLock(&Lock);
+    Cache.Empty(Cache.Max());
+}
+
+int32 FTwitchChatChatters::Num() const
+{
+    FScopeLock ScopeLock(&Lock);
+    return Cache.Num();
+}
+
+FTwitchChatChatters::FStats FTwitchChatChatters::GetStats() const
+{
+    FScopeLock ScopeLock(&Lock);
+    return Stats;
+}
+
+SIZE_T FTwitchChatChatters::GetAllocatedSize() const
+{
+    FScopeLock ScopeLock(&Lock);
+    // The cache's own index is a TSet of the keys plus a list node per entry
+    SIZE_T Bytes = SIZE_T(Cache.Max()) * (sizeof(FString) + sizeof(FTwitchChatChatterPtr) + 3 * sizeof(void*));
+    for (TLruCache<FString, FTwitchChatChatterPtr>::TConstIterator It(Cache); It; ++It)
+    {
+        const FTwitchChatChatter& Chatter = *It.Value();
+        Bytes += It.Key().GetAllocatedSize() + sizeof(FTwitchChatChatter)
+            + Chatter.UserId.GetAllocatedSize() + Chatter.UserName.GetAllocatedSize() + Chatter.ColorHex.GetAllocatedSize()
+            + Chatter.Badges.GetAllocatedSize();
+        for (const FString& Badge : Chatter.Badges)
+        {
+            Bytes += Badge.GetAllocatedSize();
+        }
+    }
+    return Bytes;
+}
+
+static FAutoConsoleCommand GTwitchChatChattersCmd(
+    TEXT("twitchchat.chatters"),
+    TEXT("Chatter cache size and hit rate, or one chatter's cached entry. Usage: twitchchat.chatters [user id] | clear"),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+        {
+            FTwitchChatChatters& Chatters = FTwitchChatChatters::Get();
+            if (Args.Num() > 0 && Args[0] == TEXT("clear"))
+            {
+                Chatters.Clear();
+                return;
+            }
+            if (Args.Num() > 0)
+            {
+                const FTwitchChatChatterPtr Chatter = Chatters.Find(Args[0]);
+                if (!Chatter)
+                {
+                    UE_LOG(LogTwitchChat, Display, TEXT("No cached chatter %s"), *Args[0]);
+                    return;
+                }
+                UE_LOG(LogTwitchChat, Display, TEXT("%s (%s) color=%s badges=%s messages=%lld first=%s last=%s"),
+                    *Chatter->UserName, *Chatter->UserId, Chatter->ColorHex.IsEmpty() ? TEXT("default") : *Chatter->ColorHex,
+                    *FString::Join(Chatter->Badges, TEXT(",")), Chatter->GetMessageCount(),
+                    *Chatter->FirstSeen.ToString(), *Chatter->GetLastSeen().ToString());
+                return;
+            }
+
+            const FTwitchChatChatters::FStats Stats = Chatters.GetStats();
+            const uint64 Lookups = Stats.Hits + Stats.Misses;
+            UE_LOG(LogTwitchChat, Display, TEXT("%d chatters cached, %.1f KB; %llu lookups, %.1f%% hits, %llu evicted"),
+                Chatters.Num(), Chatters.GetAllocatedSize() / 1024.0, Lookups,
+                Lookups > 0 ? 100.0 * Stats.Hits / Lookups : 0.0, Stats.Evictions);
+        })
+);
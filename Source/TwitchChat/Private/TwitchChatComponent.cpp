@@ -1,7 +1,90 @@
 ﻿#include "TwitchChatComponent.h"
 #include "TwitchChatConnection.h"
+#include "TwitchChatRecentHistory.h"
 #include "Async/Async.h"
 
+namespace TwitchChatComponent
+{
+    // Events already arrive on the game thread; only the channel filter applies
+    template<typename TPayload, typename TDelegate>
+    static void Forward(UTwitchChatComponent* Component, TDelegate& Target)
+    {
+        FTwitchChatEvents::Get().On<TPayload>().AddWeakLambda(Component, [Component, &Target](const TPayload& Event)
+            {
+                if (Component->AcceptsChannel(Event.ChannelLogin) || Component->AcceptsChannel(Event.ChannelId))
+                {
+                    Target.Broadcast(Event);
+                }
+            });
+    }
+
+    static FBP_TwitchChatMessage ToBlueprint(const FTwitchChatMessage& Msg)
+    {
+        FBP_TwitchChatMessage BP;
+        BP.UserName = Msg.UserName;
+        BP.Message = Msg.Message;
+        BP.UserColor = Msg.UserColor;
+
+        BP.EmoteIds = Msg.EmoteIds;
+        BP.EmoteOccurrences = Msg.EmoteIds;
+
+        const FString* Val = nullptr;
+        Val = Msg.Tags.Find(TEXT("subscriber"));
+        BP.bSubscriber = (Val && *Val == TEXT("1"));
+        Val = Msg.Tags.Find(TEXT("vip"));
+        BP.bVip = (Val && *Val == TEXT("1"));
+        Val = Msg.Tags.Find(TEXT("mod"));
+        BP.bMod = (Val && *Val == TEXT("1"));
+        Val = Msg.Tags.Find(TEXT("turbo"));
+        BP.bTurbo = (Val && *Val == TEXT("1"));
+
+        BP.Bits = 0;
+        if (const FString* V = Msg.Tags.Find(TEXT("bits")))
+        {
+            BP.Bits = FCString::Atoi(**V);
+        }
+
+        BP.TmiSentTs = 0;
+        if (const FString* V = Msg.Tags.Find(TEXT("tmi-sent-ts")))
+        {
+            BP.TmiSentTs = FCString::Atoi64(**V);
+        }
+
+        auto AssignTag = [&](const TCHAR* Key, FString& Out)
+            {
+                if (const FString* V = Msg.Tags.Find(Key))
+                {
+                    Out = *V;
+                }
+            };
+        AssignTag(TEXT("id"), BP.Id);
+        AssignTag(TEXT("reply-parent-msg-id"), BP.ReplyParentMsgId);
+        AssignTag(TEXT("reply-parent-user-id"), BP.ReplyParentUserId);
+        AssignTag(TEXT("reply-parent-display-name"), BP.ReplyParentDisplayName);
+        AssignTag(TEXT("reply-parent-msg-body"), BP.ReplyParentMsgBody);
+        AssignTag(TEXT("user-id"), BP.UserIdTag);
+        AssignTag(TEXT("user-type"), BP.UserType);
+
+        if (BP.UserIdTag.IsEmpty())
+        {
+            // EventSub messages carry no IRC tags
+            BP.UserIdTag = Msg.UserId;
+        }
+        if (Msg.Chatter.IsValid())
+        {
+            BP.Badges = Msg.Chatter->Badges;
+        }
+
+        BP.ChannelId = Msg.ChannelId;
+        BP.ChannelLogin = Msg.ChannelLogin;
+        BP.RawPayload = Msg.RawPayload;
+        BP.ReceivedTime = Msg.ReceivedTime;
+        BP.DispatchTime = Msg.DispatchTime;
+        BP.IngestSeconds = Msg.IngestSeconds;
+        return BP;
+    }
+}
+
 UTwitchChatComponent::UTwitchChatComponent()
 {
     PrimaryComponentTick.bCanEverTick = false;
@@ -12,17 +95,96 @@ void UTwitchChatComponent::BeginPlay()
     Super::BeginPlay();
     MessageHandle = FTwitchChatConnection::Get()
         ->OnMessage.AddUObject(this, &UTwitchChatComponent::HandleIncoming);
+
+    using namespace TwitchChatComponent;
+    Forward<FTwitchChatCheerEvent>(this, OnCheer);
+    Forward<FTwitchChatSubscribeEvent>(this, OnSubscribe);
+    Forward<FTwitchChatResubscribeEvent>(this, OnResubscribe);
+    Forward<FTwitchChatGiftEvent>(this, OnGiftSubscription);
+    Forward<FTwitchChatRaidEvent>(this, OnRaid);
+    Forward<FTwitchChatRedemptionEvent>(this, OnRedemption);
+    Forward<FTwitchChatNotificationEvent>(this, OnChatNotification);
+
+    if (BackfillMessages > 0)
+    {
+        // Queued ahead of any live message, and late enough for the owner's BeginPlay to bind
+        TArray<FBP_TwitchChatMessage> Backfill = GetRecentMessages(BackfillMessages, FString());
+        TWeakObjectPtr<UTwitchChatComponent> WeakThis(this);
+        Async(EAsyncExecution::TaskGraphMainThread, [WeakThis, Backfill = MoveTemp(Backfill)]()
+            {
+                for (const FBP_TwitchChatMessage& BP : Backfill)
+                {
+                    if (!WeakThis.IsValid())
+                    {
+                        return;
+                    }
+                    WeakThis->OnChatMessageReceived.Broadcast(BP);
+                }
+            });
+    }
 }
 
 void UTwitchChatComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
     FTwitchChatConnection::Get()->OnMessage.Remove(MessageHandle);
+
+    FTwitchChatEvents& Events = FTwitchChatEvents::Get();
+    Events.OnCheer.RemoveAll(this);
+    Events.OnSubscribe.RemoveAll(this);
+    Events.OnResubscribe.RemoveAll(this);
+    Events.OnGiftSubscription.RemoveAll(this);
+    Events.OnRaid.RemoveAll(this);
+    Events.OnRedemption.RemoveAll(this);
+    Events.OnChatNotification.RemoveAll(this);
     Super::EndPlay(EndPlayReason);
 }
 
+bool UTwitchChatComponent::AcceptsChannel(const FString& ChannelLoginOrId) const
+{
+    if (ChannelFilter.Num() == 0)
+        return true;
+    return ChannelFilter.ContainsByPredicate([&ChannelLoginOrId](const FString& Entry)
+        {
+            return Entry.Equals(ChannelLoginOrId, ESearchCase::IgnoreCase);
+        });
+}
+
+TArray<FBP_TwitchChatMessage> UTwitchChatComponent::GetRecentMessages(int32 MaxMessages, const FString& User) const
+{
+    // A single channel filters inside the snapshot walk; several take everything and filter here
+    const FTwitchChatRecentHistory& Recent = FTwitchChatRecentHistory::Get();
+    TArray<FTwitchChatMessage> Messages = ChannelFilter.Num() == 1
+        ? Recent.GetRecent(MaxMessages, ChannelFilter[0], User)
+        : Recent.GetRecent(ChannelFilter.Num() == 0 ? MaxMessages : MAX_int32, FString(), User);
+    if (ChannelFilter.Num() > 1)
+    {
+        Messages.RemoveAll([this](const FTwitchChatMessage& Msg)
+            {
+                return !AcceptsChannel(Msg.ChannelLogin) && !AcceptsChannel(Msg.ChannelId);
+            });
+        if (Messages.Num() > MaxMessages)
+        {
+            Messages.RemoveAt(0, Messages.Num() - FMath::Max(MaxMessages, 0));
+        }
+    }
+
+    TArray<FBP_TwitchChatMessage> Out;
+    Out.Reserve(Messages.Num());
+    for (const FTwitchChatMessage& Msg : Messages)
+    {
+        Out.Add(TwitchChatComponent::ToBlueprint(Msg));
+    }
+    return Out;
+}
+
 void UTwitchChatComponent::HandleIncoming(const FTwitchChatMessage& Msg)
 {
-   
+    // Filter before copying the message onto the game-thread queue
+    if (ChannelFilter.Num() > 0 && !AcceptsChannel(Msg.ChannelLogin) && !AcceptsChannel(Msg.ChannelId))
+    {
+        return;
+    }
+
     TWeakObjectPtr<UTwitchChatComponent> WeakThis(this);
 
     Async(EAsyncExecution::TaskGraphMainThread, [WeakThis, Msg]()
@@ -32,62 +194,6 @@ void UTwitchChatComponent::HandleIncoming(const FTwitchChatMessage& Msg)
                 return;
             }
 
-            FBP_TwitchChatMessage BP;
-
-        
-            BP.UserName = Msg.UserName;
-            BP.Message = Msg.Message;
-            BP.UserColor = Msg.UserColor;
-
-           
-            BP.EmoteIds = Msg.EmoteIds;
-
-        
-            BP.EmoteOccurrences = Msg.EmoteIds;
-
-
-            const FString* Val = nullptr;
-            Val = Msg.Tags.Find(TEXT("subscriber"));
-            BP.bSubscriber = (Val && *Val == TEXT("1"));
-            Val = Msg.Tags.Find(TEXT("vip"));
-            BP.bVip = (Val && *Val == TEXT("1"));
-            Val = Msg.Tags.Find(TEXT("mod"));
-            BP.bMod = (Val && *Val == TEXT("1"));
-            Val = Msg.Tags.Find(TEXT("turbo"));
-            BP.bTurbo = (Val && *Val == TEXT("1"));
-
-    
-            BP.Bits = 0;
-            if (const FString* V = Msg.Tags.Find(TEXT("bits")))
-            {
-                BP.Bits = FCString::Atoi(**V);
-            }
-
-       
-            BP.TmiSentTs = 0;
-            if (const FString* V = Msg.Tags.Find(TEXT("tmi-sent-ts")))
-            {
-                BP.TmiSentTs = FCString::Atoi64(**V);
-            }
-
-         
-            auto AssignTag = [&](const TCHAR* Key, FString& Out)
-                {
-                    if (const FString* V = Msg.Tags.Find(Key))
-                    {
-                        Out = *V;
-                    }
-                };
-            AssignTag(TEXT("id"), BP.Id);
-            AssignTag(TEXT("reply-parent-msg-id"), BP.ReplyParentMsgId);
-            AssignTag(TEXT("reply-parent-user-id"), BP.ReplyParentUserId);
-            AssignTag(TEXT("reply-parent-display-name"), BP.ReplyParentDisplayName);
-            AssignTag(TEXT("reply-parent-msg-body"), BP.ReplyParentMsgBody);
-            AssignTag(TEXT("user-id"), BP.UserIdTag);
-            AssignTag(TEXT("user-type"), BP.UserType);
-
-            BP.RawPayload = Msg.RawPayload;
-       
-            WeakThis->OnChatMessageReceived.Broadcast(BP);
+            WeakThis->OnChatMessageReceived.Broadcast(TwitchChatComponent::ToBlueprint(Msg));
         });
 }
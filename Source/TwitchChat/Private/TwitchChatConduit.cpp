@@ -0,0 +1,589 @@
+#include "TwitchChatConduit.h"
+#include "TwitchChatConnection.h"
+#include "TwitchChatSettings.h"
+#include "TwitchChatStats.h"
+#include "TwitchChatMetrics.h"
+#include "TwitchChatHelix.h"
+#include "WebSocketsModule.h"
+#include "IWebSocket.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpResponse.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "HAL/RunnableThread.h"
+#include "Async/Async.h"
+
+//-----------------------------------------------------------------------------
+// Shard worker
+//-----------------------------------------------------------------------------
+class FTwitchChatConduit::FWorker : public FRunnable
+{
+public:
+    FWorker(int32 Index, TFunction<void(FFrame&)> InProcess, TFunction<void(FFrame&)> InDiscard)
+        : Process(MoveTemp(InProcess))
+        , Discard(MoveTemp(InDiscard))
+    {
+        WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+        Thread = FRunnableThread::Create(this, *FString::Printf(TEXT("TwitchChatShard%d"), Index), 0, TPri_Normal);
+    }
+
+    virtual ~FWorker()
+    {
+        Stop();
+        if (Thread)
+        {
+            Thread->WaitForCompletion();
+            delete Thread;
+        }
+        FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+
+        // Stamped frames nobody will parse still have to leave the in-flight count
+        FFrame Frame;
+        while (Frames.Dequeue(Frame))
+        {
+            Discard(Frame);
+        }
+    }
+
+    // Game thread (the only producer)
+    void Enqueue(FFrame&& Frame)
+    {
+        Frames.Enqueue(MoveTemp(Frame));
+        QueueDepth.fetch_add(1, std::memory_order_relaxed);
+        WakeEvent->Trigger();
+    }
+
+    int32 GetQueueDepth() const { return QueueDepth.load(std::memory_order_relaxed); }
+
+    virtual uint32 Run() override
+    {
+        while (!bStopping)
+        {
+            WakeEvent->Wait(FTimespan::FromMilliseconds(100));
+
+            FFrame Frame;
+            while (!bStopping && Frames.Dequeue(Frame))
+            {
+                QueueDepth.fetch_sub(1, std::memory_order_relaxed);
+                Process(Frame);
+            }
+        }
+        return 0;
+    }
+
+    virtual void Stop() override
+    {
+        bStopping = true;
+        WakeEvent->Trigger();
+    }
+
+private:
+    TFunction<void(FFrame&)> Process;
+    TFunction<void(FFrame&)> Discard;
+    TQueue<FFrame, EQueueMode::Spsc> Frames;
+    std::atomic<int32> QueueDepth{ 0 };
+    std::atomic<bool> bStopping{ false };
+    FRunnableThread* Thread = nullptr;
+    FEvent* WakeEvent = nullptr;
+};
+
+//-----------------------------------------------------------------------------
+// Conduit
+//-----------------------------------------------------------------------------
+FTwitchChatConduit::FTwitchChatConduit(FTwitchChatConnection& InConnection)
+    : Connection(InConnection)
+{
+}
+
+FTwitchChatConduit::~FTwitchChatConduit()
+{
+    Stop();
+}
+
+void FTwitchChatConduit::Start(int32 InShardCount)
+{
+    check(IsInGameThread());
+    ShardCount = FMath::Clamp(InShardCount, 1, MaxShards);
+    bStarted = true;
+
+    if (!TickHandle.IsValid())
+    {
+        TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateSP(this, &FTwitchChatConduit::Tick), 0.f);
+    }
+    RequestAppToken();
+}
+
+void FTwitchChatConduit::Stop()
+{
+    bStarted = false;
+    if (TickHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+        TickHandle.Reset();
+    }
+    for (TUniquePtr<FShard>& Shard : Shards)
+    {
+        CloseShardSocket(Shard->Socket);
+        CloseShardSocket(Shard->PendingSocket);
+        Shard->Worker.Reset();
+    }
+    Shards.Empty();
+
+    // Workers are joined, so nothing produces any more
+    Parsed.Empty();
+    ReorderHeap.Empty();
+}
+
+bool FTwitchChatConduit::IsReady() const
+{
+    return !ConduitId.IsEmpty() && GetNumEnabledShards() > 0;
+}
+
+int32 FTwitchChatConduit::GetNumEnabledShards() const
+{
+    int32 Count = 0;
+    for (const TUniquePtr<FShard>& Shard : Shards)
+    {
+        Count += Shard->bEnabled ? 1 : 0;
+    }
+    return Count;
+}
+
+TArray<FTwitchChatConduit::FShardStatus> FTwitchChatConduit::GetShardStatus() const
+{
+    TArray<FShardStatus> Out;
+    for (const TUniquePtr<FShard>& Shard : Shards)
+    {
+        FShardStatus& Status = Out.AddDefaulted_GetRef();
+        Status.Index = Shard->Index;
+        Status.SessionId = Shard->SessionId;
+        Status.bEnabled = Shard->bEnabled;
+        Status.FramesReceived = Shard->FramesReceived.load(std::memory_order_relaxed);
+        Status.QueueDepth = Shard->Worker ? Shard->Worker->GetQueueDepth() : 0;
+        Status.Reconnects = Shard->Reconnects;
+    }
+    return Out;
+}
+
+TSharedRef<IHttpRequest, ESPMode::ThreadSafe> FTwitchChatConduit::MakeHelixRequest(const FString& Verb, const FString& Path) const
+{
+    const UTwitchChatSettings* S = GetDefault<UTwitchChatSettings>();
+    auto Req = FTwitchChatHelix::MakeRequest(Verb, Path);
+    Req->SetHeader(TEXT("Client-Id"), S->ClientId);
+    Req->SetHeader(TEXT("Authorization"), TEXT("Bearer ") + AppToken);
+    Req->SetHeader(TEXT("Content-Type"), TEXT("application/json"));
+    return Req;
+}
+
+void FTwitchChatConduit::RequestAppToken()
+{
+    const UTwitchChatSettings* S = GetDefault<UTwitchChatSettings>();
+    auto Req = FHttpModule::Get().CreateRequest();
+    Req->SetURL(S->GetAuthBaseUrl() + TEXT("/oauth2/token"));
+    Req->SetVerb(TEXT("POST"));
+    Req->SetHeader(TEXT("Content-Type"), TEXT("application/x-www-form-urlencoded"));
+    Req->SetContentAsString(FString::Printf(
+        TEXT("client_id=%s&client_secret=%s&grant_type=client_credentials"), *S->ClientId, *S->ClientSecret));
+
+    Req->OnProcessRequestComplete().BindLambda(
+        [Self = AsShared()](FHttpRequestPtr, FHttpResponsePtr Resp, bool bOK)
+        {
+            if (!Self->bStarted)
+                return;
+
+            TSharedPtr<FJsonObject> J;
+            TSharedRef<TJsonReader<>> R = TJsonReaderFactory<>::Create(Resp.IsValid() ? Resp->GetContentAsString() : FString());
+            if (!bOK || !Resp.IsValid() || Resp->GetResponseCode() != 200
+                || !FJsonSerializer::Deserialize(R, J) || !J->TryGetStringField(TEXT("access_token"), Self->AppToken))
+            {
+                Self->Connection.HandleSessionLost(TEXT("conduit: app access token request failed"));
+                return;
+            }
+            Self->AcquireConduit();
+        });
+    Req->ProcessRequest();
+}
+
+void FTwitchChatConduit::AcquireConduit()
+{
+    // Conduits outlive the process; reuse ours rather than piling up new ones (Twitch allows five per client)
+    auto Req = MakeHelixRequest(TEXT("GET"), TEXT("/eventsub/conduits"));
+    FTwitchChatHelix::Get()->Send(Req,
+        [Self = AsShared()](FHttpRequestPtr, FHttpResponsePtr Resp, bool bOK)
+        {
+            if (!Self->bStarted)
+                return;
+
+            FString ExistingId;
+            int32 ExistingShards = 0;
+            TSharedPtr<FJsonObject> J;
+            const TArray<TSharedPtr<FJsonValue>>* Data = nullptr;
+            TSharedRef<TJsonReader<>> R = TJsonReaderFactory<>::Create(Resp.IsValid() ? Resp->GetContentAsString() : FString());
+            if (bOK && Resp.IsValid() && Resp->GetResponseCode() == 200
+                && FJsonSerializer::Deserialize(R, J) && J->TryGetArrayField(TEXT("data"), Data) && Data->Num() > 0)
+            {
+                (*Data)[0]->AsObject()->TryGetStringField(TEXT("id"), ExistingId);
+                (*Data)[0]->AsObject()->TryGetNumberField(TEXT("shard_count"), ExistingShards);
+            }
+
+            TSharedPtr<FJsonObject> Body = MakeShared<FJsonObject>();
+            Body->SetNumberField(TEXT("shard_count"), Self->ShardCount);
+            if (!ExistingId.IsEmpty())
+            {
+                if (ExistingShards == Self->ShardCount)
+                {
+                    Self->ConduitId = ExistingId;
+                    Self->OpenShards();
+                    return;
+                }
+                Body->SetStringField(TEXT("id"), ExistingId);
+            }
+
+            FString BodyText;
+            TSharedRef<TJsonWriter<>> W = TJsonWriterFactory<>::Create(&BodyText);
+            FJsonSerializer::Serialize(Body.ToSharedRef(), W);
+
+            auto Create = Self->MakeHelixRequest(ExistingId.IsEmpty() ? TEXT("POST") : TEXT("PATCH"), TEXT("/eventsub/conduits"));
+            Create->SetContentAsString(BodyText);
+            FTwitchChatHelix::Get()->Send(Create,
+                [Self](FHttpRequestPtr, FHttpResponsePtr Resp, bool bOK)
+                {
+                    if (!Self->bStarted)
+                        return;
+
+                    TSharedPtr<FJsonObject> J;
+                    const TArray<TSharedPtr<FJsonValue>>* Data = nullptr;
+                    TSharedRef<TJsonReader<>> R = TJsonReaderFactory<>::Create(Resp.IsValid() ? Resp->GetContentAsString() : FString());
+                    if (!bOK || !Resp.IsValid() || !EHttpResponseCodes::IsOk(Resp->GetResponseCode())
+                        || !FJsonSerializer::Deserialize(R, J) || !J->TryGetArrayField(TEXT("data"), Data) || Data->Num() == 0
+                        || !(*Data)[0]->AsObject()->TryGetStringField(TEXT("id"), Self->ConduitId))
+                    {
+                        UE_LOG(LogTwitchChat, Error, TEXT("Conduit setup failed: %s"), Resp.IsValid() ? *Resp->GetContentAsString() : TEXT("no-response"));
+                        Self->Connection.HandleSessionLost(TEXT("conduit: create failed"));
+                        return;
+                    }
+                    Self->OpenShards();
+                }, ETwitchHelixBucket::App);
+        }, ETwitchHelixBucket::App);
+}
+
+void FTwitchChatConduit::OpenShards()
+{
+    UE_LOG(LogTwitchChat, Log, TEXT("Conduit %s: opening %d shards"), *ConduitId, ShardCount);
+
+    const UTwitchChatSettings* S = GetDefault<UTwitchChatSettings>();
+    const FString Url = FString::Printf(TEXT("%s?keepalive_timeout_seconds=%d"),
+        *S->GetEventSubUrl(), FMath::Clamp(S->KeepaliveTimeoutSeconds, 10, 600));
+
+    for (int32 i = 0; i < ShardCount; ++i)
+    {
+        TUniquePtr<FShard>& Shard = Shards.Add_GetRef(MakeUnique<FShard>());
+        Shard->Index = i;
+        Shard->Worker = MakeUnique<FWorker>(i,
+            [this, i](FFrame& Frame)
+            {
+                Connection.ProcessFrame(Frame.Text, Frame.Stamp,
+                    [this, i](const FString& MessageType, TSharedPtr<FJsonObject> Root)
+                    {
+                        AsyncTask(ENamedThreads::GameThread, [Weak = AsWeak(), i, MessageType, Root]()
+                            {
+                                if (TSharedPtr<FTwitchChatConduit> Self = Weak.Pin())
+                                    Self->HandleShardSession(i, MessageType, Root);
+                            });
+                    },
+                    [this](FTwitchChatMessage&& Message)
+                    {
+                        Parsed.Enqueue(MoveTemp(Message));
+                    },
+                    [this, &Frame](TUniqueFunction<void()>&& Broadcast)
+                    {
+                        Connection.Post(Frame.Stamp.Epoch, MoveTemp(Broadcast));
+                    });
+            },
+            [this](FFrame& /*Frame*/)
+            {
+                Connection.FramesInFlight.fetch_sub(1, std::memory_order_relaxed);
+                DEC_DWORD_STAT(STAT_TwitchChat_FramesInFlight);
+            });
+        OpenShardSocket(*Shard, Url, /*bPending=*/false);
+    }
+}
+
+void FTwitchChatConduit::OpenShardSocket(FShard& Shard, const FString& Url, bool bPending)
+{
+    TSharedPtr<IWebSocket> NewSocket = FWebSocketsModule::Get().CreateWebSocket(Url, TEXT(""));
+    TWeakPtr<IWebSocket> WeakSocket = NewSocket;
+    TWeakPtr<FTwitchChatConduit> WeakSelf = AsWeak();
+    const int32 Index = Shard.Index;
+
+    NewSocket->OnConnectionError().AddLambda([WeakSelf, WeakSocket, Index](const FString& Err)
+        {
+            TSharedPtr<FTwitchChatConduit> Self = WeakSelf.Pin();
+            if (!Self || !Self->IsShardSocket(Index, WeakSocket))
+                return;
+            FTwitchChatMetrics::Inc(ETwitchChatCounter::SocketErrors);
+            Self->HandleShardLost(*Self->Shards[Index], Err);
+        });
+
+    NewSocket->OnClosed().AddLambda([WeakSelf, WeakSocket, Index](int32 Code, const FString& Reason, bool)
+        {
+            TSharedPtr<FTwitchChatConduit> Self = WeakSelf.Pin();
+            if (!Self || !Self->IsShardSocket(Index, WeakSocket))
+                return;
+            FTwitchChatMetrics::Inc(ETwitchChatCounter::SocketClosed);
+
+            // The migrating session may close before its replacement says hello
+            FShard& Shard = *Self->Shards[Index];
+            if (Shard.PendingSocket.IsValid() && WeakSocket.Pin() == Shard.Socket)
+            {
+                Shard.Socket.Reset();
+                return;
+            }
+            Self->HandleShardLost(Shard, FString::Printf(TEXT("closed %d %s"), Code, *Reason));
+        });
+
+    NewSocket->OnMessage().AddLambda([WeakSelf, WeakSocket, Index](const FString& Msg)
+        {
+            TSharedPtr<FTwitchChatConduit> Self = WeakSelf.Pin();
+            if (Self && Self->IsShardSocket(Index, WeakSocket))
+                Self->HandleShardFrame(Index, Msg);
+        });
+
+    TSharedRef<TArray<uint8>> BinaryFrame = MakeShared<TArray<uint8>>();
+    NewSocket->OnBinaryMessage().AddLambda([WeakSelf, WeakSocket, Index, BinaryFrame](const void* Data, SIZE_T Size, bool bIsLastFragment)
+        {
+            BinaryFrame->Append(static_cast<const uint8*>(Data), Size);
+            if (!bIsLastFragment)
+                return;
+
+            FUTF8ToTCHAR Text(reinterpret_cast<const ANSICHAR*>(BinaryFrame->GetData()), BinaryFrame->Num());
+            BinaryFrame->Reset();
+            TSharedPtr<FTwitchChatConduit> Self = WeakSelf.Pin();
+            if (Self && Self->IsShardSocket(Index, WeakSocket))
+                Self->HandleShardFrame(Index, FString(Text.Length(), Text.Get()));
+        });
+
+    (bPending ? Shard.PendingSocket : Shard.Socket) = NewSocket;
+    Shard.LastActivityTime = FPlatformTime::Seconds();
+    NewSocket->Connect();
+}
+
+void FTwitchChatConduit::CloseShardSocket(TSharedPtr<IWebSocket>& InSocket)
+{
+    if (TSharedPtr<IWebSocket> Old = MoveTemp(InSocket))
+    {
+        Old->Close();
+    }
+}
+
+bool FTwitchChatConduit::IsShardSocket(int32 Index, const TWeakPtr<IWebSocket>& InSocket) const
+{
+    const TSharedPtr<IWebSocket> Pinned = InSocket.Pin();
+    return Pinned.IsValid() && Shards.IsValidIndex(Index)
+        && (Pinned == Shards[Index]->Socket || Pinned == Shards[Index]->PendingSocket);
+}
+
+void FTwitchChatConduit::HandleShardFrame(int32 Index, const FString& Frame)
+{
+    FShard& Shard = *Shards[Index];
+    Shard.LastActivityTime = FPlatformTime::Seconds();
+    Shard.FramesReceived.fetch_add(1, std::memory_order_relaxed);
+    Connection.CountFrame(Frame);
+    Shard.Worker->Enqueue(FFrame{ Frame, Connection.StampFrame() });
+}
+
+void FTwitchChatConduit::HandleShardSession(int32 Index, const FString& MessageType, TSharedPtr<FJsonObject> Root)
+{
+    if (!bStarted || !Shards.IsValidIndex(Index))
+        return;
+
+    if (MessageType == TEXT("revocation"))
+    {
+        // Subscriptions are the connection's business
+        Connection.HandleSessionMessage(MessageType, Root);
+        return;
+    }
+
+    FShard& Shard = *Shards[Index];
+    const TSharedPtr<FJsonObject>* Payload = nullptr;
+    const TSharedPtr<FJsonObject>* Session = nullptr;
+    if (!Root->TryGetObjectField(TEXT("payload"), Payload) || !(*Payload)->TryGetObjectField(TEXT("session"), Session))
+        return;
+
+    if (MessageType == TEXT("session_reconnect"))
+    {
+        FString Url;
+        if ((*Session)->TryGetStringField(TEXT("reconnect_url"), Url) && !Shard.PendingSocket.IsValid())
+        {
+            UE_LOG(LogTwitchChat, Log, TEXT("Conduit shard %d: session_reconnect"), Index);
+            Shard.MigrationStartTime = FPlatformTime::Seconds();
+            OpenShardSocket(Shard, Url, /*bPending=*/true);
+        }
+        return;
+    }
+
+    // session_welcome
+    int32 Keepalive = 0;
+    if ((*Session)->TryGetNumberField(TEXT("keepalive_timeout_seconds"), Keepalive) && Keepalive > 0)
+    {
+        Shard.KeepaliveSeconds = Keepalive;
+    }
+    FString NewSessionId;
+    (*Session)->TryGetStringField(TEXT("id"), NewSessionId);
+
+    if (Shard.PendingSocket.IsValid())
+    {
+        CloseShardSocket(Shard.Socket);
+        Shard.Socket = MoveTemp(Shard.PendingSocket);
+        FTwitchChatMetrics::Inc(ETwitchChatCounter::SessionMigrations);
+    }
+
+    if (NewSessionId != Shard.SessionId || !Shard.bEnabled)
+    {
+        Shard.SessionId = NewSessionId;
+        BindShard(Shard);
+    }
+}
+
+void FTwitchChatConduit::BindShard(FShard& Shard)
+{
+    TSharedPtr<FJsonObject> Transport = MakeShared<FJsonObject>();
+    Transport->SetStringField(TEXT("method"), TEXT("websocket"));
+    Transport->SetStringField(TEXT("session_id"), Shard.SessionId);
+    TSharedPtr<FJsonObject> Entry = MakeShared<FJsonObject>();
+    Entry->SetStringField(TEXT("id"), FString::FromInt(Shard.Index));
+    Entry->SetObjectField(TEXT("transport"), Transport);
+    TSharedPtr<FJsonObject> Body = MakeShared<FJsonObject>();
+    Body->SetStringField(TEXT("conduit_id"), ConduitId);
+    TArray<TSharedPtr<FJsonValue>> ShardList;
+    ShardList.Add(MakeShared<FJsonValueObject>(Entry));
+    Body->SetArrayField(TEXT("shards"), ShardList);
+
+    FString BodyText;
+    TSharedRef<TJsonWriter<>> W = TJsonWriterFactory<>::Create(&BodyText);
+    FJsonSerializer::Serialize(Body.ToSharedRef(), W);
+
+    auto Req = MakeHelixRequest(TEXT("PATCH"), TEXT("/eventsub/conduits/shards"));
+    Req->SetContentAsString(BodyText);
+    FTwitchChatHelix::Get()->Send(Req,
+        [Self = AsShared(), Index = Shard.Index, SessionId = Shard.SessionId](FHttpRequestPtr, FHttpResponsePtr Resp, bool bOK)
+        {
+            if (!Self->bStarted || !Self->Shards.IsValidIndex(Index))
+                return;
+            FShard& Shard = *Self->Shards[Index];
+            if (Shard.SessionId != SessionId)
+                return;   // superseded by a newer session
+
+            // 202 lists per-shard failures under "errors"
+            TSharedPtr<FJsonObject> J;
+            const TArray<TSharedPtr<FJsonValue>>* Errors = nullptr;
+            TSharedRef<TJsonReader<>> R = TJsonReaderFactory<>::Create(Resp.IsValid() ? Resp->GetContentAsString() : FString());
+            const bool bAccepted = bOK && Resp.IsValid() && EHttpResponseCodes::IsOk(Resp->GetResponseCode())
+                && !(FJsonSerializer::Deserialize(R, J) && J->TryGetArrayField(TEXT("errors"), Errors) && Errors->Num() > 0);
+            if (!bAccepted)
+            {
+                Self->HandleShardLost(Shard, FString::Printf(TEXT("shard update rejected: %s"),
+                    Resp.IsValid() ? *Resp->GetContentAsString() : TEXT("no-response")));
+                return;
+            }
+
+            const bool bWasReady = Self->IsReady();
+            Shard.bEnabled = true;
+            Shard.ReconnectAttempt = 0;
+            UE_LOG(LogTwitchChat, Log, TEXT("Conduit shard %d bound to session %s"), Index, *SessionId);
+
+            if (!bWasReady)
+            {
+                Self->Connection.MarkConnectStage(ETwitchChatConnectStage::SessionReady);
+                if (Self->Connection.GetState() == ETwitchChatConnectionState::Connecting)
+                {
+                    Self->Connection.SetState(ETwitchChatConnectionState::Subscribing);
+                }
+                Self->Connection.TrySubscribe();
+            }
+        }, ETwitchHelixBucket::App);
+}
+
+void FTwitchChatConduit::HandleShardLost(FShard& Shard, const FString& Reason)
+{
+    if (Shard.bBackoff)
+        return;
+
+    CloseShardSocket(Shard.Socket);
+    CloseShardSocket(Shard.PendingSocket);
+    Shard.SessionId.Empty();
+    Shard.bEnabled = false;
+    Shard.KeepaliveSeconds = 0;
+
+    // Only this shard backs off; Twitch routes its share to the shards still enabled
+    const double Delay = FTwitchChatConnection::GetReconnectDelay(Shard.ReconnectAttempt++);
+    UE_LOG(LogTwitchChat, Warning, TEXT("Conduit shard %d lost (%s); reconnect in %.2f s"), Shard.Index, *Reason, Delay);
+    Shard.NextReconnectTime = FPlatformTime::Seconds() + Delay;
+    Shard.bBackoff = true;
+}
+
+bool FTwitchChatConduit::Tick(float /*DeltaTime*/)
+{
+    const double Now = FPlatformTime::Seconds();
+    const UTwitchChatSettings* S = GetDefault<UTwitchChatSettings>();
+
+    for (TUniquePtr<FShard>& ShardPtr : Shards)
+    {
+        FShard& Shard = *ShardPtr;
+        if (Shard.bBackoff)
+        {
+            if (Now >= Shard.NextReconnectTime)
+            {
+                Shard.bBackoff = false;
+                ++Shard.Reconnects;
+                FTwitchChatMetrics::Inc(ETwitchChatCounter::Reconnects);
+                OpenShardSocket(Shard, FString::Printf(TEXT("%s?keepalive_timeout_seconds=%d"),
+                    *S->GetEventSubUrl(), FMath::Clamp(S->KeepaliveTimeoutSeconds, 10, 600)), /*bPending=*/false);
+            }
+            continue;
+        }
+
+        const int32 Keepalive = Shard.KeepaliveSeconds > 0 ? Shard.KeepaliveSeconds : FMath::Clamp(S->KeepaliveTimeoutSeconds, 10, 600);
+        if (Now - Shard.LastActivityTime > Keepalive + 2.0)
+        {
+            FTwitchChatMetrics::Inc(ETwitchChatCounter::KeepaliveTimeouts);
+            HandleShardLost(Shard, FString::Printf(TEXT("no frames for %.1f s"), Now - Shard.LastActivityTime));
+        }
+        else if (Shard.PendingSocket.IsValid() && Now - Shard.MigrationStartTime > 30.0)
+        {
+            HandleShardLost(Shard, TEXT("session_reconnect target never sent session_welcome"));
+        }
+    }
+
+    ReleaseMessages(/*bFlushAll=*/false);
+    return true;
+}
+
+void FTwitchChatConduit::ReleaseMessages(bool bFlushAll)
+{
+    auto Earlier = [](const FPendingMessage& A, const FPendingMessage& B)
+        {
+            return A.Message.Timestamp != B.Message.Timestamp
+                ? A.Message.Timestamp < B.Message.Timestamp
+                : A.Message.Serial < B.Message.Serial;
+        };
+
+    // A single shard is already in order
+    const double Window = Shards.Num() > 1 ? ReorderWindowSeconds : 0.0;
+
+    FTwitchChatMessage Message;
+    while (Parsed.Dequeue(Message))
+    {
+        const double ReleaseTime = Message.ReceivedTime + Window;
+        ReorderHeap.HeapPush(FPendingMessage{ MoveTemp(Message), ReleaseTime }, Earlier);
+    }
+
+    const double Now = FPlatformTime::Seconds();
+    while (ReorderHeap.Num() > 0 && (bFlushAll || ReorderHeap.HeapTop().ReleaseTime <= Now))
+    {
+        FPendingMessage Next;
+        ReorderHeap.HeapPop(Next, Earlier);
+        Connection.DispatchWhenReady(MoveTemp(Next.Message));
+    }
+}
@@ -2,6 +2,20 @@
 #include "TwitchChatConnection.h"
 #include "TwitchChatSettings.h"
 #include "TwitchChatMessage.h"
+#include "TwitchChatHistoryLog.h"
+#include "TwitchChatSearchIndex.h"
+#include "TwitchChatTrafficRecorder.h"
+#include "TwitchChatReplaySource.h"
+#include "TwitchChatStats.h"
+#include "TwitchChatLatency.h"
+#include "TwitchChatMetrics.h"
+#include "TwitchChatConduit.h"
+#include "TwitchChatIrc.h"
+#include "TwitchChatAuth.h"
+#include "TwitchChatHelix.h"
+#include "TwitchChatWarmStart.h"
+#include "TwitchChatEvents.h"
+#include "TwitchChatRecentHistory.h"
 #include "WebSocketsModule.h"
 #include "HttpModule.h"
 #include "Interfaces/IHttpRequest.h"
@@ -9,7 +23,12 @@
 #include "Dom/JsonObject.h"
 #include "Serialization/JsonReader.h"
 #include "Serialization/JsonSerializer.h"
-#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/ScopeExit.h"
+#include "Misc/MemStack.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Containers/Queue.h"
 
 #include "Misc/Paths.h"
 #include "Misc/FileHelper.h"
@@ -17,482 +36,1962 @@
 
 DEFINE_LOG_CATEGORY(LogTwitchChat);
 
+//-----------------------------------------------------------------------------
+// Frame parser
+//-----------------------------------------------------------------------------
+// One thread for the connection's life, so frames are parsed and posted in the order they came in
+// (replays come out the same every run) and the parser's per-thread scratch is reused frame to frame.
+class FTwitchChatConnection::FParseWorker : public FRunnable
+{
+public:
+    explicit FParseWorker(FTwitchChatConnection& InConnection)
+        : Connection(InConnection)
+    {
+        WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+        Thread = FRunnableThread::Create(this, TEXT("TwitchChatParse"), 0, TPri_Normal);
+    }
+
+    virtual ~FParseWorker()
+    {
+        Stop();
+        if (Thread)
+        {
+            Thread->WaitForCompletion();
+            delete Thread;
+        }
+        FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+
+        // Stamped frames nobody will parse still have to leave the in-flight count
+        FFrame Frame;
+        while (Frames.Dequeue(Frame))
+        {
+            Connection.FramesInFlight.fetch_sub(1, std::memory_order_relaxed);
+            DEC_DWORD_STAT(STAT_TwitchChat_FramesInFlight);
+        }
+    }
+
+    // Any thread: the socket's on the game thread, IngestFrame's on the replay or benchmark thread
+    void Enqueue(const FString& Text, const FFrameStamp& Stamp)
+    {
+        Frames.Enqueue({ Text, Stamp });
+        WakeEvent->Trigger();
+    }
+
+    // IRC reader thread. Its own queue, so IRC messages keep their order among themselves
+    void EnqueueIrc(FTwitchChatMessage&& Message, uint32 SessionEpoch)
+    {
+        IrcMessages.Enqueue({ MoveTemp(Message), SessionEpoch });
+        WakeEvent->Trigger();
+    }
+
+    virtual uint32 Run() override
+    {
+        while (!bStopping)
+        {
+            WakeEvent->Wait(FTimespan::FromMilliseconds(100));
+
+            FFrame Frame;
+            while (!bStopping && Frames.Dequeue(Frame))
+            {
+                Connection.ParseAndPost(Frame.Text, Frame.Stamp);
+            }
+
+            FIrcMessage Irc;
+            while (!bStopping && IrcMessages.Dequeue(Irc))
+            {
+                Connection.FinishIrcMessage(MoveTemp(Irc.Message), Irc.Epoch);
+            }
+        }
+        return 0;
+    }
+
+    virtual void Stop() override
+    {
+        bStopping = true;
+        WakeEvent->Trigger();
+    }
+
+private:
+    struct FFrame
+    {
+        FString Text;
+        FFrameStamp Stamp;
+    };
+
+    struct FIrcMessage
+    {
+        FTwitchChatMessage Message;
+        uint32 Epoch = 0;
+    };
+
+    FTwitchChatConnection& Connection;
+    TQueue<FFrame, EQueueMode::Mpsc> Frames;
+    TQueue<FIrcMessage, EQueueMode::Spsc> IrcMessages;
+    std::atomic<bool> bStopping{ false };
+    FRunnableThread* Thread = nullptr;
+    FEvent* WakeEvent = nullptr;
+};
+
 TSharedRef<FTwitchChatConnection> FTwitchChatConnection::Get()
 {
     static TSharedRef<FTwitchChatConnection> Instance = MakeShared<FTwitchChatConnection>();
     return Instance;
 }
 
-FTwitchChatConnection::FTwitchChatConnection() {}
+FTwitchChatConnection::FTwitchChatConnection()
+    : Executor(MakeShared<FTwitchChatExecutor>())
+    , ParseWorker(MakeUnique<FParseWorker>(*this))
+{
+}
 FTwitchChatConnection::~FTwitchChatConnection()
+{
+    // Static teardown: the core ticker may already be gone and nobody is listening for state
+    CloseSocket(Socket);
+    CloseSocket(PendingSocket);
+}
+
+void FTwitchChatConnection::Shutdown()
 {
     Disconnect();
+    ParseWorker.Reset();
 }
 
 void FTwitchChatConnection::StartDeviceFlowInteractive()
 {
-   
-    bAutoConnect = false;
-    StartDeviceFlow();
+    FTwitchChatAuth::Get()->StartDeviceFlow({});
 }
 
 
 bool FTwitchChatConnection::Connect(
     const FString& InUser,
-    const FString& /*InToken*/,
+    const FString& InToken,
     const FString& InChannel,
-    int32 /*InPort*/
+    int32 InPort
 )
 {
+    if (!IsInGameThread())
+    {
+        Executor->Post([this, InUser, InToken, InChannel, InPort]()
+            {
+                Connect(InUser, InToken, InChannel, InPort);
+            });
+        return true;
+    }
+
+    FTwitchChatMetrics::Inc(ETwitchChatCounter::ConnectAttempts);
     Disconnect();
+    FMemory::Memzero(ConnectStageTimes);
+    ConnectStageTimes[int32(ETwitchChatConnectStage::Connect)] = FPlatformTime::Seconds();
+    bWarmStart = false;
     BotLogin = InUser;
-    ChannelLogin = InChannel.ToLower();
+    Channels.Reset();
+    for (const FString& Login : ParseChannelList(InChannel))
+    {
+        AddChannel(Login);
+    }
     BeginAuthFlow();
     return true;
 }
 
 void FTwitchChatConnection::BeginAuthFlow()
 {
-    const UTwitchChatSettings* S = GetDefault<UTwitchChatSettings>();
-    FString ConfigToken = S->AccessToken.TrimStartAndEnd();
+    TSharedRef<FTwitchChatAuth> Auth = FTwitchChatAuth::Get();
+    Auth->LoadFromSettings();
+    SetState(ETwitchChatConnectionState::Authorizing);
+
+    // Disconnect or a new Connect while waiting moves the state on; the answer is then stale
+    TFunction<void(bool)> OnAuthorized = [this](bool bAuthorized)
+        {
+            if (State != ETwitchChatConnectionState::Authorizing)
+                return;
+            if (bAuthorized)
+            {
+                MarkConnectStage(ETwitchChatConnectStage::TokenReady);
+                OpenSession();
+            }
+            else
+            {
+                SetState(ETwitchChatConnectionState::Disconnected);
+            }
+        };
 
-    if (ConfigToken.IsEmpty())
+    if (!Auth->HasToken())
     {
-   
-        bAutoConnect = true;
-        StartDeviceFlow();
+        Auth->StartDeviceFlow(MoveTemp(OnAuthorized));
+        return;
     }
-    else
+    if (Auth->IsWarm())
     {
-    
-        bAutoConnect = false;
-
-        OAuthToken = ConfigToken.StartsWith(TEXT("oauth:"))
-            ? ConfigToken.Mid(6)
-            : ConfigToken;
+        // Last run validated this token: open the socket now and confirm the token alongside it
+        bWarmStart = true;
+        Auth->WhenValid([this](bool bValid)
+            {
+                if (bValid)
+                {
+                    MarkConnectStage(ETwitchChatConnectStage::TokenReady);
+                }
+                else if (State != ETwitchChatConnectionState::Disconnected)
+                {
+                    UE_LOG(LogTwitchChat, Error, TEXT("Saved access token was rejected and could not be refreshed"));
+                    Disconnect();
+                }
+            });
+        OpenSession();
+        return;
+    }
+    Auth->WhenValid(MoveTemp(OnAuthorized));
+}
 
-     
-        QueryUserId(BotLogin, [this](const FString& Id) { BotUserId = Id; bGotBotId = true; TrySubscribe(); });
-        QueryUserId(ChannelLogin, [this](const FString& Id) { BroadcasterUserId = Id; bGotBroadcasterId = true; TrySubscribe(); });
-        SetupWebSocket();
+void FTwitchChatConnection::OpenSession()
+{
+    // Validation already told us who the token belongs to
+    const TSharedRef<FTwitchChatAuth> Auth = FTwitchChatAuth::Get();
+    if (BotLogin.IsEmpty())
+        BotLogin = Auth->GetLogin();
+    if (!Auth->GetUserId().IsEmpty())
+        UserIdCache.Add(Auth->GetLogin().ToLower(), Auth->GetUserId());
+    UserIdCache.Append(FTwitchChatWarmStart::Get().GetUserIds());
+
+    // Cached ids make these synchronous; only a cold cache goes to Helix
+    if (!bGotBotId)
+    {
+        QueryUserId(BotLogin, [this, SessionEpoch = GetEpoch()](const FString& Id)
+            {
+                if (SessionEpoch != GetEpoch())
+                    return;     // answer for a connect that has since been torn down
+                BotUserId = Id;
+                bGotBotId = true;
+                TrySubscribe();
+            });
+    }
+    for (const FChannel& Channel : Channels)
+    {
+        ResolveChannel(Channel.Login);
     }
+    SetupWebSocket();
 }
 
-void FTwitchChatConnection::StartDeviceFlow()
+
+void FTwitchChatConnection::Disconnect()
 {
-    const UTwitchChatSettings* S = GetDefault<UTwitchChatSettings>();
-    auto Req = FHttpModule::Get().CreateRequest();
-    Req->SetURL(TEXT("https://id.twitch.tv/oauth2/device"));
-    Req->SetVerb(TEXT("POST"));
-    Req->SetHeader(TEXT("Content-Type"), TEXT("application/x-www-form-urlencoded"));
+    if (!IsInGameThread())
+    {
+        Executor->Post([this]()
+            {
+                Disconnect();
+            });
+        return;
+    }
 
+    if (TickHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+        TickHandle.Reset();
+    }
+    if (ParkedTickHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(ParkedTickHandle);
+        ParkedTickHandle.Reset();
+    }
+    ParkedByChannel.Reset();
+    CloseSocket(Socket);
+    CloseSocket(PendingSocket);
+    StopConduit();
+    StopIrc();
+    Epoch.fetch_add(1, std::memory_order_relaxed);
+    ReconnectAttempt = 0;
+    SessionKeepaliveSeconds = 0;
+    SetState(ETwitchChatConnectionState::Disconnected);
+    ResetSubscriptions();
+    for (FChannel& Channel : Channels)
+    {
+        Channel.BroadcasterId.Empty();
+        Channel.bResolving = false;
+    }
+    BotUserId.Empty();
+    SessionId.Empty();
+    bGotBotId = bGotWelcome = false;
+}
 
-    FString Body = FString::Printf(TEXT("client_id=%s&scopes=user%%3Aread%%3Achat"), *S->ClientId);
-    Req->SetContentAsString(Body);
+//-----------------------------------------------------------------------------
+// Channels
+//-----------------------------------------------------------------------------
+TArray<FString> FTwitchChatConnection::ParseChannelList(const FString& List)
+{
+    static const TCHAR* Delimiters[] = { TEXT(","), TEXT(" "), TEXT(";"), TEXT("\t") };
+    TArray<FString> Parts;
+    List.ParseIntoArray(Parts, Delimiters, UE_ARRAY_COUNT(Delimiters), /*InCullEmpty=*/true);
 
-    Req->OnProcessRequestComplete().BindLambda(
-        [this](FHttpRequestPtr /*R*/, FHttpResponsePtr Resp, bool bOK)
+    TArray<FString> Logins;
+    for (FString& Part : Parts)
+    {
+        Part.RemoveFromStart(TEXT("#"));
+        if (!Part.IsEmpty())
         {
-            if (!bOK || !Resp.IsValid() || Resp->GetResponseCode() != 200)
-            {
-                UE_LOG(LogTwitchChat, Error,
-                    TEXT("Device flow start failed: %s"),
-                    Resp.IsValid() ? *Resp->GetContentAsString() : TEXT("no-response"));
-                return;
-            }
+            Logins.AddUnique(Part.ToLower());
+        }
+    }
+    return Logins;
+}
 
-            TSharedPtr<FJsonObject> Json;
-            TSharedRef<TJsonReader<>> Reader =
-                TJsonReaderFactory<>::Create(Resp->GetContentAsString());
-            if (!FJsonSerializer::Deserialize(Reader, Json))
-                return;
+FTwitchChatConnection::FChannel* FTwitchChatConnection::FindChannel(const FString& Login)
+{
+    return Channels.FindByPredicate([&Login](const FChannel& Channel) { return Channel.Login.Equals(Login, ESearchCase::IgnoreCase); });
+}
 
-         
-            DeviceCode = Json->GetStringField(TEXT("device_code"));
-            UserCode = Json->GetStringField(TEXT("user_code"));
-            VerificationUri = Json->GetStringField(TEXT("verification_uri"));
-            PollIntervalSeconds = Json->GetIntegerField(TEXT("interval"));
-            DeviceFlowExpiry = FPlatformTime::Seconds() + Json->GetNumberField(TEXT("expires_in"));
+const FTwitchChatConnection::FChannel* FTwitchChatConnection::FindChannel(const FString& Login) const
+{
+    return Channels.FindByPredicate([&Login](const FChannel& Channel) { return Channel.Login.Equals(Login, ESearchCase::IgnoreCase); });
+}
 
-            UE_LOG(LogTwitchChat, Log,
-                TEXT("Device auth: go to %s and enter code %s"),
-                *VerificationUri, *UserCode);
+bool FTwitchChatConnection::AddChannel(const FString& InLogin)
+{
+    check(IsInGameThread());
+    FString Login = InLogin.TrimStartAndEnd().ToLower();
+    Login.RemoveFromStart(TEXT("#"));
+    if (Login.IsEmpty() || FindChannel(Login))
+        return false;
 
-            AsyncTask(ENamedThreads::GameThread, [this]()
-                {
-                    FPlatformProcess::LaunchURL(*VerificationUri, nullptr, nullptr);
-                });
+    if (Channels.Num() >= MaxChannelsPerSession)
+    {
+        UE_LOG(LogTwitchChat, Warning, TEXT("Cannot join %s: a session holds at most %d channels"), *Login, MaxChannelsPerSession);
+        return false;
+    }
 
-         
-            PollDeviceToken();
-        }
-    );
-    Req->ProcessRequest();
+    FChannel& Channel = Channels.AddDefaulted_GetRef();
+    Channel.Login = Login;
+    if (Irc)
+    {
+        Irc->Join(Login);
+    }
+
+    // Before the session is up, Connect/Reconnect resolve the whole list
+    if (State == ETwitchChatConnectionState::Connecting || State == ETwitchChatConnectionState::Subscribing
+        || State == ETwitchChatConnectionState::Connected || State == ETwitchChatConnectionState::Migrating)
+    {
+        UE_LOG(LogTwitchChat, Log, TEXT("Joining %s"), *Login);
+        ResolveChannel(Login);
+    }
+    return true;
 }
 
+bool FTwitchChatConnection::RemoveChannel(const FString& Login)
+{
+    check(IsInGameThread());
+    const int32 Index = Channels.IndexOfByPredicate([&Login](const FChannel& Channel) { return Channel.Login.Equals(Login, ESearchCase::IgnoreCase); });
+    if (Index == INDEX_NONE)
+        return false;
 
+    UE_LOG(LogTwitchChat, Log, TEXT("Leaving %s"), *Channels[Index].Login);
+    if (Irc)
+    {
+        Irc->Part(Channels[Index].Login);
+    }
+    if (!Channels[Index].SubscriptionId.IsEmpty())
+    {
+        DeleteSubscription(Channels[Index].SubscriptionId);
+    }
+    for (const FString& SubscriptionId : Channels[Index].EventSubscriptionIds)
+    {
+        DeleteSubscription(SubscriptionId);
+    }
+    Channels.RemoveAt(Index);
+    UpdateSubscribedState();
+    return true;
+}
 
-void FTwitchChatConnection::PollDeviceToken()
+void FTwitchChatConnection::SetChannels(const TArray<FString>& Logins)
 {
-    const UTwitchChatSettings* S = GetDefault<UTwitchChatSettings>();
-    Async(EAsyncExecution::Thread, [this, S]()
-        {
-            while (FPlatformTime::Seconds() < DeviceFlowExpiry)
-            {
-                FPlatformProcess::Sleep(PollIntervalSeconds);
+    TArray<FString> Wanted;
+    for (const FString& Login : Logins)
+    {
+        Wanted.AddUnique(Login.TrimStartAndEnd().ToLower());
+    }
 
-                auto Req = FHttpModule::Get().CreateRequest();
-                Req->SetURL(TEXT("https://id.twitch.tv/oauth2/token"));
-                Req->SetVerb(TEXT("POST"));
-                Req->SetHeader(TEXT("Content-Type"), TEXT("application/x-www-form-urlencoded"));
+    for (const FString& Current : GetChannels())
+    {
+        if (!Wanted.Contains(Current))
+            RemoveChannel(Current);
+    }
+    for (const FString& Login : Wanted)
+    {
+        AddChannel(Login);
+    }
+}
 
-                FString Body = FString::Printf(
-                    TEXT("client_id=%s&client_secret=%s&grant_type=urn:ietf:params:oauth:grant-type:device_code&device_code=%s"),
-                    *S->ClientId, *S->ClientSecret, *DeviceCode
-                );
-                Req->SetContentAsString(Body);
+TArray<FString> FTwitchChatConnection::GetChannels() const
+{
+    TArray<FString> Logins;
+    Logins.Reserve(Channels.Num());
+    for (const FChannel& Channel : Channels)
+    {
+        Logins.Add(Channel.Login);
+    }
+    return Logins;
+}
 
-                FEvent* Done = FPlatformProcess::GetSynchEventFromPool(true);
-                bool bSuccess = false;
+bool FTwitchChatConnection::IsChannelSubscribed(const FString& Login) const
+{
+    const FChannel* Channel = FindChannel(Login);
+    return Channel && !Channel->SubscriptionId.IsEmpty();
+}
 
-                Req->OnProcessRequestComplete().BindLambda(
-                    [this, &bSuccess, Done](FHttpRequestPtr, FHttpResponsePtr Resp, bool bOK)
-                    {
-                        if (bOK && Resp.IsValid() && Resp->GetResponseCode() == 200)
-                        {
-                            TSharedPtr<FJsonObject> J;
-                            TSharedRef<TJsonReader<>> R =
-                                TJsonReaderFactory<>::Create(Resp->GetContentAsString());
-                            if (FJsonSerializer::Deserialize(R, J))
-                            {
-                                OAuthToken = J->GetStringField(TEXT("access_token"));
-                                UE_LOG(LogTwitchChat, Log, TEXT("Device flow succeeded; token acquired"));
-
-                                if (UTwitchChatSettings* M = GetMutableDefault<UTwitchChatSettings>())
-                                {
-                                    M->AccessToken = OAuthToken;
-                                    M->RefreshToken = J->GetStringField(TEXT("refresh_token"));
-                                    M->SaveConfig();  
-
-                                    UE_LOG(LogTwitchChat, Log, TEXT("Tokens saved to DefaultEditorPerProjectUserSettings.ini"));
-                                }
-                                bSuccess = true;
-                            }
-                        }
-                        Done->Trigger();
-                    }
-                );
-                Req->ProcessRequest();
-                Done->Wait();
-                FPlatformProcess::ReturnSynchEventToPool(Done);
+void FTwitchChatConnection::ResolveChannel(const FString& Login)
+{
+    FChannel* Channel = FindChannel(Login);
+    if (!Channel || Channel->bResolving || !Channel->BroadcasterId.IsEmpty())
+        return;
 
-                if (bSuccess)
-                {
-                    if (bAutoConnect)
-                    {
-                        AsyncTask(ENamedThreads::GameThread, [this]()
-                            {
-                                QueryUserId(BotLogin, [this](const FString& Id) { BotUserId = Id; bGotBotId = true; TrySubscribe(); });
-                                QueryUserId(ChannelLogin, [this](const FString& Id) { BroadcasterUserId = Id; bGotBroadcasterId = true; TrySubscribe(); });
-                                SetupWebSocket();
-                            });
-                    }
-                    break;
-                }
+    Channel->bResolving = true;
+    QueryUserId(Login, [this, Login](const FString& Id)
+        {
+            FChannel* Resolved = FindChannel(Login);
+            if (!Resolved)
+                return;   // left while the lookup was in flight
+
+            Resolved->bResolving = false;
+            if (Id.IsEmpty())
+            {
+                // Stays in the list; the next reconnect tries again
+                UE_LOG(LogTwitchChat, Error, TEXT("Could not resolve channel %s"), *Login);
+                UpdateSubscribedState();
+                return;
             }
+            Resolved->BroadcasterId = Id;
+            TrySubscribe();
         });
 }
 
+void FTwitchChatConnection::ResetSubscriptions()
+{
+    // Subscriptions belong to a session; a new session starts with none
+    ++SubscriptionGeneration;
+    for (FChannel& Channel : Channels)
+    {
+        Channel.SubscriptionId.Empty();
+        Channel.EventSubscriptionIds.Reset();
+        Channel.bSubscribing = false;
+    }
+}
 
-void FTwitchChatConnection::Disconnect()
+void FTwitchChatConnection::UpdateSubscribedState()
 {
-    if (Socket.IsValid())
+    if (State != ETwitchChatConnectionState::Subscribing)
+        return;
+
+    bool bAnySubscribed = false;
+    for (const FChannel& Channel : Channels)
     {
-        Socket->Close();
-        Socket.Reset();
+        if (Channel.bResolving || Channel.bSubscribing)
+            return;
+        bAnySubscribed |= !Channel.SubscriptionId.IsEmpty();
+    }
+    if (bAnySubscribed || Channels.Num() == 0)
+    {
+        SetState(ETwitchChatConnectionState::Connected);
     }
-    bSubscribed = false;
-    BotUserId.Empty();
-    BroadcasterUserId.Empty();
-    SessionId.Empty();
-    bGotBotId = bGotBroadcasterId = bGotWelcome = false;
 }
 
 void FTwitchChatConnection::QueryUserId(const FString& Login, TFunction<void(const FString&)> Callback)
 {
-    const UTwitchChatSettings* S = GetDefault<UTwitchChatSettings>();
-    auto Req = FHttpModule::Get().CreateRequest();
-    Req->SetURL(FString::Printf(TEXT("https://api.twitch.tv/helix/users?login=%s"), *Login));
-    Req->SetVerb(TEXT("GET"));
-    Req->SetHeader(TEXT("Client-Id"), S->ClientId);
-    Req->SetHeader(TEXT("Authorization"), TEXT("Bearer ") + OAuthToken);
+    if (const FString* Cached = UserIdCache.Find(Login.ToLower()))
+    {
+        Callback(*Cached);
+        return;
+    }
 
-    Req->OnProcessRequestComplete().BindLambda(
-        [this, Login, Callback](FHttpRequestPtr, FHttpResponsePtr Resp, bool bOK)
+    // Merged with the other lookups of this tick (bot and channels on connect) into one request
+    FTwitchChatHelix::Get()->Lookup(ETwitchHelixLookup::UserByLogin, Login,
+        [this, Login, Callback](const TArray<TSharedPtr<FJsonObject>>& Users)
         {
-            if (!bOK || !Resp.IsValid())
-            {
-                Callback(FString());
-                return;
-            }
-
-            int32 Code = Resp->GetResponseCode();
-            if (Code == 401)
-            {
-                // Token expired → refresh & retry
-                RefreshOAuthToken([this, Login, Callback](bool bRefreshed)
-                    {
-                        if (bRefreshed)
-                            QueryUserId(Login, Callback);
-                        else
-                            Callback(FString());
-                    });
-                return;
-            }
-
-            if (Code == 200)
+            FString Out;
+            if (Users.Num() > 0)
             {
-                FString Out;
-                TSharedPtr<FJsonObject> J;
-                TSharedRef<TJsonReader<>> R = TJsonReaderFactory<>::Create(Resp->GetContentAsString());
-                if (FJsonSerializer::Deserialize(R, J) && J->HasField(TEXT("data")))
-                {
-                    const auto& Arr = J->GetArrayField(TEXT("data"));
-                    if (Arr.Num() > 0)
-                        Out = Arr[0]->AsObject()->GetStringField(TEXT("id"));
-                }
-                Callback(Out);
+                Users[0]->TryGetStringField(TEXT("id"), Out);
             }
-            else
+            if (!Out.IsEmpty())
             {
-                Callback(FString());
+                UserIdCache.Add(Login.ToLower(), Out);
+                FTwitchChatWarmStart::Get().StoreUserId(Login, Out);
             }
-        }
-    );
-    Req->ProcessRequest();
+            Callback(Out);
+        });
 }
 
 
 void FTwitchChatConnection::TrySubscribe()
 {
-    if (bSubscribed || !bGotBotId || !bGotBroadcasterId || !bGotWelcome)
+    check(IsInGameThread());
+    if (bGotBotId && !Channels.ContainsByPredicate([](const FChannel& Channel) { return Channel.BroadcasterId.IsEmpty(); }))
+    {
+        MarkConnectStage(ETwitchChatConnectStage::IdsResolved);
+    }
+    if (bReplaying || !bGotBotId || !(Conduit ? Conduit->IsReady() : bGotWelcome))
         return;
 
-    const UTwitchChatSettings* S = GetDefault<UTwitchChatSettings>();
-    auto Req = FHttpModule::Get().CreateRequest();
-    Req->SetURL(TEXT("https://api.twitch.tv/helix/eventsub/subscriptions"));
-    Req->SetVerb(TEXT("POST"));
-    Req->SetHeader(TEXT("Client-Id"), S->ClientId);
-    Req->SetHeader(TEXT("Authorization"), TEXT("Bearer ") + OAuthToken);
-    Req->SetHeader(TEXT("Content-Type"), TEXT("application/json"));
-
-    TSharedPtr<FJsonObject> Root = MakeShared<FJsonObject>();
-    Root->SetStringField(TEXT("type"), TEXT("channel.chat.message"));
-    Root->SetStringField(TEXT("version"), TEXT("1"));
-    TSharedPtr<FJsonObject> Cond = MakeShared<FJsonObject>();
-    Cond->SetStringField(TEXT("broadcaster_user_id"), BroadcasterUserId);
-    Cond->SetStringField(TEXT("user_id"), BotUserId);
-    Root->SetObjectField(TEXT("condition"), Cond);
-    TSharedPtr<FJsonObject> Trans = MakeShared<FJsonObject>();
-    Trans->SetStringField(TEXT("method"), TEXT("websocket"));
-    Trans->SetStringField(TEXT("session_id"), SessionId);
-    Root->SetObjectField(TEXT("transport"), Trans);
+    for (const FChannel& Channel : Channels)
+    {
+        if (!Channel.BroadcasterId.IsEmpty() && Channel.SubscriptionId.IsEmpty() && !Channel.bSubscribing)
+        {
+            Subscribe(Channel.Login);
+        }
+    }
+    UpdateSubscribedState();
+}
 
-    FString Body;
-    TSharedRef<TJsonWriter<>> W = TJsonWriterFactory<>::Create(&Body);
-    FJsonSerializer::Serialize(Root.ToSharedRef(), W);
-    Req->SetContentAsString(Body);
+void FTwitchChatConnection::Subscribe(const FString& Login)
+{
+    FChannel* Channel = FindChannel(Login);
+    check(Channel);
+    Channel->bSubscribing = true;
+    MarkConnectStage(ETwitchChatConnectStage::SubscribeSent);
 
-    Req->OnProcessRequestComplete().BindLambda(
-        [this](FHttpRequestPtr, FHttpResponsePtr Resp, bool bOK)
+    TSharedRef<FJsonObject> Cond = MakeShared<FJsonObject>();
+    Cond->SetStringField(TEXT("broadcaster_user_id"), Channel->BroadcasterId);
+    Cond->SetStringField(TEXT("user_id"), BotUserId);
+
+    SendSubscriptionRequest(TEXT("POST"), TEXT("/eventsub/subscriptions"), MakeSubscriptionBody(TEXT("channel.chat.message"), TEXT("1"), Cond),
+        [this, Login, Generation = SubscriptionGeneration](FHttpRequestPtr, FHttpResponsePtr Resp, bool bOK)
         {
+            // A reply for a session we already dropped; the new one subscribes on its own
+            if (Generation != SubscriptionGeneration)
+                return;
+
+            FChannel* Channel = FindChannel(Login);
+            if (Channel)
+            {
+                Channel->bSubscribing = false;
+            }
+
             int32 Code = Resp.IsValid() ? Resp->GetResponseCode() : -1;
             if (bOK && (Code == 200 || Code == 202))
             {
-                UE_LOG(LogTwitchChat, Log, TEXT("Subscribed to channel.chat.message"));
-                bSubscribed = true;
+                FString SubscriptionId;
+                TSharedPtr<FJsonObject> J;
+                TSharedRef<TJsonReader<>> R = TJsonReaderFactory<>::Create(Resp->GetContentAsString());
+                const TArray<TSharedPtr<FJsonValue>>* Data = nullptr;
+                if (FJsonSerializer::Deserialize(R, J) && J->TryGetArrayField(TEXT("data"), Data) && Data->Num() > 0)
+                {
+                    (*Data)[0]->AsObject()->TryGetStringField(TEXT("id"), SubscriptionId);
+                }
+
+                if (!Channel)
+                {
+                    // Left while the request was in flight
+                    DeleteSubscription(SubscriptionId);
+                    return;
+                }
+
+                if (SubscriptionId.IsEmpty())
+                {
+                    // Without the id a revocation cannot be matched to it, nor can it be deleted later
+                    FTwitchChatMetrics::Inc(ETwitchChatCounter::SubscribeFailures);
+                    UE_LOG(LogTwitchChat, Error, TEXT("Subscription for %s was accepted without an id"), *Login);
+                    UpdateSubscribedState();
+                    return;
+                }
+
+                UE_LOG(LogTwitchChat, Log, TEXT("Subscribed to channel.chat.message for %s"), *Login);
+                MarkConnectStage(ETwitchChatConnectStage::Subscribed);
+                Channel->SubscriptionId = SubscriptionId;
+                UpdateSubscribedState();
+                SubscribeEvents(Login);
             }
-            else if (Code == 401)
+            else if (Code == 409 && Channel && Conduit)
             {
-                // Token expired → refresh & retry
-                RefreshOAuthToken([this](bool bRefreshed)
-                    {
-                        if (bRefreshed)
-                            TrySubscribe();
-                    });
+                // A reused conduit keeps its subscriptions from the last run
+                AdoptSubscription(Login);
             }
             else
             {
+                FTwitchChatMetrics::Inc(ETwitchChatCounter::SubscribeFailures);
                 UE_LOG(LogTwitchChat, Error,
-                    TEXT("Subscription failed (%d): %s"),
+                    TEXT("Subscription for %s failed (%d): %s"),
+                    *Login,
                     Code,
                     Resp.IsValid() ? *Resp->GetContentAsString() : TEXT("no-response")
                 );
+                UpdateSubscribedState();
             }
         }
     );
-    Req->ProcessRequest();
 }
 
-
-
-void FTwitchChatConnection::HandleWebSocketMessage(const FString& MsgJson)
+void FTwitchChatConnection::SubscribeEvents(const FString& Login)
 {
-  
-    Async(EAsyncExecution::Thread, [this, MsgJson]()
-        {
-         
-            TSharedPtr<FJsonObject> Root;
-            TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(MsgJson);
-            if (!FJsonSerializer::Deserialize(Reader, Root) || !Root->HasField(TEXT("metadata")))
-            {
-                return;
-            }
+    const FChannel* Channel = FindChannel(Login);
+    check(Channel);
 
-            const auto& Meta = Root->GetObjectField(TEXT("metadata"));
-            const FString MessageType = Meta->GetStringField(TEXT("message_type"));
+    TArray<ETwitchChatEventType> Kinds;
+    for (ETwitchChatEventType Kind : GetDefault<UTwitchChatSettings>()->Events)
+    {
+        if (Kind < ETwitchChatEventType::Count)
+            Kinds.AddUnique(Kind);
+    }
 
-      
-            if (MessageType == TEXT("session_welcome"))
-            {
-                SessionId = Root->GetObjectField(TEXT("payload"))->GetObjectField(TEXT("session"))->GetStringField(TEXT("id"));
-                bGotWelcome = true;
-                TrySubscribe();
-                return;
-            }
+    for (ETwitchChatEventType Kind : Kinds)
+    {
+        const FTwitchChatEvents::FType& Type = FTwitchChatEvents::GetType(Kind);
+        TSharedRef<FJsonObject> Cond = MakeShared<FJsonObject>();
+        Cond->SetStringField(Type.BroadcasterCondition, Channel->BroadcasterId);
+        if (Type.bUserCondition)
+        {
+            Cond->SetStringField(TEXT("user_id"), BotUserId);
+        }
 
-       
-            if (MessageType != TEXT("notification") ||
-                Meta->GetStringField(TEXT("subscription_type")) != TEXT("channel.chat.message"))
+        SendSubscriptionRequest(TEXT("POST"), TEXT("/eventsub/subscriptions"), MakeSubscriptionBody(Type.Name, Type.Version, Cond),
+            [this, Login, Name = FString(Type.Name), Generation = SubscriptionGeneration](FHttpRequestPtr, FHttpResponsePtr Resp, bool bOK)
             {
-                return;
-            }
+                if (Generation != SubscriptionGeneration)
+                    return;
 
-            const auto& Evt = Root->GetObjectField(TEXT("payload"))->GetObjectField(TEXT("event"));
+                const int32 Code = Resp.IsValid() ? Resp->GetResponseCode() : -1;
+                if (!bOK || (Code != 200 && Code != 202))
+                {
+                    // 409: a reused conduit still has it from the last run
+                    if (Code == 409)
+                        return;
+                    FTwitchChatMetrics::Inc(ETwitchChatCounter::SubscribeFailures);
+                    UE_LOG(LogTwitchChat, Warning, TEXT("Subscription to %s for %s failed (%d): %s"),
+                        *Name, *Login, Code, Resp.IsValid() ? *Resp->GetContentAsString() : TEXT("no-response"));
+                    return;
+                }
 
-         
-            FTwitchChatMessage M;
-            M.RawPayload = MsgJson;
+                FString SubscriptionId;
+                TSharedPtr<FJsonObject> J;
+                TSharedRef<TJsonReader<>> R = TJsonReaderFactory<>::Create(Resp->GetContentAsString());
+                const TArray<TSharedPtr<FJsonValue>>* Data = nullptr;
+                if (FJsonSerializer::Deserialize(R, J) && J->TryGetArrayField(TEXT("data"), Data) && Data->Num() > 0)
+                {
+                    (*Data)[0]->AsObject()->TryGetStringField(TEXT("id"), SubscriptionId);
+                }
+
+                FChannel* Channel = FindChannel(Login);
+                if (!Channel)
+                {
+                    DeleteSubscription(SubscriptionId);
+                    return;
+                }
+                UE_LOG(LogTwitchChat, Log, TEXT("Subscribed to %s for %s"), *Name, *Login);
+                if (!SubscriptionId.IsEmpty())
+                {
+                    Channel->EventSubscriptionIds.Add(SubscriptionId);
+                }
+            }
+        );
+    }
+}
+
+FString FTwitchChatConnection::MakeSubscriptionBody(const TCHAR* Type, const TCHAR* Version, const TSharedRef<FJsonObject>& Condition) const
+{
+    TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+    Root->SetStringField(TEXT("type"), Type);
+    Root->SetStringField(TEXT("version"), Version);
+    Root->SetObjectField(TEXT("condition"), Condition);
+    TSharedPtr<FJsonObject> Trans = MakeShared<FJsonObject>();
+    if (Conduit)
+    {
+        Trans->SetStringField(TEXT("method"), TEXT("conduit"));
+        Trans->SetStringField(TEXT("conduit_id"), Conduit->GetConduitId());
+    }
+    else
+    {
+        Trans->SetStringField(TEXT("method"), TEXT("websocket"));
+        Trans->SetStringField(TEXT("session_id"), SessionId);
+    }
+    Root->SetObjectField(TEXT("transport"), Trans);
+
+    FString Body;
+    TSharedRef<TJsonWriter<>> W = TJsonWriterFactory<>::Create(&Body);
+    FJsonSerializer::Serialize(Root, W);
+    return Body;
+}
+
+void FTwitchChatConnection::SendSubscriptionRequest(const FString& Verb, const FString& Path, const FString& Body, TFunction<void(FHttpRequestPtr, FHttpResponsePtr, bool)> OnComplete)
+{
+    auto Req = FTwitchChatHelix::MakeRequest(Verb, Path);
+    if (!Body.IsEmpty())
+    {
+        Req->SetHeader(TEXT("Content-Type"), TEXT("application/json"));
+        Req->SetContentAsString(Body);
+    }
+    if (!Conduit)
+    {
+        FTwitchChatHelix::Get()->Send(Req, MoveTemp(OnComplete));
+        return;
+    }
+    Req->SetHeader(TEXT("Client-Id"), GetDefault<UTwitchChatSettings>()->ClientId);
+    Req->SetHeader(TEXT("Authorization"), TEXT("Bearer ") + Conduit->GetAppToken());
+    FTwitchChatHelix::Get()->Send(Req, MoveTemp(OnComplete), ETwitchHelixBucket::App);
+}
+
+void FTwitchChatConnection::AdoptSubscription(const FString& Login)
+{
+    FChannel* Channel = FindChannel(Login);
+    check(Channel);
+    Channel->bSubscribing = true;
+
+    SendSubscriptionRequest(TEXT("GET"), TEXT("/eventsub/subscriptions?type=channel.chat.message&user_id=") + Channel->BroadcasterId, FString(),
+        [this, Login, Generation = SubscriptionGeneration](FHttpRequestPtr, FHttpResponsePtr Resp, bool bOK)
+        {
+            FChannel* Channel = FindChannel(Login);
+            if (Generation != SubscriptionGeneration || !Channel || !Conduit)
+                return;
+            Channel->bSubscribing = false;
+
+            TSharedPtr<FJsonObject> J;
+            const TArray<TSharedPtr<FJsonValue>>* Data = nullptr;
+            TSharedRef<TJsonReader<>> R = TJsonReaderFactory<>::Create(Resp.IsValid() ? Resp->GetContentAsString() : FString());
+            if (bOK && Resp.IsValid() && Resp->GetResponseCode() == 200
+                && FJsonSerializer::Deserialize(R, J) && J->TryGetArrayField(TEXT("data"), Data))
+            {
+                for (const TSharedPtr<FJsonValue>& Value : *Data)
+                {
+                    const TSharedPtr<FJsonObject>& Sub = Value->AsObject();
+                    const TSharedPtr<FJsonObject>* Transport = nullptr;
+                    FString ConduitId;
+                    if (Sub->TryGetObjectField(TEXT("transport"), Transport)
+                        && (*Transport)->TryGetStringField(TEXT("conduit_id"), ConduitId) && ConduitId == Conduit->GetConduitId())
+                    {
+                        Sub->TryGetStringField(TEXT("id"), Channel->SubscriptionId);
+                        UE_LOG(LogTwitchChat, Log, TEXT("Reusing conduit subscription for %s"), *Login);
+                        SubscribeEvents(Login);
+                        break;
+                    }
+                }
+            }
+            if (Channel->SubscriptionId.IsEmpty())
+            {
+                FTwitchChatMetrics::Inc(ETwitchChatCounter::SubscribeFailures);
+                UE_LOG(LogTwitchChat, Error, TEXT("Subscription for %s exists but could not be found"), *Login);
+            }
+            UpdateSubscribedState();
+        }
+    );
+}
+
+void FTwitchChatConnection::DeleteSubscription(const FString& SubscriptionId)
+{
+    if (SubscriptionId.IsEmpty())
+        return;
+
+    SendSubscriptionRequest(TEXT("DELETE"), TEXT("/eventsub/subscriptions?id=") + SubscriptionId, FString(),
+        [SubscriptionId](FHttpRequestPtr, FHttpResponsePtr Resp, bool bOK)
+        {
+            const int32 Code = Resp.IsValid() ? Resp->GetResponseCode() : -1;
+            if (!bOK || (Code != 204 && Code != 404))
+            {
+                UE_LOG(LogTwitchChat, Warning, TEXT("Deleting subscription %s failed (%d)"), *SubscriptionId, Code);
+            }
+        }
+    );
+}
+
+
+
+FTwitchChatConnection::FFrameStamp FTwitchChatConnection::StampFrame()
+{
+    FramesInFlight.fetch_add(1, std::memory_order_relaxed);
+    INC_DWORD_STAT(STAT_TwitchChat_FramesInFlight);
+
+    FFrameStamp Stamp;
+    Stamp.ReceivedTime = FPlatformTime::Seconds();
+    Stamp.ReceivedUtc = bReplaying ? FDateTime() : FDateTime::UtcNow();
+    Stamp.Serial = TwitchChatTrace::NextMessageSerial();
+    Stamp.Epoch = GetEpoch();
+    TwitchChatTrace::MessageStage(Stamp.Serial, ETwitchChatTraceStage::Received);
+    return Stamp;
+}
+
+void FTwitchChatConnection::HandleWebSocketMessage(const FString& MsgJson)
+{
+    const FFrameStamp Stamp = StampFrame();
+    if (!ParseWorker)
+    {
+        // Shut down; the frame is dropped
+        FramesInFlight.fetch_sub(1, std::memory_order_relaxed);
+        DEC_DWORD_STAT(STAT_TwitchChat_FramesInFlight);
+        return;
+    }
+    ParseWorker->Enqueue(MsgJson, Stamp);
+}
+
+void FTwitchChatConnection::ParseAndPost(const FString& MsgJson, const FFrameStamp& Stamp)
+{
+    ProcessFrame(MsgJson, Stamp,
+        [this, &Stamp](const FString& MessageType, TSharedPtr<FJsonObject> Root)
+        {
+            Post(Stamp.Epoch, [this, MessageType, Root]()
+                {
+                    HandleSessionMessage(MessageType, Root);
+                });
+        },
+        [this, &Stamp](FTwitchChatMessage&& Message)
+        {
+            Post(Stamp.Epoch, [this, M = MoveTemp(Message)]() mutable
+                {
+                    DispatchWhenReady(MoveTemp(M));
+                });
+        },
+        [this, &Stamp](TUniqueFunction<void()>&& Broadcast)
+        {
+            Post(Stamp.Epoch, MoveTemp(Broadcast));
+        });
+}
+
+struct FTwitchChatConnection::FChatterFields
+{
+    TStringBuilder<64> UserName;
+    TStringBuilder<16> Color;
+    TStringBuilder<256> Badges;
+
+    void AddBadge(FStringView SetId, FStringView Id)
+    {
+        if (Badges.Len() > 0)
+            Badges << TEXT(',');
+        Badges << SetId << TEXT('/') << Id;
+    }
+};
+
+void FTwitchChatConnection::ProcessFrame(const FString& MsgJson, const FFrameStamp& Stamp,
+    TFunctionRef<void(const FString&, TSharedPtr<FJsonObject>)> OnSession,
+    TFunctionRef<void(FTwitchChatMessage&&)> OnChat,
+    TFunctionRef<void(TUniqueFunction<void()>&&)> OnEvent)
+{
+    TWITCHCHAT_TRACE_SCOPE("TwitchChat::ProcessFrame");
+    LLM_SCOPE_BYTAG(TwitchChat_Messages);
+    ON_SCOPE_EXIT
+    {
+        FramesInFlight.fetch_sub(1, std::memory_order_relaxed);
+        DEC_DWORD_STAT(STAT_TwitchChat_FramesInFlight);
+    };
+
+    if (GetDefault<UTwitchChatSettings>()->bArenaMessageParse)
+    {
+        FTwitchChatMessage M;
+        FChatterFields Chatter;
+        bool bStreamed = false;
+        {
+            SCOPE_CYCLE_COUNTER(STAT_TwitchChat_JsonParse);
+            FTwitchChatMetricsScope MetricsScope(ETwitchChatTimer::JsonParse);
+            bStreamed = StreamChat(MsgJson, M, Chatter);
+        }
+        if (bStreamed)
+        {
+            DeliverChat(M, Chatter, MsgJson, Stamp, OnChat);
+            return;
+        }
+    }
+
+    TSharedPtr<FJsonObject> Root;
+    bool bParsed = false;
+    {
+        SCOPE_CYCLE_COUNTER(STAT_TwitchChat_JsonParse);
+        FTwitchChatMetricsScope MetricsScope(ETwitchChatTimer::JsonParse);
+        TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(MsgJson);
+        bParsed = FJsonSerializer::Deserialize(Reader, Root);
+    }
+    if (!bParsed || !Root->HasField(TEXT("metadata")))
+    {
+        FTwitchChatMetrics::Inc(ETwitchChatCounter::ParseErrors);
+        return;
+    }
+
+    const auto& Meta = Root->GetObjectField(TEXT("metadata"));
+    const FString MessageType = Meta->GetStringField(TEXT("message_type"));
+
+      
+    if (MessageType == TEXT("session_keepalive"))
+    {
+        return;
+    }
+    if (MessageType == TEXT("session_welcome") || MessageType == TEXT("session_reconnect") || MessageType == TEXT("revocation"))
+    {
+        OnSession(MessageType, Root);
+        return;
+    }
+
+       
+    if (MessageType != TEXT("notification"))
+    {
+        return;
+    }
+    const FTwitchChatEvents::FType* Type = FTwitchChatEvents::Find(Meta->GetStringField(TEXT("subscription_type")));
+    if (!Type)
+    {
+        return;
+    }
+
+    const auto& Evt = Root->GetObjectField(TEXT("payload"))->GetObjectField(TEXT("event"));
+
+    if (Type->Decode)
+    {
+        TUniqueFunction<void()> Broadcast;
+        if (!Type->Decode(*Meta, *Evt, Broadcast))
+        {
+            FTwitchChatMetrics::Inc(ETwitchChatCounter::ParseErrors);
+            return;
+        }
+        FTwitchChatMetrics::Inc(ETwitchChatCounter::EventsReceived);
+        OnEvent(MoveTemp(Broadcast));
+        return;
+    }
+
+ 
+    FTwitchChatMessage M;
+    FChatterFields Chatter;
+    DecodeChat(*Meta, *Evt, M, Chatter);
+    DeliverChat(M, Chatter, MsgJson, Stamp, OnChat);
+}
+
+void FTwitchChatConnection::DecodeChat(const FJsonObject& Meta, const FJsonObject& Evt, FTwitchChatMessage& M, FChatterFields& Chatter)
+{
+    FString SentAt;
+    if (Meta.TryGetStringField(TEXT("message_timestamp"), SentAt))
+        FDateTime::ParseIso8601(*SentAt, M.Timestamp);
+
+    Evt.TryGetStringField(TEXT("message_id"), M.MessageId);
+    Evt.TryGetStringField(TEXT("broadcaster_user_id"), M.ChannelId);
+    Evt.TryGetStringField(TEXT("broadcaster_user_login"), M.ChannelLogin);
+    if (!Evt.TryGetStringField(TEXT("chatter_user_id"), M.UserId))
+        Evt.TryGetStringField(TEXT("user_id"), M.UserId);
+
+    FString UserName, Color;
+    if (!Evt.TryGetStringField(TEXT("chatter_user_name"), UserName))
+        Evt.TryGetStringField(TEXT("user_name"), UserName);
+    Evt.TryGetStringField(TEXT("color"), Color);
+    Chatter.UserName << UserName;
+    Chatter.Color << Color;
+    const TArray<TSharedPtr<FJsonValue>>* BadgeValues = nullptr;
+    if (Evt.TryGetArrayField(TEXT("badges"), BadgeValues))
+    {
+        for (const TSharedPtr<FJsonValue>& Value : *BadgeValues)
+        {
+            const TSharedPtr<FJsonObject>* Badge = nullptr;
+            if (Value->TryGetObject(Badge))
+            {
+                Chatter.AddBadge((*Badge)->GetStringField(TEXT("set_id")), (*Badge)->GetStringField(TEXT("id")));
+            }
+        }
+    }
+
+    if (Evt.HasField(TEXT("message")))
+        M.Message = Evt.GetObjectField(TEXT("message"))->GetStringField(TEXT("text"));
+    else if (Evt.HasField(TEXT("text")))
+        M.Message = Evt.GetStringField(TEXT("text"));
+
+      
+    TArray<FString> EmoteIds;
+    TArray<FIntPoint>  EmoteRanges;
+
+    if (Evt.HasField(TEXT("message")))
+    {
+        const auto& Frags = Evt.GetObjectField(TEXT("message"))->GetArrayField(TEXT("fragments"));
+        int32 Cursor = 0;
+        for (auto& FragVal : Frags)
+        {
+            const auto& FragObj = FragVal->AsObject();
+            const FString Text = FragObj->GetStringField(TEXT("text"));
+            if (FragObj->GetStringField(TEXT("type")) == TEXT("emote") && FragObj->HasField(TEXT("emote")))
+            {
+                EmoteIds.Add(FragObj->GetObjectField(TEXT("emote"))->GetStringField(TEXT("id")));
+                EmoteRanges.Add(FIntPoint(Cursor, Cursor + Text.Len()));
+            }
+            Cursor += Text.Len();
+        }
+    }
+    else if (Evt.HasField(TEXT("emotes")))
+    {
+        for (auto& Val : Evt.GetArrayField(TEXT("emotes")))
+        {
+            const auto& Obj = Val->AsObject();
+            int32 B = Obj->GetIntegerField(TEXT("begin"));
+            int32 E = Obj->GetIntegerField(TEXT("end"));
+            EmoteIds.Add(Obj->GetStringField(TEXT("id")));
+            EmoteRanges.Add(FIntPoint(B, E));
+        }
+    }
+
+    M.EmoteIds = MoveTemp(EmoteIds);
+    M.EmoteRanges = MoveTemp(EmoteRanges);
+}
+
+namespace TwitchChatStreamParse
+{
+    // The objects and arrays StreamChat reads into; anything else is skipped unread
+    enum class EScope : uint8
+    {
+        Skip,
+        Root,
+        Metadata,
+        Payload,
+        Event,
+        Message,
+        Fragments,
+        Fragment,
+        Emote,
+        Badges,
+        Badge,
+    };
+
+    static EScope Enter(EScope Parent, const FString& Name, bool bArray)
+    {
+        switch (Parent)
+        {
+        case EScope::Root:      return bArray ? EScope::Skip : Name == TEXT("metadata") ? EScope::Metadata : Name == TEXT("payload") ? EScope::Payload : EScope::Skip;
+        case EScope::Payload:   return !bArray && Name == TEXT("event") ? EScope::Event : EScope::Skip;
+        case EScope::Event:     return bArray ? (Name == TEXT("badges") ? EScope::Badges : EScope::Skip) : (Name == TEXT("message") ? EScope::Message : EScope::Skip);
+        case EScope::Message:   return bArray && Name == TEXT("fragments") ? EScope::Fragments : EScope::Skip;
+        case EScope::Fragments: return bArray ? EScope::Skip : EScope::Fragment;
+        case EScope::Fragment:  return !bArray && Name == TEXT("emote") ? EScope::Emote : EScope::Skip;
+        case EScope::Badges:    return bArray ? EScope::Skip : EScope::Badge;
+        default:                return EScope::Skip;
+        }
+    }
+}
+
+bool FTwitchChatConnection::StreamChat(const FString& Frame, FTwitchChatMessage& M, FChatterFields& Chatter)
+{
+    using namespace TwitchChatStreamParse;
+
+    // Everything below that does not end up in the message is popped off the stack in one go
+    FMemMark Mark(FMemStack::Get());
+    TArray<FString, TMemStackAllocator<>> EmoteIds;
+    TArray<FIntPoint, TMemStackAllocator<>> EmoteRanges;
+
+    bool bNotification = false;
+    bool bChatMessage = false;
+    bool bHasMessage = false;
+
+    // The open fragment or badge; fields can come in any order, so they are applied when it closes
+    int32 Cursor = 0;
+    int32 FragmentLen = 0;
+    bool bEmoteFragment = false;
+    FString FragmentEmoteId;
+    TStringBuilder<32> BadgeSet, BadgeId;
+
+    TArray<EScope, TInlineAllocator<12>> Scopes;
+    TSharedRef<TJsonReader<TCHAR>> Reader = TJsonReaderFactory<TCHAR>::CreateFromView(Frame);
+    EJsonNotation Notation;
+    while (Reader->ReadNext(Notation))
+    {
+        if (Notation == EJsonNotation::ObjectEnd || Notation == EJsonNotation::ArrayEnd)
+        {
+            if (Scopes.Num() == 0)
+                return false;
+            const EScope Closed = Scopes.Pop();
+            if (Closed == EScope::Fragment)
+            {
+                if (bEmoteFragment && !FragmentEmoteId.IsEmpty())
+                {
+                    EmoteIds.Add(MoveTemp(FragmentEmoteId));
+                    EmoteRanges.Add(FIntPoint(Cursor, Cursor + FragmentLen));
+                }
+                Cursor += FragmentLen;
+                FragmentLen = 0;
+                bEmoteFragment = false;
+                FragmentEmoteId.Reset();
+            }
+            else if (Closed == EScope::Badge)
+            {
+                Chatter.AddBadge(BadgeSet.ToView(), BadgeId.ToView());
+                BadgeSet.Reset();
+                BadgeId.Reset();
+            }
+            else if (Closed == EScope::Message)
+            {
+                bHasMessage = true;
+            }
+            if (Scopes.Num() == 0)
+                break;
+            continue;
+        }
+
+        if (Notation == EJsonNotation::ObjectStart || Notation == EJsonNotation::ArrayStart)
+        {
+            const bool bArray = Notation == EJsonNotation::ArrayStart;
+            const EScope Scope = Scopes.Num() == 0 ? (bArray ? EScope::Skip : EScope::Root) : Enter(Scopes.Last(), Reader->GetIdentifier(), bArray);
+            if (Scope != EScope::Skip)
+            {
+                Scopes.Push(Scope);
+            }
+            else if (!(bArray ? Reader->SkipArray() : Reader->SkipObject()))
+            {
+                return false;
+            }
+            continue;
+        }
+
+        if (Notation != EJsonNotation::String || Scopes.Num() == 0)
+            continue;
+
+        const FString& Name = Reader->GetIdentifier();
+        const FString& Value = Reader->GetValueAsString();
+        switch (Scopes.Last())
+        {
+        case EScope::Metadata:
+            if (Name == TEXT("message_type"))
+            {
+                bNotification = Value == TEXT("notification");
+                if (!bNotification)
+                    return false;
+            }
+            else if (Name == TEXT("subscription_type"))
+            {
+                bChatMessage = Value == TEXT("channel.chat.message");
+                if (!bChatMessage)
+                    return false;
+            }
+            else if (Name == TEXT("message_timestamp"))
+            {
+                FDateTime::ParseIso8601(*Value, M.Timestamp);
+            }
+            break;
+        case EScope::Event:
+            if (Name == TEXT("message_id"))                     M.MessageId = Value;
+            else if (Name == TEXT("broadcaster_user_id"))       M.ChannelId = Value;
+            else if (Name == TEXT("broadcaster_user_login"))    M.ChannelLogin = Value;
+            else if (Name == TEXT("chatter_user_id"))           M.UserId = Value;
+            else if (Name == TEXT("chatter_user_name"))         Chatter.UserName << Value;
+            else if (Name == TEXT("color"))                     Chatter.Color << Value;
+            break;
+        case EScope::Message:
+            if (Name == TEXT("text"))
+                M.Message = Value;
+            break;
+        case EScope::Fragment:
+            if (Name == TEXT("type"))
+                bEmoteFragment = Value == TEXT("emote");
+            else if (Name == TEXT("text"))
+                FragmentLen = Value.Len();
+            break;
+        case EScope::Emote:
+            if (Name == TEXT("id"))
+                FragmentEmoteId = Value;
+            break;
+        case EScope::Badge:
+            if (Name == TEXT("set_id"))
+                BadgeSet << Value;
+            else if (Name == TEXT("id"))
+                BadgeId << Value;
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (!bNotification || !bChatMessage || !bHasMessage || M.UserId.IsEmpty() || Scopes.Num() != 0)
+        return false;
+
+    // The message's own arrays are allocated once, at their final size
+    M.EmoteIds.Reserve(EmoteIds.Num());
+    for (FString& Id : EmoteIds)
+        M.EmoteIds.Add(MoveTemp(Id));
+    M.EmoteRanges.Append(EmoteRanges.GetData(), EmoteRanges.Num());
+    return true;
+}
+
+void FTwitchChatConnection::ResolveChatter(FTwitchChatMessage& M, const FChatterFields& Chatter)
+{
+    M.Chatter = FTwitchChatChatters::Get().Touch(M.UserId, Chatter.UserName.ToView(), Chatter.Color.ToView(), Chatter.Badges.ToView(), M.Timestamp);
+    M.UserName = M.Chatter->UserName;
+    M.UserColor = M.Chatter->Color;
+}
+
+bool FTwitchChatConnection::ParseChatFrame(const FString& Frame, FTwitchChatMessage& Out, bool bArena)
+{
+    FChatterFields Chatter;
+    if (bArena)
+    {
+        if (!StreamChat(Frame, Out, Chatter))
+            return false;
+    }
+    else
+    {
+        TSharedPtr<FJsonObject> Root;
+        TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Frame);
+        const TSharedPtr<FJsonObject>* Meta = nullptr;
+        const TSharedPtr<FJsonObject>* Payload = nullptr;
+        const TSharedPtr<FJsonObject>* Evt = nullptr;
+        FString SubscriptionType;
+        if (!FJsonSerializer::Deserialize(Reader, Root) || !Root->TryGetObjectField(TEXT("metadata"), Meta)
+            || !(*Meta)->TryGetStringField(TEXT("subscription_type"), SubscriptionType) || SubscriptionType != TEXT("channel.chat.message")
+            || !Root->TryGetObjectField(TEXT("payload"), Payload) || !(*Payload)->TryGetObjectField(TEXT("event"), Evt))
+        {
+            return false;
+        }
+        DecodeChat(**Meta, **Evt, Out, Chatter);
+    }
+
+    if (Out.Timestamp.GetTicks() == 0)
+        Out.Timestamp = FDateTime::UtcNow();
+    ResolveChatter(Out, Chatter);
+    return true;
+}
+
+void FTwitchChatConnection::DeliverChat(FTwitchChatMessage& M, const FChatterFields& Chatter, const FString& MsgJson, const FFrameStamp& Stamp,
+    TFunctionRef<void(FTwitchChatMessage&&)> OnChat)
+{
+    M.RawPayload = MsgJson;
+    M.ReceivedTime = Stamp.ReceivedTime;
+    M.Serial = Stamp.Serial;
+
+    if (M.Timestamp.GetTicks() > 0)
+    {
+        // Replayed frames carry their original send time, so ingest is only measured live
+        if (Stamp.ReceivedUtc.GetTicks() > 0)
+            M.IngestSeconds = (Stamp.ReceivedUtc - M.Timestamp).GetTotalSeconds();
+    }
+    else
+    {
+        M.Timestamp = FDateTime::UtcNow();
+    }
+
+    if (IsHedging() && !AdmitHedged(M.MessageId, ETwitchChatTransport::EventSub, Stamp.ReceivedTime))
+        return;
+
+    // Name, color and badges resolve through the chatter cache, parsed once per chatter
+    ResolveChatter(M, Chatter);
+
+    for (const FString& EmoteId : M.EmoteIds)
+    {
+        DownloadEmoteIfNeeded(EmoteId);
+    }
+
+    FinishMessage(M);
+    OnChat(MoveTemp(M));
+}
+
+void FTwitchChatConnection::FinishMessage(FTwitchChatMessage& M)
+{
+    const UTwitchChatSettings* Settings = GetDefault<UTwitchChatSettings>();
+
+    M.ParsedTime = FPlatformTime::Seconds();
+    FTwitchChatLatency::Get().RecordParsed(M);
+    TwitchChatTrace::MessageStage(M.Serial, ETwitchChatTraceStage::Parsed);
+
+    if (Settings->bEnableHistoryLog)
+    {
+        FTwitchChatHistoryLog::Get()->Append(M);
+    }
+    if (Settings->bEnableSearchIndex)
+    {
+        FTwitchChatSearchIndex::Get()->Add(M);
+    }
+}
+
+void FTwitchChatConnection::DispatchWhenReady(FTwitchChatMessage&& M)
+{
+    check(IsInGameThread());
+    const TArray<FParkedMessage>* Parked = ParkedByChannel.Find(M.ChannelId);
+    if ((!Parked || Parked->Num() == 0) && !IsWaitingForEmotes(M))
+    {
+        DispatchMessage(M);
+        return;
+    }
+
+    // Waits on the game thread's clock instead of a parse thread, so frames behind it keep flowing
+    const double Timeout = GetDefault<UTwitchChatSettings>()->EmoteRenderTimeoutSeconds;
+    const double Deadline = (M.ParsedTime > 0.0 ? M.ParsedTime : FPlatformTime::Seconds()) + Timeout;
+    const FString ChannelId = M.ChannelId;
+    ParkedByChannel.FindOrAdd(ChannelId).Add({ MoveTemp(M), Deadline });
+
+    if (!ParkedTickHandle.IsValid())
+    {
+        ParkedTickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([this](float)
+            {
+                ReleaseParked();
+                if (ParkedByChannel.Num() > 0)
+                    return true;
+                ParkedTickHandle.Reset();
+                return false;
+            }), 0.1f);
+    }
+}
+
+bool FTwitchChatConnection::IsWaitingForEmotes(const FTwitchChatMessage& M) const
+{
+    if (M.EmoteIds.Num() == 0 || !GetDefault<UTwitchChatSettings>()->AutoDownloadEmotes)
+        return false;
+
+    FScopeLock ScopeLock(&EmoteFetchLock);
+    return M.EmoteIds.ContainsByPredicate([this](const FString& Id) { return EmoteFetches.Contains(Id); });
+}
+
+void FTwitchChatConnection::ReleaseParked()
+{
+    check(IsInGameThread());
+    const double Now = FPlatformTime::Seconds();
+
+    // Collected first: a listener may disconnect, which empties ParkedByChannel
+    TArray<FTwitchChatMessage> Ready;
+    for (auto It = ParkedByChannel.CreateIterator(); It; ++It)
+    {
+        TArray<FParkedMessage>& Queue = It.Value();
+        int32 Released = 0;
+        while (Released < Queue.Num())
+        {
+            FParkedMessage& Parked = Queue[Released];
+            if (IsWaitingForEmotes(Parked.Message))
+            {
+                if (Now < Parked.Deadline)
+                    break;
+                FTwitchChatMetrics::Inc(ETwitchChatCounter::EmoteWaitTimeouts);
+            }
+            Ready.Add(MoveTemp(Parked.Message));
+            ++Released;
+        }
+        Queue.RemoveAt(0, Released);
+        if (Queue.Num() == 0)
+        {
+            It.RemoveCurrent();
+        }
+    }
+
+    const uint32 ReleaseEpoch = GetEpoch();
+    for (FTwitchChatMessage& M : Ready)
+    {
+        if (ReleaseEpoch != GetEpoch())
+            break;
+        DispatchMessage(M);
+    }
+}
+
+void FTwitchChatConnection::DispatchMessage(FTwitchChatMessage& M)
+{
+    SCOPE_CYCLE_COUNTER(STAT_TwitchChat_Dispatch);
+    LLM_SCOPE_BYTAG(TwitchChat_Messages);
+    M.DispatchTime = FPlatformTime::Seconds();
+    FTwitchChatLatency::Get().RecordDispatched(M);
+    INC_DWORD_STAT(STAT_TwitchChat_Messages);
+    FTwitchChatMetrics::Inc(ETwitchChatCounter::MessagesDispatched);
+    TwitchChatTrace::MessageStage(M.Serial, ETwitchChatTraceStage::Dispatched);
+    FTwitchChatRecentHistory::Get().Append(M);
+    OnMessage.Broadcast(M);
+
+    if (!bReplaying && MarkConnectStage(ETwitchChatConnectStage::FirstMessage))
+    {
+        LogConnectTimeline();
+    }
+}
+
+
+
+
+void FTwitchChatConnection::HandleSocketFrame(const FString& Frame)
+{
+    LastActivityTime = FPlatformTime::Seconds();
+    CountFrame(Frame);
+    HandleWebSocketMessage(Frame);
+}
+
+void FTwitchChatConnection::CountFrame(const FString& Frame)
+{
+    FTwitchChatMetrics::Inc(ETwitchChatCounter::FramesReceived);
+    if (Recorder)
+    {
+        Recorder->Record(Frame, FPlatformTime::Cycles64());
+    }
+}
+
+void FTwitchChatConnection::IngestFrame(const FString& Frame)
+{
+    FTwitchChatMetrics::Inc(ETwitchChatCounter::FramesReceived);
+    HandleWebSocketMessage(Frame);
+}
+
+void FTwitchChatConnection::BeginReplay()
+{
+    Disconnect();
+    bReplaying = true;
+}
+
+void FTwitchChatConnection::EndReplay()
+{
+    bReplaying = false;
+    SessionId.Empty();
+    bGotWelcome = false;
+}
+
+bool FTwitchChatConnection::StartRecording(const FString& Path)
+{
+    TUniquePtr<FTwitchChatTrafficRecorder> NewRecorder = MakeUnique<FTwitchChatTrafficRecorder>();
+    if (!NewRecorder->Open(Path))
+        return false;
+
+    Recorder = MoveTemp(NewRecorder);
+    UE_LOG(LogTwitchChat, Log, TEXT("Recording EventSub traffic to %s"), *Path);
+    return true;
+}
+
+void FTwitchChatConnection::StopRecording()
+{
+    Recorder.Reset();
+}
+
+bool FTwitchChatConnection::IsRecording() const
+{
+    return Recorder.IsValid() && Recorder->IsOpen();
+}
+
+void FTwitchChatConnection::SetupWebSocket()
+{
+    const UTwitchChatSettings* S = GetDefault<UTwitchChatSettings>();
+
+    
+    int32 KA = FMath::Clamp(S->KeepaliveTimeoutSeconds, 10, 600);
+
+    
+    FString URL = FString::Printf(
+        TEXT("%s?keepalive_timeout_seconds=%d"),
+        *S->GetEventSubUrl(), KA
+    );
+
+    CloseSocket(Socket);
+    StopConduit();
+    SessionId.Empty();
+    bGotWelcome = false;
+    ResetSubscriptions();
+    SessionKeepaliveSeconds = 0;
+
+    SetState(ETwitchChatConnectionState::Connecting);
+    StartIrc();
+    if (!S->bUseEventSub)
+    {
+        // IRC alone; HandleIrcStatus drives the state
+        if (Irc && Irc->IsJoined())
+        {
+            SetState(ETwitchChatConnectionState::Connected);
+        }
+        return;
+    }
+    if (S->bUseConduit)
+    {
+        // Shards keep their own watchdogs; this ticker only drives backoff
+        if (!TickHandle.IsValid())
+        {
+            TickHandle = FTSTicker::GetCoreTicker().AddTicker(
+                FTickerDelegate::CreateSP(this, &FTwitchChatConnection::TickConnection), 0.25f);
+        }
+        Conduit = MakeShared<FTwitchChatConduit>(*this);
+        Conduit->Start(S->ConduitShardCount);
+        return;
+    }
+    Socket = OpenSocket(URL);
+}
+
+void FTwitchChatConnection::StartIrc()
+{
+    const UTwitchChatSettings* S = GetDefault<UTwitchChatSettings>();
+    bHedging = S->bUseEventSub && S->bUseIrc;
+    if (!S->bUseIrc || Irc)
+        return;
+
+    if (!S->bUseEventSub)
+    {
+        UE_LOG(LogTwitchChat, Log, TEXT("EventSub is off; receiving chat over IRC only"));
+    }
+    Irc = MakeUnique<FTwitchChatIrc>(*this);
+    Irc->Start(S->IrcHost, S->Port, GetChannels());
+}
+
+void FTwitchChatConnection::StopIrc()
+{
+    bHedging = false;
+    Irc.Reset();
+}
+
+void FTwitchChatConnection::HandleIrcStatus(bool bJoined)
+{
+    if (!Irc)
+        return;
+
+    UE_LOG(LogTwitchChat, Log, TEXT("IRC %s"), bJoined ? TEXT("joined") : TEXT("lost"));
+    if (!GetDefault<UTwitchChatSettings>()->bUseEventSub && State != ETwitchChatConnectionState::Disconnected)
+    {
+        SetState(bJoined ? ETwitchChatConnectionState::Connected : ETwitchChatConnectionState::Connecting);
+    }
+}
+
+void FTwitchChatConnection::HandleIrcMessage(FTwitchChatMessage&& Message)
+{
+    if (IsHedging() && !AdmitHedged(Message.MessageId, ETwitchChatTransport::Irc, Message.ReceivedTime))
+        return;
 
+    // Same order as DeliverChat: a duplicate the EventSub copy already brought never touches the chatter cache
+    FChatterFields Chatter;
+    Chatter.UserName << Message.UserName;
+    if (const FString* Color = Message.Tags.Find(TEXT("color")))
+        Chatter.Color << *Color;
+    if (const FString* Badges = Message.Tags.Find(TEXT("badges")))
+        Chatter.Badges << *Badges;
+    ResolveChatter(Message, Chatter);
 
-            if (Evt->HasField(TEXT("chatter_user_name")))
-                M.UserName = Evt->GetStringField(TEXT("chatter_user_name"));
-            else if (Evt->HasField(TEXT("user_name")))
-                M.UserName = Evt->GetStringField(TEXT("user_name"));
+    Message.Serial = TwitchChatTrace::NextMessageSerial();
+    TwitchChatTrace::MessageStage(Message.Serial, ETwitchChatTraceStage::Received);
 
+    // Disk and history work goes to the parse worker, so the socket reader only reads
+    ParseWorker->EnqueueIrc(MoveTemp(Message), GetEpoch());
+}
 
-            if (Evt->HasField(TEXT("message")))
-                M.Message = Evt->GetObjectField(TEXT("message"))->GetStringField(TEXT("text"));
-            else if (Evt->HasField(TEXT("text")))
-                M.Message = Evt->GetStringField(TEXT("text"));
+void FTwitchChatConnection::FinishIrcMessage(FTwitchChatMessage&& M, uint32 SessionEpoch)
+{
+    LLM_SCOPE_BYTAG(TwitchChat_Messages);
+    for (const FString& EmoteId : M.EmoteIds)
+    {
+        DownloadEmoteIfNeeded(EmoteId);
+    }
+    FinishMessage(M);
+    Post(SessionEpoch, [this, M = MoveTemp(M)]() mutable
+        {
+            DispatchWhenReady(MoveTemp(M));
+        });
+}
 
-      
-            TArray<FString> EmoteIds;
-            TArray<FIntPoint>  EmoteRanges;
+bool FTwitchChatConnection::AdmitHedged(const FString& MessageId, ETwitchChatTransport Transport, double ReceivedTime)
+{
+    FTwitchChatDedup::FRepeat Repeat;
+    if (MessageId.IsEmpty() || Dedup.Admit(MessageId, Transport, ReceivedTime, Repeat))
+    {
+        FTwitchChatMetrics::Inc(Transport == ETwitchChatTransport::Irc ? ETwitchChatCounter::HedgeFirstIrc : ETwitchChatCounter::HedgeFirstEventSub);
+        return true;
+    }
 
-            if (Evt->HasField(TEXT("message")))
-            {
-                const auto& Frags = Evt->GetObjectField(TEXT("message"))->GetArrayField(TEXT("fragments"));
-                int32 Cursor = 0;
-                for (auto& FragVal : Frags)
-                {
-                    const auto& FragObj = FragVal->AsObject();
-                    const FString Text = FragObj->GetStringField(TEXT("text"));
-                    if (FragObj->GetStringField(TEXT("type")) == TEXT("emote") && FragObj->HasField(TEXT("emote")))
-                    {
-                        const FString EmId = FragObj->GetObjectField(TEXT("emote"))->GetStringField(TEXT("id"));
-                        EmoteIds.Add(EmId);
-                        EmoteRanges.Add(FIntPoint(Cursor, Cursor + Text.Len()));
-                        DownloadEmoteIfNeeded(EmId);
-                    }
-                    Cursor += Text.Len();
-                }
-            }
-            else if (Evt->HasField(TEXT("emotes")))
-            {
-                for (auto& Val : Evt->GetArrayField(TEXT("emotes")))
-                {
-                    const auto& Obj = Val->AsObject();
-                    const FString EmId = Obj->GetStringField(TEXT("id"));
-                    int32 B = Obj->GetIntegerField(TEXT("begin"));
-                    int32 E = Obj->GetIntegerField(TEXT("end"));
-                    EmoteIds.Add(EmId);
-                    EmoteRanges.Add(FIntPoint(B, E));
-                    DownloadEmoteIfNeeded(EmId);
-                }
-            }
+    FTwitchChatMetrics::Inc(ETwitchChatCounter::HedgeDuplicates);
+    if (!Repeat.bSameTransport)
+    {
+        FTwitchChatMetrics::Time(Repeat.FirstTransport == ETwitchChatTransport::Irc ? ETwitchChatTimer::HedgeLeadIrc : ETwitchChatTimer::HedgeLeadEventSub,
+            Repeat.LeadSeconds);
+        UE_LOG(LogTwitchChat, VeryVerbose, TEXT("Hedge: %s first by %.1f ms (%s)"),
+            GetTransportName(Repeat.FirstTransport), Repeat.LeadSeconds * 1000.0, *MessageId);
+    }
+    return false;
+}
+
+void FTwitchChatConnection::StopConduit()
+{
+    if (TSharedPtr<FTwitchChatConduit> Old = MoveTemp(Conduit))
+    {
+        Old->Stop();
+    }
+}
+
+TSharedPtr<IWebSocket> FTwitchChatConnection::OpenSocket(const FString& Url)
+{
+    TSharedPtr<IWebSocket> NewSocket = FWebSocketsModule::Get().CreateWebSocket(Url, TEXT(""));
+    TWeakPtr<IWebSocket> Weak = NewSocket;
+
+    // Sockets that were replaced or closed by us keep firing events; only the live ones count
+    NewSocket->OnConnected().AddLambda([this, Weak]()
+        {
+            if (!IsCurrentSocket(Weak))
+                return;
+            LastActivityTime = FPlatformTime::Seconds();
+            MarkConnectStage(ETwitchChatConnectStage::SocketOpen);
+            UE_LOG(LogTwitchChat, Log, TEXT("WS connected; awaiting session_welcome"));
+        });
 
-            M.EmoteIds = MoveTemp(EmoteIds);
-            M.EmoteRanges = MoveTemp(EmoteRanges);
+    NewSocket->OnConnectionError().AddLambda([this, Weak](const FString& Err)
+        {
+            if (!IsCurrentSocket(Weak))
+                return;
+            FTwitchChatMetrics::Inc(ETwitchChatCounter::SocketErrors);
+            UE_LOG(LogTwitchChat, Error, TEXT("WS error: %s"), *Err);
+            HandleSessionLost(Err);
+        });
+
+    NewSocket->OnClosed().AddLambda([this, Weak](int32 Code, const FString& Reason, bool)
+        {
+            if (!IsCurrentSocket(Weak))
+                return;
+            FTwitchChatMetrics::Inc(ETwitchChatCounter::SocketClosed);
+            UE_LOG(LogTwitchChat, Warning, TEXT("WS closed: %d (%s)"), Code, *Reason);
 
-     
-            if (Evt->HasField(TEXT("color")) && !Evt->GetStringField(TEXT("color")).IsEmpty())
+            // Twitch may close the migrating socket before the new one says hello
+            if (State == ETwitchChatConnectionState::Migrating && Weak.Pin() == Socket)
             {
-                M.UserColor = FLinearColor(FColor::FromHex(Evt->GetStringField(TEXT("color"))));
+                Socket.Reset();
+                return;
             }
-            else
+            HandleSessionLost(FString::Printf(TEXT("closed %d %s"), Code, *Reason));
+        });
+
+    NewSocket->OnMessage().AddLambda([this, Weak](const FString& Msg)
+        {
+            if (IsCurrentSocket(Weak))
+                HandleSocketFrame(Msg);
+        });
+
+    // Some servers (e.g. UE's WebSocketNetworking, used by the local emulator) only send binary frames
+    TSharedRef<TArray<uint8>> BinaryFrame = MakeShared<TArray<uint8>>();
+    NewSocket->OnBinaryMessage().AddLambda([this, Weak, BinaryFrame](const void* Data, SIZE_T Size, bool bIsLastFragment)
+        {
+            BinaryFrame->Append(static_cast<const uint8*>(Data), Size);
+            if (bIsLastFragment)
             {
-                M.UserColor = FLinearColor(FColor::FromHex(TEXT("#6441A4")));
+                FUTF8ToTCHAR Text(reinterpret_cast<const ANSICHAR*>(BinaryFrame->GetData()), BinaryFrame->Num());
+                BinaryFrame->Reset();
+                if (IsCurrentSocket(Weak))
+                    HandleSocketFrame(FString(Text.Length(), Text.Get()));
             }
+        });
+
+    if (!TickHandle.IsValid())
+    {
+        TickHandle = FTSTicker::GetCoreTicker().AddTicker(
+            FTickerDelegate::CreateSP(this, &FTwitchChatConnection::TickConnection), 0.25f);
+    }
+
+    LastActivityTime = FPlatformTime::Seconds();
+    NewSocket->Connect();
+    return NewSocket;
+}
+
+void FTwitchChatConnection::CloseSocket(TSharedPtr<IWebSocket>& InSocket)
+{
+    // Reset first so the resulting OnClosed is recognised as stale
+    if (TSharedPtr<IWebSocket> Old = MoveTemp(InSocket))
+    {
+        Old->Close();
+    }
+}
+
+bool FTwitchChatConnection::IsCurrentSocket(const TWeakPtr<IWebSocket>& InSocket) const
+{
+    const TSharedPtr<IWebSocket> Pinned = InSocket.Pin();
+    return Pinned.IsValid() && (Pinned == Socket || Pinned == PendingSocket);
+}
+
+const TCHAR* FTwitchChatConnection::GetTransportName(ETwitchChatTransport Transport)
+{
+    return Transport == ETwitchChatTransport::Irc ? TEXT("irc") : TEXT("eventsub");
+}
+
+const TCHAR* FTwitchChatConnection::GetStateName(ETwitchChatConnectionState InState)
+{
+    switch (InState)
+    {
+    case ETwitchChatConnectionState::Disconnected: return TEXT("disconnected");
+    case ETwitchChatConnectionState::Authorizing:  return TEXT("authorizing");
+    case ETwitchChatConnectionState::Connecting:   return TEXT("connecting");
+    case ETwitchChatConnectionState::Subscribing:  return TEXT("subscribing");
+    case ETwitchChatConnectionState::Connected:    return TEXT("connected");
+    case ETwitchChatConnectionState::Migrating:    return TEXT("migrating");
+    case ETwitchChatConnectionState::Backoff:      return TEXT("backoff");
+    default:                                       return TEXT("unknown");
+    }
+}
 
-         
-            const UTwitchChatSettings* Settings = GetDefault<UTwitchChatSettings>();
-            if (Settings->AutoDownloadEmotes && M.EmoteIds.Num() > 0)
+void FTwitchChatConnection::Post(uint32 PostEpoch, TUniqueFunction<void()>&& Task)
+{
+    Executor->Post([this, PostEpoch, Task = MoveTemp(Task)]()
+        {
+            if (PostEpoch != GetEpoch())
             {
-                double TimeoutSecs = Settings->EmoteRenderTimeoutSeconds;            
-                double Deadline = FPlatformTime::Seconds() + TimeoutSecs;
-                AllEmotesDownloaded(M.EmoteIds, Deadline);                         
+                FTwitchChatMetrics::Inc(ETwitchChatCounter::StaleDropped);
+                return;
             }
-
-         
-            AsyncTask(ENamedThreads::GameThread, [this, M = MoveTemp(M)]()
-                {
-                    OnMessage.Broadcast(M);
-                });
+            Task();
         });
 }
 
+const TCHAR* FTwitchChatConnection::GetConnectStageName(ETwitchChatConnectStage Stage)
+{
+    switch (Stage)
+    {
+    case ETwitchChatConnectStage::Connect:       return TEXT("connect");
+    case ETwitchChatConnectStage::TokenReady:    return TEXT("token ready");
+    case ETwitchChatConnectStage::SocketOpen:    return TEXT("socket open");
+    case ETwitchChatConnectStage::SessionReady:  return TEXT("session ready");
+    case ETwitchChatConnectStage::IdsResolved:   return TEXT("ids resolved");
+    case ETwitchChatConnectStage::SubscribeSent: return TEXT("subscribe sent");
+    case ETwitchChatConnectStage::Subscribed:    return TEXT("subscribed");
+    case ETwitchChatConnectStage::FirstMessage:  return TEXT("first message");
+    default:                                     return TEXT("unknown");
+    }
+}
 
+bool FTwitchChatConnection::MarkConnectStage(ETwitchChatConnectStage Stage)
+{
+    double& Time = ConnectStageTimes[int32(Stage)];
+    if (Time > 0.0 || ConnectStageTimes[int32(ETwitchChatConnectStage::Connect)] == 0.0)
+        return false;
+    Time = FPlatformTime::Seconds();
+    return true;
+}
 
+double FTwitchChatConnection::GetConnectStageTime(ETwitchChatConnectStage Stage) const
+{
+    const double Start = ConnectStageTimes[int32(ETwitchChatConnectStage::Connect)];
+    const double Time = ConnectStageTimes[int32(Stage)];
+    return Start > 0.0 && Time > 0.0 ? Time - Start : -1.0;
+}
 
-void FTwitchChatConnection::SetupWebSocket()
+void FTwitchChatConnection::LogConnectTimeline() const
+{
+    if (GetConnectStageTime(ETwitchChatConnectStage::Connect) < 0.0)
+    {
+        UE_LOG(LogTwitchChat, Display, TEXT("No connect since startup"));
+        return;
+    }
+
+    UE_LOG(LogTwitchChat, Display, TEXT("Connect timeline (%s start):"), bWarmStart ? TEXT("warm") : TEXT("cold"));
+    for (int32 i = 1; i < int32(ETwitchChatConnectStage::Num); ++i)
+    {
+        const double Time = GetConnectStageTime(ETwitchChatConnectStage(i));
+        if (Time < 0.0)
+            UE_LOG(LogTwitchChat, Display, TEXT("  %-15s        -"), GetConnectStageName(ETwitchChatConnectStage(i)));
+        else
+            UE_LOG(LogTwitchChat, Display, TEXT("  %-15s %7.0f ms"), GetConnectStageName(ETwitchChatConnectStage(i)), Time * 1000.0);
+    }
+
+    // Subscribing needs the session and the ids (and, cold, the token); the last of them gated it
+    const ETwitchChatConnectStage Gates[] = { ETwitchChatConnectStage::TokenReady, ETwitchChatConnectStage::SessionReady, ETwitchChatConnectStage::IdsResolved };
+    const double Sent = GetConnectStageTime(ETwitchChatConnectStage::SubscribeSent);
+    double Latest = -1.0;
+    ETwitchChatConnectStage Gate = ETwitchChatConnectStage::Connect;
+    for (ETwitchChatConnectStage Stage : Gates)
+    {
+        const double Time = GetConnectStageTime(Stage);
+        if (Time >= 0.0 && Time <= Sent && Time > Latest && !(bWarmStart && Stage == ETwitchChatConnectStage::TokenReady))
+        {
+            Latest = Time;
+            Gate = Stage;
+        }
+    }
+    if (Sent >= 0.0 && Latest >= 0.0)
+    {
+        UE_LOG(LogTwitchChat, Display, TEXT("  critical path: subscribing waited on %s"), GetConnectStageName(Gate));
+    }
+}
+
+void FTwitchChatConnection::SetState(ETwitchChatConnectionState NewState)
+{
+    check(IsInGameThread());
+    if (State == NewState)
+        return;
+
+    UE_LOG(LogTwitchChat, Verbose, TEXT("Connection: %s -> %s"), GetStateName(State), GetStateName(NewState));
+    State = NewState;
+    if (State == ETwitchChatConnectionState::Connected)
+    {
+        ReconnectAttempt = 0;
+    }
+    OnStateChanged.Broadcast(State);
+}
+
+bool FTwitchChatConnection::TickConnection(float /*DeltaTime*/)
+{
+    const double Now = FPlatformTime::Seconds();
+    switch (State)
+    {
+    case ETwitchChatConnectionState::Backoff:
+        if (Now >= NextReconnectTime)
+        {
+            Reconnect();
+        }
+        break;
+
+    case ETwitchChatConnectionState::Connecting:
+    case ETwitchChatConnectionState::Subscribing:
+    case ETwitchChatConnectionState::Connected:
+    {
+        if (Conduit || !GetDefault<UTwitchChatSettings>()->bUseEventSub)
+            break;
+
+        // Twitch sends a keepalive whenever the session is otherwise idle for keepalive_timeout_seconds
+        const int32 Keepalive = SessionKeepaliveSeconds > 0
+            ? SessionKeepaliveSeconds
+            : FMath::Clamp(GetDefault<UTwitchChatSettings>()->KeepaliveTimeoutSeconds, 10, 600);
+        if (Now - LastActivityTime > Keepalive + 2.0)
+        {
+            FTwitchChatMetrics::Inc(ETwitchChatCounter::KeepaliveTimeouts);
+            HandleSessionLost(FString::Printf(TEXT("no frames for %.1f s"), Now - LastActivityTime));
+        }
+        break;
+    }
+
+    case ETwitchChatConnectionState::Migrating:
+        // Twitch keeps the old session for 30 s after session_reconnect
+        if (Now - MigrationStartTime > 30.0)
+        {
+            HandleSessionLost(TEXT("session_reconnect target never sent session_welcome"));
+        }
+        break;
+
+    default:
+        break;
+    }
+    return true;
+}
+
+void FTwitchChatConnection::HandleSessionLost(const FString& Reason)
 {
+    if (State == ETwitchChatConnectionState::Disconnected || State == ETwitchChatConnectionState::Backoff)
+        return;
+
+    CloseSocket(Socket);
+    CloseSocket(PendingSocket);
+    StopConduit();
+    SessionId.Empty();
+    bGotWelcome = false;
+    ResetSubscriptions();
+
     const UTwitchChatSettings* S = GetDefault<UTwitchChatSettings>();
+    if (!S->bAutoReconnect)
+    {
+        UE_LOG(LogTwitchChat, Warning, TEXT("Session lost (%s); auto reconnect is off"), *Reason);
+        SetState(ETwitchChatConnectionState::Disconnected);
+        return;
+    }
 
-    
-    int32 KA = FMath::Clamp(S->KeepaliveTimeoutSeconds, 10, 600);
+    const double Delay = GetReconnectDelay(ReconnectAttempt++);
 
-    
-    FString URL = FString::Printf(
-        TEXT("wss://eventsub.wss.twitch.tv/ws?keepalive_timeout_seconds=%d"),
-        KA
-    );
+    UE_LOG(LogTwitchChat, Warning, TEXT("Session lost (%s); reconnect %d in %.2f s"), *Reason, ReconnectAttempt, Delay);
+    NextReconnectTime = FPlatformTime::Seconds() + Delay;
+    SetState(ETwitchChatConnectionState::Backoff);
+}
+
+double FTwitchChatConnection::GetReconnectDelay(int32 Attempt)
+{
+    // Full jitter on the first retry, equal jitter after; keeps a fleet of clients from reconnecting in lockstep
+    const UTwitchChatSettings* S = GetDefault<UTwitchChatSettings>();
+    const double Base = FMath::Max(0.05f, S->ReconnectBaseDelaySeconds);
+    const double Cap = FMath::Max(Base, double(S->ReconnectMaxDelaySeconds));
+    return Attempt == 0
+        ? FMath::FRandRange(0.0, Base)
+        : FMath::Min(Cap, Base * FMath::Pow(2.0, double(FMath::Min(Attempt, 16)))) * FMath::FRandRange(0.5, 1.0);
+}
+
+void FTwitchChatConnection::Reconnect()
+{
+    FTwitchChatMetrics::Inc(ETwitchChatCounter::Reconnects);
+
+    if (!FTwitchChatAuth::Get()->HasToken())
+    {
+        BeginAuthFlow();
+        return;
+    }
+    OpenSession();
+}
+
+void FTwitchChatConnection::HandleSessionMessage(const FString& MessageType, TSharedPtr<FJsonObject> Root)
+{
+    if (bReplaying || State == ETwitchChatConnectionState::Disconnected)
+        return;
 
+    const TSharedPtr<FJsonObject>* Payload = nullptr;
+    if (!Root->TryGetObjectField(TEXT("payload"), Payload))
+        return;
 
-    Socket = FWebSocketsModule::Get().CreateWebSocket(URL, TEXT(""));
+    if (MessageType == TEXT("session_welcome") || MessageType == TEXT("session_reconnect"))
+    {
+        const TSharedPtr<FJsonObject>* Session = nullptr;
+        if (!(*Payload)->TryGetObjectField(TEXT("session"), Session))
+            return;
 
-    Socket->OnConnected().AddLambda([]()
+        if (MessageType == TEXT("session_reconnect"))
         {
-            UE_LOG(LogTwitchChat, Log, TEXT("WS connected; awaiting session_welcome"));
-        });
+            FString Url;
+            if (!(*Session)->TryGetStringField(TEXT("reconnect_url"), Url) || State == ETwitchChatConnectionState::Migrating)
+                return;
+
+            // Zero-gap handover: the old socket keeps delivering until the new one is welcomed
+            UE_LOG(LogTwitchChat, Log, TEXT("session_reconnect; migrating to %s"), *Url);
+            MigrationStartTime = FPlatformTime::Seconds();
+            SetState(ETwitchChatConnectionState::Migrating);
+            PendingSocket = OpenSocket(Url);
+            return;
+        }
 
-    Socket->OnConnectionError().AddLambda([](const FString& Err)
+        int32 Keepalive = 0;
+        if ((*Session)->TryGetNumberField(TEXT("keepalive_timeout_seconds"), Keepalive) && Keepalive > 0)
         {
-            UE_LOG(LogTwitchChat, Error, TEXT("WS error: %s"), *Err);
-        });
+            SessionKeepaliveSeconds = Keepalive;
+        }
+        (*Session)->TryGetStringField(TEXT("id"), SessionId);
+        bGotWelcome = true;
+        MarkConnectStage(ETwitchChatConnectStage::SessionReady);
 
-    Socket->OnClosed().AddLambda([](int32 Code, const FString& Reason, bool)
+        if (State == ETwitchChatConnectionState::Migrating && PendingSocket.IsValid())
         {
-            UE_LOG(LogTwitchChat, Warning, TEXT("WS closed: %d (%s)"), Code, *Reason);
-        });
+            // Subscriptions move with the session; nothing to resubscribe
+            CloseSocket(Socket);
+            Socket = MoveTemp(PendingSocket);
+            FTwitchChatMetrics::Inc(ETwitchChatCounter::SessionMigrations);
+            UE_LOG(LogTwitchChat, Log, TEXT("Session migrated in %.0f ms"), (FPlatformTime::Seconds() - MigrationStartTime) * 1000.0);
+            const bool bAnySubscribed = Channels.ContainsByPredicate([](const FChannel& Channel) { return !Channel.SubscriptionId.IsEmpty(); });
+            SetState(bAnySubscribed || Channels.Num() == 0 ? ETwitchChatConnectionState::Connected : ETwitchChatConnectionState::Subscribing);
+            TrySubscribe();
+            return;
+        }
+
+        SetState(ETwitchChatConnectionState::Subscribing);
+        TrySubscribe();
+        return;
+    }
 
-    Socket->OnMessage().AddLambda([this](const FString& Msg)
+    if (MessageType == TEXT("revocation"))
+    {
+        // One subscription is gone; the session and every other subscription on it carry on
+        FTwitchChatMetrics::Inc(ETwitchChatCounter::Revocations);
+        FString Status, SubscriptionId, Type;
+        const TSharedPtr<FJsonObject>* Subscription = nullptr;
+        if ((*Payload)->TryGetObjectField(TEXT("subscription"), Subscription))
         {
-            HandleWebSocketMessage(Msg);
-        });
+            (*Subscription)->TryGetStringField(TEXT("status"), Status);
+            (*Subscription)->TryGetStringField(TEXT("id"), SubscriptionId);
+            (*Subscription)->TryGetStringField(TEXT("type"), Type);
+        }
+        if (SubscriptionId.IsEmpty())
+        {
+            UE_LOG(LogTwitchChat, Warning, TEXT("Revocation without a subscription id (%s): %s"), *Type, *Status);
+            return;
+        }
+
+        for (FChannel& Channel : Channels)
+        {
+            if (Channel.EventSubscriptionIds.Remove(SubscriptionId) > 0)
+            {
+                UE_LOG(LogTwitchChat, Warning, TEXT("%s subscription for %s revoked: %s"), *Type, *Channel.Login, *Status);
+                return;
+            }
+        }
+
+        FChannel* Channel = Channels.FindByPredicate([&SubscriptionId](const FChannel& C) { return C.SubscriptionId == SubscriptionId; });
+        if (!Channel)
+        {
+            // Left the channel since, or a subscription from another run
+            UE_LOG(LogTwitchChat, Log, TEXT("Revocation for unknown subscription %s (%s): %s"), *SubscriptionId, *Type, *Status);
+            return;
+        }
+
+        const FString Login = Channel->Login;
+        UE_LOG(LogTwitchChat, Warning, TEXT("Chat subscription for %s revoked: %s"), *Login, *Status);
+        Channel->SubscriptionId.Empty();
 
-   
-    Socket->Connect();
+        if (Status == TEXT("user_removed"))
+        {
+            RemoveChannel(Login);
+        }
+        else if (Status == TEXT("authorization_revoked"))
+        {
+            FTwitchChatAuth::Get()->Refresh([this, SessionEpoch = GetEpoch()](bool bRefreshed)
+                {
+                    if (SessionEpoch != GetEpoch())
+                        return;
+                    if (bRefreshed)
+                        TrySubscribe();
+                    else
+                        UE_LOG(LogTwitchChat, Error, TEXT("Token refresh failed; revoked subscriptions stay down until the next connect"));
+                });
+        }
+        else
+        {
+            // version_removed: resubscribing cannot succeed, and the other channels are unaffected
+            UE_LOG(LogTwitchChat, Error, TEXT("Chat for %s stopped; channel.chat.message no longer accepts this version"), *Login);
+        }
+    }
 }
 
 
@@ -502,106 +2001,147 @@ bool FTwitchChatConnection::DownloadEmoteIfNeeded(const FString& EmoteId)
     const FString Dir = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("FetchedEmotes"));
     const FString Path = FPaths::Combine(Dir, EmoteId + TEXT(".png"));
     if (FPaths::FileExists(Path))
+    {
+        INC_DWORD_STAT(STAT_TwitchChat_EmoteDiskHits);
+        FTwitchChatMetrics::Inc(ETwitchChatCounter::EmoteDiskHits);
         return true;
+    }
+    INC_DWORD_STAT(STAT_TwitchChat_EmoteDiskMisses);
+    FTwitchChatMetrics::Inc(ETwitchChatCounter::EmoteDiskMisses);
+    {
+        FScopeLock ScopeLock(&EmoteFetchLock);
+        bool bAlreadyFetching = false;
+        EmoteFetches.Add(EmoteId, &bAlreadyFetching);
+        if (bAlreadyFetching)
+            return false;
+    }
+    SCOPE_CYCLE_COUNTER(STAT_TwitchChat_EmoteFetch);
 
     IFileManager::Get().MakeDirectory(*Dir, /*Tree=*/true);
     auto Req = FHttpModule::Get().CreateRequest();
     Req->SetURL(FString::Printf(
-        TEXT("https://static-cdn.jtvnw.net/emoticons/v2/%s/default/dark/3.0"),
-        *EmoteId
+        TEXT("%s/emoticons/v2/%s/default/dark/3.0"),
+        *GetDefault<UTwitchChatSettings>()->GetEmoteCdnBaseUrl(), *EmoteId
     ));
     Req->SetVerb(TEXT("GET"));
     Req->OnProcessRequestComplete().BindLambda(
-        [Path](FHttpRequestPtr, FHttpResponsePtr Resp, bool bOK)
+        [this, Path, EmoteId](FHttpRequestPtr, FHttpResponsePtr Resp, bool bOK)
         {
+            LLM_SCOPE_BYTAG(TwitchChat_EmoteCache);
+            ON_SCOPE_EXIT
+            {
+                {
+                    FScopeLock ScopeLock(&EmoteFetchLock);
+                    EmoteFetches.Remove(EmoteId);
+                }
+                // Messages parked on this emote may go now, found or not
+                Executor->Post([this]() { ReleaseParked(); });
+            };
+            FTwitchChatMetrics::Add(ETwitchChatGauge::EmoteDownloadsInFlight, -1);
             if (bOK && Resp.IsValid()
                 && EHttpResponseCodes::IsOk(Resp->GetResponseCode()))
             {
                 FFileHelper::SaveArrayToFile(Resp->GetContent(), *Path);
             }
+            else
+            {
+                FTwitchChatMetrics::Inc(ETwitchChatCounter::EmoteDownloadFailures);
+            }
         }
     );
-    return Req->ProcessRequest();
+    // The completion callback runs even when the request fails to start
+    FTwitchChatMetrics::Add(ETwitchChatGauge::EmoteDownloadsInFlight, 1);
+    Req->ProcessRequest();
+    return false;
 }
-
-bool FTwitchChatConnection::AllEmotesDownloaded(
-    const TArray<FString>& EmoteIds,
-    double Deadline
-)
-{
-    while (FPlatformTime::Seconds() < Deadline)
-    {
-        bool bAll = true;
-        for (const FString& Id : EmoteIds)
+static FAutoConsoleCommand GTwitchChatHedgeCmd(
+    TEXT("twitchchat.hedge"),
+    TEXT("Compare EventSub and IRC when both are on: which received each message first and by how much."),
+    FConsoleCommandDelegate::CreateLambda([]()
         {
-            const FString P = FPaths::Combine(
-                FPaths::ProjectSavedDir(), TEXT("FetchedEmotes"), Id + TEXT(".png")
-            );
-            if (!FPaths::FileExists(P))
+            const FTwitchChatMetrics& Metrics = FTwitchChatMetrics::Get();
+            const int64 Admitted = Metrics.GetCounter(ETwitchChatCounter::HedgeFirstEventSub) + Metrics.GetCounter(ETwitchChatCounter::HedgeFirstIrc);
+            int64 Paired = 0;
+
+            UE_LOG(LogTwitchChat, Display, TEXT("Hedging %s"), FTwitchChatConnection::Get()->IsHedging() ? TEXT("on") : TEXT("off"));
+            UE_LOG(LogTwitchChat, Display, TEXT("%-9s %9s %9s %9s %9s %9s %9s"),
+                TEXT("first"), TEXT("dispatched"), TEXT("won"), TEXT("lead p50"), TEXT("p90"), TEXT("p99"), TEXT("max ms"));
+            for (ETwitchChatTransport Transport : { ETwitchChatTransport::EventSub, ETwitchChatTransport::Irc })
             {
-                bAll = false;
-                break;
+                const bool bIrc = Transport == ETwitchChatTransport::Irc;
+                const FTwitchChatLatencySummary Lead = Metrics.GetTimer(bIrc ? ETwitchChatTimer::HedgeLeadIrc : ETwitchChatTimer::HedgeLeadEventSub).Summarize();
+                Paired += Lead.Count;
+                UE_LOG(LogTwitchChat, Display, TEXT("%-9s %9lld %9lld %9.2f %9.2f %9.2f %9.2f"),
+                    FTwitchChatConnection::GetTransportName(Transport),
+                    Metrics.GetCounter(bIrc ? ETwitchChatCounter::HedgeFirstIrc : ETwitchChatCounter::HedgeFirstEventSub),
+                    Lead.Count, Lead.P50Ms, Lead.P90Ms, Lead.P99Ms, Lead.MaxMs);
+            }
+            UE_LOG(LogTwitchChat, Display, TEXT("%lld messages seen on one transport only (so far)"), FMath::Max<int64>(0, Admitted - Paired));
+        })
+);
+
+static FAutoConsoleCommand GTwitchChatTimelineCmd(
+    TEXT("twitchchat.timeline"),
+    TEXT("When each stage of the latest Connect finished, from Connect to the first chat message."),
+    FConsoleCommandDelegate::CreateLambda([]()
+        {
+            FTwitchChatConnection::Get()->LogConnectTimeline();
+        })
+);
+
+//-----------------------------------------------------------------------------
+// Record / replay console commands
+//-----------------------------------------------------------------------------
+static TSharedPtr<FTwitchChatReplaySource> GActiveReplay;
+
+static FAutoConsoleCommand GTwitchChatRecordCmd(
+    TEXT("twitchchat.record"),
+    TEXT("Toggle recording of raw EventSub frames. Usage: twitchchat.record [Path]"),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+        {
+            TSharedRef<FTwitchChatConnection> Conn = FTwitchChatConnection::Get();
+            if (Conn->IsRecording())
+            {
+                Conn->StopRecording();
+                return;
+            }
+            Conn->StartRecording(Args.Num() > 0 ? Args[0] : FTwitchChatTrafficRecorder::MakeDefaultPath());
+        })
+);
+
+static FAutoConsoleCommand GTwitchChatReplayCmd(
+    TEXT("twitchchat.replay"),
+    TEXT("Replay a recording through the chat pipeline. Usage: twitchchat.replay <Path> [Speed, 0 = max]"),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+        {
+            if (Args.Num() < 1)
+            {
+                UE_LOG(LogTwitchChat, Warning, TEXT("Usage: twitchchat.replay <Path> [Speed]"));
+                return;
+            }
+            if (GActiveReplay.IsValid() && GActiveReplay->IsRunning())
+            {
+                UE_LOG(LogTwitchChat, Warning, TEXT("Replay already running; use twitchchat.replay.stop"));
+                return;
             }
-        }
-        if (bAll)
-            return true;
-        FPlatformProcess::Sleep(0.1f);
-    }
-    return false;
-}
-void FTwitchChatConnection::RefreshOAuthToken(TFunction<void(bool)> OnComplete)
-{
-    const UTwitchChatSettings* S = GetDefault<UTwitchChatSettings>();
-    if (S->RefreshToken.IsEmpty())
-    {
-        UE_LOG(LogTwitchChat, Error, TEXT("No refresh token available"));
-        OnComplete(false);
-        return;
-    }
 
-    auto Req = FHttpModule::Get().CreateRequest();
-    Req->SetURL(TEXT("https://id.twitch.tv/oauth2/token"));
-    Req->SetVerb(TEXT("POST"));
-    Req->SetHeader(TEXT("Content-Type"), TEXT("application/x-www-form-urlencoded"));
-    FString Body = FString::Printf(
-        TEXT("grant_type=refresh_token&refresh_token=%s&client_id=%s&client_secret=%s"),
-        *S->RefreshToken, *S->ClientId, *S->ClientSecret
-    );
-    Req->SetContentAsString(Body);
+            TArray<FTwitchChatReplaySource::FFrame> Frames;
+            if (!FTwitchChatReplaySource::LoadFile(Args[0], Frames))
+                return;
 
-    Req->OnProcessRequestComplete().BindLambda(
-        [this, OnComplete](FHttpRequestPtr, FHttpResponsePtr Resp, bool bOK)
+            GActiveReplay = MakeShared<FTwitchChatReplaySource>(FTwitchChatConnection::Get(), MoveTemp(Frames));
+            GActiveReplay->Start(Args.Num() > 1 ? FCString::Atof(*Args[1]) : 1.f);
+        })
+);
+
+static FAutoConsoleCommand GTwitchChatReplayStopCmd(
+    TEXT("twitchchat.replay.stop"),
+    TEXT("Stop the running replay."),
+    FConsoleCommandDelegate::CreateLambda([]()
         {
-            if (bOK && Resp.IsValid() && Resp->GetResponseCode() == 200)
+            if (GActiveReplay.IsValid())
             {
-                TSharedPtr<FJsonObject> J;
-                TSharedRef<TJsonReader<>> R = TJsonReaderFactory<>::Create(Resp->GetContentAsString());
-                if (FJsonSerializer::Deserialize(R, J))
-                {
-                    if (UTwitchChatSettings* M = GetMutableDefault<UTwitchChatSettings>())
-                    {
-                        if (J->HasField(TEXT("access_token")))
-                        {
-                            M->AccessToken = J->GetStringField(TEXT("access_token"));
-                            OAuthToken = M->AccessToken;
-                        }
-                        if (J->HasField(TEXT("refresh_token")))
-                        {
-                            M->RefreshToken = J->GetStringField(TEXT("refresh_token"));
-                        }
-                        M->SaveConfig();  
-                        UE_LOG(LogTwitchChat, Log, TEXT("Tokens saved to INI after refresh."));
-                        OnComplete(true);
-                        return;
-                    }
-                }
+                GActiveReplay->Stop();
             }
-            UE_LOG(LogTwitchChat, Error,
-                TEXT("Failed to refresh OAuth token: %s"),
-                Resp.IsValid() ? *Resp->GetContentAsString() : TEXT("no-response")
-            );
-            OnComplete(false);
-        }
-    );
-    Req->ProcessRequest();
-}
+        })
+);
@@ -0,0 +1,93 @@
+#include "TwitchChatDedup.h"
+#include "Hash/CityHash.h"
+
+namespace TwitchChatDedup
+{
+    // [fingerprint:39][arrival:24][transport:1]; never 0, which marks an empty slot
+    static uint64 GetTag(uint64 Word) { return Word >> 25; }
+    static uint32 GetArrival(uint64 Word) { return uint32(Word >> 1) & ((1u << 24) - 1); }
+    static ETwitchChatTransport GetTransport(uint64 Word) { return ETwitchChatTransport(Word & 1); }
+}
+
+FTwitchChatDedup::FTwitchChatDedup(int32 CapacityLog2, double InWindowSeconds)
+{
+    const uint32 Capacity = 1u << FMath::Clamp(CapacityLog2, 8, 24);
+    Slots = MakeUnique<std::atomic<uint64>[]>(Capacity);
+    Mask = Capacity - 1;
+    // Ages are signed and taken modulo the 24-bit clock, so they span about +-14 minutes; the window stays well inside
+    WindowTicks = uint32(FMath::Clamp(InWindowSeconds, 1.0, 600.0) * TicksPerSecond);
+    Reset();
+}
+
+void FTwitchChatDedup::Reset()
+{
+    for (uint32 i = 0; i <= Mask; ++i)
+    {
+        Slots[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+bool FTwitchChatDedup::Admit(const FString& Id, ETwitchChatTransport Transport, double ReceivedTime, FRepeat& OutRepeat)
+{
+    using namespace TwitchChatDedup;
+
+    FTCHARToUTF8 Utf8(*Id, Id.Len());
+    const uint64 Hash = CityHash64(Utf8.Get(), Utf8.Length());
+    const uint64 Tag = (Hash >> 25) | 1;
+    const uint32 Now = uint32(uint64(ReceivedTime * TicksPerSecond) & TimeMask);
+    const uint64 Word = (Tag << 25) | (uint64(Now) << 1) | uint64(Transport);
+    const uint32 Start = uint32(Hash) & Mask;
+
+    // Signed, since a frame stamped earlier can reach Admit after one stamped later on another thread
+    auto Age = [Now](uint64 Seen)
+        {
+            return int32(((Now - GetArrival(Seen)) & uint32(TimeMask)) << (32 - TimeBits)) >> (32 - TimeBits);
+        };
+    // Past the window, or too far "ahead" to be a concurrent frame: an arrival from over half the clock range ago
+    auto IsExpired = [this, &Age](uint64 Seen)
+        {
+            const int32 SeenAge = Age(Seen);
+            return SeenAge > int32(WindowTicks) || SeenAge < -SkewTicks;
+        };
+    auto Repeat = [&](uint64 Seen)
+        {
+            const int32 Lead = Age(Seen);
+            OutRepeat.FirstTransport = Lead >= 0 ? GetTransport(Seen) : Transport;
+            OutRepeat.LeadSeconds = FMath::Abs(Lead) / TicksPerSecond;
+            OutRepeat.bSameTransport = GetTransport(Seen) == Transport;
+            return false;
+        };
+
+    // Look for the id across the whole run first, so a reclaimed slot ahead of it cannot shadow it
+    uint64 Seen[MaxProbes];
+    for (int32 Probe = 0; Probe < MaxProbes; ++Probe)
+    {
+        Seen[Probe] = Slots[(Start + Probe) & Mask].load(std::memory_order_acquire);
+        if (Seen[Probe] != 0 && GetTag(Seen[Probe]) == Tag && !IsExpired(Seen[Probe]))
+            return Repeat(Seen[Probe]);
+    }
+
+    // Near-simultaneous arrivals pick the same first free slot; the loser of the CAS sees the winner
+    int32 Oldest = 0;
+    for (int32 Probe = 0; Probe < MaxProbes; ++Probe)
+    {
+        std::atomic<uint64>& Slot = Slots[(Start + Probe) & Mask];
+        while (Seen[Probe] == 0 || IsExpired(Seen[Probe]))
+        {
+            if (Slot.compare_exchange_weak(Seen[Probe], Word, std::memory_order_acq_rel))
+                return true;
+            if (GetTag(Seen[Probe]) == Tag && !IsExpired(Seen[Probe]))
+                return Repeat(Seen[Probe]);
+        }
+        if (Age(Seen[Probe]) > Age(Seen[Oldest]))
+        {
+            Oldest = Probe;
+        }
+    }
+
+    // Every slot in the run is live (ages within [-SkewTicks, WindowTicks]); evict the oldest rather than drop a new message
+    std::atomic<uint64>& Victim = Slots[(Start + Oldest) & Mask];
+    if (!Victim.compare_exchange_strong(Seen[Oldest], Word, std::memory_order_acq_rel) && GetTag(Seen[Oldest]) == Tag)
+        return Repeat(Seen[Oldest]);
+    return true;
+}
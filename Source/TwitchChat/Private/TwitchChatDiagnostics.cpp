@@ -0,0 +1,280 @@
+#include "TwitchChatDiagnostics.h"
+#include "TwitchChatConnection.h"
+#include "TwitchChatHistoryLog.h"
+#include "TwitchChatLatency.h"
+#include "TwitchChatMetrics.h"
+
+#include "AnimatedTexture2D.h"
+#include "AnimatedTextureModule.h"
+#include "Widgets/SLeafWidget.h"
+#include "Widgets/SBoxPanel.h"
+#include "Widgets/Layout/SBox.h"
+#include "Widgets/Layout/SScrollBox.h"
+#include "Widgets/Text/STextBlock.h"
+#include "Rendering/DrawElements.h"
+#include "Styling/CoreStyle.h"
+#include "UObject/UObjectIterator.h"
+
+#define LOCTEXT_NAMESPACE "TwitchChatDiagnostics"
+
+const FName STwitchChatDiagnostics::TabName(TEXT("TwitchChatDiagnostics"));
+
+namespace TwitchChatDiagnostics
+{
+    static constexpr float SampleInterval = 0.25f;
+    static constexpr int32 NumSamples = 240;        // one minute
+
+    static const FLinearColor LineColor(0.39f, 0.25f, 0.64f);
+    static const FLinearColor WarnColor(1.f, 0.55f, 0.1f);
+}
+
+//-----------------------------------------------------------------------------
+// Series
+//-----------------------------------------------------------------------------
+void STwitchChatDiagnostics::FSeries::Push(float Value)
+{
+    if (Samples.Num() < TwitchChatDiagnostics::NumSamples)
+    {
+        Samples.Add(Value);
+        return;
+    }
+    Samples[Head] = Value;
+    Head = (Head + 1) % Samples.Num();
+}
+
+float STwitchChatDiagnostics::FSeries::Latest() const
+{
+    if (Samples.Num() == 0)
+        return 0.f;
+    return Samples[(Head + Samples.Num() - 1) % Samples.Num()];
+}
+
+float STwitchChatDiagnostics::FSeries::Peak() const
+{
+    float Max = 0.f;
+    for (float V : Samples)
+        Max = FMath::Max(Max, V);
+    return Max;
+}
+
+// Sparkline over one series, scaled to its peak in the window
+class STwitchChatSparkline : public SLeafWidget
+{
+public:
+    SLATE_BEGIN_ARGS(STwitchChatSparkline) {}
+    SLATE_END_ARGS()
+
+    void Construct(const FArguments& /*InArgs*/, TSharedPtr<STwitchChatDiagnostics::FSeries> InSeries)
+    {
+        Series = InSeries;
+    }
+
+    virtual FVector2D ComputeDesiredSize(float) const override { return FVector2D(240.f, 28.f); }
+
+    virtual int32 OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect,
+        FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const override
+    {
+        FSlateDrawElement::MakeBox(OutDrawElements, LayerId, AllottedGeometry.ToPaintGeometry(),
+            FCoreStyle::Get().GetBrush("WhiteBrush"), ESlateDrawEffect::None, FLinearColor(0.02f, 0.02f, 0.02f));
+
+        const int32 Num = Series->Samples.Num();
+        if (Num < 2)
+            return LayerId + 1;
+
+        const FVector2D Size = AllottedGeometry.GetLocalSize();
+        const float Peak = FMath::Max(Series->Peak(), KINDA_SMALL_NUMBER);
+        const float Step = Size.X / float(TwitchChatDiagnostics::NumSamples - 1);
+        const float XOffset = Step * float(TwitchChatDiagnostics::NumSamples - Num);
+
+        TArray<FVector2D> Points;
+        Points.Reserve(Num);
+        for (int32 i = 0; i < Num; ++i)
+        {
+            const float V = Series->Samples[(Series->Head + i) % Num];
+            Points.Add(FVector2D(XOffset + i * Step, Size.Y - 1.f - (Size.Y - 2.f) * (V / Peak)));
+        }
+
+        FSlateDrawElement::MakeLines(OutDrawElements, LayerId + 1, AllottedGeometry.ToPaintGeometry(), Points,
+            ESlateDrawEffect::None, Series->IsWarning() ? TwitchChatDiagnostics::WarnColor : TwitchChatDiagnostics::LineColor,
+            /*bAntialias=*/true, 1.5f);
+        return LayerId + 1;
+    }
+
+private:
+    TSharedPtr<STwitchChatDiagnostics::FSeries> Series;
+};
+
+//-----------------------------------------------------------------------------
+// Widget
+//-----------------------------------------------------------------------------
+void STwitchChatDiagnostics::Construct(const FArguments& /*InArgs*/)
+{
+    auto Make = [this](ESeries Index, const FText& Label, int32 Decimals, float WarnAt = 0.f)
+        {
+            Series[Index] = MakeShared<FSeries>();
+            Series[Index]->Label = Label;
+            Series[Index]->Decimals = Decimals;
+            Series[Index]->WarnAt = WarnAt;
+        };
+    Make(MessageRate,        LOCTEXT("MessageRate", "Messages / s"),                0);
+    Make(ParseLatency,       LOCTEXT("ParseLatency", "Parse latency (ms)"),         2, 5.f);
+    Make(DispatchLatency,    LOCTEXT("DispatchLatency", "Dispatch latency (ms)"),   1, 250.f);
+    Make(FramesInFlight,     LOCTEXT("FramesInFlight", "Frames in flight"),         0, 64.f);
+    Make(HistoryQueue,       LOCTEXT("HistoryQueue", "History queue"),              0, 2000.f);
+    Make(EmoteDiskHitRatio,  LOCTEXT("EmoteDiskHits", "Emote disk hits (%)"),       0);
+    Make(EmoteBrushHitRatio, LOCTEXT("EmoteBrushHits", "Emote brush hits (%)"),     0);
+    Make(EmoteDownloads,     LOCTEXT("EmoteDownloads", "Emote downloads in flight"),0, 32.f);
+    Make(AnimatedTextures,   LOCTEXT("AnimatedTextures", "Animated textures"),      0);
+    Make(FramesDecodedRate,  LOCTEXT("FramesDecoded", "Frames decoded / s"),        0);
+    Make(FrameDecodeCost,    LOCTEXT("FrameDecode", "Frame decode (ms)"),           3, 2.f);
+    Make(FrameUploadCost,    LOCTEXT("FrameUpload", "Frame upload (ms)"),           3, 1.f);
+
+    TSharedRef<SVerticalBox> Rows = SNew(SVerticalBox);
+    for (int32 i = 0; i < NumSeries; ++i)
+    {
+        Rows->AddSlot().AutoHeight().Padding(2)[MakeRow(ESeries(i))];
+    }
+
+    ChildSlot
+        [
+            SNew(SVerticalBox)
+
+                + SVerticalBox::Slot().AutoHeight().Padding(4)
+                [
+                    SNew(STextBlock).Text(this, &STwitchChatDiagnostics::GetStatusText)
+                ]
+
+                + SVerticalBox::Slot().FillHeight(1)
+                [
+                    SNew(SScrollBox) + SScrollBox::Slot()[Rows]
+                ]
+        ];
+
+    Last = TakeSnapshot();
+    SampleTimerHandle = RegisterActiveTimer(
+        TwitchChatDiagnostics::SampleInterval,
+        FWidgetActiveTimerDelegate::CreateSP(this, &STwitchChatDiagnostics::Sample)
+    );
+}
+
+STwitchChatDiagnostics::~STwitchChatDiagnostics()
+{
+    if (SampleTimerHandle.IsValid())
+    {
+        UnRegisterActiveTimer(SampleTimerHandle.ToSharedRef());
+    }
+}
+
+TSharedRef<SWidget> STwitchChatDiagnostics::MakeRow(ESeries Index)
+{
+    TSharedPtr<FSeries> S = Series[Index];
+    return SNew(SHorizontalBox)
+
+        + SHorizontalBox::Slot().AutoWidth().VAlign(VAlign_Center)
+        [
+            SNew(SBox).WidthOverride(180)
+                [
+                    SNew(STextBlock)
+                        .Text(S->Label)
+                        .ColorAndOpacity_Lambda([S]() { return S->IsWarning() ? FSlateColor(TwitchChatDiagnostics::WarnColor) : FSlateColor::UseForeground(); })
+                ]
+        ]
+
+        + SHorizontalBox::Slot().AutoWidth().VAlign(VAlign_Center)
+        [
+            SNew(SBox).WidthOverride(140)
+                [
+                    SNew(STextBlock).Text_Lambda([S]()
+                        {
+                            FNumberFormattingOptions Options;
+                            Options.SetMinimumFractionalDigits(S->Decimals).SetMaximumFractionalDigits(S->Decimals);
+                            return FText::Format(LOCTEXT("Value", "{0}  (max {1})"),
+                                FText::AsNumber(S->Latest(), &Options), FText::AsNumber(S->Peak(), &Options));
+                        })
+                ]
+        ]
+
+        + SHorizontalBox::Slot().FillWidth(1).Padding(4, 0, 0, 0)
+        [
+            SNew(STwitchChatSparkline, S)
+        ];
+}
+
+FText STwitchChatDiagnostics::GetStatusText() const
+{
+    TSharedRef<FTwitchChatConnection> Connection = FTwitchChatConnection::Get();
+    const FText State = Connection->IsReplaying()
+        ? LOCTEXT("Replaying", "replaying")
+        : FText::FromString(FTwitchChatConnection::GetStateName(Connection->GetState()));
+
+    const FTwitchChatMetrics& Metrics = FTwitchChatMetrics::Get();
+    return FText::Format(LOCTEXT("Status", "{0}  |  {1} messages, {2} reconnects, {3} parse errors, {4} emote wait timeouts"),
+        State,
+        FText::AsNumber(Metrics.GetCounter(ETwitchChatCounter::MessagesDispatched)),
+        FText::AsNumber(Metrics.GetCounter(ETwitchChatCounter::Reconnects)),
+        FText::AsNumber(Metrics.GetCounter(ETwitchChatCounter::ParseErrors)),
+        FText::AsNumber(Metrics.GetCounter(ETwitchChatCounter::EmoteWaitTimeouts)));
+}
+
+STwitchChatDiagnostics::FSnapshot STwitchChatDiagnostics::TakeSnapshot() const
+{
+    const FTwitchChatMetrics& Metrics = FTwitchChatMetrics::Get();
+    const FTwitchChatLatency& Latency = FTwitchChatLatency::Get();
+    const FAnimatedTextureCounters& Anim = FAnimatedTextureCounters::Get();
+    const FTwitchChatLatencyHistogram& Parse = Latency.GetHistogram(ETwitchChatLatencyStage::Parse);
+    const FTwitchChatLatencyHistogram& Dispatch = Latency.GetHistogram(ETwitchChatLatencyStage::Dispatch);
+
+    FSnapshot S;
+    S.Time = FPlatformTime::Seconds();
+    S.Dispatched = Metrics.GetCounter(ETwitchChatCounter::MessagesDispatched);
+    S.ParseCount = Parse.GetCount();
+    S.ParseSum = Parse.GetSumMicros();
+    S.DispatchCount = Dispatch.GetCount();
+    S.DispatchSum = Dispatch.GetSumMicros();
+    S.DiskHits = Metrics.GetCounter(ETwitchChatCounter::EmoteDiskHits);
+    S.DiskMisses = Metrics.GetCounter(ETwitchChatCounter::EmoteDiskMisses);
+    S.BrushHits = Metrics.GetCounter(ETwitchChatCounter::EmoteBrushHits);
+    S.BrushMisses = Metrics.GetCounter(ETwitchChatCounter::EmoteBrushMisses);
+    S.FramesDecoded = Anim.FramesDecoded.load(std::memory_order_relaxed);
+    S.DecodeCycles = Anim.DecodeCycles.load(std::memory_order_relaxed);
+    S.FramesUploaded = Anim.FramesUploaded.load(std::memory_order_relaxed);
+    S.UploadCycles = Anim.UploadCycles.load(std::memory_order_relaxed);
+    return S;
+}
+
+EActiveTimerReturnType STwitchChatDiagnostics::Sample(double /*InCurrentTime*/, float /*InDeltaTime*/)
+{
+    const FSnapshot Now = TakeSnapshot();
+    const double Elapsed = FMath::Max(Now.Time - Last.Time, 0.001);
+
+    // Interval means; a latency reset makes the delta negative, which reads as an idle interval
+    auto MeanMs = [](int64 Count, int64 SumMicros) { return Count > 0 && SumMicros >= 0 ? float(SumMicros / 1000.0 / Count) : 0.f; };
+    auto Percent = [](int64 Hits, int64 Misses) { return Hits + Misses > 0 ? 100.f * Hits / float(Hits + Misses) : 0.f; };
+    auto CyclesMs = [](uint64 Cycles, uint64 Frames) { return Frames > 0 ? float(FPlatformTime::ToMilliseconds64(Cycles) / Frames) : 0.f; };
+
+    Series[MessageRate]->Push(float((Now.Dispatched - Last.Dispatched) / Elapsed));
+    Series[ParseLatency]->Push(MeanMs(Now.ParseCount - Last.ParseCount, int64(Now.ParseSum - Last.ParseSum)));
+    Series[DispatchLatency]->Push(MeanMs(Now.DispatchCount - Last.DispatchCount, int64(Now.DispatchSum - Last.DispatchSum)));
+    Series[FramesInFlight]->Push(float(FTwitchChatConnection::Get()->GetNumFramesInFlight()));
+    const TSharedPtr<FTwitchChatHistoryLog> History = FTwitchChatHistoryLog::GetIfCreated();
+    Series[HistoryQueue]->Push(float(History ? History->GetQueueDepth() : 0));
+    Series[EmoteDiskHitRatio]->Push(Percent(Now.DiskHits - Last.DiskHits, Now.DiskMisses - Last.DiskMisses));
+    Series[EmoteBrushHitRatio]->Push(Percent(Now.BrushHits - Last.BrushHits, Now.BrushMisses - Last.BrushMisses));
+    Series[EmoteDownloads]->Push(float(FTwitchChatMetrics::Get().GetGauge(ETwitchChatGauge::EmoteDownloadsInFlight)));
+
+    int32 NumAnimated = 0;
+    for (TObjectIterator<UAnimatedTexture2D> It; It; ++It)
+    {
+        ++NumAnimated;
+    }
+    Series[AnimatedTextures]->Push(float(NumAnimated));
+
+    Series[FramesDecodedRate]->Push(float((Now.FramesDecoded - Last.FramesDecoded) / Elapsed));
+    Series[FrameDecodeCost]->Push(CyclesMs(Now.DecodeCycles - Last.DecodeCycles, Now.FramesDecoded - Last.FramesDecoded));
+    Series[FrameUploadCost]->Push(CyclesMs(Now.UploadCycles - Last.UploadCycles, Now.FramesUploaded - Last.FramesUploaded));
+
+    Last = Now;
+    return EActiveTimerReturnType::Continue;
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,801 @@
+#include "TwitchChatEmulator.h"
+#include "TwitchChatConnection.h"
+#include "TwitchChatSettings.h"
+
+#include "IWebSocketNetworkingModule.h"
+#include "IWebSocketServer.h"
+#include "INetworkingWebSocket.h"
+#include "WebSocketNetworkingDelegates.h"
+#include "HttpServerModule.h"
+#include "IHttpRouter.h"
+#include "HttpPath.h"
+#include "HttpServerRequest.h"
+#include "HttpServerResponse.h"
+#include "IImageWrapperModule.h"
+#include "IImageWrapper.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Guid.h"
+#include "Modules/ModuleManager.h"
+
+namespace TwitchChatEmulator
+{
+    static TSharedPtr<FTwitchChatEmulator> GActive;
+
+    static FString BodyAsString(const FHttpServerRequest& Request)
+    {
+        FUTF8ToTCHAR Conv(reinterpret_cast<const ANSICHAR*>(Request.Body.GetData()), Request.Body.Num());
+        return FString(Conv.Length(), Conv.Get());
+    }
+
+    static TUniquePtr<FHttpServerResponse> Json(const FString& Body, EHttpServerResponseCodes Code = EHttpServerResponseCodes::Ok)
+    {
+        TUniquePtr<FHttpServerResponse> Response = FHttpServerResponse::Create(Body, TEXT("application/json"));
+        Response->Code = Code;
+        return Response;
+    }
+
+    static FString SubscriptionJson(const FTwitchChatEmulator::FSubscription& Sub)
+    {
+        const FString Transport = Sub.ConduitId.IsEmpty()
+            ? FString::Printf(TEXT("{\"method\":\"websocket\",\"session_id\":\"%s\"}"), *Sub.SessionId)
+            : FString::Printf(TEXT("{\"method\":\"conduit\",\"conduit_id\":\"%s\"}"), *Sub.ConduitId);
+        return FString::Printf(
+            TEXT("{\"id\":\"%s\",\"status\":\"enabled\",\"type\":\"%s\",\"version\":\"1\",")
+            TEXT("\"condition\":{\"broadcaster_user_id\":\"%s\"},\"created_at\":\"%s\",\"transport\":%s,\"cost\":0}"),
+            *Sub.Id, *Sub.Type, *Sub.BroadcasterId, *FDateTime::UtcNow().ToIso8601(), *Transport);
+    }
+
+    static TUniquePtr<FHttpServerResponse> Helix(const FString& Body, EHttpServerResponseCodes Code = EHttpServerResponseCodes::Ok)
+    {
+        TUniquePtr<FHttpServerResponse> Response = Json(Body, Code);
+        const FString Reset = LexToString(FDateTime::UtcNow().ToUnixTimestamp() + 60);
+        Response->Headers.Add(TEXT("Ratelimit-Limit"), { TEXT("800") });
+        Response->Headers.Add(TEXT("Ratelimit-Remaining"), { TEXT("799") });
+        Response->Headers.Add(TEXT("Ratelimit-Reset"), { Reset });
+        return Response;
+    }
+
+    static TArray<uint8> MakeEmotePng()
+    {
+        const int32 Size = 28;
+        TArray<FColor> Pixels;
+        Pixels.Init(FColor(145, 70, 255), Size * Size);
+
+        IImageWrapperModule& ImgMod = FModuleManager::LoadModuleChecked<IImageWrapperModule>("ImageWrapper");
+        TSharedPtr<IImageWrapper> Wrapper = ImgMod.CreateImageWrapper(EImageFormat::PNG);
+        if (!Wrapper.IsValid() || !Wrapper->SetRaw(Pixels.GetData(), Pixels.Num() * sizeof(FColor), Size, Size, ERGBFormat::BGRA, 8))
+            return TArray<uint8>();
+
+        return TArray<uint8>(Wrapper->GetCompressed());
+    }
+}
+
+TSharedPtr<FTwitchChatEmulator> FTwitchChatEmulator::GetActive()
+{
+    return TwitchChatEmulator::GActive;
+}
+
+TSharedPtr<FTwitchChatEmulator> FTwitchChatEmulator::StartActive(const FConfig& InConfig)
+{
+    StopActive();
+
+    TSharedPtr<FTwitchChatEmulator> Emulator = MakeShared<FTwitchChatEmulator>();
+    if (!Emulator->Start(InConfig))
+        return nullptr;
+
+    Emulator->RedirectSettings();
+    TwitchChatEmulator::GActive = Emulator;
+    return Emulator;
+}
+
+void FTwitchChatEmulator::StopActive()
+{
+    if (TwitchChatEmulator::GActive.IsValid())
+    {
+        TwitchChatEmulator::GActive->Stop();
+        TwitchChatEmulator::GActive.Reset();
+    }
+}
+
+FTwitchChatEmulator::FTwitchChatEmulator() {}
+
+FTwitchChatEmulator::~FTwitchChatEmulator()
+{
+    Stop();
+}
+
+bool FTwitchChatEmulator::Start(const FConfig& InConfig)
+{
+    Stop();
+    Config = InConfig;
+    Chat = MakeUnique<FTwitchChatSyntheticChat>(Config.Chat);
+
+    // EventSub WebSocket
+    IWebSocketNetworkingModule& WsModule =
+        FModuleManager::LoadModuleChecked<IWebSocketNetworkingModule>(TEXT("WebSocketNetworking"));
+    Server = WsModule.CreateServer();
+
+    FWebSocketClientConnectedCallBack OnConnected;
+    OnConnected.BindRaw(this, &FTwitchChatEmulator::OnClientConnected);
+    if (!Server || !Server->Init(Config.WebSocketPort, OnConnected, TEXT("127.0.0.1")))
+    {
+        UE_LOG(LogTwitchChat, Error, TEXT("Emulator: cannot listen for WebSockets on port %d"), Config.WebSocketPort);
+        Server.Reset();
+        return false;
+    }
+
+    // Auth, Helix and CDN
+    Router = FHttpServerModule::Get().GetHttpRouter(Config.HttpPort, /*bFailOnBindFailure=*/true);
+    if (!Router.IsValid())
+    {
+        UE_LOG(LogTwitchChat, Error, TEXT("Emulator: cannot listen for HTTP on port %d"), Config.HttpPort);
+        Server.Reset();
+        return false;
+    }
+    EmotePng = TwitchChatEmulator::MakeEmotePng();
+    BindRoutes();
+    FHttpServerModule::Get().StartAllListeners();
+
+    TickHandle = FTSTicker::GetCoreTicker().AddTicker(
+        FTickerDelegate::CreateSP(this, &FTwitchChatEmulator::Tick));
+
+    bRunning = true;
+    UE_LOG(LogTwitchChat, Log, TEXT("Emulator: HTTP on %s, EventSub on %s"), *GetHttpBaseUrl(), *GetWebSocketUrl());
+    return true;
+}
+
+void FTwitchChatEmulator::Stop()
+{
+    if (TickHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+        TickHandle.Reset();
+    }
+
+    if (Router.IsValid())
+    {
+        for (const FHttpRouteHandle& Route : Routes)
+        {
+            Router->UnbindRoute(Route);
+        }
+        Routes.Empty();
+        Router.Reset();
+    }
+
+    Clients.Empty();
+    Server.Reset();
+    Subscriptions.Empty();
+    ConduitId.Empty();
+    ConduitShards.Empty();
+
+    if (bRedirected)
+    {
+        if (UTwitchChatSettings* S = GetMutableDefault<UTwitchChatSettings>())
+        {
+            S->ClearEndpointOverride();
+        }
+        bRedirected = false;
+    }
+
+    if (bRunning)
+    {
+        UE_LOG(LogTwitchChat, Log, TEXT("Emulator: stopped after %lld notifications"), NumNotificationsSent);
+    }
+    bRunning = false;
+}
+
+void FTwitchChatEmulator::RedirectSettings()
+{
+    UTwitchChatSettings* S = GetMutableDefault<UTwitchChatSettings>();
+    if (!S || bRedirected)
+        return;
+
+    // A runtime override, not the config fields, so nothing that saves settings meanwhile can
+    // write the emulator's endpoints or tokens over the user's own
+    UTwitchChatSettings::FEndpointOverride Override;
+    Override.AuthBaseUrl = GetHttpBaseUrl();
+    Override.HelixBaseUrl = GetHttpBaseUrl() + TEXT("/helix");
+    Override.EventSubUrl = GetWebSocketUrl();
+    Override.EmoteCdnBaseUrl = GetHttpBaseUrl();
+    Override.AccessToken = TEXT("emulator-token");
+    S->SetEndpointOverride(Override);
+    bRedirected = true;
+}
+
+FString FTwitchChatEmulator::GetHttpBaseUrl() const
+{
+    return FString::Printf(TEXT("http://127.0.0.1:%d"), Config.HttpPort);
+}
+
+FString FTwitchChatEmulator::GetWebSocketUrl() const
+{
+    return FString::Printf(TEXT("ws://127.0.0.1:%d/ws"), Config.WebSocketPort);
+}
+
+void FTwitchChatEmulator::SetChatConfig(const FTwitchChatSyntheticChat::FConfig& InChat)
+{
+    Config.Chat = InChat;
+    Chat = MakeUnique<FTwitchChatSyntheticChat>(InChat);
+}
+
+//-----------------------------------------------------------------------------
+// EventSub WebSocket
+//-----------------------------------------------------------------------------
+void FTwitchChatEmulator::OnClientConnected(INetworkingWebSocket* Socket)
+{
+    TUniquePtr<FClient> Client = MakeUnique<FClient>();
+    Client->Socket.Reset(Socket);
+    FClient* Raw = Client.Get();
+
+    FWebSocketInfoCallBack OnClosed;
+    OnClosed.BindLambda([Raw]() { Raw->bClosed = true; });
+    Socket->SetSocketClosedCallBack(OnClosed);
+
+    FWebSocketPacketReceivedCallBack OnReceive;
+    OnReceive.BindLambda([](void* /*Data*/, int32 /*Count*/) {});   // EventSub clients never send
+    Socket->SetReceiveCallBack(OnReceive);
+
+    // A client arriving after session_reconnect takes over the migrating session
+    Client->SessionId = ReconnectSessionId.IsEmpty()
+        ? FGuid::NewGuid().ToString(EGuidFormats::DigitsWithHyphensLower)
+        : ReconnectSessionId;
+
+    SendFrame(*Client, FTwitchChatSyntheticChat::MakeWelcome(Client->SessionId, Config.KeepaliveSeconds));
+
+    if (!ReconnectSessionId.IsEmpty())
+    {
+        for (TUniquePtr<FClient>& Other : Clients)
+        {
+            if (Other->bDraining && Other->SessionId == ReconnectSessionId)
+                Other->bClosed = true;
+        }
+        ReconnectSessionId.Empty();
+    }
+
+    Clients.Add(MoveTemp(Client));
+}
+
+void FTwitchChatEmulator::SendFrame(FClient& Client, const FString& Frame)
+{
+    if (Client.bClosed || !Client.Socket)
+        return;
+
+    FTCHARToUTF8 Utf8(*Frame, Frame.Len());
+    Client.Socket->Send(reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length(), /*bPrependSize=*/false);
+    Client.LastSendTime = FPlatformTime::Seconds();
+}
+
+void FTwitchChatEmulator::RequestReconnect()
+{
+    for (TUniquePtr<FClient>& Client : Clients)
+    {
+        if (Client->bDraining || Client->bClosed)
+            continue;
+
+        Client->bDraining = true;
+        ReconnectSessionId = Client->SessionId;
+        SendFrame(*Client, FTwitchChatSyntheticChat::MakeReconnect(Client->SessionId, GetWebSocketUrl()));
+        break;   // one migration at a time
+    }
+}
+
+FTwitchChatEmulator::FClient* FTwitchChatEmulator::FindDeliveryClient(const FSubscription& Sub)
+{
+    auto FindSession = [this](const FString& Session) -> FClient*
+        {
+            for (TUniquePtr<FClient>& Client : Clients)
+            {
+                if (!Client->bDraining && !Client->bClosed && Client->SessionId == Session)
+                    return Client.Get();
+            }
+            return nullptr;
+        };
+
+    if (Sub.ConduitId.IsEmpty())
+        return FindSession(Sub.SessionId);
+
+    // Conduit notifications go to any enabled shard, spread round robin like Twitch does
+    for (int32 Tries = 0; Tries < ConduitShards.Num(); ++Tries)
+    {
+        const FString& Session = ConduitShards[NextShard++ % ConduitShards.Num()];
+        if (FClient* Client = Session.IsEmpty() ? nullptr : FindSession(Session))
+            return Client;
+    }
+    return nullptr;
+}
+
+void FTwitchChatEmulator::EmitChat(int32 Count)
+{
+    // Each chat subscription receives messages for its broadcaster on its session
+    TArray<const FSubscription*> ChatSubs;
+    for (const FSubscription& Sub : Subscriptions)
+    {
+        if (Sub.Type == TEXT("channel.chat.message"))
+            ChatSubs.Add(&Sub);
+    }
+    if (ChatSubs.Num() == 0)
+        return;
+
+    for (int32 i = 0; i < Count; ++i)
+    {
+        const FSubscription& Sub = *ChatSubs[NextChannel++ % ChatSubs.Num()];
+        if (FClient* Client = FindDeliveryClient(Sub))
+        {
+            FTwitchChatSyntheticChat::FChannel Channel{ Sub.BroadcasterId, LookupUserLogin(Sub.BroadcasterId) };
+            SendFrame(*Client, Chat->NextChatMessage(Client->SessionId, Channel));
+            ++NumNotificationsSent;
+        }
+    }
+}
+
+void FTwitchChatEmulator::Say(const FString& UserLogin, const FString& Text)
+{
+    for (const FSubscription& Sub : Subscriptions)
+    {
+        if (Sub.Type != TEXT("channel.chat.message"))
+            continue;
+
+        if (FClient* Client = FindDeliveryClient(Sub))
+        {
+            FTwitchChatSyntheticChat::FChannel Channel{ Sub.BroadcasterId, LookupUserLogin(Sub.BroadcasterId) };
+            SendFrame(*Client, Chat->MakeChatMessage(Client->SessionId, Channel, LookupUserId(UserLogin), UserLogin, Text));
+            ++NumNotificationsSent;
+        }
+    }
+}
+
+bool FTwitchChatEmulator::Tick(float DeltaTime)
+{
+    if (!Server)
+        return true;
+
+    Server->Tick();
+    TickScript();
+
+    ChatBudget += ChatRate * DeltaTime;
+    const int32 Due = int32(ChatBudget) + PendingBurst;
+    ChatBudget -= int32(ChatBudget);
+    PendingBurst = 0;
+    if (Due > 0)
+    {
+        EmitChat(Due);
+    }
+
+    const double Now = FPlatformTime::Seconds();
+    for (TUniquePtr<FClient>& Client : Clients)
+    {
+        if (!Client->bDraining && Now - Client->LastSendTime >= Config.KeepaliveSeconds)
+        {
+            SendFrame(*Client, FTwitchChatSyntheticChat::MakeKeepalive());
+        }
+    }
+
+    Clients.RemoveAll([](const TUniquePtr<FClient>& Client) { return Client->bClosed; });
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Script
+//-----------------------------------------------------------------------------
+bool FTwitchChatEmulator::RunScript(const FString& Path)
+{
+    TArray<FString> Lines;
+    if (!FFileHelper::LoadFileToStringArray(Lines, *Path))
+    {
+        UE_LOG(LogTwitchChat, Error, TEXT("Emulator: cannot read script %s"), *Path);
+        return false;
+    }
+
+    ScriptLines = MoveTemp(Lines);
+    ScriptCursor = 0;
+    ScriptWaitUntil = 0.0;
+    return true;
+}
+
+void FTwitchChatEmulator::TickScript()
+{
+    while (ScriptCursor < ScriptLines.Num() && FPlatformTime::Seconds() >= ScriptWaitUntil)
+    {
+        const FString Line = ScriptLines[ScriptCursor++].TrimStartAndEnd();
+        if (Line.IsEmpty() || Line.StartsWith(TEXT("#")))
+            continue;
+
+        if (!ExecuteCommand(Line))
+        {
+            UE_LOG(LogTwitchChat, Warning, TEXT("Emulator: bad script line %d: %s"), ScriptCursor, *Line);
+        }
+    }
+}
+
+bool FTwitchChatEmulator::ExecuteCommand(const FString& Line)
+{
+    FString Command, Rest;
+    if (!Line.Split(TEXT(" "), &Command, &Rest))
+    {
+        Command = Line;
+    }
+    Rest.TrimStartInline();
+
+    if (Command == TEXT("rate"))
+    {
+        SetChatRate(FCString::Atof(*Rest));
+    }
+    else if (Command == TEXT("burst"))
+    {
+        Burst(FCString::Atoi(*Rest));
+    }
+    else if (Command == TEXT("wait"))
+    {
+        ScriptWaitUntil = FPlatformTime::Seconds() + FCString::Atof(*Rest);
+    }
+    else if (Command == TEXT("reconnect"))
+    {
+        RequestReconnect();
+    }
+    else if (Command == TEXT("scenario"))
+    {
+        FTwitchChatSyntheticChat::FConfig ChatConfig;
+        if (!FTwitchChatSyntheticChat::FConfig::FromName(Rest, ChatConfig))
+            return false;
+        SetChatConfig(ChatConfig);
+    }
+    else if (Command == TEXT("say"))
+    {
+        FString User, Text;
+        if (!Rest.Split(TEXT(" "), &User, &Text))
+            return false;
+        Say(User, Text);
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// HTTP endpoints
+//-----------------------------------------------------------------------------
+FString FTwitchChatEmulator::LookupUserId(const FString& Login) const
+{
+    // Stable fake ids so repeated lookups agree
+    return FString::Printf(TEXT("%u"), 1000000u + (GetTypeHash(Login.ToLower()) % 8000000u));
+}
+
+FString FTwitchChatEmulator::LookupUserLogin(const FString& Id) const
+{
+    if (const FString* Known = KnownLogins.Find(Id))
+        return *Known;
+    return FString::Printf(TEXT("user_%s"), *Id);
+}
+
+void FTwitchChatEmulator::BindRoutes()
+{
+    using namespace TwitchChatEmulator;
+
+    auto Bind = [this](const TCHAR* Path, EHttpServerRequestVerbs Verb,
+        TFunction<TUniquePtr<FHttpServerResponse>(const FHttpServerRequest&)> Handler)
+        {
+            Routes.Add(Router->BindRoute(FHttpPath(Path), Verb,
+                FHttpRequestHandler::CreateLambda([Handler](const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete)
+                    {
+                        OnComplete(Handler(Request));
+                        return true;
+                    })));
+        };
+
+    Bind(TEXT("/oauth2/device"), EHttpServerRequestVerbs::VERB_POST, [this](const FHttpServerRequest&)
+        {
+            return Json(FString::Printf(
+                TEXT("{\"device_code\":\"emulator-device\",\"user_code\":\"EMULATOR\",\"verification_uri\":\"%s/activate\",\"expires_in\":1800,\"interval\":1}"),
+                *GetHttpBaseUrl()));
+        });
+
+    Bind(TEXT("/oauth2/token"), EHttpServerRequestVerbs::VERB_POST, [this](const FHttpServerRequest&)
+        {
+            ++TokenSerial;
+            return Json(FString::Printf(
+                TEXT("{\"access_token\":\"emulator-token-%d\",\"refresh_token\":\"emulator-refresh-%d\",\"expires_in\":14400,")
+                TEXT("\"scope\":[\"user:read:chat\"],\"token_type\":\"bearer\"}"),
+                TokenSerial, TokenSerial));
+        });
+
+    Bind(TEXT("/oauth2/validate"), EHttpServerRequestVerbs::VERB_GET, [](const FHttpServerRequest&)
+        {
+            return Json(TEXT("{\"client_id\":\"emulator\",\"login\":\"emulated\",\"scopes\":[\"user:read:chat\"],\"user_id\":\"1000\",\"expires_in\":14000}"));
+        });
+
+    Bind(TEXT("/helix/users"), EHttpServerRequestVerbs::VERB_GET, [this](const FHttpServerRequest& Request)
+        {
+            FString Id, Login;
+            if (const FString* L = Request.QueryParams.Find(TEXT("login")))
+            {
+                Login = L->ToLower();
+                Id = LookupUserId(Login);
+                KnownLogins.Add(Id, Login);
+            }
+            else if (const FString* I = Request.QueryParams.Find(TEXT("id")))
+            {
+                Id = *I;
+                Login = LookupUserLogin(Id);
+            }
+            else
+            {
+                return Helix(TEXT("{\"data\":[]}"));
+            }
+
+            return Helix(FString::Printf(
+                TEXT("{\"data\":[{\"id\":\"%s\",\"login\":\"%s\",\"display_name\":\"%s\",\"type\":\"\",\"broadcaster_type\":\"\",")
+                TEXT("\"description\":\"\",\"profile_image_url\":\"%s/emoticons/v2/avatar/%s\",\"offline_image_url\":\"\",\"created_at\":\"2020-01-01T00:00:00Z\"}]}"),
+                *Id, *Login, *Login, *GetHttpBaseUrl(), *Id));
+        });
+
+    Bind(TEXT("/helix/eventsub/subscriptions"), EHttpServerRequestVerbs::VERB_POST, [this](const FHttpServerRequest& Request)
+        {
+            TSharedPtr<FJsonObject> Root;
+            TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(BodyAsString(Request));
+            if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid())
+            {
+                return Helix(TEXT("{\"error\":\"Bad Request\",\"status\":400,\"message\":\"invalid body\"}"), EHttpServerResponseCodes::BadRequest);
+            }
+
+            FSubscription Sub;
+            Sub.Id = FGuid::NewGuid().ToString(EGuidFormats::DigitsWithHyphensLower);
+            Sub.Type = Root->GetStringField(TEXT("type"));
+
+            const TSharedPtr<FJsonObject>* Condition = nullptr;
+            if (Root->TryGetObjectField(TEXT("condition"), Condition))
+            {
+                (*Condition)->TryGetStringField(TEXT("broadcaster_user_id"), Sub.BroadcasterId);
+            }
+            const TSharedPtr<FJsonObject>* Transport = nullptr;
+            if (Root->TryGetObjectField(TEXT("transport"), Transport))
+            {
+                (*Transport)->TryGetStringField(TEXT("session_id"), Sub.SessionId);
+                (*Transport)->TryGetStringField(TEXT("conduit_id"), Sub.ConduitId);
+            }
+
+            if (!Sub.ConduitId.IsEmpty())
+            {
+                if (Sub.ConduitId != ConduitId)
+                {
+                    return Helix(TEXT("{\"error\":\"Bad Request\",\"status\":400,\"message\":\"conduit not found\"}"), EHttpServerResponseCodes::BadRequest);
+                }
+                // Conduit subscriptions outlive sessions, so a restarted client can collide with its own
+                const bool bDuplicate = Subscriptions.ContainsByPredicate([&Sub](const FSubscription& Other)
+                    {
+                        return Other.ConduitId == Sub.ConduitId && Other.Type == Sub.Type && Other.BroadcasterId == Sub.BroadcasterId;
+                    });
+                if (bDuplicate)
+                {
+                    return Helix(TEXT("{\"error\":\"Conflict\",\"status\":409,\"message\":\"subscription already exists\"}"), EHttpServerResponseCodes::Conflict);
+                }
+            }
+            else
+            {
+                const bool bKnownSession = Clients.ContainsByPredicate(
+                    [&Sub](const TUniquePtr<FClient>& C) { return C->SessionId == Sub.SessionId && !C->bClosed; });
+                if (!bKnownSession)
+                {
+                    return Helix(TEXT("{\"error\":\"Bad Request\",\"status\":400,\"message\":\"websocket transport session does not exist or has already disconnected\"}"),
+                        EHttpServerResponseCodes::BadRequest);
+                }
+            }
+
+            Subscriptions.Add(Sub);
+            return Helix(FString::Printf(
+                TEXT("{\"data\":[%s],\"total\":%d,\"total_cost\":0,\"max_total_cost\":10}"), *SubscriptionJson(Sub), Subscriptions.Num()),
+                EHttpServerResponseCodes::Accepted);
+        });
+
+    Bind(TEXT("/helix/eventsub/subscriptions"), EHttpServerRequestVerbs::VERB_GET, [this](const FHttpServerRequest& Request)
+        {
+            const FString* Type = Request.QueryParams.Find(TEXT("type"));
+            const FString* UserId = Request.QueryParams.Find(TEXT("user_id"));
+            TArray<FString> Data;
+            for (const FSubscription& Sub : Subscriptions)
+            {
+                if ((!Type || Sub.Type == *Type) && (!UserId || Sub.BroadcasterId == *UserId))
+                    Data.Add(SubscriptionJson(Sub));
+            }
+            return Helix(FString::Printf(TEXT("{\"data\":[%s],\"total\":%d,\"total_cost\":0,\"max_total_cost\":10,\"pagination\":{}}"),
+                *FString::Join(Data, TEXT(",")), Subscriptions.Num()));
+        });
+
+    Bind(TEXT("/helix/eventsub/subscriptions"), EHttpServerRequestVerbs::VERB_DELETE, [this](const FHttpServerRequest& Request)
+        {
+            const FString* Id = Request.QueryParams.Find(TEXT("id"));
+            const int32 Removed = Id ? Subscriptions.RemoveAll([Id](const FSubscription& Sub) { return Sub.Id == *Id; }) : 0;
+            if (Removed == 0)
+            {
+                return Helix(TEXT("{\"error\":\"Not Found\",\"status\":404,\"message\":\"subscription not found\"}"), EHttpServerResponseCodes::NotFound);
+            }
+            return Helix(FString(), EHttpServerResponseCodes::NoContent);
+        });
+
+    // Sent messages come back as chat on every subscription for that broadcaster
+    Bind(TEXT("/helix/chat/messages"), EHttpServerRequestVerbs::VERB_POST, [this](const FHttpServerRequest& Request)
+        {
+            TSharedPtr<FJsonObject> Root;
+            TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(BodyAsString(Request));
+            FString BroadcasterId, SenderId, Text;
+            if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid()
+                || !Root->TryGetStringField(TEXT("broadcaster_id"), BroadcasterId)
+                || !Root->TryGetStringField(TEXT("sender_id"), SenderId)
+                || !Root->TryGetStringField(TEXT("message"), Text))
+            {
+                return Helix(TEXT("{\"error\":\"Bad Request\",\"status\":400,\"message\":\"missing broadcaster_id, sender_id or message\"}"), EHttpServerResponseCodes::BadRequest);
+            }
+
+            for (const FSubscription& Sub : Subscriptions)
+            {
+                if (Sub.Type != TEXT("channel.chat.message") || Sub.BroadcasterId != BroadcasterId)
+                    continue;
+                if (FClient* Client = FindDeliveryClient(Sub))
+                {
+                    FTwitchChatSyntheticChat::FChannel Channel{ Sub.BroadcasterId, LookupUserLogin(Sub.BroadcasterId) };
+                    SendFrame(*Client, Chat->MakeChatMessage(Client->SessionId, Channel, SenderId, LookupUserLogin(SenderId), Text));
+                    ++NumNotificationsSent;
+                }
+            }
+            return Helix(FString::Printf(TEXT("{\"data\":[{\"message_id\":\"%s\",\"is_sent\":true}]}"),
+                *FGuid::NewGuid().ToString(EGuidFormats::DigitsWithHyphensLower)));
+        });
+
+    // One conduit per emulator run; enough for the plugin's find-or-create
+    Bind(TEXT("/helix/eventsub/conduits"), EHttpServerRequestVerbs::VERB_GET, [this](const FHttpServerRequest&)
+        {
+            return Helix(ConduitId.IsEmpty() ? FString(TEXT("{\"data\":[]}"))
+                : FString::Printf(TEXT("{\"data\":[{\"id\":\"%s\",\"shard_count\":%d}]}"), *ConduitId, ConduitShards.Num()));
+        });
+
+    auto SetShardCount = [this](const FHttpServerRequest& Request, bool bCreate) -> TUniquePtr<FHttpServerResponse>
+        {
+            TSharedPtr<FJsonObject> Root;
+            TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(BodyAsString(Request));
+            int32 Count = 0;
+            if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid() || !Root->TryGetNumberField(TEXT("shard_count"), Count)
+                || Count < 1 || Count > 20000)
+            {
+                return Helix(TEXT("{\"error\":\"Bad Request\",\"status\":400,\"message\":\"invalid shard_count\"}"), EHttpServerResponseCodes::BadRequest);
+            }
+            if (bCreate)
+            {
+                ConduitId = FGuid::NewGuid().ToString(EGuidFormats::DigitsWithHyphensLower);
+                ConduitShards.Reset();
+            }
+            else if (Root->GetStringField(TEXT("id")) != ConduitId || ConduitId.IsEmpty())
+            {
+                return Helix(TEXT("{\"error\":\"Not Found\",\"status\":404,\"message\":\"conduit not found\"}"), EHttpServerResponseCodes::NotFound);
+            }
+            ConduitShards.SetNum(Count);
+            return Helix(FString::Printf(TEXT("{\"data\":[{\"id\":\"%s\",\"shard_count\":%d}]}"), *ConduitId, Count));
+        };
+    Bind(TEXT("/helix/eventsub/conduits"), EHttpServerRequestVerbs::VERB_POST, [SetShardCount](const FHttpServerRequest& Request)
+        {
+            return SetShardCount(Request, true);
+        });
+    Bind(TEXT("/helix/eventsub/conduits"), EHttpServerRequestVerbs::VERB_PATCH, [SetShardCount](const FHttpServerRequest& Request)
+        {
+            return SetShardCount(Request, false);
+        });
+
+    Bind(TEXT("/helix/eventsub/conduits/shards"), EHttpServerRequestVerbs::VERB_PATCH, [this](const FHttpServerRequest& Request)
+        {
+            TSharedPtr<FJsonObject> Root;
+            TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(BodyAsString(Request));
+            const TArray<TSharedPtr<FJsonValue>>* Shards = nullptr;
+            if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid() || Root->GetStringField(TEXT("conduit_id")) != ConduitId
+                || !Root->TryGetArrayField(TEXT("shards"), Shards))
+            {
+                return Helix(TEXT("{\"error\":\"Bad Request\",\"status\":400,\"message\":\"invalid conduit update\"}"), EHttpServerResponseCodes::BadRequest);
+            }
+
+            TArray<FString> Updated, Errors;
+            for (const TSharedPtr<FJsonValue>& Value : *Shards)
+            {
+                const TSharedPtr<FJsonObject>& Shard = Value->AsObject();
+                const FString Id = Shard->GetStringField(TEXT("id"));
+                const int32 Index = FCString::Atoi(*Id);
+                const TSharedPtr<FJsonObject>* Transport = nullptr;
+                FString Session;
+                const bool bValid = ConduitShards.IsValidIndex(Index) && Shard->TryGetObjectField(TEXT("transport"), Transport)
+                    && (*Transport)->TryGetStringField(TEXT("session_id"), Session)
+                    && Clients.ContainsByPredicate([&Session](const TUniquePtr<FClient>& C) { return C->SessionId == Session && !C->bClosed; });
+                if (!bValid)
+                {
+                    Errors.Add(FString::Printf(TEXT("{\"id\":\"%s\",\"message\":\"invalid shard or session\",\"code\":\"\"}"), *Id));
+                    continue;
+                }
+                ConduitShards[Index] = Session;
+                Updated.Add(FString::Printf(TEXT("{\"id\":\"%s\",\"status\":\"enabled\",\"transport\":{\"method\":\"websocket\",\"session_id\":\"%s\"}}"), *Id, *Session));
+            }
+            return Helix(FString::Printf(TEXT("{\"data\":[%s],\"errors\":[%s]}"),
+                *FString::Join(Updated, TEXT(",")), *FString::Join(Errors, TEXT(","))), EHttpServerResponseCodes::Accepted);
+        });
+
+    // Badge images are the emote PNG too; enough for the badge/avatar atlas to have something to pack
+    auto BadgeSets = [this](const TArray<FString>& Badges)
+        {
+            TArray<FString> Sets;
+            for (const FString& Badge : Badges)
+            {
+                FString SetId, Id;
+                Badge.Split(TEXT("/"), &SetId, &Id);
+                Sets.Add(FString::Printf(
+                    TEXT("{\"set_id\":\"%s\",\"versions\":[{\"id\":\"%s\",\"image_url_1x\":\"%s/emoticons/v2/badge/%s/1\",")
+                    TEXT("\"image_url_2x\":\"%s/emoticons/v2/badge/%s/2\",\"image_url_4x\":\"%s/emoticons/v2/badge/%s/4\",\"title\":\"%s\"}]}"),
+                    *SetId, *Id, *GetHttpBaseUrl(), *Badge, *GetHttpBaseUrl(), *Badge, *GetHttpBaseUrl(), *Badge, *SetId));
+            }
+            return Helix(FString::Printf(TEXT("{\"data\":[%s]}"), *FString::Join(Sets, TEXT(","))));
+        };
+    Bind(TEXT("/helix/chat/badges/global"), EHttpServerRequestVerbs::VERB_GET, [BadgeSets](const FHttpServerRequest&)
+        {
+            return BadgeSets({ TEXT("moderator/1"), TEXT("subscriber/0") });
+        });
+    Bind(TEXT("/helix/chat/badges"), EHttpServerRequestVerbs::VERB_GET, [BadgeSets](const FHttpServerRequest&)
+        {
+            return BadgeSets({ TEXT("subscriber/0") });
+        });
+
+    Bind(TEXT("/emoticons/v2"), EHttpServerRequestVerbs::VERB_GET, [this](const FHttpServerRequest&)
+        {
+            return FHttpServerResponse::Create(EmotePng, TEXT("image/png"));
+        });
+}
+
+//-----------------------------------------------------------------------------
+// Console
+//-----------------------------------------------------------------------------
+static FAutoConsoleCommand GTwitchChatEmulatorStartCmd(
+    TEXT("twitchchat.emulator.start"),
+    TEXT("Start the local Twitch emulator and point the plugin at it. Usage: twitchchat.emulator.start [HttpPort] [Rate]"),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+        {
+            FTwitchChatEmulator::FConfig Config;
+            if (Args.Num() > 0)
+            {
+                Config.HttpPort = FCString::Atoi(*Args[0]);
+                Config.WebSocketPort = Config.HttpPort + 1;
+            }
+            if (TSharedPtr<FTwitchChatEmulator> Emulator = FTwitchChatEmulator::StartActive(Config))
+            {
+                Emulator->SetChatRate(Args.Num() > 1 ? FCString::Atof(*Args[1]) : 5.f);
+            }
+        })
+);
+
+static FAutoConsoleCommand GTwitchChatEmulatorStopCmd(
+    TEXT("twitchchat.emulator.stop"),
+    TEXT("Stop the local Twitch emulator and restore the real endpoints."),
+    FConsoleCommandDelegate::CreateStatic(&FTwitchChatEmulator::StopActive)
+);
+
+static FAutoConsoleCommand GTwitchChatEmulatorCmd(
+    TEXT("twitchchat.emulator"),
+    TEXT("Drive the running emulator. Usage: twitchchat.emulator <rate N | burst N | scenario default|emote|long|reply | say User Text | reconnect | script Path>"),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+        {
+            TSharedPtr<FTwitchChatEmulator> Emulator = FTwitchChatEmulator::GetActive();
+            if (!Emulator.IsValid() || Args.Num() == 0)
+            {
+                UE_LOG(LogTwitchChat, Warning, TEXT("Emulator not running or no command given"));
+                return;
+            }
+            if (Args[0] == TEXT("script"))
+            {
+                if (Args.Num() > 1)
+                    Emulator->RunScript(Args[1]);
+                return;
+            }
+            const FString Line = FString::Join(Args, TEXT(" "));
+            if (!Emulator->ExecuteCommand(Line))
+            {
+                UE_LOG(LogTwitchChat, Warning, TEXT("Emulator: unknown command '%s'"), *Line);
+            }
+        })
+);
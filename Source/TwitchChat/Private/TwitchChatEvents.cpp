@@ -0,0 +1,228 @@
+#include "TwitchChatEvents.h"
+#include "Dom/JsonObject.h"
+
+namespace TwitchChatEvents
+{
+    static void DecodeUser(const FJsonObject& Event, const TCHAR* Prefix, FTwitchChatEvent& Out)
+    {
+        Event.TryGetStringField(FString(Prefix) + TEXT("user_id"), Out.UserId);
+        Event.TryGetStringField(FString(Prefix) + TEXT("user_login"), Out.UserLogin);
+        Event.TryGetStringField(FString(Prefix) + TEXT("user_name"), Out.UserName);
+    }
+
+    static FString MessageText(const FJsonObject& Event)
+    {
+        FString Text;
+        const TSharedPtr<FJsonObject>* Message = nullptr;
+        if (Event.TryGetObjectField(TEXT("message"), Message))
+            (*Message)->TryGetStringField(TEXT("text"), Text);
+        else
+            Event.TryGetStringField(TEXT("message"), Text);
+        return Text;
+    }
+
+    static bool DecodeEvent(const FJsonObject& Event, FTwitchChatCheerEvent& Out)
+    {
+        DecodeUser(Event, TEXT(""), Out);
+        Event.TryGetBoolField(TEXT("is_anonymous"), Out.bAnonymous);
+        Out.Message = MessageText(Event);
+        return Event.TryGetNumberField(TEXT("bits"), Out.Bits);
+    }
+
+    static bool DecodeEvent(const FJsonObject& Event, FTwitchChatSubscribeEvent& Out)
+    {
+        DecodeUser(Event, TEXT(""), Out);
+        Event.TryGetBoolField(TEXT("is_gift"), Out.bGift);
+        return Event.TryGetStringField(TEXT("tier"), Out.Tier);
+    }
+
+    static bool DecodeEvent(const FJsonObject& Event, FTwitchChatResubscribeEvent& Out)
+    {
+        DecodeUser(Event, TEXT(""), Out);
+        Out.Message = MessageText(Event);
+        Event.TryGetNumberField(TEXT("streak_months"), Out.StreakMonths);
+        Event.TryGetNumberField(TEXT("duration_months"), Out.DurationMonths);
+        return Event.TryGetStringField(TEXT("tier"), Out.Tier)
+            && Event.TryGetNumberField(TEXT("cumulative_months"), Out.CumulativeMonths);
+    }
+
+    static bool DecodeEvent(const FJsonObject& Event, FTwitchChatGiftEvent& Out)
+    {
+        DecodeUser(Event, TEXT(""), Out);
+        Event.TryGetBoolField(TEXT("is_anonymous"), Out.bAnonymous);
+        Event.TryGetNumberField(TEXT("cumulative_total"), Out.CumulativeTotal);
+        return Event.TryGetStringField(TEXT("tier"), Out.Tier)
+            && Event.TryGetNumberField(TEXT("total"), Out.Total);
+    }
+
+    static bool DecodeEvent(const FJsonObject& Event, FTwitchChatRaidEvent& Out)
+    {
+        DecodeUser(Event, TEXT("from_broadcaster_"), Out);
+        Event.TryGetStringField(TEXT("to_broadcaster_user_id"), Out.ChannelId);
+        Event.TryGetStringField(TEXT("to_broadcaster_user_login"), Out.ChannelLogin);
+        return Event.TryGetNumberField(TEXT("viewers"), Out.Viewers);
+    }
+
+    static bool DecodeEvent(const FJsonObject& Event, FTwitchChatRedemptionEvent& Out)
+    {
+        DecodeUser(Event, TEXT(""), Out);
+        Event.TryGetStringField(TEXT("id"), Out.RedemptionId);
+        Event.TryGetStringField(TEXT("user_input"), Out.UserInput);
+        Event.TryGetStringField(TEXT("status"), Out.Status);
+
+        const TSharedPtr<FJsonObject>* Reward = nullptr;
+        if (!Event.TryGetObjectField(TEXT("reward"), Reward))
+            return false;
+        (*Reward)->TryGetStringField(TEXT("title"), Out.RewardTitle);
+        (*Reward)->TryGetNumberField(TEXT("cost"), Out.RewardCost);
+        return (*Reward)->TryGetStringField(TEXT("id"), Out.RewardId);
+    }
+
+    static bool DecodeEvent(const FJsonObject& Event, FTwitchChatNotificationEvent& Out)
+    {
+        DecodeUser(Event, TEXT("chatter_"), Out);
+        Event.TryGetBoolField(TEXT("chatter_is_anonymous"), Out.bAnonymous);
+        Event.TryGetStringField(TEXT("system_message"), Out.SystemMessage);
+        Out.Message = MessageText(Event);
+
+        FString Color;
+        if (Event.TryGetStringField(TEXT("color"), Color) && !Color.IsEmpty())
+            Out.UserColor = FLinearColor(FColor::FromHex(Color));
+        return Event.TryGetStringField(TEXT("notice_type"), Out.NoticeType);
+    }
+
+    // The handler each row points at: shared fields, the payload's own decoder, then a task that
+    // hands the payload to its typed delegate
+    template<typename TPayload>
+    static bool Decode(const FJsonObject& Metadata, const FJsonObject& Event, TUniqueFunction<void()>& OutBroadcast)
+    {
+        TPayload Payload;
+        Metadata.TryGetStringField(TEXT("message_id"), Payload.EventId);
+        FString SentAt;
+        if (!Metadata.TryGetStringField(TEXT("message_timestamp"), SentAt) || !FDateTime::ParseIso8601(*SentAt, Payload.Timestamp))
+            Payload.Timestamp = FDateTime::UtcNow();
+        Event.TryGetStringField(TEXT("broadcaster_user_id"), Payload.ChannelId);
+        Event.TryGetStringField(TEXT("broadcaster_user_login"), Payload.ChannelLogin);
+
+        if (!DecodeEvent(Event, Payload))
+            return false;
+
+        OutBroadcast = [Payload = MoveTemp(Payload)]()
+            {
+                FTwitchChatEvents::Get().On<TPayload>().Broadcast(Payload);
+            };
+        return true;
+    }
+
+    template<typename TPayload>
+    static constexpr FTwitchChatEvents::FType MakeType(const TCHAR* Name, const TCHAR* Version,
+        const TCHAR* BroadcasterCondition = TEXT("broadcaster_user_id"), bool bUserCondition = false)
+    {
+        return { TTwitchChatEvent<TPayload>::Kind, Name, Version, BroadcasterCondition, bUserCondition, &Decode<TPayload> };
+    }
+
+    // Indexed by ETwitchChatEventType; chat messages last
+    static constexpr FTwitchChatEvents::FType Types[] =
+    {
+        MakeType<FTwitchChatCheerEvent>(TEXT("channel.cheer"), TEXT("1")),
+        MakeType<FTwitchChatSubscribeEvent>(TEXT("channel.subscribe"), TEXT("1")),
+        MakeType<FTwitchChatResubscribeEvent>(TEXT("channel.subscription.message"), TEXT("1")),
+        MakeType<FTwitchChatGiftEvent>(TEXT("channel.subscription.gift"), TEXT("1")),
+        MakeType<FTwitchChatRaidEvent>(TEXT("channel.raid"), TEXT("1"), TEXT("to_broadcaster_user_id")),
+        MakeType<FTwitchChatRedemptionEvent>(TEXT("channel.channel_points_custom_reward_redemption.add"), TEXT("1")),
+        MakeType<FTwitchChatNotificationEvent>(TEXT("channel.chat.notification"), TEXT("1"), TEXT("broadcaster_user_id"), true),
+        { ETwitchChatEventType::Count, TEXT("channel.chat.message"), TEXT("1"), TEXT("broadcaster_user_id"), true, nullptr },
+    };
+    static_assert(UE_ARRAY_COUNT(Types) == int32(ETwitchChatEventType::Count) + 1, "Event type table out of date");
+
+    constexpr bool TypesInKindOrder()
+    {
+        for (int32 i = 0; i < int32(ETwitchChatEventType::Count); ++i)
+        {
+            if (int32(Types[i].Kind) != i)
+                return false;
+        }
+        return true;
+    }
+    static_assert(TypesInKindOrder(), "Event type table must follow ETwitchChatEventType");
+
+    // Perfect hash: seeded FNV-1a, top bits pick the slot. The compiler searches for a seed that
+    // puts every known type in its own slot.
+    constexpr int32 SlotBits = 4;
+    constexpr int32 NumSlots = 1 << SlotBits;
+    static_assert(UE_ARRAY_COUNT(Types) <= NumSlots, "Grow SlotBits");
+
+    constexpr uint32 Slot(const TCHAR* Name, uint32 Seed)
+    {
+        uint32 Hash = 2166136261u ^ Seed;
+        for (; *Name; ++Name)
+        {
+            Hash = (Hash ^ uint32(*Name)) * 16777619u;
+        }
+        return Hash >> (32 - SlotBits);
+    }
+
+    constexpr uint32 FindSeed()
+    {
+        for (uint32 Seed = 1; Seed < 65536; ++Seed)
+        {
+            bool bTaken[NumSlots] = {};
+            bool bPerfect = true;
+            for (const FTwitchChatEvents::FType& Type : Types)
+            {
+                const uint32 Index = Slot(Type.Name, Seed);
+                bPerfect = bPerfect && !bTaken[Index];
+                bTaken[Index] = true;
+            }
+            if (bPerfect)
+                return Seed;
+        }
+        return 0;
+    }
+    constexpr uint32 Seed = FindSeed();
+    static_assert(Seed != 0, "No collision-free seed; grow SlotBits");
+
+    struct FSlots
+    {
+        int8 Index[NumSlots];
+    };
+
+    constexpr FSlots BuildSlots()
+    {
+        FSlots Out{};
+        for (int8& Index : Out.Index)
+        {
+            Index = INDEX_NONE;
+        }
+        for (int32 i = 0; i < UE_ARRAY_COUNT(Types); ++i)
+        {
+            Out.Index[Slot(Types[i].Name, Seed)] = int8(i);
+        }
+        return Out;
+    }
+    constexpr FSlots Slots = BuildSlots();
+}
+
+FTwitchChatEvents& FTwitchChatEvents::Get()
+{
+    static FTwitchChatEvents Instance;
+    return Instance;
+}
+
+const FTwitchChatEvents::FType* FTwitchChatEvents::Find(const FString& SubscriptionType)
+{
+    using namespace TwitchChatEvents;
+    const int32 Index = Slots.Index[Slot(*SubscriptionType, Seed)];
+    if (Index == INDEX_NONE)
+        return nullptr;
+
+    // Slots are only unique among known types; an unknown one can land on any of them
+    const FType& Type = Types[Index];
+    return FCString::Strcmp(*SubscriptionType, Type.Name) == 0 ? &Type : nullptr;
+}
+
+const FTwitchChatEvents::FType& FTwitchChatEvents::GetType(ETwitchChatEventType Kind)
+{
+    check(Kind < ETwitchChatEventType::Count);
+    return TwitchChatEvents::Types[int32(Kind)];
+}
@@ -0,0 +1,76 @@
+#include "TwitchChatExecutor.h"
+#include "Async/Async.h"
+
+void FTwitchChatExecutor::Post(TUniqueFunction<void()>&& Task)
+{
+    // Enqueue before counting, so whoever sees the count can also dequeue the task
+    Tasks.Enqueue(MoveTemp(Task));
+    if (Pending.fetch_add(1, std::memory_order_acq_rel) == 0)
+    {
+        ScheduleDrain();
+    }
+}
+
+void FTwitchChatExecutor::ScheduleDrain()
+{
+    AsyncTask(ENamedThreads::GameThread, [Weak = AsWeak()]()
+        {
+            if (TSharedPtr<FTwitchChatExecutor> Self = Weak.Pin())
+            {
+                Self->Drain();
+            }
+        });
+}
+
+int32 FTwitchChatExecutor::RunQueued(int32 Budget)
+{
+    int32 Ran = 0;
+    TUniqueFunction<void()> Task;
+    while (Ran < Budget && Tasks.Dequeue(Task))
+    {
+        Task();
+        ++Ran;
+    }
+    return Ran;
+}
+
+void FTwitchChatExecutor::Drain()
+{
+    check(IsInGameThread());
+    if (bDraining)
+        return;     // Flush from inside a task; the outer drain carries on
+
+    TGuardValue<bool> Guard(bDraining, true);
+    int32 Budget = MaxTasksPerDrain;
+    for (;;)
+    {
+        const int32 Ran = RunQueued(Budget);
+        Budget -= Ran;
+
+        // Anything posted before this subtraction is ours to run; a later post schedules again
+        const int32 Left = Pending.fetch_sub(Ran, std::memory_order_acq_rel) - Ran;
+        if (Left == 0)
+            return;
+        if (Budget <= 0)
+        {
+            // Count stays above zero, so no poster schedules; hand the rest to the next task
+            ScheduleDrain();
+            return;
+        }
+        // Left > 0 with an empty dequeue: a poster is between Enqueue and its link becoming visible
+    }
+}
+
+void FTwitchChatExecutor::Flush()
+{
+    check(IsInGameThread());
+    if (bDraining)
+        return;
+
+    TGuardValue<bool> Guard(bDraining, true);
+    while (Pending.load(std::memory_order_acquire) > 0)
+    {
+        const int32 Ran = RunQueued(MAX_int32);
+        Pending.fetch_sub(Ran, std::memory_order_acq_rel);
+    }
+}
@@ -0,0 +1,405 @@
+#include "TwitchChatHelix.h"
+#include "TwitchChatAuth.h"
+#include "TwitchChatConnection.h"
+#include "TwitchChatSettings.h"
+#include "TwitchChatMetrics.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpResponse.h"
+#include "GenericPlatform/GenericPlatformHttp.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "HAL/IConsoleManager.h"
+
+namespace TwitchChatHelix
+{
+    struct FLookupSpec
+    {
+        const TCHAR* Path;
+        const TCHAR* Param;      // nullptr: the endpoint takes no key
+        int32 MaxKeys;
+        const TCHAR* KeyField;   // nullptr: every item belongs to the single key
+        bool bLowerCase;
+    };
+
+    static const FLookupSpec Specs[] =
+    {
+        { TEXT("/users"),              TEXT("login"),          100, TEXT("login"),        true  },
+        { TEXT("/users"),              TEXT("id"),             100, TEXT("id"),           false },
+        { TEXT("/chat/emotes/set"),    TEXT("emote_set_id"),   25,  TEXT("emote_set_id"), false },
+        { TEXT("/chat/badges"),        TEXT("broadcaster_id"), 1,   nullptr,              false },
+        { TEXT("/chat/badges/global"), nullptr,                1,   nullptr,              false },
+    };
+    static_assert(UE_ARRAY_COUNT(Specs) == int32(ETwitchHelixLookup::Num), "Lookup table out of date");
+
+    static FString NormalizeKey(const FLookupSpec& Spec, const FString& Key)
+    {
+        return !Spec.Param ? FString() : Spec.bLowerCase ? Key.ToLower() : Key;
+    }
+}
+
+TSharedRef<FTwitchChatHelix> FTwitchChatHelix::Get()
+{
+    static TSharedRef<FTwitchChatHelix> Instance = MakeShared<FTwitchChatHelix>();
+    return Instance;
+}
+
+TSharedRef<IHttpRequest, ESPMode::ThreadSafe> FTwitchChatHelix::MakeRequest(const FString& Verb, const FString& Path)
+{
+    auto Req = FHttpModule::Get().CreateRequest();
+    Req->SetURL(GetDefault<UTwitchChatSettings>()->GetHelixBaseUrl() + Path);
+    Req->SetVerb(Verb);
+    return Req;
+}
+
+void FTwitchChatHelix::EnsureTicker()
+{
+    if (!TickHandle.IsValid())
+    {
+        TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateSP(this, &FTwitchChatHelix::Tick), float(MergeWindowSeconds));
+    }
+}
+
+void FTwitchChatHelix::Shutdown()
+{
+    if (TickHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+        TickHandle.Reset();
+    }
+}
+
+bool FTwitchChatHelix::Tick(float /*DeltaTime*/)
+{
+    const double Now = FPlatformTime::Seconds();
+    for (int32 Kind = 0; Kind < int32(ETwitchHelixLookup::Num); ++Kind)
+    {
+        if (Lookups[Kind].Unsent.Num() > 0 && Now >= Lookups[Kind].FlushTime)
+        {
+            FlushLookups(ETwitchHelixLookup(Kind));
+        }
+    }
+    for (int32 Bucket = 0; Bucket < int32(ETwitchHelixBucket::Num); ++Bucket)
+    {
+        Pump(ETwitchHelixBucket(Bucket));
+    }
+
+    if (Now >= NextPruneTime)
+    {
+        NextPruneTime = Now + 60.0;
+        for (TMap<FString, FCacheEntry>& Entries : Cache)
+        {
+            for (auto It = Entries.CreateIterator(); It; ++It)
+            {
+                if (It->Value.ExpiresAt <= Now)
+                    It.RemoveCurrent();
+            }
+        }
+    }
+    return true;
+}
+
+void FTwitchChatHelix::Send(TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Req, FOnResponse OnComplete, ETwitchHelixBucket Bucket)
+{
+    Buckets[int32(Bucket)].Queue.Add(FPending{ Req, MoveTemp(OnComplete) });
+    FTwitchChatMetrics::Add(ETwitchChatGauge::HelixQueued, 1);
+    EnsureTicker();
+    Pump(Bucket);
+}
+
+void FTwitchChatHelix::Pump(ETwitchHelixBucket Which)
+{
+    FBucket& Bucket = Buckets[int32(Which)];
+    const double Now = FPlatformTime::Seconds();
+
+    // Twitch refills the bucket continuously at Limit points per minute
+    if (Bucket.LastRefill > 0.0)
+    {
+        Bucket.Tokens = FMath::Min(double(Bucket.Limit), Bucket.Tokens + (Now - Bucket.LastRefill) * Bucket.Limit / 60.0);
+    }
+    Bucket.LastRefill = Now;
+
+    while (Bucket.Queue.Num() > 0 && Now >= Bucket.BlockedUntil && Bucket.Tokens >= 1.0)
+    {
+        Bucket.Tokens -= 1.0;
+        FPending Pending = MoveTemp(Bucket.Queue[0]);
+        Bucket.Queue.RemoveAt(0);
+        FTwitchChatMetrics::Add(ETwitchChatGauge::HelixQueued, -1);
+        Dispatch(Which, MoveTemp(Pending));
+    }
+}
+
+void FTwitchChatHelix::Dispatch(ETwitchHelixBucket Which, FPending&& Pending)
+{
+    TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Req = Pending.Req;
+    FString UsedToken;
+    if (Which == ETwitchHelixBucket::User)
+    {
+        UsedToken = FTwitchChatAuth::Get()->GetAccessToken();
+        Req->SetHeader(TEXT("Client-Id"), GetDefault<UTwitchChatSettings>()->ClientId);
+        Req->SetHeader(TEXT("Authorization"), TEXT("Bearer ") + UsedToken);
+    }
+    FTwitchChatMetrics::Inc(ETwitchChatCounter::HelixRequests);
+
+    // The request owns this delegate, so it must not hold the request itself
+    Req->OnProcessRequestComplete().BindLambda(
+        [this, Which, OnComplete = MoveTemp(Pending.OnComplete), bRefreshed = Pending.bRefreshed, UsedToken](FHttpRequestPtr R, FHttpResponsePtr Resp, bool bOK) mutable
+        {
+            FBucket& Bucket = Buckets[int32(Which)];
+            ReadRateLimit(Bucket, Resp);
+
+            const int32 Code = Resp.IsValid() ? Resp->GetResponseCode() : -1;
+            if (Code == 429)
+            {
+                // Back to the front; ReadRateLimit has held the bucket until the reset
+                FTwitchChatMetrics::Inc(ETwitchChatCounter::HelixThrottled);
+                Bucket.Queue.Insert(FPending{ R.ToSharedRef(), MoveTemp(OnComplete), bRefreshed }, 0);
+                FTwitchChatMetrics::Add(ETwitchChatGauge::HelixQueued, 1);
+                return;
+            }
+            if (Code == 401 && Which == ETwitchHelixBucket::User && !bRefreshed)
+            {
+                FTwitchChatAuth::Get()->Refresh(
+                    [this, Which, R, Resp, bOK, OnComplete = MoveTemp(OnComplete)](bool bTokenRefreshed) mutable
+                    {
+                        if (!bTokenRefreshed)
+                        {
+                            OnComplete(R, Resp, bOK);
+                            return;
+                        }
+                        Buckets[int32(Which)].Queue.Insert(FPending{ R.ToSharedRef(), MoveTemp(OnComplete), true }, 0);
+                        FTwitchChatMetrics::Add(ETwitchChatGauge::HelixQueued, 1);
+                        Pump(Which);
+                    }, UsedToken);
+                return;
+            }
+
+            if (OnComplete)
+            {
+                OnComplete(R, Resp, bOK);
+            }
+        });
+    Req->ProcessRequest();
+}
+
+void FTwitchChatHelix::ReadRateLimit(FBucket& Bucket, const FHttpResponsePtr& Resp)
+{
+    if (!Resp.IsValid())
+        return;
+
+    const FString Limit = Resp->GetHeader(TEXT("Ratelimit-Limit"));
+    const FString Remaining = Resp->GetHeader(TEXT("Ratelimit-Remaining"));
+    const FString Reset = Resp->GetHeader(TEXT("Ratelimit-Reset"));
+    if (!Limit.IsEmpty())
+    {
+        Bucket.Limit = FMath::Max(1, FCString::Atoi(*Limit));
+    }
+    if (!Remaining.IsEmpty())
+    {
+        // Twitch counts requests from every client sharing the token; trust the lower figure
+        Bucket.Tokens = FMath::Min(Bucket.Tokens, FCString::Atod(*Remaining));
+    }
+
+    if (Resp->GetResponseCode() == 429 || (!Remaining.IsEmpty() && Bucket.Tokens < 1.0))
+    {
+        // Ratelimit-Reset is a Unix time for when the bucket is full again
+        const int64 ResetIn = Reset.IsEmpty() ? 1 : FCString::Atoi64(*Reset) - FDateTime::UtcNow().ToUnixTimestamp();
+        const double Wait = FMath::Clamp(double(ResetIn), 1.0, 60.0);
+        Bucket.BlockedUntil = FMath::Max(Bucket.BlockedUntil, FPlatformTime::Seconds() + Wait);
+        UE_LOG(LogTwitchChat, Warning, TEXT("Helix rate limit reached; holding requests for %.0f s"), Wait);
+    }
+}
+
+void FTwitchChatHelix::Lookup(ETwitchHelixLookup Kind, const FString& Key, FOnLookup OnComplete)
+{
+    const TwitchChatHelix::FLookupSpec& Spec = TwitchChatHelix::Specs[int32(Kind)];
+    const FString NormalKey = TwitchChatHelix::NormalizeKey(Spec, Key);
+
+    if (const FCacheEntry* Hit = Cache[int32(Kind)].Find(NormalKey))
+    {
+        if (Hit->ExpiresAt > FPlatformTime::Seconds())
+        {
+            FTwitchChatMetrics::Inc(ETwitchChatCounter::HelixCacheHits);
+            OnComplete(Hit->Items);
+            return;
+        }
+    }
+
+    FLookupQueue& Queue = Lookups[int32(Kind)];
+    if (TArray<FOnLookup>* Waiters = Queue.Waiting.Find(NormalKey))
+    {
+        // Already queued or in flight; share its answer
+        Waiters->Add(MoveTemp(OnComplete));
+        return;
+    }
+    Queue.Waiting.Add(NormalKey).Add(MoveTemp(OnComplete));
+    if (Queue.Unsent.Num() == 0)
+    {
+        Queue.FlushTime = FPlatformTime::Seconds() + MergeWindowSeconds;
+    }
+    Queue.Unsent.Add(NormalKey);
+    EnsureTicker();
+
+    if (Queue.Unsent.Num() >= Spec.MaxKeys)
+    {
+        FlushLookups(Kind);
+    }
+}
+
+void FTwitchChatHelix::FlushLookups(ETwitchHelixLookup Kind)
+{
+    const int32 MaxKeys = TwitchChatHelix::Specs[int32(Kind)].MaxKeys;
+    TArray<FString> Unsent = MoveTemp(Lookups[int32(Kind)].Unsent);
+    for (int32 First = 0; First < Unsent.Num(); First += MaxKeys)
+    {
+        TArray<FString> Keys(Unsent.GetData() + First, FMath::Min(MaxKeys, Unsent.Num() - First));
+        const bool bSplitMisses = Keys.Num() > 1;
+        SendLookup(Kind, MoveTemp(Keys), bSplitMisses);
+    }
+}
+
+void FTwitchChatHelix::SendLookup(ETwitchHelixLookup Kind, TArray<FString>&& Keys, bool bSplitMisses)
+{
+    const TwitchChatHelix::FLookupSpec& Spec = TwitchChatHelix::Specs[int32(Kind)];
+    FString Path = Spec.Path;
+    if (Spec.Param)
+    {
+        for (int32 i = 0; i < Keys.Num(); ++i)
+        {
+            Path += FString::Printf(TEXT("%c%s=%s"), i == 0 ? TEXT('?') : TEXT('&'), Spec.Param, *FGenericPlatformHttp::UrlEncode(Keys[i]));
+        }
+    }
+    FTwitchChatMetrics::Inc(ETwitchChatCounter::HelixBatchedKeys, Keys.Num());
+
+    Send(MakeRequest(TEXT("GET"), Path),
+        [this, Kind, Keys = MoveTemp(Keys), bSplitMisses](FHttpRequestPtr, FHttpResponsePtr Resp, bool bOK)
+        {
+            const TwitchChatHelix::FLookupSpec& Spec = TwitchChatHelix::Specs[int32(Kind)];
+
+            TSharedPtr<FJsonObject> J;
+            const TArray<TSharedPtr<FJsonValue>>* Data = nullptr;
+            TSharedRef<TJsonReader<>> R = TJsonReaderFactory<>::Create(Resp.IsValid() ? Resp->GetContentAsString() : FString());
+            if (!bOK || !Resp.IsValid() || Resp->GetResponseCode() != 200
+                || !FJsonSerializer::Deserialize(R, J) || !J->TryGetArrayField(TEXT("data"), Data))
+            {
+                // Not cached; the next lookup asks again
+                UE_LOG(LogTwitchChat, Warning, TEXT("Helix %s lookup failed (%d)"), Spec.Path, Resp.IsValid() ? Resp->GetResponseCode() : -1);
+                for (const FString& Key : Keys)
+                {
+                    CompleteLookup(Kind, Key, {}, 0.0);
+                }
+                return;
+            }
+
+            TMap<FString, TArray<TSharedPtr<FJsonObject>>> Found;
+            for (const TSharedPtr<FJsonValue>& Value : *Data)
+            {
+                TSharedPtr<FJsonObject> Item = Value->AsObject();
+                if (!Item.IsValid())
+                    continue;
+                FString ItemKey = Keys[0];
+                if (Spec.KeyField)
+                {
+                    Item->TryGetStringField(Spec.KeyField, ItemKey);
+                    if (Spec.bLowerCase)
+                        ItemKey.ToLowerInline();
+                }
+                Found.FindOrAdd(ItemKey).Add(Item);
+            }
+
+            for (const FString& Key : Keys)
+            {
+                if (const TArray<TSharedPtr<FJsonObject>>* Items = Found.Find(Key))
+                {
+                    CompleteLookup(Kind, Key, *Items, HitTtlSeconds);
+                }
+                else if (bSplitMisses)
+                {
+                    // Twitch leaves out keys it does not know; asking for the key alone confirms the
+                    // miss and copes with servers that only honour one repeated parameter (the emulator)
+                    SendLookup(Kind, { Key }, false);
+                }
+                else
+                {
+                    CompleteLookup(Kind, Key, {}, MissTtlSeconds);
+                }
+            }
+        });
+}
+
+void FTwitchChatHelix::CompleteLookup(ETwitchHelixLookup Kind, const FString& Key, const TArray<TSharedPtr<FJsonObject>>& Items, double Ttl)
+{
+    if (Ttl > 0.0)
+    {
+        FCacheEntry& Entry = Cache[int32(Kind)].Add(Key);
+        Entry.Items = Items;
+        Entry.ExpiresAt = FPlatformTime::Seconds() + Ttl;
+    }
+
+    TArray<FOnLookup> Waiters;
+    Lookups[int32(Kind)].Waiting.RemoveAndCopyValue(Key, Waiters);
+    for (FOnLookup& Waiter : Waiters)
+    {
+        Waiter(Items);
+    }
+}
+
+void FTwitchChatHelix::ClearCache()
+{
+    for (TMap<FString, FCacheEntry>& Entries : Cache)
+    {
+        Entries.Reset();
+    }
+}
+
+FTwitchChatHelix::FBucketStatus FTwitchChatHelix::GetBucketStatus(ETwitchHelixBucket Which) const
+{
+    const FBucket& Bucket = Buckets[int32(Which)];
+    FBucketStatus Status;
+    Status.Limit = Bucket.Limit;
+    Status.Tokens = Bucket.Tokens;
+    Status.Queued = Bucket.Queue.Num();
+    Status.BlockedFor = FMath::Max(0.0, Bucket.BlockedUntil - FPlatformTime::Seconds());
+    return Status;
+}
+
+int32 FTwitchChatHelix::GetCacheSize() const
+{
+    int32 Num = 0;
+    for (const TMap<FString, FCacheEntry>& Entries : Cache)
+    {
+        Num += Entries.Num();
+    }
+    return Num;
+}
+
+static FAutoConsoleCommand GTwitchChatHelixCmd(
+    TEXT("twitchchat.helix"),
+    TEXT("Helix rate-limit buckets and lookup cache. Usage: twitchchat.helix [clear]"),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+        {
+            TSharedRef<FTwitchChatHelix> Helix = FTwitchChatHelix::Get();
+            if (Args.Num() > 0 && Args[0] == TEXT("clear"))
+            {
+                Helix->ClearCache();
+                UE_LOG(LogTwitchChat, Display, TEXT("Helix lookup cache cleared"));
+                return;
+            }
+
+            static const TCHAR* BucketNames[] = { TEXT("user"), TEXT("app") };
+            static_assert(UE_ARRAY_COUNT(BucketNames) == int32(ETwitchHelixBucket::Num), "Bucket names out of date");
+            for (int32 i = 0; i < int32(ETwitchHelixBucket::Num); ++i)
+            {
+                const FTwitchChatHelix::FBucketStatus Status = Helix->GetBucketStatus(ETwitchHelixBucket(i));
+                UE_LOG(LogTwitchChat, Display, TEXT("%-5s %5.0f / %d points, %d queued%s"), BucketNames[i],
+                    Status.Tokens, Status.Limit, Status.Queued,
+                    Status.BlockedFor > 0.0 ? *FString::Printf(TEXT(", held for %.0f s"), Status.BlockedFor) : TEXT(""));
+            }
+
+            const FTwitchChatMetrics& Metrics = FTwitchChatMetrics::Get();
+            UE_LOG(LogTwitchChat, Display, TEXT("%lld requests, %lld throttled, %lld keys batched, %lld cache hits, %d cached"),
+                Metrics.GetCounter(ETwitchChatCounter::HelixRequests), Metrics.GetCounter(ETwitchChatCounter::HelixThrottled),
+                Metrics.GetCounter(ETwitchChatCounter::HelixBatchedKeys), Metrics.GetCounter(ETwitchChatCounter::HelixCacheHits),
+                Helix->GetCacheSize());
+        })
+);
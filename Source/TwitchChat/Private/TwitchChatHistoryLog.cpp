@@ -0,0 +1,647 @@
+#include "TwitchChatHistoryLog.h"
+#include "TwitchChatConnection.h"
+#include "TwitchChatSettings.h"
+#include "TwitchChatStats.h"
+#include "TwitchChatMetrics.h"
+
+#include "HAL/RunnableThread.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Paths.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Compression.h"
+#include "Misc/ScopeRWLock.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+
+namespace TwitchChatHistory
+{
+    static const uint32 SegmentMagic = 0x4C484354; // "TCHL"
+    static const uint32 IndexMagic = 0x58484354;   // "TCHX"
+    static const int32  Version = 1;
+    static const TCHAR* SegmentExtension = TEXT(".tchl");
+    static const TCHAR* IndexExtension = TEXT(".tchx");
+
+    // Sanity bounds for block headers read back from disk: blocks close at BlockSizeBytes (4 MB at most)
+    // plus one record, and the smallest record (empty strings and arrays) is 48 bytes
+    static const int32  MaxBlockBytes = 64 * 1024 * 1024;
+    static const int32  MinRecordBytes = 48;
+
+    static void SerializeRecord(FArchive& Ar, FTwitchChatMessage& M)
+    {
+        int64 Ticks = M.Timestamp.GetTicks();
+        Ar << Ticks;
+        if (Ar.IsLoading())
+        {
+            M.Timestamp = FDateTime(Ticks);
+        }
+        Ar << M.MessageId << M.UserId << M.UserName << M.Message << M.UserColor << M.EmoteIds << M.EmoteRanges;
+    }
+
+    static FString UserKey(const FString& In)
+    {
+        return In.ToLower();
+    }
+}
+
+FTwitchChatHistoryLog::FOptions FTwitchChatHistoryLog::FOptions::FromSettings()
+{
+    const UTwitchChatSettings* S = GetDefault<UTwitchChatSettings>();
+
+    FOptions O;
+    O.Directory = S->HistoryDirectory.IsEmpty()
+        ? FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("TwitchChatHistory"))
+        : S->HistoryDirectory;
+    O.CompressionFormat = S->HistoryCompression == ETwitchChatHistoryCompression::Oodle ? NAME_Oodle : NAME_Zlib;
+    O.BlockSizeBytes = FMath::Clamp(S->HistoryBlockSizeKB, 4, 4096) * 1024;
+    O.SegmentSizeBytes = int64(FMath::Clamp(S->HistorySegmentSizeMB, 1, 4096)) * 1024 * 1024;
+    O.FlushIntervalSeconds = FMath::Clamp(S->HistoryFlushIntervalSeconds, 0.1f, 60.f);
+    return O;
+}
+
+namespace TwitchChatHistory
+{
+    static std::atomic<bool> bSharedCreated{ false };
+}
+
+TSharedRef<FTwitchChatHistoryLog> FTwitchChatHistoryLog::Get()
+{
+    static TSharedRef<FTwitchChatHistoryLog> Instance = []()
+        {
+            TSharedRef<FTwitchChatHistoryLog> Log = MakeShared<FTwitchChatHistoryLog>(FOptions::FromSettings());
+            TwitchChatHistory::bSharedCreated = true;
+            return Log;
+        }();
+    return Instance;
+}
+
+TSharedPtr<FTwitchChatHistoryLog> FTwitchChatHistoryLog::GetIfCreated()
+{
+    return TwitchChatHistory::bSharedCreated ? TSharedPtr<FTwitchChatHistoryLog>(Get()) : nullptr;
+}
+
+FTwitchChatHistoryLog::FTwitchChatHistoryLog(const FOptions& InOptions)
+    : Options(InOptions)
+{
+    if (!FCompression::IsFormatValid(Options.CompressionFormat))
+    {
+        UE_LOG(LogTwitchChat, Warning, TEXT("History: compression %s unavailable, using Zlib"), *Options.CompressionFormat.ToString());
+        Options.CompressionFormat = NAME_Zlib;
+    }
+
+    IFileManager::Get().MakeDirectory(*Options.Directory, /*Tree=*/true);
+    LoadExistingSegments();
+
+    WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+    FlushedEvent = FPlatformProcess::GetSynchEventFromPool(false);
+    Thread = FRunnableThread::Create(this, TEXT("TwitchChatHistory"), 0, TPri_BelowNormal);
+}
+
+FTwitchChatHistoryLog::~FTwitchChatHistoryLog()
+{
+    Shutdown();
+    FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+    FPlatformProcess::ReturnSynchEventToPool(FlushedEvent);
+    WakeEvent = FlushedEvent = nullptr;
+}
+
+void FTwitchChatHistoryLog::Append(const FTwitchChatMessage& Msg)
+{
+    if (bStopping)
+    {
+        FTwitchChatMetrics::Inc(ETwitchChatCounter::ShedHistory);
+        return;
+    }
+
+    LLM_SCOPE_BYTAG(TwitchChat_Messages);
+    Pending.Enqueue(Msg);
+    QueueDepth.fetch_add(1, std::memory_order_relaxed);
+    INC_DWORD_STAT(STAT_TwitchChat_HistoryQueue);
+}
+
+void FTwitchChatHistoryLog::Flush()
+{
+    if (!Thread)
+        return;
+
+    const int32 Ticket = FlushRequested.fetch_add(1) + 1;
+    WakeEvent->Trigger();
+    while (FlushCompleted.load() < Ticket && !bStopping)
+    {
+        FlushedEvent->Wait(FTimespan::FromMilliseconds(50));
+    }
+}
+
+void FTwitchChatHistoryLog::Shutdown()
+{
+    if (!Thread)
+        return;
+
+    Stop();
+    Thread->WaitForCompletion();
+    delete Thread;
+    Thread = nullptr;
+}
+
+void FTwitchChatHistoryLog::Stop()
+{
+    bStopping = true;
+    if (WakeEvent)
+        WakeEvent->Trigger();
+}
+
+uint32 FTwitchChatHistoryLog::Run()
+{
+    LastBlockTime = FPlatformTime::Seconds();
+
+    while (!bStopping)
+    {
+        WakeEvent->Wait(FTimespan::FromSeconds(FMath::Min(Options.FlushIntervalSeconds, 0.25f)));
+
+        // Take the ticket before draining: whatever was appended before a Flush() is then in this block
+        const int32 Requested = FlushRequested.load();
+        DrainQueue();
+
+        const bool bFlushRequested = Requested != FlushCompleted.load();
+        if (bFlushRequested || FPlatformTime::Seconds() - LastBlockTime >= Options.FlushIntervalSeconds)
+        {
+            WriteBlock();
+        }
+        if (bFlushRequested)
+        {
+            FlushCompleted = Requested;
+            FlushedEvent->Trigger();
+        }
+    }
+
+    const int32 Requested = FlushRequested.load();
+    DrainQueue();
+    WriteBlock();
+    CloseSegment();
+
+    FlushCompleted = Requested;
+    FlushedEvent->Trigger();
+    return 0;
+}
+
+void FTwitchChatHistoryLog::DrainQueue()
+{
+    LLM_SCOPE_BYTAG(TwitchChat_Messages);
+    FTwitchChatMessage M;
+    while (Pending.Dequeue(M))
+    {
+        QueueDepth.fetch_sub(1, std::memory_order_relaxed);
+        DEC_DWORD_STAT(STAT_TwitchChat_HistoryQueue);
+
+        FMemoryWriter Writer(BlockBuffer, /*bIsPersistent=*/true, /*bSetOffset=*/true);
+        TwitchChatHistory::SerializeRecord(Writer, M);
+
+        const int64 Ticks = M.Timestamp.GetTicks();
+        BlockMinTicks = BlockRecords == 0 ? Ticks : FMath::Min(BlockMinTicks, Ticks);
+        BlockMaxTicks = BlockRecords == 0 ? Ticks : FMath::Max(BlockMaxTicks, Ticks);
+        ++BlockRecords;
+
+        if (!M.UserId.IsEmpty())
+            BlockUsers.Add(TwitchChatHistory::UserKey(M.UserId));
+        if (!M.UserName.IsEmpty())
+            BlockUsers.Add(TwitchChatHistory::UserKey(M.UserName));
+
+        if (BlockBuffer.Num() >= Options.BlockSizeBytes)
+        {
+            WriteBlock();
+        }
+    }
+}
+
+void FTwitchChatHistoryLog::WriteBlock()
+{
+    LastBlockTime = FPlatformTime::Seconds();
+    if (BlockRecords == 0)
+        return;
+
+    if (!SegmentWriter)
+    {
+        OpenSegment();
+        if (!SegmentWriter)
+        {
+            BlockBuffer.Reset();
+            BlockUsers.Reset();
+            BlockRecords = 0;
+            return;
+        }
+    }
+
+    const FName Format = CurrentSegment->CompressionFormat;
+    int32 CompressedSize = FCompression::CompressMemoryBound(Format, BlockBuffer.Num());
+    TArray<uint8> Compressed;
+    Compressed.SetNumUninitialized(CompressedSize);
+    if (!FCompression::CompressMemory(Format, Compressed.GetData(), CompressedSize, BlockBuffer.GetData(), BlockBuffer.Num()))
+    {
+        UE_LOG(LogTwitchChat, Error, TEXT("History: failed to compress block of %d records"), BlockRecords);
+        BlockBuffer.Reset();
+        BlockUsers.Reset();
+        BlockRecords = 0;
+        return;
+    }
+
+    FBlockEntry Entry;
+    Entry.Offset = SegmentWriter->Tell();
+    Entry.CompressedSize = CompressedSize;
+    Entry.UncompressedSize = BlockBuffer.Num();
+    Entry.NumRecords = BlockRecords;
+    Entry.MinTicks = BlockMinTicks;
+    Entry.MaxTicks = BlockMaxTicks;
+
+    // Block header duplicates the index entry so a segment can be re-indexed after a crash
+    *SegmentWriter << Entry;
+    SegmentWriter->Serialize(Compressed.GetData(), CompressedSize);
+    SegmentWriter->Flush();
+
+    {
+        FWriteScopeLock Lock(IndexLock);
+        const int32 BlockIndex = CurrentSegment->Blocks.Add(Entry);
+        for (const FString& User : BlockUsers)
+        {
+            CurrentSegment->UserBlocks.FindOrAdd(User).Add(BlockIndex);
+        }
+    }
+
+    NumWritten += BlockRecords;
+    BytesWritten += CompressedSize;
+    UncompressedBytesWritten += BlockBuffer.Num();
+
+    BlockBuffer.Reset();
+    BlockUsers.Reset();
+    BlockRecords = 0;
+
+    if (SegmentWriter->Tell() >= Options.SegmentSizeBytes)
+    {
+        CloseSegment();
+    }
+}
+
+void FTwitchChatHistoryLog::OpenSegment()
+{
+    const FString Name = FString::Printf(TEXT("History_%s%s"),
+        *FDateTime::UtcNow().ToString(TEXT("%Y%m%d_%H%M%S_%s")), TwitchChatHistory::SegmentExtension);
+    const FString Path = FPaths::Combine(Options.Directory, Name);
+
+    SegmentWriter.Reset(IFileManager::Get().CreateFileWriter(*Path, FILEWRITE_AllowRead));
+    if (!SegmentWriter)
+    {
+        UE_LOG(LogTwitchChat, Error, TEXT("History: cannot open %s for writing"), *Path);
+        return;
+    }
+
+    uint32 Magic = TwitchChatHistory::SegmentMagic;
+    int32 Version = TwitchChatHistory::Version;
+    FString FormatName = Options.CompressionFormat.ToString();
+    *SegmentWriter << Magic << Version << FormatName;
+
+    CurrentSegment = MakeShared<FSegment>();
+    CurrentSegment->Path = Path;
+    CurrentSegment->CompressionFormat = Options.CompressionFormat;
+
+    FWriteScopeLock Lock(IndexLock);
+    Segments.Add(CurrentSegment);
+}
+
+void FTwitchChatHistoryLog::CloseSegment()
+{
+    if (!SegmentWriter)
+        return;
+
+    SegmentWriter->Close();
+    SegmentWriter.Reset();
+
+    {
+        FReadScopeLock Lock(IndexLock);
+        SaveSegmentIndex(*CurrentSegment);
+    }
+    CurrentSegment.Reset();
+}
+
+void FTwitchChatHistoryLog::SaveSegmentIndex(const FSegment& Segment) const
+{
+    TArray<uint8> Data;
+    FMemoryWriter Ar(Data);
+
+    uint32 Magic = TwitchChatHistory::IndexMagic;
+    int32 Version = TwitchChatHistory::Version;
+    TArray<FBlockEntry> Blocks = Segment.Blocks;
+    TMap<FString, TArray<int32>> UserBlocks = Segment.UserBlocks;
+    Ar << Magic << Version << Blocks << UserBlocks;
+
+    FFileHelper::SaveArrayToFile(Data, *FPaths::ChangeExtension(Segment.Path, TwitchChatHistory::IndexExtension));
+}
+
+bool FTwitchChatHistoryLog::LoadSegmentIndex(FSegment& Segment) const
+{
+    TArray<uint8> Data;
+    const FString IndexPath = FPaths::ChangeExtension(Segment.Path, TwitchChatHistory::IndexExtension);
+    if (!FFileHelper::LoadFileToArray(Data, *IndexPath, FILEREAD_Silent))
+        return false;
+
+    FMemoryReader Ar(Data);
+    uint32 Magic = 0;
+    int32 Version = 0;
+    Ar << Magic << Version;
+    if (Magic != TwitchChatHistory::IndexMagic || Version != TwitchChatHistory::Version)
+        return false;
+
+    Ar << Segment.Blocks << Segment.UserBlocks;
+    return !Ar.IsError();
+}
+
+bool FTwitchChatHistoryLog::RebuildSegmentIndex(FSegment& Segment) const
+{
+    TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Segment.Path, FILEREAD_AllowWrite));
+    if (!Reader)
+        return false;
+
+    const int64 Size = Reader->TotalSize();
+    while (!Reader->IsError() && Reader->Tell() < Size)
+    {
+        FBlockEntry Entry;
+        *Reader << Entry;
+        if (Reader->IsError() || Entry.CompressedSize <= 0 || Entry.CompressedSize > TwitchChatHistory::MaxBlockBytes
+            || Reader->Tell() + Entry.CompressedSize > Size)
+            break; // torn tail block
+
+        FBlockRef Ref{ Segment.Path, Segment.CompressionFormat, Entry };
+        TArray<uint8> Compressed;
+        Compressed.SetNumUninitialized(Entry.CompressedSize);
+        Reader->Serialize(Compressed.GetData(), Entry.CompressedSize);
+
+        TArray<FTwitchChatMessage> Records;
+        if (!DecodeBlock(Ref, Compressed, Records))
+            break;
+
+        const int32 BlockIndex = Segment.Blocks.Add(Entry);
+        for (const FTwitchChatMessage& M : Records)
+        {
+            for (const FString* Key : { &M.UserId, &M.UserName })
+            {
+                if (!Key->IsEmpty())
+                    Segment.UserBlocks.FindOrAdd(TwitchChatHistory::UserKey(*Key)).AddUnique(BlockIndex);
+            }
+        }
+    }
+
+    SaveSegmentIndex(Segment);
+    return true;
+}
+
+void FTwitchChatHistoryLog::LoadExistingSegments()
+{
+    TArray<FString> Files;
+    IFileManager::Get().FindFiles(Files, *FPaths::Combine(Options.Directory, FString(TEXT("*")) + TwitchChatHistory::SegmentExtension), true, false);
+    Files.Sort();
+
+    for (const FString& File : Files)
+    {
+        TSharedPtr<FSegment> Segment = MakeShared<FSegment>();
+        Segment->Path = FPaths::Combine(Options.Directory, File);
+
+        TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Segment->Path));
+        if (!Reader)
+            continue;
+
+        uint32 Magic = 0;
+        int32 Version = 0;
+        FString FormatName;
+        *Reader << Magic << Version << FormatName;
+        if (Magic != TwitchChatHistory::SegmentMagic || Version != TwitchChatHistory::Version)
+        {
+            UE_LOG(LogTwitchChat, Warning, TEXT("History: skipping unknown segment %s"), *File);
+            continue;
+        }
+        Segment->CompressionFormat = FName(*FormatName);
+        Reader.Reset();
+
+        if (!LoadSegmentIndex(*Segment) && !RebuildSegmentIndex(*Segment))
+            continue;
+
+        Segments.Add(Segment);
+    }
+
+    if (Segments.Num() > 0)
+    {
+        UE_LOG(LogTwitchChat, Log, TEXT("History: indexed %d segment(s) in %s"), Segments.Num(), *Options.Directory);
+    }
+}
+
+bool FTwitchChatHistoryLog::DecodeBlock(const FBlockRef& Ref, const TArray<uint8>& Compressed, TArray<FTwitchChatMessage>& Out)
+{
+    // The header may come from a torn or corrupt tail; check it before sizing anything from it
+    const FBlockEntry& Block = Ref.Block;
+    if (Block.UncompressedSize <= 0 || Block.UncompressedSize > TwitchChatHistory::MaxBlockBytes
+        || Block.NumRecords <= 0 || Block.NumRecords > Block.UncompressedSize / TwitchChatHistory::MinRecordBytes
+        || Compressed.Num() != Block.CompressedSize)
+    {
+        return false;
+    }
+
+    TArray<uint8> Raw;
+    Raw.SetNumUninitialized(Ref.Block.UncompressedSize);
+    if (!FCompression::UncompressMemory(Ref.CompressionFormat, Raw.GetData(), Raw.Num(), Compressed.GetData(), Compressed.Num()))
+        return false;
+
+    FMemoryReader Ar(Raw);
+    Out.Reserve(Out.Num() + Ref.Block.NumRecords);
+    for (int32 i = 0; i < Ref.Block.NumRecords && !Ar.IsError(); ++i)
+    {
+        TwitchChatHistory::SerializeRecord(Ar, Out.AddDefaulted_GetRef());
+    }
+    return !Ar.IsError();
+}
+
+TArray<FTwitchChatMessage> FTwitchChatHistoryLog::ReadBlocks(
+    const TArray<FBlockRef>& Refs,
+    TFunctionRef<bool(const FTwitchChatMessage&)> Filter,
+    FQueryStats* OutStats) const
+{
+    TArray<FTwitchChatMessage> Result;
+    TUniquePtr<FArchive> Reader;
+    FString OpenPath;
+
+    for (const FBlockRef& Ref : Refs)
+    {
+        if (!Reader || OpenPath != Ref.Path)
+        {
+            Reader.Reset(IFileManager::Get().CreateFileReader(*Ref.Path, FILEREAD_AllowWrite));
+            OpenPath = Ref.Path;
+            if (!Reader)
+                continue;
+        }
+
+        FBlockEntry Header;
+        Reader->Seek(Ref.Block.Offset);
+        *Reader << Header;
+
+        TArray<uint8> Compressed;
+        Compressed.SetNumUninitialized(Ref.Block.CompressedSize);
+        Reader->Serialize(Compressed.GetData(), Compressed.Num());
+        if (Reader->IsError())
+        {
+            Reader.Reset();
+            continue;
+        }
+
+        TArray<FTwitchChatMessage> Records;
+        if (!DecodeBlock(Ref, Compressed, Records))
+            continue;
+
+        if (OutStats)
+        {
+            ++OutStats->BlocksRead;
+            OutStats->BytesRead += Compressed.Num();
+        }
+
+        for (FTwitchChatMessage& M : Records)
+        {
+            if (Filter(M))
+                Result.Add(MoveTemp(M));
+        }
+    }
+
+    Result.StableSort([](const FTwitchChatMessage& A, const FTwitchChatMessage& B) { return A.Timestamp < B.Timestamp; });
+    return Result;
+}
+
+TArray<FTwitchChatMessage> FTwitchChatHistoryLog::QueryTimeRange(const FDateTime& From, const FDateTime& To, FQueryStats* OutStats) const
+{
+    const int64 FromTicks = From.GetTicks();
+    const int64 ToTicks = To.GetTicks();
+
+    TArray<FBlockRef> Refs;
+    {
+        FReadScopeLock Lock(IndexLock);
+        for (const TSharedPtr<FSegment>& Segment : Segments)
+        {
+            for (const FBlockEntry& Block : Segment->Blocks)
+            {
+                if (OutStats) ++OutStats->BlocksScanned;
+                if (Block.MaxTicks >= FromTicks && Block.MinTicks <= ToTicks)
+                    Refs.Add({ Segment->Path, Segment->CompressionFormat, Block });
+            }
+        }
+    }
+
+    return ReadBlocks(Refs, [FromTicks, ToTicks](const FTwitchChatMessage& M)
+        {
+            const int64 T = M.Timestamp.GetTicks();
+            return T >= FromTicks && T <= ToTicks;
+        }, OutStats);
+}
+
+TArray<FTwitchChatMessage> FTwitchChatHistoryLog::QueryUser(const FString& UserKey, const FDateTime& From, const FDateTime& To, FQueryStats* OutStats) const
+{
+    const FString Key = TwitchChatHistory::UserKey(UserKey);
+    const int64 FromTicks = From.GetTicks();
+    const int64 ToTicks = To.GetTicks();
+
+    TArray<FBlockRef> Refs;
+    {
+        FReadScopeLock Lock(IndexLock);
+        for (const TSharedPtr<FSegment>& Segment : Segments)
+        {
+            const TArray<int32>* BlockIndices = Segment->UserBlocks.Find(Key);
+            if (!BlockIndices)
+                continue;
+
+            for (int32 Index : *BlockIndices)
+            {
+                const FBlockEntry& Block = Segment->Blocks[Index];
+                if (OutStats) ++OutStats->BlocksScanned;
+                if (Block.MaxTicks >= FromTicks && Block.MinTicks <= ToTicks)
+                    Refs.Add({ Segment->Path, Segment->CompressionFormat, Block });
+            }
+        }
+    }
+
+    return ReadBlocks(Refs, [&Key, FromTicks, ToTicks](const FTwitchChatMessage& M)
+        {
+            const int64 T = M.Timestamp.GetTicks();
+            return T >= FromTicks && T <= ToTicks
+                && (M.UserId == Key || M.UserName.Equals(Key, ESearchCase::IgnoreCase));
+        }, OutStats);
+}
+
+//-----------------------------------------------------------------------------
+// twitchchat.history.bench [Messages] [Users]
+// Writes a synthetic transcript into a scratch directory and reports sustained
+// write rate and query latency.
+//-----------------------------------------------------------------------------
+static void RunHistoryBenchmark(const TArray<FString>& Args)
+{
+    const int32 NumMessages = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 200000;
+    const int32 NumUsers = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 2000;
+
+    FTwitchChatHistoryLog::FOptions Options = FTwitchChatHistoryLog::FOptions::FromSettings();
+    Options.Directory = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("TwitchChatHistoryBench"));
+    IFileManager::Get().DeleteDirectory(*Options.Directory, false, true);
+
+    // One hour of chat ending now
+    const FDateTime End = FDateTime::UtcNow();
+    const int64 StepTicks = FTimespan::FromHours(1).GetTicks() / NumMessages;
+
+    TArray<FTwitchChatMessage> Samples;
+    Samples.SetNum(FMath::Min(NumUsers, NumMessages));
+    for (int32 i = 0; i < Samples.Num(); ++i)
+    {
+        FTwitchChatMessage& M = Samples[i];
+        M.UserId = FString::FromInt(100000 + i);
+        M.UserName = FString::Printf(TEXT("viewer_%d"), i);
+        M.Message = FString::Printf(TEXT("synthetic message %d with some typical chat length Kappa"), i);
+        M.UserColor = FLinearColor::MakeRandomColor();
+        M.EmoteIds.Add(TEXT("25"));
+        M.EmoteRanges.Add(FIntPoint(M.Message.Len() - 5, M.Message.Len() - 1));
+    }
+
+    {
+        TSharedRef<FTwitchChatHistoryLog> Log = MakeShared<FTwitchChatHistoryLog>(Options);
+
+        const double WriteStart = FPlatformTime::Seconds();
+        for (int32 i = 0; i < NumMessages; ++i)
+        {
+            FTwitchChatMessage& M = Samples[i % Samples.Num()];
+            M.MessageId = FString::FromInt(i);
+            M.Timestamp = End - FTimespan(StepTicks * (NumMessages - i));
+            Log->Append(M);
+        }
+        Log->Flush();
+        const double WriteSecs = FPlatformTime::Seconds() - WriteStart;
+
+        FTwitchChatHistoryLog::FQueryStats RangeStats;
+        const double RangeStart = FPlatformTime::Seconds();
+        const int32 RangeHits = Log->QueryTimeRange(End - FTimespan::FromMinutes(5), End, &RangeStats).Num();
+        const double RangeSecs = FPlatformTime::Seconds() - RangeStart;
+
+        FTwitchChatHistoryLog::FQueryStats UserStats;
+        const double UserStart = FPlatformTime::Seconds();
+        const int32 UserHits = Log->QueryUser(Samples[0].UserName, FDateTime::MinValue(), FDateTime::MaxValue(), &UserStats).Num();
+        const double UserSecs = FPlatformTime::Seconds() - UserStart;
+
+        UE_LOG(LogTwitchChat, Display, TEXT("History bench: %d messages, %d users, %s"),
+            NumMessages, Samples.Num(), *Options.CompressionFormat.ToString());
+        UE_LOG(LogTwitchChat, Display, TEXT("  write   %.0f msg/s, %.2f MB/s raw, ratio %.2f"),
+            NumMessages / WriteSecs,
+            Log->GetUncompressedBytesWritten() / WriteSecs / (1024.0 * 1024.0),
+            double(Log->GetUncompressedBytesWritten()) / FMath::Max<int64>(1, Log->GetBytesWritten()));
+        UE_LOG(LogTwitchChat, Display, TEXT("  last 5m %6.2f ms, %d hits, %d/%d blocks read"),
+            RangeSecs * 1000.0, RangeHits, RangeStats.BlocksRead, RangeStats.BlocksScanned);
+        UE_LOG(LogTwitchChat, Display, TEXT("  by user %6.2f ms, %d hits, %d/%d blocks read"),
+            UserSecs * 1000.0, UserHits, UserStats.BlocksRead, UserStats.BlocksScanned);
+
+        Log->Shutdown();
+    }
+
+    IFileManager::Get().DeleteDirectory(*Options.Directory, false, true);
+}
+
+static FAutoConsoleCommand GTwitchChatHistoryBenchCmd(
+    TEXT("twitchchat.history.bench"),
+    TEXT("Benchmark the chat history log. Usage: twitchchat.history.bench [Messages] [Users]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&RunHistoryBenchmark)
+);
@@ -0,0 +1,350 @@
+#include "TwitchChatImages.h"
+#include "TwitchChatHelix.h"
+#include "TwitchChatSettings.h"
+#include "TwitchChatStats.h"
+#include "Engine/Texture2D.h"
+#include "Brushes/SlateImageBrush.h"
+#include "IImageWrapperModule.h"
+#include "IImageWrapper.h"
+#include "Modules/ModuleManager.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpResponse.h"
+#include "Dom/JsonObject.h"
+#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+
+TSharedRef<FTwitchChatImages> FTwitchChatImages::Get()
+{
+    static TSharedRef<FTwitchChatImages> Instance = MakeShared<FTwitchChatImages>();
+    return Instance;
+}
+
+void FTwitchChatImages::EnsureBound()
+{
+    if (StateHandle.IsValid())
+        return;
+    StateHandle = FTwitchChatConnection::Get()->OnStateChanged.AddSP(this, &FTwitchChatImages::HandleStateChanged);
+    ByUrl.Empty(FMath::Max(1, GetDefault<UTwitchChatSettings>()->ChatterImageAtlasPages) * CellsPerPage);
+}
+
+void FTwitchChatImages::HandleStateChanged(ETwitchChatConnectionState State)
+{
+    // A migration keeps the session's channels; anything else reaching Connected is a new connect
+    if (State == ETwitchChatConnectionState::Connected && LastState != ETwitchChatConnectionState::Migrating)
+    {
+        Reset();
+        ResolveBadges(FString());
+    }
+    LastState = State;
+}
+
+void FTwitchChatImages::Reset()
+{
+    Badges.Reset();
+    AvatarUrls.Reset();
+    Failed.Reset();
+}
+
+void FTwitchChatImages::ResolveBadges(const FString& ChannelId)
+{
+    if (Badges.Contains(ChannelId))
+        return;
+
+    Badges.Add(ChannelId);
+    const ETwitchHelixLookup Kind = ChannelId.IsEmpty() ? ETwitchHelixLookup::GlobalBadges : ETwitchHelixLookup::ChannelBadges;
+    FTwitchChatHelix::Get()->Lookup(Kind, ChannelId, [WeakThis = AsWeak(), ChannelId](const TArray<TSharedPtr<FJsonObject>>& Items)
+        {
+            TSharedPtr<FTwitchChatImages> This = WeakThis.Pin();
+            FBadgeSets* Sets = This ? This->Badges.Find(ChannelId) : nullptr;
+            if (!Sets)
+                return;
+
+            // [{ set_id, versions: [{ id, image_url_1x, image_url_2x, image_url_4x, ... }] }]
+            for (const TSharedPtr<FJsonObject>& Set : Items)
+            {
+                const FString SetId = Set->GetStringField(TEXT("set_id"));
+                const TArray<TSharedPtr<FJsonValue>>* Versions = nullptr;
+                if (!Set->TryGetArrayField(TEXT("versions"), Versions))
+                    continue;
+                for (const TSharedPtr<FJsonValue>& Value : *Versions)
+                {
+                    const TSharedPtr<FJsonObject>* Version = nullptr;
+                    FString Url;
+                    if (Value->TryGetObject(Version) && (*Version)->TryGetStringField(TEXT("image_url_4x"), Url))
+                    {
+                        Sets->Urls.Add(SetId + TEXT("/") + (*Version)->GetStringField(TEXT("id")), Url);
+                    }
+                }
+            }
+            Sets->bResolved = true;
+            This->OnImagesLoaded.Broadcast();
+        });
+}
+
+const FSlateBrush* FTwitchChatImages::FindBadge(const FString& ChannelId, const FString& Badge)
+{
+    check(IsInGameThread());
+    EnsureBound();
+
+    // A channel's own set (subscriber and bits badges) replaces the global one of the same name
+    ResolveBadges(FString());
+    ResolveBadges(ChannelId);
+    const FBadgeSets& Global = Badges.FindChecked(FString());
+    const FBadgeSets& Channel = Badges.FindChecked(ChannelId);
+    if (!Channel.bResolved || !Global.bResolved)
+        return nullptr;
+
+    const FString* Url = Channel.Urls.Find(Badge);
+    if (!Url)
+        Url = Global.Urls.Find(Badge);
+    return Url ? FindImage(*Url) : nullptr;
+}
+
+const FSlateBrush* FTwitchChatImages::FindAvatar(const FString& UserId)
+{
+    check(IsInGameThread());
+    EnsureBound();
+    if (UserId.IsEmpty())
+        return nullptr;
+
+    if (const FString* Url = AvatarUrls.Find(UserId))
+        return Url->IsEmpty() ? nullptr : FindImage(*Url);
+
+    // Lookups made within the Helix merge window share one /users?id= request
+    AvatarUrls.Add(UserId);
+    FTwitchChatHelix::Get()->Lookup(ETwitchHelixLookup::UserById, UserId, [WeakThis = AsWeak(), UserId](const TArray<TSharedPtr<FJsonObject>>& Items)
+        {
+            TSharedPtr<FTwitchChatImages> This = WeakThis.Pin();
+            FString* Url = This ? This->AvatarUrls.Find(UserId) : nullptr;
+            if (Url && Items.Num() > 0 && Items[0]->TryGetStringField(TEXT("profile_image_url"), *Url) && !Url->IsEmpty())
+            {
+                This->OnImagesLoaded.Broadcast();
+            }
+        });
+    return nullptr;
+}
+
+const FSlateBrush* FTwitchChatImages::FindImage(const FString& Url)
+{
+    if (const int32* Cell = ByUrl.FindAndTouch(Url))
+        return Cells[*Cell].Brush.Get();
+    if (!Loading.Contains(Url) && !Failed.Contains(Url))
+        Load(Url);
+    return nullptr;
+}
+
+void FTwitchChatImages::Load(const FString& Url)
+{
+    Loading.Add(Url);
+
+    // The module must be loaded here; creating wrappers from it is safe on any thread
+    IImageWrapperModule& ImageWrapper = FModuleManager::LoadModuleChecked<IImageWrapperModule>("ImageWrapper");
+
+    auto Req = FHttpModule::Get().CreateRequest();
+    Req->SetURL(Url);
+    Req->SetVerb(TEXT("GET"));
+    Req->OnProcessRequestComplete().BindLambda([WeakThis = AsWeak(), Url, &ImageWrapper](FHttpRequestPtr, FHttpResponsePtr Resp, bool bOK)
+        {
+            if (!bOK || !Resp.IsValid() || !EHttpResponseCodes::IsOk(Resp->GetResponseCode()))
+            {
+                if (TSharedPtr<FTwitchChatImages> This = WeakThis.Pin())
+                {
+                    This->Loading.Remove(Url);
+                    This->Failed.Add(Url);
+                }
+                return;
+            }
+
+            Async(EAsyncExecution::ThreadPool, [WeakThis, Url, &ImageWrapper, Compressed = Resp->GetContent()]()
+                {
+                    TArray<uint8> Pixels;
+                    const bool bDecoded = Decode(ImageWrapper, Compressed, Pixels);
+                    AsyncTask(ENamedThreads::GameThread, [WeakThis, Url, bDecoded, Pixels = MoveTemp(Pixels)]() mutable
+                        {
+                            TSharedPtr<FTwitchChatImages> This = WeakThis.Pin();
+                            if (!This || !This->Loading.Remove(Url))
+                                return;
+                            if (!bDecoded)
+                            {
+                                This->Failed.Add(Url);
+                                return;
+                            }
+                            This->Place(Url, MoveTemp(Pixels));
+                        });
+                });
+        });
+    Req->ProcessRequest();
+}
+
+bool FTwitchChatImages::Decode(IImageWrapperModule& ImageWrapper, const TArray<uint8>& Compressed, TArray<uint8>& OutPixels)
+{
+    SCOPE_CYCLE_COUNTER(STAT_TwitchChat_EmoteDecode);
+    const EImageFormat Format = ImageWrapper.DetectImageFormat(Compressed.GetData(), Compressed.Num());
+    if (Format == EImageFormat::Invalid)
+        return false;
+    TSharedPtr<IImageWrapper> Wrapper = ImageWrapper.CreateImageWrapper(Format);
+    TArray<uint8> Raw;
+    if (!Wrapper.IsValid() || !Wrapper->SetCompressed(Compressed.GetData(), Compressed.Num()) || !Wrapper->GetRaw(ERGBFormat::BGRA, 8, Raw))
+        return false;
+
+    const int32 SrcW = Wrapper->GetWidth();
+    const int32 SrcH = Wrapper->GetHeight();
+    if (SrcW <= 0 || SrcH <= 0)
+        return false;
+
+    // Box filter into the cell, keeping the aspect ratio; profile pictures arrive at 300 px
+    const double Scale = double(CellSize) / FMath::Max(SrcW, SrcH);
+    const int32 DstW = FMath::Clamp(FMath::RoundToInt(SrcW * Scale), 1, CellSize);
+    const int32 DstH = FMath::Clamp(FMath::RoundToInt(SrcH * Scale), 1, CellSize);
+    const int32 OffsetX = (CellSize - DstW) / 2;
+    const int32 OffsetY = (CellSize - DstH) / 2;
+
+    OutPixels.SetNumZeroed(CellSize * CellSize * 4);
+    for (int32 Y = 0; Y < DstH; ++Y)
+    {
+        const int32 Y0 = Y * SrcH / DstH;
+        const int32 Y1 = FMath::Max(Y0 + 1, (Y + 1) * SrcH / DstH);
+        for (int32 X = 0; X < DstW; ++X)
+        {
+            const int32 X0 = X * SrcW / DstW;
+            const int32 X1 = FMath::Max(X0 + 1, (X + 1) * SrcW / DstW);
+            uint32 Sum[4] = {};
+            for (int32 SY = Y0; SY < Y1; ++SY)
+            {
+                const uint8* Src = &Raw[(SY * SrcW + X0) * 4];
+                for (int32 SX = X0; SX < X1; ++SX, Src += 4)
+                {
+                    Sum[0] += Src[0]; Sum[1] += Src[1]; Sum[2] += Src[2]; Sum[3] += Src[3];
+                }
+            }
+            const uint32 Count = uint32((Y1 - Y0) * (X1 - X0));
+            uint8* Dst = &OutPixels[((OffsetY + Y) * CellSize + OffsetX + X) * 4];
+            for (int32 C = 0; C < 4; ++C)
+            {
+                Dst[C] = uint8(Sum[C] / Count);
+            }
+        }
+    }
+    return true;
+}
+
+int32 FTwitchChatImages::AllocateCell()
+{
+    if (Cells.Num() < Pages.Num() * CellsPerPage)
+    {
+        return Cells.AddDefaulted();
+    }
+    if (Pages.Num() < FMath::Max(1, GetDefault<UTwitchChatSettings>()->ChatterImageAtlasPages))
+    {
+        LLM_SCOPE_BYTAG(TwitchChat_EmoteTextures);
+        UTexture2D* Page = UTexture2D::CreateTransient(PageSize, PageSize, PF_B8G8R8A8);
+        if (Page)
+        {
+            Page->SRGB = true;
+            Page->Filter = TF_Bilinear;
+            Page->NeverStream = true;
+            void* MipData = Page->GetPlatformData()->Mips[0].BulkData.Lock(LOCK_READ_WRITE);
+            FMemory::Memzero(MipData, PageSize * PageSize * 4);
+            Page->GetPlatformData()->Mips[0].BulkData.Unlock();
+            Page->AddToRoot();
+            Page->UpdateResource();
+            Pages.Add(Page);
+            return Cells.AddDefaulted();
+        }
+    }
+    if (ByUrl.Num() == 0)
+        return INDEX_NONE;
+
+    // Full: the least recently drawn image gives up its cell
+    const int32 Cell = ByUrl.RemoveLeastRecent();
+    Cells[Cell].Url.Reset();
+    return Cell;
+}
+
+void FTwitchChatImages::Place(const FString& Url, TArray<uint8>&& Pixels)
+{
+    const int32 Cell = AllocateCell();
+    if (Cell == INDEX_NONE)
+        return;
+
+    UTexture2D* Page = Pages[Cell / CellsPerPage];
+    const int32 X = (Cell % CellsPerPage) % CellsPerRow * CellSize;
+    const int32 Y = (Cell % CellsPerPage) / CellsPerRow * CellSize;
+
+    FCell& Slot = Cells[Cell];
+    if (!Slot.Brush.IsValid())
+    {
+        Slot.Brush = MakeShared<FSlateImageBrush>(Page, FVector2D(CellSize, CellSize));
+        Slot.Brush->SetUVRegion(FBox2f(FVector2f(X, Y) / PageSize, FVector2f(X + CellSize, Y + CellSize) / PageSize));
+    }
+    Slot.Url = Url;
+    ByUrl.Add(Url, Cell);
+
+    // The render thread reads the pixels later; the cleanup callback frees them there
+    FUpdateTextureRegion2D* Region = new FUpdateTextureRegion2D(X, Y, 0, 0, CellSize, CellSize);
+    uint8* Data = static_cast<uint8*>(FMemory::Malloc(Pixels.Num()));
+    FMemory::Memcpy(Data, Pixels.GetData(), Pixels.Num());
+    Page->UpdateTextureRegions(0, 1, Region, CellSize * 4, 4, Data,
+        [](uint8* SrcData, const FUpdateTextureRegion2D* Regions)
+        {
+            FMemory::Free(SrcData);
+            delete Regions;
+        });
+
+    OnImagesLoaded.Broadcast();
+}
+
+SIZE_T FTwitchChatImages::GetAllocatedSize() const
+{
+    SIZE_T Bytes = SIZE_T(Pages.Num()) * PageSize * PageSize * 4
+        + Cells.GetAllocatedSize() + Cells.Num() * sizeof(FSlateImageBrush)
+        + Badges.GetAllocatedSize() + AvatarUrls.GetAllocatedSize();
+    for (const FCell& Cell : Cells)
+    {
+        Bytes += Cell.Url.GetAllocatedSize();
+    }
+    for (const TPair<FString, FBadgeSets>& Pair : Badges)
+    {
+        Bytes += Pair.Value.Urls.GetAllocatedSize();
+        for (const TPair<FString, FString>& Url : Pair.Value.Urls)
+        {
+            Bytes += Url.Key.GetAllocatedSize() + Url.Value.GetAllocatedSize();
+        }
+    }
+    for (const TPair<FString, FString>& Pair : AvatarUrls)
+    {
+        Bytes += Pair.Key.GetAllocatedSize() + Pair.Value.GetAllocatedSize();
+    }
+    return Bytes;
+}
+
+void FTwitchChatImages::Shutdown()
+{
+    if (StateHandle.IsValid())
+    {
+        FTwitchChatConnection::Get()->OnStateChanged.Remove(StateHandle);
+        StateHandle.Reset();
+    }
+    Reset();
+    Loading.Reset();
+    ByUrl.Empty();
+    Cells.Reset();
+    for (UTexture2D* Page : Pages)
+    {
+        Page->RemoveFromRoot();
+    }
+    Pages.Reset();
+}
+
+static FAutoConsoleCommand GTwitchChatImagesCmd(
+    TEXT("twitchchat.images"),
+    TEXT("Badge and profile picture atlas: pages, cells in use, images loading."),
+    FConsoleCommandDelegate::CreateLambda([]()
+        {
+            TSharedRef<FTwitchChatImages> Images = FTwitchChatImages::Get();
+            UE_LOG(LogTwitchChat, Display, TEXT("%d images in %d atlas page(s) of %d cells (%dx%d px), %d loading, %.1f MB"),
+                Images->Num(), Images->GetPageCount(), FTwitchChatImages::CellsPerPage,
+                FTwitchChatImages::PageSize, FTwitchChatImages::PageSize, Images->GetLoadingCount(),
+                Images->GetAllocatedSize() / (1024.0 * 1024.0));
+        })
+);
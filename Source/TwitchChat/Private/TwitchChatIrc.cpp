@@ -0,0 +1,449 @@
+#include "TwitchChatIrc.h"
+#include "TwitchChatConnection.h"
+#include "TwitchChatMetrics.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+#include "AddressInfoTypes.h"
+#include "HAL/RunnableThread.h"
+#include "Async/Async.h"
+
+namespace TwitchChatIrc
+{
+    // Twitch PINGs roughly every five minutes; ask ourselves if it has been quiet for longer
+    static constexpr double IdlePingSeconds = 330.0;
+    static constexpr double PongTimeoutSeconds = 15.0;
+    static constexpr double ConnectTimeoutSeconds = 10.0;
+
+    static FString UnescapeTag(const FString& Value)
+    {
+        if (!Value.Contains(TEXT("\\")))
+            return Value;
+
+        FString Out;
+        Out.Reserve(Value.Len());
+        for (int32 i = 0; i < Value.Len(); ++i)
+        {
+            if (Value[i] != TEXT('\\') || i + 1 == Value.Len())
+            {
+                Out.AppendChar(Value[i]);
+                continue;
+            }
+            switch (Value[++i])
+            {
+            case TEXT('s'): Out.AppendChar(TEXT(' ')); break;
+            case TEXT(':'): Out.AppendChar(TEXT(';')); break;
+            case TEXT('r'): Out.AppendChar(TEXT('\r')); break;
+            case TEXT('n'): Out.AppendChar(TEXT('\n')); break;
+            default:        Out.AppendChar(Value[i]); break;
+            }
+        }
+        return Out;
+    }
+
+    // IRC emote positions count code points; FString indexes UTF-16 units
+    static TArray<int32> MapCodePoints(const FString& Text)
+    {
+        TArray<int32> Map;
+        for (int32 i = 0; i < Text.Len(); ++i)
+        {
+            if (!StringConv::IsLowSurrogate(Text[i]))
+                Map.Add(i);
+        }
+        Map.Add(Text.Len());
+        return Map;
+    }
+}
+
+struct FTwitchChatIrc::FResolve
+{
+    TSharedPtr<FInternetAddr> Address;
+    std::atomic<bool> bDone{ false };
+};
+
+FTwitchChatIrc::FTwitchChatIrc(FTwitchChatConnection& InConnection)
+    : Connection(InConnection)
+{
+}
+
+FTwitchChatIrc::~FTwitchChatIrc()
+{
+    Shutdown();
+}
+
+bool FTwitchChatIrc::Start(const FString& InHost, int32 InPort, const TArray<FString>& InChannels)
+{
+    check(!Thread);
+    Host = InHost;
+    Port = InPort;
+    Nick = FString::Printf(TEXT("justinfan%d"), FMath::RandRange(10000, 99999));
+    Channels = TSet<FString>(InChannels);
+    bStopping = false;
+
+    Thread = FRunnableThread::Create(this, TEXT("TwitchChatIrc"), 0, TPri_AboveNormal);
+    return Thread != nullptr;
+}
+
+void FTwitchChatIrc::Shutdown()
+{
+    if (Thread)
+    {
+        Stop();
+        Thread->WaitForCompletion();
+        delete Thread;
+        Thread = nullptr;
+    }
+}
+
+void FTwitchChatIrc::Stop()
+{
+    bStopping = true;
+}
+
+void FTwitchChatIrc::Join(const FString& Login)
+{
+    ChannelChanges.Enqueue(TEXT("+") + Login.ToLower());
+}
+
+void FTwitchChatIrc::Part(const FString& Login)
+{
+    ChannelChanges.Enqueue(TEXT("-") + Login.ToLower());
+}
+
+uint32 FTwitchChatIrc::Run()
+{
+    uint8 Buffer[16 * 1024];
+    while (!bStopping)
+    {
+        const double Now = FPlatformTime::Seconds();
+        if (!Socket)
+        {
+            if (Now < NextConnectTime || !Open())
+            {
+                FPlatformProcess::Sleep(0.05f);
+            }
+            continue;
+        }
+
+        FString Change;
+        while (ChannelChanges.Dequeue(Change))
+        {
+            const FString Login = Change.Mid(1);
+            const bool bJoin = Change[0] == TEXT('+');
+            if (bJoin ? !Channels.Contains(Login) : Channels.Remove(Login) > 0)
+            {
+                if (bJoin)
+                    Channels.Add(Login);
+                Send(FString::Printf(TEXT("%s #%s"), bJoin ? TEXT("JOIN") : TEXT("PART"), *Login));
+            }
+        }
+
+        if (Now - LastReceiveTime > TwitchChatIrc::IdlePingSeconds + (bPingSent ? TwitchChatIrc::PongTimeoutSeconds : 0.0))
+        {
+            if (bPingSent)
+            {
+                Close(TEXT("no PONG"));
+                continue;
+            }
+            Send(TEXT("PING :tmi.twitch.tv"));
+            bPingSent = true;
+        }
+
+        if (!Socket->Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromMilliseconds(100)))
+            continue;
+
+        int32 BytesRead = 0;
+        if (!Socket->Recv(Buffer, sizeof(Buffer), BytesRead) || BytesRead == 0)
+        {
+            Close(TEXT("connection closed"));
+            continue;
+        }
+
+        // One stamp per read; every line in it arrived together
+        const double ReceivedTime = FPlatformTime::Seconds();
+        const FDateTime ReceivedUtc = FDateTime::UtcNow();
+        LastReceiveTime = ReceivedTime;
+        bPingSent = false;
+
+        Pending.Append(Buffer, BytesRead);
+        int32 LineStart = 0;
+        for (int32 i = 0; i + 1 < Pending.Num(); ++i)
+        {
+            if (Pending[i] == '\r' && Pending[i + 1] == '\n')
+            {
+                FUTF8ToTCHAR Line(reinterpret_cast<const ANSICHAR*>(Pending.GetData() + LineStart), i - LineStart);
+                HandleLine(FString(Line.Length(), Line.Get()), ReceivedTime, ReceivedUtc);
+                LineStart = i + 2;
+                ++i;
+            }
+        }
+        Pending.RemoveAt(0, LineStart, EAllowShrinking::No);
+    }
+
+    if (Socket || Connecting)
+    {
+        Close(TEXT("shutdown"));
+    }
+    return 0;
+}
+
+// Steps the resolve and the connect without blocking, so Run sees Stop() within one pass; true once connected
+bool FTwitchChatIrc::Open()
+{
+    ISocketSubsystem* Subsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+    if (!Connecting)
+    {
+        if (!Resolving)
+        {
+            Resolving = MakeShared<FResolve, ESPMode::ThreadSafe>();
+            Subsystem->GetAddressInfoAsync([Resolve = Resolving](FAddressInfoResult Resolved)
+                {
+                    if (Resolved.ReturnCode == SE_NO_ERROR && Resolved.Results.Num() > 0)
+                    {
+                        Resolve->Address = Resolved.Results[0].Address;
+                    }
+                    Resolve->bDone = true;
+                },
+                *Host, *FString::FromInt(Port), EAddressInfoFlags::Default, NAME_None, ESocketType::SOCKTYPE_Streaming);
+            return false;
+        }
+        if (!Resolving->bDone)
+            return false;
+
+        const TSharedPtr<FInternetAddr> Address = Resolving->Address;
+        Resolving.Reset();
+        if (!Address)
+        {
+            Close(FString::Printf(TEXT("cannot resolve %s"), *Host));
+            return false;
+        }
+
+        Connecting = Subsystem->CreateSocket(NAME_Stream, TEXT("TwitchChat IRC"), Address->GetProtocolType());
+        if (!Connecting || !Connecting->SetNonBlocking(true) || !Connecting->Connect(*Address))
+        {
+            Close(FString::Printf(TEXT("cannot connect to %s:%d"), *Host, Port));
+            return false;
+        }
+        ConnectDeadline = FPlatformTime::Seconds() + TwitchChatIrc::ConnectTimeoutSeconds;
+    }
+
+    if (!Connecting->Wait(ESocketWaitConditions::WaitForWrite, FTimespan::Zero()))
+    {
+        if (FPlatformTime::Seconds() < ConnectDeadline)
+            return false;
+        Close(FString::Printf(TEXT("timed out connecting to %s:%d"), *Host, Port));
+        return false;
+    }
+    if (Connecting->GetConnectionState() != SCS_Connected)
+    {
+        Close(FString::Printf(TEXT("cannot connect to %s:%d"), *Host, Port));
+        return false;
+    }
+
+    // Reads already wait with a timeout; blocking sends keep Send simple
+    Connecting->SetNonBlocking(false);
+    Socket = Connecting;
+    Connecting = nullptr;
+    Pending.Reset();
+    LastReceiveTime = FPlatformTime::Seconds();
+    bPingSent = false;
+
+    // Anonymous logins read chat without a token or extra scopes
+    Send(FString::Printf(TEXT("NICK %s"), *Nick));
+    Send(TEXT("CAP REQ :twitch.tv/tags twitch.tv/commands"));
+    for (const FString& Login : Channels)
+    {
+        Send(FString::Printf(TEXT("JOIN #%s"), *Login));
+    }
+    return true;
+}
+
+void FTwitchChatIrc::Close(const FString& Reason)
+{
+    if (Socket)
+    {
+        Socket->Close();
+        ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+        Socket = nullptr;
+    }
+    if (Connecting)
+    {
+        Connecting->Close();
+        ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Connecting);
+        Connecting = nullptr;
+    }
+    SetJoined(false);
+
+    if (!bStopping)
+    {
+        const double Delay = FTwitchChatConnection::GetReconnectDelay(ReconnectAttempt++);
+        UE_LOG(LogTwitchChat, Warning, TEXT("IRC: %s; reconnect in %.2f s"), *Reason, Delay);
+        NextConnectTime = FPlatformTime::Seconds() + Delay;
+        FTwitchChatMetrics::Inc(ETwitchChatCounter::IrcReconnects);
+    }
+}
+
+void FTwitchChatIrc::Send(const FString& Line)
+{
+    if (!Socket)
+        return;
+
+    FTCHARToUTF8 Utf8(*(Line + TEXT("\r\n")));
+    const uint8* Data = reinterpret_cast<const uint8*>(Utf8.Get());
+    int32 Remaining = Utf8.Length();
+    while (Remaining > 0)
+    {
+        int32 Sent = 0;
+        if (!Socket->Send(Data, Remaining, Sent))
+            return;     // the read side notices the dead socket
+        Data += Sent;
+        Remaining -= Sent;
+    }
+}
+
+void FTwitchChatIrc::SetJoined(bool bInJoined)
+{
+    if (bJoined.exchange(bInJoined) == bInJoined)
+        return;
+
+    // May run after this client is gone; the connection outlives it
+    Connection.Post(Connection.GetEpoch(), [Owner = &Connection, bInJoined]()
+        {
+            Owner->HandleIrcStatus(bInJoined);
+        });
+}
+
+void FTwitchChatIrc::HandleLine(const FString& Line, double ReceivedTime, const FDateTime& ReceivedUtc)
+{
+    if (Line.StartsWith(TEXT("PING ")))
+    {
+        Send(TEXT("PONG ") + Line.Mid(5));
+        return;
+    }
+
+    FTwitchChatMessage M;
+    if (ParsePrivmsg(Line, M))
+    {
+        M.ReceivedTime = ReceivedTime;
+        if (M.Timestamp.GetTicks() > 0)
+            M.IngestSeconds = (ReceivedUtc - M.Timestamp).GetTotalSeconds();
+        else
+            M.Timestamp = ReceivedUtc;
+        Connection.HandleIrcMessage(MoveTemp(M));
+        return;
+    }
+
+    // Skip the tags and prefix to reach the command
+    FString Rest = Line;
+    if (Rest.StartsWith(TEXT("@")))
+        Rest.Split(TEXT(" "), nullptr, &Rest);
+    if (Rest.StartsWith(TEXT(":")))
+        Rest.Split(TEXT(" "), nullptr, &Rest);
+
+    if (Rest.StartsWith(TEXT("001 ")))
+    {
+        ReconnectAttempt = 0;
+    }
+    else if (Rest.StartsWith(TEXT("JOIN ")) || Rest.StartsWith(TEXT("ROOMSTATE ")))
+    {
+        SetJoined(true);
+    }
+    else if (Rest.StartsWith(TEXT("RECONNECT")))
+    {
+        // Twitch is about to restart this server; leaving now keeps the gap short
+        Close(TEXT("server asked to reconnect"));
+        NextConnectTime = 0.0;
+    }
+    else if (Rest.StartsWith(TEXT("NOTICE ")))
+    {
+        UE_LOG(LogTwitchChat, Log, TEXT("IRC: %s"), *Rest);
+    }
+}
+
+bool FTwitchChatIrc::ParsePrivmsg(const FString& Line, FTwitchChatMessage& Out)
+{
+    // @tags :nick!nick@nick.tmi.twitch.tv PRIVMSG #channel :text
+    FString Tags, Rest = Line;
+    if (Rest.StartsWith(TEXT("@")))
+    {
+        if (!Rest.Split(TEXT(" "), &Tags, &Rest))
+            return false;
+        Tags.RemoveAt(0);
+    }
+    FString Prefix;
+    if (Rest.StartsWith(TEXT(":")) && !Rest.Split(TEXT(" "), &Prefix, &Rest))
+        return false;
+    if (!Rest.StartsWith(TEXT("PRIVMSG #")))
+        return false;
+
+    FString Channel, Text;
+    if (!Rest.Mid(9).Split(TEXT(" :"), &Channel, &Text))
+        return false;
+
+    TArray<FString> Pairs;
+    Tags.ParseIntoArray(Pairs, TEXT(";"));
+    for (const FString& Pair : Pairs)
+    {
+        FString Key, Value;
+        if (!Pair.Split(TEXT("="), &Key, &Value))
+            Key = Pair;
+        Out.Tags.Add(Key, TwitchChatIrc::UnescapeTag(Value));
+    }
+
+    // /me arrives as a CTCP ACTION
+    if (Text.StartsWith(TEXT("\x01" "ACTION ")) && Text.EndsWith(TEXT("\x01")))
+    {
+        Text = Text.Mid(8, Text.Len() - 9);
+    }
+
+    Out.RawPayload = Line;
+    Out.Transport = ETwitchChatTransport::Irc;
+    Out.ChannelLogin = Channel.ToLower();
+    Out.Message = MoveTemp(Text);
+    Out.MessageId = Out.Tags.FindRef(TEXT("id"));
+    Out.ChannelId = Out.Tags.FindRef(TEXT("room-id"));
+    Out.UserId = Out.Tags.FindRef(TEXT("user-id"));
+
+    const FString SentMs = Out.Tags.FindRef(TEXT("tmi-sent-ts"));
+    if (!SentMs.IsEmpty())
+    {
+        const int64 Ms = FCString::Atoi64(*SentMs);
+        Out.Timestamp = FDateTime::FromUnixTimestamp(Ms / 1000) + FTimespan::FromMilliseconds(double(Ms % 1000));
+    }
+
+    // As sent; the connection resolves it, with the color and badges tags, once the message is admitted
+    Out.UserName = Out.Tags.FindRef(TEXT("display-name"));
+    if (Out.UserName.IsEmpty())
+    {
+        Prefix.Mid(1).Split(TEXT("!"), &Out.UserName, nullptr);
+    }
+
+    // emotes=25:0-4,12-16/1902:6-10, inclusive code point ranges
+    const FString Emotes = Out.Tags.FindRef(TEXT("emotes"));
+    if (!Emotes.IsEmpty())
+    {
+        const TArray<int32> Map = TwitchChatIrc::MapCodePoints(Out.Message);
+        auto ToIndex = [&Map](int32 CodePoint) { return Map[FMath::Clamp(CodePoint, 0, Map.Num() - 1)]; };
+
+        TArray<FString> Entries;
+        Emotes.ParseIntoArray(Entries, TEXT("/"));
+        for (const FString& Entry : Entries)
+        {
+            FString EmoteId, Ranges;
+            if (!Entry.Split(TEXT(":"), &EmoteId, &Ranges))
+                continue;
+            TArray<FString> RangeList;
+            Ranges.ParseIntoArray(RangeList, TEXT(","));
+            for (const FString& Range : RangeList)
+            {
+                FString Begin, End;
+                if (Range.Split(TEXT("-"), &Begin, &End))
+                {
+                    Out.EmoteIds.Add(EmoteId);
+                    Out.EmoteRanges.Add(FIntPoint(ToIndex(FCString::Atoi(*Begin)), ToIndex(FCString::Atoi(*End) + 1)));
+                }
+            }
+        }
+    }
+    return !Out.MessageId.IsEmpty();
+}
@@ -0,0 +1,193 @@
+#include "TwitchChatLatency.h"
+#include "TwitchChatConnection.h"
+
+#include "HAL/IConsoleManager.h"
+
+//-----------------------------------------------------------------------------
+// Histogram
+//-----------------------------------------------------------------------------
+int32 FTwitchChatLatencyHistogram::BucketIndex(uint64 Micros)
+{
+    static constexpr uint64 Largest = (uint64(1) << (MaxShift + SubBucketBits + 1)) - 1;
+    Micros = FMath::Min(Micros, Largest);
+    if (Micros < uint64(2 * SubBuckets))
+        return int32(Micros);
+
+    const int32 Shift = int32(FPlatformMath::FloorLog2_64(Micros)) - SubBucketBits;
+    return Shift * SubBuckets + int32(Micros >> Shift);
+}
+
+uint64 FTwitchChatLatencyHistogram::BucketLowest(int32 Index)
+{
+    if (Index < 2 * SubBuckets)
+        return uint64(Index);
+
+    const int32 Shift = Index / SubBuckets - 1;
+    return uint64(Index - Shift * SubBuckets) << Shift;
+}
+
+uint64 FTwitchChatLatencyHistogram::BucketWidth(int32 Index)
+{
+    return Index < 2 * SubBuckets ? 1 : uint64(1) << (Index / SubBuckets - 1);
+}
+
+void FTwitchChatLatencyHistogram::Record(uint64 Micros)
+{
+    Buckets[BucketIndex(Micros)].fetch_add(1, std::memory_order_relaxed);
+    Count.fetch_add(1, std::memory_order_relaxed);
+    Sum.fetch_add(Micros, std::memory_order_relaxed);
+
+    uint64 Prev = Max.load(std::memory_order_relaxed);
+    while (Micros > Prev && !Max.compare_exchange_weak(Prev, Micros, std::memory_order_relaxed))
+    {
+    }
+}
+
+void FTwitchChatLatencyHistogram::Reset()
+{
+    for (std::atomic<int64>& Bucket : Buckets)
+        Bucket.store(0, std::memory_order_relaxed);
+    Count = 0;
+    Sum = 0;
+    Max = 0;
+}
+
+double FTwitchChatLatencyHistogram::GetMeanMicros() const
+{
+    const int64 N = GetCount();
+    return N > 0 ? double(Sum.load(std::memory_order_relaxed)) / N : 0.0;
+}
+
+uint64 FTwitchChatLatencyHistogram::GetPercentileMicros(double P) const
+{
+    // Buckets and Count are updated independently; rank against the bucket total seen by this scan
+    int64 Total = 0;
+    for (const std::atomic<int64>& Bucket : Buckets)
+        Total += Bucket.load(std::memory_order_relaxed);
+    if (Total == 0)
+        return 0;
+
+    const int64 Rank = FMath::Max<int64>(1, int64(FMath::CeilToDouble(FMath::Clamp(P, 0.0, 1.0) * Total)));
+    int64 Seen = 0;
+    for (int32 i = 0; i < NumBuckets; ++i)
+    {
+        Seen += Buckets[i].load(std::memory_order_relaxed);
+        if (Seen >= Rank)
+            return FMath::Min(BucketLowest(i) + (BucketWidth(i) - 1) / 2, GetMaxMicros());
+    }
+    return GetMaxMicros();
+}
+
+void FTwitchChatLatencyHistogram::ForEachBucket(TFunctionRef<void(uint64, int64)> Visit) const
+{
+    for (int32 i = 0; i < NumBuckets; ++i)
+    {
+        const int64 N = Buckets[i].load(std::memory_order_relaxed);
+        if (N > 0)
+            Visit(BucketLowest(i) + BucketWidth(i) - 1, N);
+    }
+}
+
+FTwitchChatLatencySummary FTwitchChatLatencyHistogram::Summarize() const
+{
+    FTwitchChatLatencySummary S;
+    S.Count = GetCount();
+    S.MeanMs = float(GetMeanMicros() / 1000.0);
+    S.P50Ms = GetPercentileMicros(0.50) / 1000.f;
+    S.P90Ms = GetPercentileMicros(0.90) / 1000.f;
+    S.P99Ms = GetPercentileMicros(0.99) / 1000.f;
+    S.P999Ms = GetPercentileMicros(0.999) / 1000.f;
+    S.MaxMs = GetMaxMicros() / 1000.f;
+    return S;
+}
+
+//-----------------------------------------------------------------------------
+// Stages
+//-----------------------------------------------------------------------------
+FTwitchChatLatency& FTwitchChatLatency::Get()
+{
+    static FTwitchChatLatency Instance;
+    return Instance;
+}
+
+const TCHAR* FTwitchChatLatency::GetStageName(ETwitchChatLatencyStage Stage)
+{
+    switch (Stage)
+    {
+    case ETwitchChatLatencyStage::Ingest:   return TEXT("ingest");
+    case ETwitchChatLatencyStage::Parse:    return TEXT("parse");
+    case ETwitchChatLatencyStage::Dispatch: return TEXT("dispatch");
+    case ETwitchChatLatencyStage::Render:   return TEXT("render");
+    case ETwitchChatLatencyStage::EndToEnd: return TEXT("end_to_end");
+    default:                                return TEXT("unknown");
+    }
+}
+
+void FTwitchChatLatency::Record(ETwitchChatLatencyStage Stage, double Seconds)
+{
+    if (Stage < ETwitchChatLatencyStage::Num)
+    {
+        // Clock skew between Twitch and this machine can make ingest slightly negative
+        Histograms[int32(Stage)].Record(uint64(FMath::Max(0.0, Seconds) * 1000000.0));
+    }
+}
+
+void FTwitchChatLatency::RecordParsed(const FTwitchChatMessage& Msg)
+{
+    if (Msg.IngestSeconds >= 0.0)
+        Record(ETwitchChatLatencyStage::Ingest, Msg.IngestSeconds);
+    if (Msg.ReceivedTime > 0.0 && Msg.ParsedTime > 0.0)
+        Record(ETwitchChatLatencyStage::Parse, Msg.ParsedTime - Msg.ReceivedTime);
+}
+
+void FTwitchChatLatency::RecordDispatched(const FTwitchChatMessage& Msg)
+{
+    if (Msg.ParsedTime > 0.0 && Msg.DispatchTime > 0.0)
+        Record(ETwitchChatLatencyStage::Dispatch, Msg.DispatchTime - Msg.ParsedTime);
+}
+
+void FTwitchChatLatency::RecordPainted(double ReceivedTime, double DispatchTime, double IngestSeconds)
+{
+    if (DispatchTime <= 0.0)
+        return;
+
+    const double Now = FPlatformTime::Seconds();
+    Record(ETwitchChatLatencyStage::Render, Now - DispatchTime);
+    if (IngestSeconds >= 0.0 && ReceivedTime > 0.0)
+    {
+        Record(ETwitchChatLatencyStage::EndToEnd, IngestSeconds + (Now - ReceivedTime));
+    }
+}
+
+void FTwitchChatLatency::Reset()
+{
+    for (FTwitchChatLatencyHistogram& H : Histograms)
+        H.Reset();
+}
+
+//-----------------------------------------------------------------------------
+// Console
+//-----------------------------------------------------------------------------
+static FAutoConsoleCommand GTwitchChatLatencyCmd(
+    TEXT("twitchchat.latency"),
+    TEXT("Print chat latency percentiles per stage. Usage: twitchchat.latency [reset]"),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+        {
+            FTwitchChatLatency& Latency = FTwitchChatLatency::Get();
+            if (Args.Num() > 0 && Args[0] == TEXT("reset"))
+            {
+                Latency.Reset();
+                return;
+            }
+
+            UE_LOG(LogTwitchChat, Display, TEXT("%-10s %9s %9s %9s %9s %9s %9s %9s"),
+                TEXT("stage"), TEXT("count"), TEXT("mean ms"), TEXT("p50"), TEXT("p90"), TEXT("p99"), TEXT("p999"), TEXT("max"));
+            for (int32 i = 0; i < int32(ETwitchChatLatencyStage::Num); ++i)
+            {
+                const ETwitchChatLatencyStage Stage = ETwitchChatLatencyStage(i);
+                const FTwitchChatLatencySummary S = Latency.Summarize(Stage);
+                UE_LOG(LogTwitchChat, Display, TEXT("%-10s %9lld %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f"),
+                    FTwitchChatLatency::GetStageName(Stage), S.Count, S.MeanMs, S.P50Ms, S.P90Ms, S.P99Ms, S.P999Ms, S.MaxMs);
+            }
+        })
+);
@@ -1,6 +1,11 @@
 ﻿#include "TwitchChatLibrary.h"
 #include "TwitchChatConnection.h"
 #include "TwitchChatSettings.h"
+#include "TwitchChatStats.h"
+#include "TwitchChatMemory.h"
+#include "TwitchChatMetrics.h"
+#include "TwitchChatOutbox.h"
+#include "TwitchChatImages.h"
 #include "Misc/Paths.h"
 #include "Misc/FileHelper.h"
 #include "IImageWrapperModule.h"
@@ -83,6 +88,9 @@ bool UTwitchChatLibrary::TwitchChat_GetEmoteTexture(const FString& EmoteID, UTex
         return false;
     }
 
+    SCOPE_CYCLE_COUNTER(STAT_TwitchChat_EmoteDecode);
+    FTwitchChatMetricsScope MetricsScope(ETwitchChatTimer::EmoteDecode);
+
     TArray<uint8> FileData;
     if (!FFileHelper::LoadFileToArray(FileData, *Path))
     {
@@ -109,12 +117,14 @@ bool UTwitchChatLibrary::TwitchChat_GetEmoteTexture(const FString& EmoteID, UTex
     const int32 H = Wrapper->GetHeight();
 
     // Create the transient texture
+    LLM_SCOPE_BYTAG(TwitchChat_EmoteTextures);
     UTexture2D* Tex = UTexture2D::CreateTransient(W, H, PF_B8G8R8A8);
     if (!Tex)
     {
         UE_LOG(LogTwitchChatLibrary, Error, TEXT("  CreateTransient failed for %s"), *Path);
         return false;
     }
+    FTwitchChatMemory::TrackEmoteTexture(Tex);
     Tex->AddToRoot();
     Tex->SRGB = true;
     Tex->UpdateResource();  // initialize RHI-side resource
@@ -147,12 +157,67 @@ bool UTwitchChatLibrary::TwitchChat_GetEmoteTexture(const FString& EmoteID, UTex
 
 
 
+void UTwitchChatLibrary::TwitchChat_ReportMessagePainted(const FBP_TwitchChatMessage& ChatMessage)
+{
+    FTwitchChatLatency::Get().RecordPainted(ChatMessage.ReceivedTime, ChatMessage.DispatchTime, ChatMessage.IngestSeconds);
+}
+
+FTwitchChatLatencySummary UTwitchChatLibrary::TwitchChat_GetLatency(ETwitchChatLatencyStage Stage)
+{
+    return Stage < ETwitchChatLatencyStage::Num ? FTwitchChatLatency::Get().Summarize(Stage) : FTwitchChatLatencySummary();
+}
+
+void UTwitchChatLibrary::TwitchChat_ResetLatency()
+{
+    FTwitchChatLatency::Get().Reset();
+}
+
+bool UTwitchChatLibrary::TwitchChat_SendChatMessage(const FString& Channel, const FString& Message, const FString& ReplyToMessageId, const FOnTwitchChatMessageSent& OnSent)
+{
+    return FTwitchChatOutbox::Get()->Send(Channel, Message, ReplyToMessageId,
+        [OnSent](bool bSent, const FString& Reason)
+        {
+            OnSent.ExecuteIfBound(bSent, Reason);
+        });
+}
+
+void UTwitchChatLibrary::TwitchChat_SetModeratorOrVip(const FString& Channel, bool bModeratorOrVip)
+{
+    FTwitchChatOutbox::Get()->SetElevated(Channel, bModeratorOrVip);
+}
+
+int32 UTwitchChatLibrary::TwitchChat_GetOutgoingQueueDepth()
+{
+    return FTwitchChatOutbox::Get()->GetQueueDepth();
+}
+
+FTwitchChatLatencySummary UTwitchChatLibrary::TwitchChat_GetOutgoingLatency()
+{
+    return FTwitchChatMetrics::Get().GetTimer(ETwitchChatTimer::ChatSend).Summarize();
+}
+
+bool UTwitchChatLibrary::TwitchChat_GetBadgeBrush(const FString& ChannelId, const FString& Badge, FSlateBrush& OutBrush)
+{
+    const FSlateBrush* Brush = FTwitchChatImages::Get()->FindBadge(ChannelId, Badge);
+    if (Brush)
+        OutBrush = *Brush;
+    return Brush != nullptr;
+}
+
+bool UTwitchChatLibrary::TwitchChat_GetAvatarBrush(const FString& UserId, FSlateBrush& OutBrush)
+{
+    const FSlateBrush* Brush = FTwitchChatImages::Get()->FindAvatar(UserId);
+    if (Brush)
+        OutBrush = *Brush;
+    return Brush != nullptr;
+}
+
 void UTwitchChatLibrary::TwitchChat_Connect()
 {
     UE_LOG(LogTwitchChatLibrary, Log, TEXT("TwitchChat_Connect called"));
     if (UTwitchChatSettings* S = GetMutableDefault<UTwitchChatSettings>())
     {
-        FTwitchChatConnection::Get()->Connect(S->UserName, S->AccessToken, S->LastChannel, S->Port);
+        FTwitchChatConnection::Get()->Connect(S->UserName, S->GetAccessToken(), S->LastChannel, S->Port);
     }
 }
 
@@ -165,7 +230,7 @@ void UTwitchChatLibrary::TwitchChat_Disconnect()
 void UTwitchChatLibrary::TwitchChat_ChangeChannel(const FString& NewChannel)
 {
     UE_LOG(LogTwitchChatLibrary, Log, TEXT("TwitchChat_ChangeChannel called: %s"), *NewChannel);
-    FTwitchChatConnection::Get()->Disconnect();
+    FTwitchChatConnection::Get()->SetChannels(FTwitchChatConnection::ParseChannelList(NewChannel));
 
     if (UTwitchChatSettings* S = GetMutableDefault<UTwitchChatSettings>())
     {
@@ -173,3 +238,35 @@ void UTwitchChatLibrary::TwitchChat_ChangeChannel(const FString& NewChannel)
         S->SaveConfig();
     }
 }
+
+static void SaveChannelList()
+{
+    if (UTwitchChatSettings* S = GetMutableDefault<UTwitchChatSettings>())
+    {
+        S->LastChannel = FString::Join(FTwitchChatConnection::Get()->GetChannels(), TEXT(", "));
+        S->SaveConfig();
+    }
+}
+
+bool UTwitchChatLibrary::TwitchChat_JoinChannel(const FString& Channel)
+{
+    UE_LOG(LogTwitchChatLibrary, Log, TEXT("TwitchChat_JoinChannel called: %s"), *Channel);
+    if (!FTwitchChatConnection::Get()->AddChannel(Channel))
+        return false;
+    SaveChannelList();
+    return true;
+}
+
+bool UTwitchChatLibrary::TwitchChat_LeaveChannel(const FString& Channel)
+{
+    UE_LOG(LogTwitchChatLibrary, Log, TEXT("TwitchChat_LeaveChannel called: %s"), *Channel);
+    if (!FTwitchChatConnection::Get()->RemoveChannel(Channel))
+        return false;
+    SaveChannelList();
+    return true;
+}
+
+TArray<FString> UTwitchChatLibrary::TwitchChat_GetChannels()
+{
+    return FTwitchChatConnection::Get()->GetChannels();
+}
@@ -0,0 +1,139 @@
+#include "TwitchChatMemory.h"
+#include "TwitchChatConnection.h"
+#include "TwitchChatHistoryLog.h"
+#include "TwitchChatSearchIndex.h"
+#include "TwitchChatRecentHistory.h"
+#include "TwitchChatImages.h"
+
+#include "AnimatedTexture2D.h"
+#include "Engine/Texture2D.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/UObjectIterator.h"
+
+FTwitchChatMemory::FOnCollect FTwitchChatMemory::OnCollect;
+
+static TArray<TWeakObjectPtr<UTexture2D>>& GetTrackedEmoteTextures()
+{
+    static TArray<TWeakObjectPtr<UTexture2D>> Textures;
+    return Textures;
+}
+
+void FTwitchChatMemory::TrackEmoteTexture(UTexture2D* Texture)
+{
+    check(IsInGameThread());
+    TArray<TWeakObjectPtr<UTexture2D>>& Textures = GetTrackedEmoteTextures();
+    Textures.RemoveAllSwap([](const TWeakObjectPtr<UTexture2D>& T) { return !T.IsValid(); });
+    Textures.AddUnique(Texture);
+}
+
+SIZE_T FTwitchChatMemory::GetMessageSize(const FTwitchChatMessage& Msg)
+{
+    SIZE_T Bytes = sizeof(FTwitchChatMessage)
+        + Msg.MessageId.GetAllocatedSize() + Msg.UserId.GetAllocatedSize()
+        + Msg.ChannelId.GetAllocatedSize() + Msg.ChannelLogin.GetAllocatedSize()
+        + Msg.UserName.GetAllocatedSize() + Msg.Message.GetAllocatedSize()
+        + Msg.RawPayload.GetAllocatedSize()
+        + Msg.EmoteIds.GetAllocatedSize() + Msg.EmoteRanges.GetAllocatedSize()
+        + Msg.Tags.GetAllocatedSize();
+    for (const FString& Id : Msg.EmoteIds)
+    {
+        Bytes += Id.GetAllocatedSize();
+    }
+    for (const TPair<FString, FString>& Tag : Msg.Tags)
+    {
+        Bytes += Tag.Key.GetAllocatedSize() + Tag.Value.GetAllocatedSize();
+    }
+    return Bytes;
+}
+
+TArray<FTwitchChatMemory::FLine> FTwitchChatMemory::Collect(bool bIncludeAnimatedTextures)
+{
+    check(IsInGameThread());
+    TArray<FLine> Lines;
+
+    TSharedRef<FTwitchChatSearchIndex> Index = FTwitchChatSearchIndex::Get();
+    Lines.Add({ TEXT("Messages"), TEXT("search index"), Index->Num(), Index->GetAllocatedSize() });
+
+    const FTwitchChatRecentHistory& Recent = FTwitchChatRecentHistory::Get();
+    Lines.Add({ TEXT("Messages"), TEXT("recent history"), Recent.Num(), Recent.GetAllocatedSize() });
+
+    FTwitchChatChatters& Chatters = FTwitchChatChatters::Get();
+    Lines.Add({ TEXT("Messages"), TEXT("chatter cache"), Chatters.Num(), Chatters.GetAllocatedSize() });
+
+    // Queued records are copies of the dispatched message; count the struct only
+    const TSharedPtr<FTwitchChatHistoryLog> History = FTwitchChatHistoryLog::GetIfCreated();
+    const int32 Queued = History ? History->GetQueueDepth() : 0;
+    Lines.Add({ TEXT("Messages"), TEXT("history queue"), Queued, SIZE_T(Queued) * sizeof(FTwitchChatMessage) });
+
+    TSharedRef<FTwitchChatImages> Images = FTwitchChatImages::Get();
+    Lines.Add({ TEXT("ChatterImages"), TEXT("badge/avatar atlas"), Images->Num(), Images->GetAllocatedSize() });
+
+    {
+        FLine Line{ TEXT("EmoteTextures"), TEXT("transient PNG textures") };
+        for (const TWeakObjectPtr<UTexture2D>& Weak : GetTrackedEmoteTextures())
+        {
+            if (UTexture2D* Tex = Weak.Get())
+            {
+                ++Line.Count;
+                Line.Bytes += Tex->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+            }
+        }
+        Lines.Add(MoveTemp(Line));
+    }
+
+    OnCollect.Broadcast(Lines);
+
+    if (bIncludeAnimatedTextures)
+    {
+        for (TObjectIterator<UAnimatedTexture2D> It; It; ++It)
+        {
+            const UAnimatedTexture2D::FMemoryUsage Usage = It->GetMemoryUsage();
+            const TCHAR* Type = It->GetFileType() == EAnimatedTextureType::Gif ? TEXT("gif")
+                : It->GetFileType() == EAnimatedTextureType::Webp ? TEXT("webp") : TEXT("-");
+            Lines.Add({ TEXT("AnimatedTexture"),
+                FString::Printf(TEXT("%s [%s %dx%d] blob %.1f KB, decoder %.1f KB (frame %.1f KB), gpu %.1f KB"),
+                    *It->GetName(), Type, int32(It->GetSurfaceWidth()), int32(It->GetSurfaceHeight()),
+                    Usage.FileBlob / 1024.0, Usage.Decoder / 1024.0, Usage.FrameBuffer / 1024.0, Usage.Texture / 1024.0),
+                1, Usage.FileBlob + Usage.Decoder + Usage.Texture });
+        }
+    }
+    return Lines;
+}
+
+void FTwitchChatMemory::LogReport(bool bIncludeAnimatedTextures)
+{
+    const TArray<FLine> Lines = Collect(bIncludeAnimatedTextures);
+
+    TMap<FString, TPair<int32, SIZE_T>> Totals;
+    SIZE_T Grand = 0;
+    for (const FLine& Line : Lines)
+    {
+        TPair<int32, SIZE_T>& Total = Totals.FindOrAdd(Line.Subsystem);
+        Total.Key += Line.Count;
+        Total.Value += Line.Bytes;
+        Grand += Line.Bytes;
+    }
+
+    UE_LOG(LogTwitchChat, Display, TEXT("==== TwitchChat memory ===="));
+    UE_LOG(LogTwitchChat, Display, TEXT("%-16s %8s %12s"), TEXT("subsystem"), TEXT("count"), TEXT("KB"));
+    for (const TPair<FString, TPair<int32, SIZE_T>>& Pair : Totals)
+    {
+        UE_LOG(LogTwitchChat, Display, TEXT("%-16s %8d %12.1f"), *Pair.Key, Pair.Value.Key, Pair.Value.Value / 1024.0);
+    }
+    UE_LOG(LogTwitchChat, Display, TEXT("%-16s %8s %12.1f"), TEXT("total"), TEXT(""), Grand / 1024.0);
+
+    UE_LOG(LogTwitchChat, Display, TEXT("---- detail ----"));
+    for (const FLine& Line : Lines)
+    {
+        UE_LOG(LogTwitchChat, Display, TEXT("%-16s %8d %12.1f  %s"), *Line.Subsystem, Line.Count, Line.Bytes / 1024.0, *Line.Name);
+    }
+}
+
+static FAutoConsoleCommand GTwitchChatMemReportCmd(
+    TEXT("twitchchat.memreport"),
+    TEXT("Log resident memory per TwitchChat subsystem and per animated texture. Usage: twitchchat.memreport [-noanim]"),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+        {
+            FTwitchChatMemory::LogReport(!Args.Contains(TEXT("-noanim")));
+        })
+);
@@ -0,0 +1,317 @@
+#include "TwitchChatMetrics.h"
+#include "TwitchChatConnection.h"
+#include "TwitchChatConduit.h"
+#include "TwitchChatHistoryLog.h"
+#include "TwitchChatSearchIndex.h"
+#include "TwitchChatSettings.h"
+
+#include "HttpServerModule.h"
+#include "IHttpRouter.h"
+#include "HttpServerRequest.h"
+#include "HttpServerResponse.h"
+#include "HAL/IConsoleManager.h"
+
+namespace TwitchChatMetrics
+{
+    struct FCounterInfo
+    {
+        const TCHAR* Name;
+        const TCHAR* Help;
+    };
+
+    static const FCounterInfo Counters[] =
+    {
+        { TEXT("twitchchat_frames_received_total"),        TEXT("EventSub frames received on the socket or injected by replay.") },
+        { TEXT("twitchchat_parse_errors_total"),           TEXT("Frames that were not valid EventSub JSON.") },
+        { TEXT("twitchchat_messages_dispatched_total"),    TEXT("Chat messages broadcast on the game thread.") },
+        { TEXT("twitchchat_connect_attempts_total"),       TEXT("Calls to Connect.") },
+        { TEXT("twitchchat_reconnects_total"),             TEXT("Automatic reconnects after a lost session.") },
+        { TEXT("twitchchat_keepalive_timeouts_total"),     TEXT("Sessions declared dead by the keepalive watchdog.") },
+        { TEXT("twitchchat_session_migrations_total"),     TEXT("Completed session_reconnect handovers.") },
+        { TEXT("twitchchat_revocations_total"),            TEXT("EventSub revocation messages.") },
+        { TEXT("twitchchat_socket_errors_total"),          TEXT("WebSocket connection errors.") },
+        { TEXT("twitchchat_socket_closed_total"),          TEXT("WebSocket closes.") },
+        { TEXT("twitchchat_subscribe_failures_total"),     TEXT("Failed EventSub subscription requests.") },
+        { TEXT("twitchchat_token_refreshes_total"),        TEXT("OAuth refresh requests.") },
+        { TEXT("twitchchat_emote_disk_hits_total"),        TEXT("Emotes already in Saved/FetchedEmotes.") },
+        { TEXT("twitchchat_emote_disk_misses_total"),      TEXT("Emotes fetched from the CDN.") },
+        { TEXT("twitchchat_emote_download_failures_total"),TEXT("Emote CDN requests that failed.") },
+        { TEXT("twitchchat_emote_wait_timeouts_total"),    TEXT("Messages dispatched before all their emotes were on disk.") },
+        { TEXT("twitchchat_emote_brush_hits_total"),       TEXT("Editor window emote brush cache hits.") },
+        { TEXT("twitchchat_emote_brush_misses_total"),     TEXT("Editor window emote brush cache misses.") },
+        { TEXT("twitchchat_shed_history_total"),           TEXT("Messages not written to the history log because it was stopping.") },
+        { TEXT("twitchchat_hedge_first_eventsub_total"),   TEXT("Hedged messages dispatched from EventSub.") },
+        { TEXT("twitchchat_hedge_first_irc_total"),        TEXT("Hedged messages dispatched from IRC.") },
+        { TEXT("twitchchat_hedge_duplicates_total"),       TEXT("Second copies dropped by message id.") },
+        { TEXT("twitchchat_irc_reconnects_total"),         TEXT("IRC connections lost or refused.") },
+        { TEXT("twitchchat_helix_requests_total"),         TEXT("Helix requests sent, retries included.") },
+        { TEXT("twitchchat_helix_throttled_total"),        TEXT("Helix requests answered with 429.") },
+        { TEXT("twitchchat_helix_cache_hits_total"),       TEXT("Helix lookups answered from the cache.") },
+        { TEXT("twitchchat_helix_batched_keys_total"),     TEXT("Keys sent in batched Helix lookups.") },
+        { TEXT("twitchchat_stale_dropped_total"),          TEXT("Worker results dropped because Disconnect ended their session first.") },
+        { TEXT("twitchchat_events_total"),                 TEXT("EventSub events other than chat decoded (cheers, subs, raids, ...).") },
+        { TEXT("twitchchat_chat_sent_total"),              TEXT("Outgoing chat messages Twitch accepted.") },
+        { TEXT("twitchchat_chat_dropped_total"),           TEXT("Outgoing chat messages refused, dropped by Twitch or failed.") },
+    };
+    static_assert(UE_ARRAY_COUNT(Counters) == int32(ETwitchChatCounter::Num), "Counter table out of date");
+
+    static const FCounterInfo Gauges[] =
+    {
+        { TEXT("twitchchat_emote_downloads_in_flight"), TEXT("Emote CDN requests not yet completed.") },
+        { TEXT("twitchchat_helix_queued"),              TEXT("Helix requests waiting for rate-limit budget.") },
+        { TEXT("twitchchat_chat_queued"),               TEXT("Outgoing chat messages waiting for send budget or a reply.") },
+    };
+    static_assert(UE_ARRAY_COUNT(Gauges) == int32(ETwitchChatGauge::Num), "Gauge table out of date");
+
+    static const FCounterInfo Timers[] =
+    {
+        { TEXT("twitchchat_json_parse_seconds"),   TEXT("EventSub frame JSON parse time.") },
+        { TEXT("twitchchat_emote_decode_seconds"), TEXT("Emote PNG decode and texture creation time.") },
+        { TEXT("twitchchat_hedge_eventsub_lead_seconds"), TEXT("How far EventSub was ahead of IRC, for messages it received first.") },
+        { TEXT("twitchchat_hedge_irc_lead_seconds"),      TEXT("How far IRC was ahead of EventSub, for messages it received first.") },
+        { TEXT("twitchchat_chat_send_seconds"),           TEXT("Outgoing chat from Send to Twitch accepting it, queueing included.") },
+    };
+    static_assert(UE_ARRAY_COUNT(Timers) == int32(ETwitchChatTimer::Num), "Timer table out of date");
+
+    // Exported bucket bounds; the log-linear buckets are folded into these.
+    static const double BucketBounds[] = { 0.0001, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0 };
+
+    static void Header(FString& Out, const TCHAR* Name, const TCHAR* Help, const TCHAR* Type)
+    {
+        Out += FString::Printf(TEXT("# HELP %s %s\n# TYPE %s %s\n"), Name, Help, Name, Type);
+    }
+
+    static void Gauge(FString& Out, const TCHAR* Name, const TCHAR* Help, double Value)
+    {
+        Header(Out, Name, Help, TEXT("gauge"));
+        Out += FString::Printf(TEXT("%s %s\n"), Name, *FString::SanitizeFloat(Value));
+    }
+
+    static void Histogram(FString& Out, const TCHAR* Name, const FString& Labels, const FTwitchChatLatencyHistogram& H)
+    {
+        int64 Cumulative[UE_ARRAY_COUNT(BucketBounds)] = {};
+        int64 Total = 0;
+        H.ForEachBucket([&](uint64 UpperMicros, int64 Count)
+            {
+                const double Upper = UpperMicros / 1000000.0;
+                for (int32 i = 0; i < UE_ARRAY_COUNT(BucketBounds); ++i)
+                {
+                    if (Upper <= BucketBounds[i])
+                        Cumulative[i] += Count;
+                }
+                Total += Count;
+            });
+
+        const FString Sep = Labels.IsEmpty() ? FString() : Labels + TEXT(",");
+        for (int32 i = 0; i < UE_ARRAY_COUNT(BucketBounds); ++i)
+        {
+            Out += FString::Printf(TEXT("%s_bucket{%sle=\"%s\"} %lld\n"), Name, *Sep, *FString::SanitizeFloat(BucketBounds[i]), Cumulative[i]);
+        }
+        Out += FString::Printf(TEXT("%s_bucket{%sle=\"+Inf\"} %lld\n"), Name, *Sep, Total);
+
+        const FString Braced = Labels.IsEmpty() ? FString() : TEXT("{") + Labels + TEXT("}");
+        Out += FString::Printf(TEXT("%s_sum%s %s\n"), Name, *Braced, *FString::SanitizeFloat(H.GetSumMicros() / 1000000.0));
+        Out += FString::Printf(TEXT("%s_count%s %lld\n"), Name, *Braced, Total);
+    }
+
+    static double Ratio(int64 Hits, int64 Misses)
+    {
+        return Hits + Misses > 0 ? double(Hits) / double(Hits + Misses) : 0.0;
+    }
+}
+
+FTwitchChatMetrics& FTwitchChatMetrics::Get()
+{
+    static FTwitchChatMetrics Instance;
+    return Instance;
+}
+
+const TCHAR* FTwitchChatMetrics::GetCounterName(ETwitchChatCounter Counter)
+{
+    return Counter < ETwitchChatCounter::Num ? TwitchChatMetrics::Counters[int32(Counter)].Name : TEXT("unknown");
+}
+
+void FTwitchChatMetrics::StartSampling()
+{
+    if (SampleHandle.IsValid())
+        return;
+
+    LastDispatched = GetCounter(ETwitchChatCounter::MessagesDispatched);
+    LastSampleTime = FPlatformTime::Seconds();
+    SampleHandle = FTSTicker::GetCoreTicker().AddTicker(
+        FTickerDelegate::CreateRaw(this, &FTwitchChatMetrics::Sample), 1.0f);
+}
+
+void FTwitchChatMetrics::StopSampling()
+{
+    if (SampleHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(SampleHandle);
+        SampleHandle.Reset();
+    }
+}
+
+bool FTwitchChatMetrics::Sample(float /*DeltaTime*/)
+{
+    const double Now = FPlatformTime::Seconds();
+    const int64 Dispatched = GetCounter(ETwitchChatCounter::MessagesDispatched);
+    const double Elapsed = Now - LastSampleTime;
+    if (Elapsed > 0.0)
+    {
+        MessagesPerSecond.store(float((Dispatched - LastDispatched) / Elapsed), std::memory_order_relaxed);
+    }
+    LastDispatched = Dispatched;
+    LastSampleTime = Now;
+    return true;
+}
+
+bool FTwitchChatMetrics::StartEndpoint(int32 Port)
+{
+    StopEndpoint();
+
+    // Bind address follows [HTTPServer.Listeners] in Engine.ini
+    Router = FHttpServerModule::Get().GetHttpRouter(Port, /*bFailOnBindFailure=*/true);
+    if (!Router.IsValid())
+    {
+        UE_LOG(LogTwitchChat, Error, TEXT("Metrics: cannot listen for HTTP on port %d"), Port);
+        return false;
+    }
+
+    Routes.Add(Router->BindRoute(FHttpPath(TEXT("/metrics")), EHttpServerRequestVerbs::VERB_GET,
+        FHttpRequestHandler::CreateLambda([this](const FHttpServerRequest&, const FHttpResultCallback& OnComplete)
+            {
+                OnComplete(FHttpServerResponse::Create(RenderPrometheus(), TEXT("text/plain; version=0.0.4")));
+                return true;
+            })));
+    FHttpServerModule::Get().StartAllListeners();
+
+    UE_LOG(LogTwitchChat, Log, TEXT("Metrics: serving http://localhost:%d/metrics"), Port);
+    return true;
+}
+
+void FTwitchChatMetrics::StopEndpoint()
+{
+    if (Router.IsValid())
+    {
+        for (const FHttpRouteHandle& Route : Routes)
+        {
+            Router->UnbindRoute(Route);
+        }
+        Routes.Empty();
+        Router.Reset();
+    }
+}
+
+FString FTwitchChatMetrics::RenderPrometheus() const
+{
+    using namespace TwitchChatMetrics;
+    check(IsInGameThread());
+
+    FString Out;
+    Out.Reserve(16 * 1024);
+
+    // Connection
+    {
+        TSharedRef<FTwitchChatConnection> Connection = FTwitchChatConnection::Get();
+        Header(Out, TEXT("twitchchat_connection_state"), TEXT("1 for the current connection state."), TEXT("gauge"));
+        for (uint8 i = 0; i <= uint8(ETwitchChatConnectionState::Backoff); ++i)
+        {
+            const ETwitchChatConnectionState State = ETwitchChatConnectionState(i);
+            Out += FString::Printf(TEXT("twitchchat_connection_state{state=\"%s\"} %d\n"),
+                FTwitchChatConnection::GetStateName(State), Connection->GetState() == State ? 1 : 0);
+        }
+        Header(Out, TEXT("twitchchat_channel_subscribed"), TEXT("1 when chat for the channel is subscribed on the session."), TEXT("gauge"));
+        for (const FString& Channel : Connection->GetChannels())
+        {
+            Out += FString::Printf(TEXT("twitchchat_channel_subscribed{channel=\"%s\"} %d\n"),
+                *Channel, Connection->IsChannelSubscribed(Channel) ? 1 : 0);
+        }
+        Gauge(Out, TEXT("twitchchat_replaying"), TEXT("1 while recorded traffic is being replayed."), Connection->IsReplaying() ? 1.0 : 0.0);
+        Gauge(Out, TEXT("twitchchat_frames_in_flight"), TEXT("Frames received but not yet parsed."), Connection->GetNumFramesInFlight());
+
+        if (TSharedPtr<FTwitchChatConduit> Conduit = Connection->GetConduit())
+        {
+            const TArray<FTwitchChatConduit::FShardStatus> Shards = Conduit->GetShardStatus();
+            Header(Out, TEXT("twitchchat_conduit_shard_enabled"), TEXT("1 while the shard's session is bound to the conduit."), TEXT("gauge"));
+            for (const FTwitchChatConduit::FShardStatus& Shard : Shards)
+            {
+                Out += FString::Printf(TEXT("twitchchat_conduit_shard_enabled{shard=\"%d\"} %d\n"), Shard.Index, Shard.bEnabled ? 1 : 0);
+            }
+            Header(Out, TEXT("twitchchat_conduit_shard_queue"), TEXT("Frames waiting for the shard's parse worker."), TEXT("gauge"));
+            for (const FTwitchChatConduit::FShardStatus& Shard : Shards)
+            {
+                Out += FString::Printf(TEXT("twitchchat_conduit_shard_queue{shard=\"%d\"} %d\n"), Shard.Index, Shard.QueueDepth);
+            }
+            Header(Out, TEXT("twitchchat_conduit_shard_frames"), TEXT("Frames received on the shard."), TEXT("counter"));
+            for (const FTwitchChatConduit::FShardStatus& Shard : Shards)
+            {
+                Out += FString::Printf(TEXT("twitchchat_conduit_shard_frames{shard=\"%d\"} %lld\n"), Shard.Index, Shard.FramesReceived);
+            }
+        }
+    }
+
+    for (int32 i = 0; i < int32(ETwitchChatCounter::Num); ++i)
+    {
+        const FCounterInfo& Info = TwitchChatMetrics::Counters[i];
+        Header(Out, Info.Name, Info.Help, TEXT("counter"));
+        Out += FString::Printf(TEXT("%s %lld\n"), Info.Name, GetCounter(ETwitchChatCounter(i)));
+    }
+
+    for (int32 i = 0; i < int32(ETwitchChatGauge::Num); ++i)
+    {
+        const FCounterInfo& Info = TwitchChatMetrics::Gauges[i];
+        Gauge(Out, Info.Name, Info.Help, double(GetGauge(ETwitchChatGauge(i))));
+    }
+    Gauge(Out, TEXT("twitchchat_messages_per_second"), TEXT("Dispatched messages over the last second."), GetMessagesPerSecond());
+    const TSharedPtr<FTwitchChatHistoryLog> History = FTwitchChatHistoryLog::GetIfCreated();
+    Gauge(Out, TEXT("twitchchat_history_queue_depth"), TEXT("Messages waiting for the history writer."), History ? History->GetQueueDepth() : 0);
+    Gauge(Out, TEXT("twitchchat_search_index_messages"), TEXT("Messages held by the search index."), FTwitchChatSearchIndex::Get()->Num());
+    Gauge(Out, TEXT("twitchchat_emote_disk_hit_ratio"), TEXT("Emote disk cache hits / lookups."),
+        Ratio(GetCounter(ETwitchChatCounter::EmoteDiskHits), GetCounter(ETwitchChatCounter::EmoteDiskMisses)));
+    Gauge(Out, TEXT("twitchchat_emote_brush_hit_ratio"), TEXT("Editor window emote brush hits / lookups."),
+        Ratio(GetCounter(ETwitchChatCounter::EmoteBrushHits), GetCounter(ETwitchChatCounter::EmoteBrushMisses)));
+
+    for (int32 i = 0; i < int32(ETwitchChatTimer::Num); ++i)
+    {
+        const FCounterInfo& Info = TwitchChatMetrics::Timers[i];
+        Header(Out, Info.Name, Info.Help, TEXT("histogram"));
+        Histogram(Out, Info.Name, FString(), Timers[i]);
+    }
+
+    Header(Out, TEXT("twitchchat_latency_seconds"), TEXT("Chat latency per pipeline stage (see twitchchat.latency)."), TEXT("histogram"));
+    for (int32 i = 0; i < int32(ETwitchChatLatencyStage::Num); ++i)
+    {
+        const ETwitchChatLatencyStage Stage = ETwitchChatLatencyStage(i);
+        Histogram(Out, TEXT("twitchchat_latency_seconds"),
+            FString::Printf(TEXT("stage=\"%s\""), FTwitchChatLatency::GetStageName(Stage)),
+            FTwitchChatLatency::Get().GetHistogram(Stage));
+    }
+    return Out;
+}
+
+static FAutoConsoleCommand GTwitchChatMetricsCmd(
+    TEXT("twitchchat.metrics"),
+    TEXT("Pipeline metrics. Usage: twitchchat.metrics [start [Port] | stop] (no argument logs the Prometheus text)"),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+        {
+            FTwitchChatMetrics& Metrics = FTwitchChatMetrics::Get();
+            if (Args.Num() > 0 && Args[0] == TEXT("start"))
+            {
+                const int32 Port = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : GetDefault<UTwitchChatSettings>()->MetricsPort;
+                Metrics.StartEndpoint(Port);
+            }
+            else if (Args.Num() > 0 && Args[0] == TEXT("stop"))
+            {
+                Metrics.StopEndpoint();
+            }
+            else
+            {
+                TArray<FString> Lines;
+                Metrics.RenderPrometheus().ParseIntoArrayLines(Lines);
+                for (const FString& Line : Lines)
+                {
+                    UE_LOG(LogTwitchChat, Display, TEXT("%s"), *Line);
+                }
+            }
+        })
+);
@@ -0,0 +1,405 @@
+#include "TwitchChatOutbox.h"
+#include "TwitchChatAuth.h"
+#include "TwitchChatConnection.h"
+#include "TwitchChatHelix.h"
+#include "TwitchChatMetrics.h"
+#include "TwitchChatSettings.h"
+#include "Interfaces/IHttpResponse.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+#include "HAL/IConsoleManager.h"
+
+namespace TwitchChatOutbox
+{
+    static constexpr float TickSeconds = 0.1f;
+    static const TCHAR* MergeSeparator = TEXT(" | ");
+
+    static FString NormalizeChannel(const FString& Channel)
+    {
+        FString Out = Channel.TrimStartAndEnd().ToLower();
+        Out.RemoveFromStart(TEXT("#"));
+        return Out;
+    }
+}
+
+TSharedRef<FTwitchChatOutbox> FTwitchChatOutbox::Get()
+{
+    static TSharedRef<FTwitchChatOutbox> Instance = MakeShared<FTwitchChatOutbox>();
+    return Instance;
+}
+
+void FTwitchChatOutbox::FBucket::Configure(int32 InLimit)
+{
+    if (InLimit == Limit)
+        return;
+    Limit = InLimit;
+    Tokens = Limit * 0.5;
+    LastRefill = FPlatformTime::Seconds();
+}
+
+void FTwitchChatOutbox::FBucket::Refill(double Now)
+{
+    // Half the limit as burst, the other half refilled over the window
+    const double Burst = Limit * 0.5;
+    const double Rate = (Limit - Burst) / WindowSeconds;
+    Tokens = FMath::Min(Burst, Tokens + (Now - LastRefill) * Rate);
+    LastRefill = Now;
+}
+
+void FTwitchChatOutbox::EnsureTicker()
+{
+    if (!TickHandle.IsValid())
+    {
+        TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateSP(this, &FTwitchChatOutbox::Tick), TwitchChatOutbox::TickSeconds);
+    }
+}
+
+void FTwitchChatOutbox::Shutdown()
+{
+    if (TickHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+        TickHandle.Reset();
+    }
+}
+
+bool FTwitchChatOutbox::Send(const FString& InChannel, const FString& InText, const FString& ReplyParentMessageId, FOnSent OnSent)
+{
+    check(IsInGameThread());
+    const FString Channel = TwitchChatOutbox::NormalizeChannel(InChannel);
+    const FString Text = InText.TrimStartAndEnd();
+
+    if (!GetDefault<UTwitchChatSettings>()->bEnableSendChat)
+    {
+        UE_LOG(LogTwitchChat, Warning, TEXT("Not sending to %s: Enable Sending Chat is off in the Twitch Chat settings"), *Channel);
+        return false;
+    }
+    if (Channel.IsEmpty() || Text.IsEmpty() || Text.Len() > MaxMessageLength)
+    {
+        UE_LOG(LogTwitchChat, Warning, TEXT("Not sending to '%s': message is empty or longer than %d characters"), *Channel, MaxMessageLength);
+        return false;
+    }
+    if (Queue.Num() >= MaxQueued)
+    {
+        FTwitchChatMetrics::Inc(ETwitchChatCounter::ChatDropped);
+        UE_LOG(LogTwitchChat, Warning, TEXT("Not sending to %s: %d messages already waiting"), *Channel, Queue.Num());
+        return false;
+    }
+
+    FOutgoing& Msg = Queue.AddDefaulted_GetRef();
+    Msg.Channel = Channel;
+    Msg.Text = Text;
+    Msg.ReplyParentMessageId = ReplyParentMessageId;
+    Msg.QueuedTimes.Add(FPlatformTime::Seconds());
+    if (OnSent)
+    {
+        Msg.OnSent.Add(MoveTemp(OnSent));
+    }
+    FTwitchChatMetrics::Add(ETwitchChatGauge::ChatQueued, 1);
+    EnsureTicker();
+    return true;
+}
+
+void FTwitchChatOutbox::SetElevated(const FString& Channel, bool bElevated)
+{
+    if (bElevated)
+        Elevated.Add(TwitchChatOutbox::NormalizeChannel(Channel));
+    else
+        Elevated.Remove(TwitchChatOutbox::NormalizeChannel(Channel));
+}
+
+bool FTwitchChatOutbox::IsElevated(const FString& InChannel) const
+{
+    const FString Channel = TwitchChatOutbox::NormalizeChannel(InChannel);
+    return Elevated.Contains(Channel)
+        || GetDefault<UTwitchChatSettings>()->ElevatedChatChannels.ContainsByPredicate(
+            [&Channel](const FString& Entry) { return TwitchChatOutbox::NormalizeChannel(Entry) == Channel; });
+}
+
+FTwitchChatOutbox::FBucket& FTwitchChatOutbox::GetBucket(const FOutgoing& Msg)
+{
+    const bool bOwnChannel = Msg.BroadcasterId == FTwitchChatAuth::Get()->GetUserId();
+    return Buckets[bOwnChannel || IsElevated(Msg.Channel) ? 1 : 0];
+}
+
+FTwitchChatOutbox::FBudgetStatus FTwitchChatOutbox::GetBudgetStatus(bool bElevated) const
+{
+    const FBucket& Bucket = Buckets[bElevated ? 1 : 0];
+    FBudgetStatus Status;
+    Status.Limit = Bucket.Limit;
+    Status.Tokens = Bucket.Tokens;
+    return Status;
+}
+
+void FTwitchChatOutbox::Clear()
+{
+    TArray<FOutgoing> Dropped = MoveTemp(Queue);
+    Queue.Reset();
+    for (FOutgoing& Msg : Dropped)
+    {
+        Complete(Msg, false, TEXT("cleared"));
+    }
+}
+
+void FTwitchChatOutbox::Resolve(const FString& Channel)
+{
+    for (FOutgoing& Msg : Queue)
+    {
+        if (Msg.Channel == Channel)
+            Msg.bResolving = true;
+    }
+
+    // Cached after the first message, and merged with the connection's own lookups
+    FTwitchChatHelix::Get()->Lookup(ETwitchHelixLookup::UserByLogin, Channel,
+        [WeakThis = AsWeak(), Channel](const TArray<TSharedPtr<FJsonObject>>& Users)
+        {
+            TSharedPtr<FTwitchChatOutbox> Self = WeakThis.Pin();
+            if (!Self)
+                return;
+
+            FString Id;
+            if (Users.Num() > 0)
+                Users[0]->TryGetStringField(TEXT("id"), Id);
+
+            for (int32 i = 0; i < Self->Queue.Num(); )
+            {
+                FOutgoing& Msg = Self->Queue[i];
+                if (Msg.Channel != Channel || !Msg.BroadcasterId.IsEmpty())
+                {
+                    ++i;
+                    continue;
+                }
+                Msg.bResolving = false;
+                if (!Id.IsEmpty())
+                {
+                    Msg.BroadcasterId = Id;
+                    ++i;
+                    continue;
+                }
+                FOutgoing Failed = MoveTemp(Msg);
+                Self->Queue.RemoveAt(i);
+                Self->Complete(Failed, false, TEXT("unknown channel"));
+            }
+        });
+}
+
+void FTwitchChatOutbox::MergeFollowing(int32 Index)
+{
+    FOutgoing& Msg = Queue[Index];
+    if (!GetDefault<UTwitchChatSettings>()->bMergeOutgoingChat || !Msg.ReplyParentMessageId.IsEmpty())
+        return;
+
+    for (int32 i = Index + 1; i < Queue.Num(); )
+    {
+        FOutgoing& Next = Queue[i];
+        if (Next.Channel != Msg.Channel)
+        {
+            ++i;
+            continue;
+        }
+        // A reply or a line that does not fit keeps its place; nothing after it may jump ahead
+        if (!Next.ReplyParentMessageId.IsEmpty()
+            || Msg.Text.Len() + FCString::Strlen(TwitchChatOutbox::MergeSeparator) + Next.Text.Len() > MaxMessageLength)
+        {
+            return;
+        }
+        Msg.Text += TwitchChatOutbox::MergeSeparator;
+        Msg.Text += Next.Text;
+        Msg.QueuedTimes.Append(Next.QueuedTimes);
+        Msg.OnSent.Append(MoveTemp(Next.OnSent));
+        Queue.RemoveAt(i);
+    }
+}
+
+bool FTwitchChatOutbox::Tick(float /*DeltaTime*/)
+{
+    if (Queue.Num() == 0)
+        return true;
+
+    const TSharedRef<FTwitchChatAuth> Auth = FTwitchChatAuth::Get();
+    if (Auth->GetUserId().IsEmpty())
+    {
+        // The sender id comes with token validation
+        if (!bWaitingForAuth)
+        {
+            bWaitingForAuth = true;
+            Auth->WhenValid([WeakThis = AsWeak()](bool bValid)
+                {
+                    TSharedPtr<FTwitchChatOutbox> Self = WeakThis.Pin();
+                    if (!Self)
+                        return;
+                    Self->bWaitingForAuth = false;
+                    if (!bValid)
+                    {
+                        UE_LOG(LogTwitchChat, Warning, TEXT("Dropping %d outgoing chat messages: no valid token"), Self->Queue.Num());
+                        Self->Clear();
+                    }
+                });
+        }
+        return true;
+    }
+
+    const UTwitchChatSettings* Settings = GetDefault<UTwitchChatSettings>();
+    const double Now = FPlatformTime::Seconds();
+    Buckets[0].Configure(Settings->ChatSendLimit);
+    Buckets[1].Configure(Settings->ElevatedChatSendLimit);
+    Buckets[0].Refill(Now);
+    Buckets[1].Refill(Now);
+
+    TSet<FString> Waiting;      // channels with an earlier message still queued
+    TArray<FString> ToResolve;
+    for (int32 i = 0; i < Queue.Num(); )
+    {
+        FOutgoing& Msg = Queue[i];
+        if (Msg.BroadcasterId.IsEmpty())
+        {
+            if (!Msg.bResolving)
+                ToResolve.AddUnique(Msg.Channel);
+            Waiting.Add(Msg.Channel);
+            ++i;
+            continue;
+        }
+
+        FBucket& Bucket = GetBucket(Msg);
+        if (Waiting.Contains(Msg.Channel) || Bucket.Tokens < 1.0)
+        {
+            Waiting.Add(Msg.Channel);
+            ++i;
+            continue;
+        }
+
+        MergeFollowing(i);
+        Bucket.Tokens -= 1.0;
+        FOutgoing Out = MoveTemp(Queue[i]);
+        Queue.RemoveAt(i);
+        Deliver(MoveTemp(Out));
+    }
+
+    // After the loop: cached lookups call back (and may drop messages) right away
+    for (const FString& Channel : ToResolve)
+    {
+        Resolve(Channel);
+    }
+    return true;
+}
+
+void FTwitchChatOutbox::Deliver(FOutgoing&& Msg)
+{
+    TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+    Root->SetStringField(TEXT("broadcaster_id"), Msg.BroadcasterId);
+    Root->SetStringField(TEXT("sender_id"), FTwitchChatAuth::Get()->GetUserId());
+    Root->SetStringField(TEXT("message"), Msg.Text);
+    if (!Msg.ReplyParentMessageId.IsEmpty())
+    {
+        Root->SetStringField(TEXT("reply_parent_message_id"), Msg.ReplyParentMessageId);
+    }
+    FString Body;
+    TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Body);
+    FJsonSerializer::Serialize(Root, Writer);
+
+    auto Req = FTwitchChatHelix::MakeRequest(TEXT("POST"), TEXT("/chat/messages"));
+    Req->SetHeader(TEXT("Content-Type"), TEXT("application/json"));
+    Req->SetContentAsString(Body);
+
+    ++InFlight;
+    TSharedRef<FOutgoing> Sent = MakeShared<FOutgoing>(MoveTemp(Msg));
+    FTwitchChatHelix::Get()->Send(Req,
+        [WeakThis = AsWeak(), Sent](FHttpRequestPtr, FHttpResponsePtr Resp, bool bOK)
+        {
+            TSharedPtr<FTwitchChatOutbox> Self = WeakThis.Pin();
+            if (!Self)
+                return;
+            --Self->InFlight;
+
+            const int32 Code = Resp.IsValid() ? Resp->GetResponseCode() : -1;
+            TSharedPtr<FJsonObject> Json;
+            TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Resp.IsValid() ? Resp->GetContentAsString() : FString());
+            const bool bParsed = FJsonSerializer::Deserialize(Reader, Json) && Json.IsValid();
+
+            if (!bOK || Code != 200 || !bParsed)
+            {
+                FString Error;
+                if (bParsed)
+                    Json->TryGetStringField(TEXT("message"), Error);
+                Self->Complete(*Sent, false, FString::Printf(TEXT("HTTP %d %s"), Code, *Error));
+                return;
+            }
+
+            // 200 only means Twitch looked at it; AutoMod, duplicates and slow mode drop it here
+            bool bSent = false;
+            FString Reason;
+            const TArray<TSharedPtr<FJsonValue>>* Data = nullptr;
+            if (Json->TryGetArrayField(TEXT("data"), Data) && Data->Num() > 0)
+            {
+                const TSharedPtr<FJsonObject>& Result = (*Data)[0]->AsObject();
+                Result->TryGetBoolField(TEXT("is_sent"), bSent);
+                const TSharedPtr<FJsonObject>* Drop = nullptr;
+                if (!bSent && Result->TryGetObjectField(TEXT("drop_reason"), Drop))
+                    (*Drop)->TryGetStringField(TEXT("message"), Reason);
+            }
+            Self->Complete(*Sent, bSent, Reason);
+        },
+        ETwitchHelixBucket::User);
+}
+
+void FTwitchChatOutbox::Complete(FOutgoing& Msg, bool bSent, const FString& Reason)
+{
+    const int32 Count = Msg.QueuedTimes.Num();
+    FTwitchChatMetrics::Add(ETwitchChatGauge::ChatQueued, -Count);
+    FTwitchChatMetrics::Inc(bSent ? ETwitchChatCounter::ChatSent : ETwitchChatCounter::ChatDropped, Count);
+    if (bSent)
+    {
+        const double Now = FPlatformTime::Seconds();
+        for (double Queued : Msg.QueuedTimes)
+        {
+            FTwitchChatMetrics::Time(ETwitchChatTimer::ChatSend, Now - Queued);
+        }
+    }
+    else
+    {
+        UE_LOG(LogTwitchChat, Warning, TEXT("Message to %s not sent: %s"), *Msg.Channel, Reason.IsEmpty() ? TEXT("unknown reason") : *Reason);
+    }
+
+    for (FOnSent& OnSent : Msg.OnSent)
+    {
+        OnSent(bSent, Reason);
+    }
+}
+
+static FAutoConsoleCommand GTwitchChatSayCmd(
+    TEXT("twitchchat.say"),
+    TEXT("Send a chat message through the outgoing queue. Usage: twitchchat.say <channel> <text>"),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+        {
+            if (Args.Num() < 2)
+            {
+                UE_LOG(LogTwitchChat, Display, TEXT("Usage: twitchchat.say <channel> <text>"));
+                return;
+            }
+            TArray<FString> Words(Args);
+            const FString Channel = Words[0];
+            Words.RemoveAt(0);
+            FTwitchChatOutbox::Get()->Send(Channel, FString::Join(Words, TEXT(" ")));
+        })
+);
+
+static FAutoConsoleCommand GTwitchChatOutboxCmd(
+    TEXT("twitchchat.outbox"),
+    TEXT("Show the outgoing chat queue and send budgets. 'twitchchat.outbox clear' drops what is waiting."),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+        {
+            TSharedRef<FTwitchChatOutbox> Outbox = FTwitchChatOutbox::Get();
+            if (Args.Num() > 0 && Args[0] == TEXT("clear"))
+            {
+                Outbox->Clear();
+            }
+            const FTwitchChatOutbox::FBudgetStatus Regular = Outbox->GetBudgetStatus(false);
+            const FTwitchChatOutbox::FBudgetStatus Elevated = Outbox->GetBudgetStatus(true);
+            const FTwitchChatLatencySummary Latency = FTwitchChatMetrics::Get().GetTimer(ETwitchChatTimer::ChatSend).Summarize();
+            UE_LOG(LogTwitchChat, Display, TEXT("Outbox: %d waiting or in flight; regular %.1f/%d, elevated %.1f/%d tokens; send latency p50 %.0f ms, p99 %.0f ms (%lld sent)"),
+                Outbox->GetQueueDepth(), Regular.Tokens, Regular.Limit, Elevated.Tokens, Elevated.Limit,
+                Latency.P50Ms, Latency.P99Ms, Latency.Count);
+        })
+);
@@ -0,0 +1,186 @@
+#include "TwitchChatRecentHistory.h"
+#include "TwitchChatConnection.h"
+#include "TwitchChatMemory.h"
+#include "TwitchChatSettings.h"
+#include "Algo/Reverse.h"
+#include "HAL/IConsoleManager.h"
+
+FTwitchChatRecentHistory& FTwitchChatRecentHistory::Get()
+{
+    static FTwitchChatRecentHistory Instance;
+    return Instance;
+}
+
+FTwitchChatRecentHistory::~FTwitchChatRecentHistory()
+{
+    // Static teardown; no readers are left
+    delete Current.load();
+    for (FSnapshot* Snapshot : Retiring)
+        delete Snapshot;
+    for (FSnapshot* Snapshot : Draining)
+        delete Snapshot;
+}
+
+uint32 FTwitchChatRecentHistory::EnterRead() const
+{
+    for (;;)
+    {
+        const uint32 ReadEpoch = Epoch.load();
+        Readers[ReadEpoch & 1].fetch_add(1);
+        // The writer may have flipped and checked this counter before the add; then step back and use the new one
+        if (Epoch.load() == ReadEpoch)
+            return ReadEpoch;
+        Readers[ReadEpoch & 1].fetch_sub(1);
+    }
+}
+
+void FTwitchChatRecentHistory::ExitRead(uint32 ReadEpoch) const
+{
+    Readers[ReadEpoch & 1].fetch_sub(1);
+}
+
+void FTwitchChatRecentHistory::Publish(FSnapshot* Snapshot)
+{
+    if (FSnapshot* Old = Current.exchange(Snapshot))
+    {
+        Retiring.Add(Old);
+    }
+    Reclaim();
+}
+
+void FTwitchChatRecentHistory::Reclaim()
+{
+    // One grace period at a time: readers that entered before the flip hold Readers[DrainingParity]
+    if (Draining.Num() > 0)
+    {
+        if (Readers[DrainingParity].load() != 0)
+            return;
+        for (FSnapshot* Snapshot : Draining)
+            delete Snapshot;
+        Draining.Reset();
+    }
+    if (Retiring.Num() == 0)
+        return;
+
+    Swap(Draining, Retiring);
+    DrainingParity = Epoch.fetch_add(1) & 1;
+    if (Readers[DrainingParity].load() == 0)
+    {
+        for (FSnapshot* Snapshot : Draining)
+            delete Snapshot;
+        Draining.Reset();
+    }
+}
+
+void FTwitchChatRecentHistory::Append(const FTwitchChatMessage& Msg)
+{
+    check(IsInGameThread());
+    const int32 Capacity = GetDefault<UTwitchChatSettings>()->RecentHistorySize;
+    if (Capacity <= 0)
+    {
+        if (Num() > 0)
+            Clear();
+        return;
+    }
+
+    const FSnapshot* Old = Current.load();
+    FSnapshot* Snapshot = Old ? new FSnapshot(*Old) : new FSnapshot();
+
+    // Slots past the old snapshot's end are seen by no reader yet, so the shared last chunk can take the message
+    const int32 End = Snapshot->First + Snapshot->Count;
+    if (End == Snapshot->Chunks.Num() * ChunkSize)
+    {
+        Snapshot->Chunks.Add(MakeShared<FChunk, ESPMode::NotThreadSafe>());
+    }
+    Snapshot->Chunks.Last()->Messages[End % ChunkSize] = Msg;
+    ++Snapshot->Count;
+
+    while (Snapshot->Count > Capacity)
+    {
+        --Snapshot->Count;
+        if (++Snapshot->First == ChunkSize)
+        {
+            Snapshot->Chunks.RemoveAt(0);
+            Snapshot->First = 0;
+        }
+    }
+    Publish(Snapshot);
+}
+
+void FTwitchChatRecentHistory::Clear()
+{
+    check(IsInGameThread());
+    Publish(new FSnapshot());
+}
+
+TArray<FTwitchChatMessage> FTwitchChatRecentHistory::GetRecent(int32 MaxMessages, const FString& Channel, const FString& User) const
+{
+    TArray<FTwitchChatMessage> Out;
+    if (MaxMessages <= 0)
+        return Out;
+
+    const uint32 ReadEpoch = EnterRead();
+    if (const FSnapshot* Snapshot = Current.load())
+    {
+        Out.Reserve(FMath::Min(MaxMessages, Snapshot->Count));
+        for (int32 i = Snapshot->Count - 1; i >= 0 && Out.Num() < MaxMessages; --i)
+        {
+            const int32 Index = Snapshot->First + i;
+            const FTwitchChatMessage& Msg = Snapshot->Chunks[Index / ChunkSize]->Messages[Index % ChunkSize];
+            if (!Channel.IsEmpty() && !Msg.ChannelLogin.Equals(Channel, ESearchCase::IgnoreCase) && Msg.ChannelId != Channel)
+                continue;
+            if (!User.IsEmpty() && Msg.UserId != User && !Msg.UserName.Equals(User, ESearchCase::IgnoreCase))
+                continue;
+            Out.Add(Msg);
+        }
+    }
+    ExitRead(ReadEpoch);
+
+    Algo::Reverse(Out);
+    return Out;
+}
+
+int32 FTwitchChatRecentHistory::Num() const
+{
+    const uint32 ReadEpoch = EnterRead();
+    const FSnapshot* Snapshot = Current.load();
+    const int32 Count = Snapshot ? Snapshot->Count : 0;
+    ExitRead(ReadEpoch);
+    return Count;
+}
+
+SIZE_T FTwitchChatRecentHistory::GetAllocatedSize() const
+{
+    check(IsInGameThread());
+    SIZE_T Bytes = (Retiring.Num() + Draining.Num() + 1) * sizeof(FSnapshot);
+    if (const FSnapshot* Snapshot = Current.load())
+    {
+        Bytes += Snapshot->Chunks.GetAllocatedSize();
+        for (const TSharedPtr<FChunk, ESPMode::NotThreadSafe>& Chunk : Snapshot->Chunks)
+        {
+            Bytes += sizeof(FChunk);
+            for (const FTwitchChatMessage& Msg : Chunk->Messages)
+            {
+                Bytes += FTwitchChatMemory::GetMessageSize(Msg) - sizeof(FTwitchChatMessage);
+            }
+        }
+    }
+    return Bytes;
+}
+
+static FAutoConsoleCommand GTwitchChatRecentCmd(
+    TEXT("twitchchat.recent"),
+    TEXT("Print the newest messages from the in-memory history. Usage: twitchchat.recent [count=20] [channel] [user]"),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+        {
+            const int32 Count = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 20;
+            const TArray<FTwitchChatMessage> Recent = FTwitchChatRecentHistory::Get().GetRecent(Count,
+                Args.Num() > 1 ? Args[1] : FString(), Args.Num() > 2 ? Args[2] : FString());
+            for (const FTwitchChatMessage& Msg : Recent)
+            {
+                UE_LOG(LogTwitchChat, Display, TEXT("[%s] #%s %s: %s"),
+                    *Msg.Timestamp.ToString(TEXT("%H:%M:%S")), *Msg.ChannelLogin, *Msg.UserName, *Msg.Message);
+            }
+            UE_LOG(LogTwitchChat, Display, TEXT("%d of %d kept messages"), Recent.Num(), FTwitchChatRecentHistory::Get().Num());
+        })
+);
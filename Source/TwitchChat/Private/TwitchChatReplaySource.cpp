@@ -0,0 +1,120 @@
+#include "TwitchChatReplaySource.h"
+#include "TwitchChatConnection.h"
+#include "TwitchChatTrafficRecorder.h"
+
+#include "Async/Async.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryReader.h"
+
+bool FTwitchChatReplaySource::LoadFile(const FString& Path, TArray<FFrame>& OutFrames, FDateTime* OutStartUtc)
+{
+    TArray<uint8> Data;
+    if (!FFileHelper::LoadFileToArray(Data, *Path))
+    {
+        UE_LOG(LogTwitchChat, Error, TEXT("Replay: cannot read %s"), *Path);
+        return false;
+    }
+
+    FMemoryReader Ar(Data);
+    uint32 Magic = 0;
+    int32 Version = 0;
+    int64 StartTicks = 0;
+    Ar << Magic << Version << StartTicks;
+    if (Magic != FTwitchChatTrafficRecorder::FileMagic || Version != FTwitchChatTrafficRecorder::FileVersion)
+    {
+        UE_LOG(LogTwitchChat, Error, TEXT("Replay: %s is not a TwitchChat recording"), *Path);
+        return false;
+    }
+    if (OutStartUtc)
+    {
+        *OutStartUtc = FDateTime(StartTicks);
+    }
+
+    double Seconds = 0.0;
+    TArray<ANSICHAR> Utf8;
+    while (!Ar.AtEnd() && !Ar.IsError())
+    {
+        uint32 DeltaMicros = 0;
+        uint32 Length = 0;
+        Ar.SerializeIntPacked(DeltaMicros);
+        Ar.SerializeIntPacked(Length);
+        if (Ar.IsError() || Ar.Tell() + Length > Ar.TotalSize())
+            break; // torn tail frame
+
+        Utf8.SetNumUninitialized(Length);
+        Ar.Serialize(Utf8.GetData(), Length);
+
+        Seconds += DeltaMicros / 1000000.0;
+        FFrame& Frame = OutFrames.AddDefaulted_GetRef();
+        Frame.Seconds = Seconds;
+        Frame.Payload = FString(FUTF8ToTCHAR(Utf8.GetData(), Length));
+    }
+
+    return OutFrames.Num() > 0;
+}
+
+FTwitchChatReplaySource::FTwitchChatReplaySource(TSharedRef<FTwitchChatConnection> InConnection, TArray<FFrame>&& InFrames)
+    : Connection(InConnection)
+    , Frames(MoveTemp(InFrames))
+{
+}
+
+void FTwitchChatReplaySource::Start(float InSpeed)
+{
+    if (bRunning.exchange(true))
+        return;
+
+    bStopRequested = false;
+    Connection->BeginReplay();
+
+    TSharedRef<FTwitchChatReplaySource> Self = AsShared();
+    Async(EAsyncExecution::Thread, [Self, Speed = InSpeed]()
+        {
+            FStats Stats;
+            const double Start = FPlatformTime::Seconds();
+
+            for (const FFrame& Frame : Self->Frames)
+            {
+                if (Self->bStopRequested)
+                    break;
+
+                if (Speed > 0.f)
+                {
+                    const double Due = Start + Frame.Seconds / Speed;
+                    const double Wait = Due - FPlatformTime::Seconds();
+                    if (Wait > 0.0)
+                    {
+                        FPlatformProcess::Sleep(float(Wait));
+                    }
+                }
+                else
+                {
+                    while (Self->Connection->GetNumFramesInFlight() > Self->MaxInFlight && !Self->bStopRequested)
+                    {
+                        FPlatformProcess::Sleep(0.0005f);
+                    }
+                }
+
+                Self->Connection->IngestFrame(Frame.Payload);
+                ++Stats.Frames;
+                Stats.RecordedSeconds = Frame.Seconds;
+            }
+
+            Stats.WallSeconds = FPlatformTime::Seconds() - Start;
+
+            AsyncTask(ENamedThreads::GameThread, [Self, Stats]()
+                {
+                    Self->Connection->EndReplay();
+                    Self->bRunning = false;
+                    UE_LOG(LogTwitchChat, Log, TEXT("Replay: %d frames, %.2fs recorded in %.2fs wall (%.0f frames/s)"),
+                        Stats.Frames, Stats.RecordedSeconds, Stats.WallSeconds,
+                        Stats.Frames / FMath::Max(Stats.WallSeconds, 1e-6));
+                    Self->OnFinished.ExecuteIfBound(Stats);
+                });
+        });
+}
+
+void FTwitchChatReplaySource::Stop()
+{
+    bStopRequested = true;
+}
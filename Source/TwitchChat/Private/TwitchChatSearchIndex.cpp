@@ -0,0 +1,227 @@
+#include "TwitchChatSearchIndex.h"
+#include "TwitchChatSettings.h"
+#include "TwitchChatMemory.h"
+#include "TwitchChatStats.h"
+
+#include "Algo/BinarySearch.h"
+#include "Algo/Unique.h"
+#include "Misc/ScopeRWLock.h"
+
+namespace TwitchChatSearch
+{
+    static const TCHAR* FromPrefix = TEXT("from:");
+    static const TCHAR* EmotePrefix = TEXT("emote:");
+    static const TCHAR* ChannelPrefix = TEXT("in:");
+
+    static void ParseQuery(const FString& Query, TArray<FString>& OutTerms)
+    {
+        TArray<FString> Parts;
+        Query.ParseIntoArrayWS(Parts);
+
+        for (const FString& Part : Parts)
+        {
+            if (Part.StartsWith(FromPrefix, ESearchCase::IgnoreCase))
+            {
+                OutTerms.Add(FString(FromPrefix) + Part.Mid(5).TrimChar(TEXT('@')).ToLower());
+            }
+            else if (Part.StartsWith(TEXT("@")))
+            {
+                OutTerms.Add(FString(FromPrefix) + Part.Mid(1).ToLower());
+            }
+            else if (Part.StartsWith(EmotePrefix, ESearchCase::IgnoreCase))
+            {
+                OutTerms.Add(FString(EmotePrefix) + Part.Mid(6));
+            }
+            else if (Part.StartsWith(ChannelPrefix, ESearchCase::IgnoreCase))
+            {
+                OutTerms.Add(FString(ChannelPrefix) + Part.Mid(3).TrimChar(TEXT('#')).ToLower());
+            }
+            else
+            {
+                FTwitchChatSearchIndex::Tokenize(Part, OutTerms);
+            }
+        }
+    }
+}
+
+TSharedRef<FTwitchChatSearchIndex> FTwitchChatSearchIndex::Get()
+{
+    static TSharedRef<FTwitchChatSearchIndex> Instance =
+        MakeShared<FTwitchChatSearchIndex>(GetDefault<UTwitchChatSettings>()->SearchIndexMaxMessages);
+    return Instance;
+}
+
+FTwitchChatSearchIndex::FTwitchChatSearchIndex(int32 InMaxMessages)
+    : MaxMessages(FMath::Max(1000, InMaxMessages))
+{
+}
+
+void FTwitchChatSearchIndex::Tokenize(const FString& Text, TArray<FString>& OutTokens)
+{
+    FString Current;
+    auto Emit = [&]()
+        {
+            if (!Current.IsEmpty())
+            {
+                OutTokens.Add(MoveTemp(Current));
+                Current.Reset();
+            }
+        };
+
+    for (TCHAR C : Text)
+    {
+        if (FChar::IsAlnum(C) || C == TEXT('_'))
+        {
+            Current.AppendChar(FChar::ToLower(C));
+        }
+        else
+        {
+            Emit();
+        }
+    }
+    Emit();
+}
+
+void FTwitchChatSearchIndex::Add(const FTwitchChatMessage& Msg)
+{
+    LLM_SCOPE_BYTAG(TwitchChat_Messages);
+
+    // Tokenize outside the lock; only posting appends happen under it
+    TArray<FString> Tokens;
+    Tokenize(Msg.Message, Tokens);
+    for (const FString& EmoteId : Msg.EmoteIds)
+    {
+        Tokens.Add(TwitchChatSearch::EmotePrefix + EmoteId);
+    }
+    if (!Msg.UserName.IsEmpty())
+    {
+        Tokens.Add(TwitchChatSearch::FromPrefix + Msg.UserName.ToLower());
+    }
+    if (!Msg.ChannelLogin.IsEmpty())
+    {
+        Tokens.Add(TwitchChatSearch::ChannelPrefix + Msg.ChannelLogin.ToLower());
+    }
+    Tokens.Sort();
+    Tokens.SetNum(Algo::Unique(Tokens));
+
+    TSharedPtr<FTwitchChatMessage> Doc = MakeShared<FTwitchChatMessage>(Msg);
+    Doc->RawPayload.Empty();
+
+    FWriteScopeLock WriteLock(Lock);
+    const uint32 DocId = NextDocId++;
+    Docs.Add(MoveTemp(Doc));
+    for (FString& Token : Tokens)
+    {
+        Postings.FindOrAdd(MoveTemp(Token)).Add(DocId);
+    }
+
+    if (Docs.Num() > MaxMessages + FMath::Max(1024, MaxMessages / 8))
+    {
+        Compact();
+    }
+}
+
+void FTwitchChatSearchIndex::Compact()
+{
+    const int32 Drop = Docs.Num() - MaxMessages;
+    Docs.RemoveAt(0, Drop, EAllowShrinking::No);
+    FirstDocId += Drop;
+
+    for (auto It = Postings.CreateIterator(); It; ++It)
+    {
+        FPostings& List = It.Value();
+        const int32 Stale = Algo::LowerBound(List, FirstDocId);
+        if (Stale == List.Num())
+        {
+            It.RemoveCurrent();
+        }
+        else if (Stale > 0)
+        {
+            List.RemoveAt(0, Stale, EAllowShrinking::No);
+        }
+    }
+}
+
+void FTwitchChatSearchIndex::Reset()
+{
+    FWriteScopeLock WriteLock(Lock);
+    Postings.Empty();
+    Docs.Empty();
+    FirstDocId = NextDocId;
+}
+
+int32 FTwitchChatSearchIndex::Num() const
+{
+    FReadScopeLock ReadLock(Lock);
+    return Docs.Num();
+}
+
+SIZE_T FTwitchChatSearchIndex::GetAllocatedSize() const
+{
+    FReadScopeLock ReadLock(Lock);
+    SIZE_T Bytes = Docs.GetAllocatedSize() + Postings.GetAllocatedSize();
+    for (const TSharedPtr<FTwitchChatMessage>& Doc : Docs)
+    {
+        Bytes += FTwitchChatMemory::GetMessageSize(*Doc);
+    }
+    for (const TPair<FString, FPostings>& Pair : Postings)
+    {
+        Bytes += Pair.Key.GetAllocatedSize() + Pair.Value.GetAllocatedSize();
+    }
+    return Bytes;
+}
+
+FTwitchChatSearchIndex::FResult FTwitchChatSearchIndex::Search(const FString& Query, int32 MaxResults) const
+{
+    FResult Result;
+    const double Start = FPlatformTime::Seconds();
+
+    TArray<FString> Terms;
+    TwitchChatSearch::ParseQuery(Query, Terms);
+    if (Terms.Num() == 0)
+    {
+        return Result;
+    }
+
+    FReadScopeLock ReadLock(Lock);
+
+    TArray<const FPostings*> Lists;
+    for (const FString& Term : Terms)
+    {
+        const FPostings* List = Postings.Find(Term);
+        if (!List)
+        {
+            Result.Seconds = FPlatformTime::Seconds() - Start;
+            return Result;
+        }
+        Lists.Add(List);
+    }
+
+    // Walk the rarest term newest-to-oldest and probe the others
+    Lists.Sort([](const FPostings& A, const FPostings& B) { return A.Num() < B.Num(); });
+    const FPostings& Rarest = *Lists[0];
+
+    for (int32 i = Rarest.Num() - 1; i >= 0; --i)
+    {
+        const uint32 DocId = Rarest[i];
+        if (DocId < FirstDocId)
+            break;
+
+        bool bAll = true;
+        for (int32 L = 1; L < Lists.Num() && bAll; ++L)
+        {
+            bAll = Algo::BinarySearch(*Lists[L], DocId) != INDEX_NONE;
+        }
+        if (!bAll)
+            continue;
+
+        ++Result.TotalMatches;
+        if (Result.Messages.Num() < MaxResults)
+        {
+            Result.Messages.Add(Docs[DocId - FirstDocId]);
+        }
+    }
+
+    Result.Seconds = FPlatformTime::Seconds() - Start;
+    return Result;
+}
@@ -20,3 +20,28 @@ UTwitchChatSettings::UTwitchChatSettings()
 
     MaxMessages = 20;
 }
+
+void UTwitchChatSettings::SetEndpointOverride(const FEndpointOverride& InOverride)
+{
+    EndpointOverride = InOverride;
+    bEndpointOverride = true;
+}
+
+void UTwitchChatSettings::ClearEndpointOverride()
+{
+    // The strings stay allocated: a worker may still be reading one it fetched a moment ago
+    bEndpointOverride = false;
+}
+
+void UTwitchChatSettings::StoreTokens(const FString& InAccessToken, const FString& InRefreshToken)
+{
+    if (bEndpointOverride)
+    {
+        EndpointOverride.AccessToken = InAccessToken;
+        EndpointOverride.RefreshToken = InRefreshToken;
+        return;
+    }
+    AccessToken = InAccessToken;
+    RefreshToken = InRefreshToken;
+    SaveConfig();
+}
@@ -0,0 +1,45 @@
+#include "TwitchChatStats.h"
+#include <atomic>
+
+DEFINE_STAT(STAT_TwitchChat_JsonParse);
+DEFINE_STAT(STAT_TwitchChat_EmoteFetch);
+DEFINE_STAT(STAT_TwitchChat_EmoteDecode);
+DEFINE_STAT(STAT_TwitchChat_Dispatch);
+DEFINE_STAT(STAT_TwitchChat_RowGeneration);
+
+DEFINE_STAT(STAT_TwitchChat_Messages);
+DEFINE_STAT(STAT_TwitchChat_EmoteDiskHits);
+DEFINE_STAT(STAT_TwitchChat_EmoteDiskMisses);
+DEFINE_STAT(STAT_TwitchChat_EmoteBrushHits);
+DEFINE_STAT(STAT_TwitchChat_EmoteBrushMisses);
+
+DEFINE_STAT(STAT_TwitchChat_FramesInFlight);
+DEFINE_STAT(STAT_TwitchChat_HistoryQueue);
+DEFINE_STAT(STAT_TwitchChat_WindowMessages);
+
+LLM_DEFINE_TAG(TwitchChat, TEXT("TwitchChat"));
+LLM_DEFINE_TAG(TwitchChat_Messages, TEXT("Chat Messages"), TEXT("TwitchChat"));
+LLM_DEFINE_TAG(TwitchChat_EmoteCache, TEXT("Emote Cache"), TEXT("TwitchChat"));
+LLM_DEFINE_TAG(TwitchChat_EmoteTextures, TEXT("Emote Textures"), TEXT("TwitchChat"));
+
+UE_TRACE_CHANNEL_DEFINE(TwitchChatChannel);
+
+UE_TRACE_EVENT_BEGIN(TwitchChat, MessageStage)
+    UE_TRACE_EVENT_FIELD(uint64, Cycle)
+    UE_TRACE_EVENT_FIELD(uint32, Serial)
+    UE_TRACE_EVENT_FIELD(uint8, Stage)
+UE_TRACE_EVENT_END()
+
+uint32 TwitchChatTrace::NextMessageSerial()
+{
+    static std::atomic<uint32> Serial{ 0 };
+    return ++Serial;
+}
+
+void TwitchChatTrace::MessageStage(uint32 Serial, ETwitchChatTraceStage Stage)
+{
+    UE_TRACE_LOG(TwitchChat, MessageStage, TwitchChatChannel)
+        << MessageStage.Cycle(FPlatformTime::Cycles64())
+        << MessageStage.Serial(Serial)
+        << MessageStage.Stage(uint8(Stage));
+}
@@ -0,0 +1,267 @@
+#include "TwitchChatStress.h"
+#include "TwitchChatConnection.h"
+#include "TwitchChatEmulator.h"
+#include "TwitchChatMetrics.h"
+#include "TwitchChatSettings.h"
+#include "TwitchChatSyntheticChat.h"
+
+#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+
+namespace TwitchChatStress
+{
+    static TSharedPtr<FTwitchChatStress> GActive;
+
+    // Seconds the connection gets to drain after the final Disconnect before the run fails
+    static constexpr double DrainTimeout = 10.0;
+
+    static const TCHAR* ChannelLogin = TEXT("stress");
+}
+
+FTwitchChatStress::FOptions FTwitchChatStress::FOptions::FromArgs(const TArray<FString>& Args)
+{
+    FOptions Out;
+    for (const FString& Arg : Args)
+    {
+        FString Key, Value;
+        if (!Arg.Split(TEXT("="), &Key, &Value))
+            continue;
+
+        if (Key == TEXT("seconds"))       Out.Seconds = FMath::Max(0.5f, FCString::Atof(*Value));
+        else if (Key == TEXT("threads"))  Out.Threads = FMath::Clamp(FCString::Atoi(*Value), 1, 64);
+        else if (Key == TEXT("rate"))     Out.Rate = FMath::Max(0.f, FCString::Atof(*Value));
+        else if (Key == TEXT("toggle"))   Out.ToggleSeconds = FMath::Max(0.f, FCString::Atof(*Value));
+        else if (Key == TEXT("inflight")) Out.MaxInFlight = FMath::Max(1, FCString::Atoi(*Value));
+    }
+    return Out;
+}
+
+TSharedPtr<FTwitchChatStress> FTwitchChatStress::GetActive()
+{
+    return TwitchChatStress::GActive;
+}
+
+TSharedPtr<FTwitchChatStress> FTwitchChatStress::StartActive(const FOptions& InOptions)
+{
+    if (TwitchChatStress::GActive.IsValid() && TwitchChatStress::GActive->IsRunning())
+    {
+        UE_LOG(LogTwitchChat, Warning, TEXT("Stress run already in progress"));
+        return nullptr;
+    }
+
+    TSharedPtr<FTwitchChatStress> Stress = MakeShared<FTwitchChatStress>(FTwitchChatConnection::Get(), InOptions);
+    if (!Stress->Start())
+        return nullptr;
+
+    TwitchChatStress::GActive = Stress;
+    return Stress;
+}
+
+FTwitchChatStress::FTwitchChatStress(TSharedRef<FTwitchChatConnection> InConnection, const FOptions& InOptions)
+    : Connection(InConnection)
+    , Options(InOptions)
+{
+}
+
+FTwitchChatStress::~FTwitchChatStress()
+{
+    bStopProducers = true;
+    if (TickHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+    }
+}
+
+bool FTwitchChatStress::Start()
+{
+    if (bRunning)
+        return false;
+
+    if (!FTwitchChatEmulator::GetActive().IsValid())
+    {
+        TSharedPtr<FTwitchChatEmulator> Emulator = FTwitchChatEmulator::StartActive(FTwitchChatEmulator::FConfig());
+        if (!Emulator.IsValid())
+        {
+            UE_LOG(LogTwitchChat, Warning, TEXT("Stress: could not start the emulator"));
+            return false;
+        }
+        // Only the injected frames are counted; keep the emulator's own chat out of the way
+        Emulator->SetChatRate(0.f);
+        bStartedEmulator = true;
+    }
+
+    Connection->Disconnect();
+    MessageHandle = Connection->OnMessage.AddSP(this, &FTwitchChatStress::HandleMessage);
+    TickHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateSP(this, &FTwitchChatStress::Tick));
+
+    bRunning = true;
+    StaleAtStart = FTwitchChatMetrics::Get().GetCounter(ETwitchChatCounter::StaleDropped);
+    StartTime = NextToggle = FPlatformTime::Seconds();
+
+    UE_LOG(LogTwitchChat, Display, TEXT("Stress: %.1fs, %d producer threads, toggling every %.2fs"),
+        Options.Seconds, Options.Threads, Options.ToggleSeconds);
+
+    TSharedRef<FTwitchChatStress> Self = AsShared();
+    for (int32 ThreadIndex = 0; ThreadIndex < Options.Threads; ++ThreadIndex)
+    {
+        ++ProducersRunning;
+        Async(EAsyncExecution::Thread, [Self, ThreadIndex]()
+            {
+                FTwitchChatSyntheticChat Chat;
+                FTwitchChatSyntheticChat::FChannel Channel;
+                Channel.BroadcasterLogin = TwitchChatStress::ChannelLogin;
+                const FString SessionId = FString::Printf(TEXT("stress-%d"), ThreadIndex);
+
+                const float Rate = Self->Options.Rate;
+                const double Start = FPlatformTime::Seconds();
+                for (int64 i = 0; !Self->bStopProducers; ++i)
+                {
+                    if (Rate > 0.f)
+                    {
+                        const double Wait = Start + i / Rate - FPlatformTime::Seconds();
+                        if (Wait > 0.0)
+                            FPlatformProcess::Sleep(float(Wait));
+                    }
+                    while (Self->Connection->GetNumFramesInFlight() >= Self->Options.MaxInFlight && !Self->bStopProducers)
+                    {
+                        FPlatformProcess::Sleep(0.0005f);
+                    }
+                    if (Self->bStopProducers)
+                        break;
+
+                    Self->Connection->IngestFrame(Chat.NextChatMessage(SessionId, Channel));
+                    ++Self->Injected;
+                }
+                --Self->ProducersRunning;
+            });
+    }
+    return true;
+}
+
+void FTwitchChatStress::HandleMessage(const FTwitchChatMessage& Msg)
+{
+    if (!bRunning || Msg.ChannelLogin != TwitchChatStress::ChannelLogin)
+        return;
+
+    if (!IsInGameThread())
+        bOffTheGameThread = true;
+
+    ++Delivered;
+    if (bFinalDisconnect)
+        ++DeliveredAfterDisconnect;
+}
+
+void FTwitchChatStress::Toggle()
+{
+    if (Connection->GetState() == ETwitchChatConnectionState::Disconnected)
+    {
+        const UTwitchChatSettings* S = GetDefault<UTwitchChatSettings>();
+        Connection->Connect(S->UserName, S->GetAccessToken(), TEXT("emulated"), S->Port);
+    }
+    else
+    {
+        Connection->Disconnect();
+    }
+    ++Toggles;
+}
+
+bool FTwitchChatStress::Tick(float /*DeltaTime*/)
+{
+    if (!bRunning)
+        return true;
+
+    const double Now = FPlatformTime::Seconds();
+    if (!bStopProducers)
+    {
+        if (!bCancelled && Now - StartTime < Options.Seconds)
+        {
+            if (Now >= NextToggle)
+            {
+                Toggle();
+                NextToggle = Now + Options.ToggleSeconds;
+            }
+            return true;
+        }
+        bStopProducers = true;
+    }
+
+    // Producers must be out of IngestFrame before the final Disconnect, or their frames
+    // would carry the new epoch and legitimately arrive afterwards
+    if (ProducersRunning.load() > 0)
+        return true;
+
+    if (!bFinalDisconnect)
+    {
+        Connection->Disconnect();
+        bFinalDisconnect = true;
+        DrainStart = Now;
+        return true;
+    }
+
+    const bool bDrained = Connection->GetNumFramesInFlight() == 0 && Connection->GetNumPostedTasks() == 0;
+    if (bDrained || Now - DrainStart > TwitchChatStress::DrainTimeout)
+    {
+        Finish();
+    }
+    return true;
+}
+
+void FTwitchChatStress::Finish()
+{
+    bRunning = false;
+    Connection->OnMessage.Remove(MessageHandle);
+    FTSTicker::GetCoreTicker().RemoveTicker(TickHandle);
+    TickHandle.Reset();
+
+    const int32 FramesInFlight = Connection->GetNumFramesInFlight();
+    const int32 PostedTasks = Connection->GetNumPostedTasks();
+    const int64 Stale = FTwitchChatMetrics::Get().GetCounter(ETwitchChatCounter::StaleDropped) - StaleAtStart;
+    const int64 Lost = Injected.load() - Delivered;
+
+    TArray<FString> Failures;
+    if (FramesInFlight != 0)
+        Failures.Add(FString::Printf(TEXT("%d frames still in flight"), FramesInFlight));
+    if (PostedTasks != 0)
+        Failures.Add(FString::Printf(TEXT("%d executor tasks never ran"), PostedTasks));
+    if (Connection->GetState() != ETwitchChatConnectionState::Disconnected)
+        Failures.Add(FString::Printf(TEXT("ended %s"), FTwitchChatConnection::GetStateName(Connection->GetState())));
+    if (DeliveredAfterDisconnect > 0)
+        Failures.Add(FString::Printf(TEXT("%lld messages after the final Disconnect"), DeliveredAfterDisconnect));
+    if (Lost > Stale)
+        Failures.Add(FString::Printf(TEXT("%lld messages neither delivered nor dropped as stale"), Lost - Stale));
+    if (bOffTheGameThread)
+        Failures.Add(TEXT("OnMessage fired off the game thread"));
+
+    bPassed = Failures.Num() == 0;
+    UE_LOG(LogTwitchChat, Display, TEXT("Stress %s: %d toggles, %lld injected, %lld delivered, %lld dropped as stale%s%s"),
+        bPassed ? TEXT("PASS") : TEXT("FAIL"), Toggles, Injected.load(), Delivered, Stale,
+        bPassed ? TEXT("") : TEXT("; "), *FString::Join(Failures, TEXT("; ")));
+
+    if (bStartedEmulator)
+    {
+        FTwitchChatEmulator::StopActive();
+        bStartedEmulator = false;
+    }
+}
+
+static FAutoConsoleCommand GTwitchChatStressCmd(
+    TEXT("twitchchat.stress"),
+    TEXT("Inject chat from several threads while toggling Connect/Disconnect, then check nothing leaked past the final Disconnect. ")
+    TEXT("Usage: twitchchat.stress [seconds=10] [threads=4] [rate=2000] [toggle=0.25] [inflight=1024]"),
+    FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+        {
+            FTwitchChatStress::StartActive(FTwitchChatStress::FOptions::FromArgs(Args));
+        })
+);
+
+static FAutoConsoleCommand GTwitchChatStressStopCmd(
+    TEXT("twitchchat.stress.stop"),
+    TEXT("End the running stress run early; the final checks still run."),
+    FConsoleCommandDelegate::CreateLambda([]()
+        {
+            if (TSharedPtr<FTwitchChatStress> Stress = FTwitchChatStress::GetActive())
+            {
+                Stress->Cancel();
+            }
+        })
+);
@@ -0,0 +1,260 @@
+#include "TwitchChatSyntheticChat.h"
+
+#include "Misc/Guid.h"
+
+namespace TwitchChatSynthetic
+{
+    struct FEmote { const TCHAR* Id; const TCHAR* Code; };
+
+    static const FEmote Emotes[] = {
+        { TEXT("25"),     TEXT("Kappa") },
+        { TEXT("41"),     TEXT("Kreygasm") },
+        { TEXT("86"),     TEXT("BibleThump") },
+        { TEXT("354"),    TEXT("4Head") },
+        { TEXT("425618"), TEXT("LUL") },
+        { TEXT("1902"),   TEXT("Keepo") },
+    };
+
+    static const TCHAR* Words[] = {
+        TEXT("hello"), TEXT("chat"), TEXT("that"), TEXT("was"), TEXT("insane"), TEXT("play"), TEXT("again"),
+        TEXT("sponsor"), TEXT("when"), TEXT("is"), TEXT("the"), TEXT("next"), TEXT("round"), TEXT("gg"),
+        TEXT("clip"), TEXT("it"), TEXT("no"), TEXT("way"), TEXT("lets"), TEXT("go"), TEXT("raid"), TEXT("hype"),
+        TEXT("stream"), TEXT("camera"), TEXT("audio"), TEXT("looks"), TEXT("great"), TEXT("today"),
+    };
+
+    static const TCHAR* Colors[] = {
+        TEXT("#FF0000"), TEXT("#0000FF"), TEXT("#008000"), TEXT("#B22222"), TEXT("#FF7F50"),
+        TEXT("#9ACD32"), TEXT("#FF4500"), TEXT("#2E8B57"), TEXT("#DAA520"), TEXT("#1E90FF"), TEXT(""),
+    };
+
+    static FString NewId()
+    {
+        return FGuid::NewGuid().ToString(EGuidFormats::DigitsWithHyphensLower);
+    }
+}
+
+FTwitchChatSyntheticChat::FConfig FTwitchChatSyntheticChat::FConfig::EmoteHeavy()
+{
+    FConfig C;
+    C.EmoteRatio = 0.8f;
+    C.MinWords = 4;
+    C.MaxWords = 20;
+    return C;
+}
+
+FTwitchChatSyntheticChat::FConfig FTwitchChatSyntheticChat::FConfig::LongText()
+{
+    FConfig C;
+    C.EmoteRatio = 0.05f;
+    C.MinWords = 60;
+    C.MaxWords = 90;   // close to the 500 character chat limit
+    return C;
+}
+
+FTwitchChatSyntheticChat::FConfig FTwitchChatSyntheticChat::FConfig::ReplyHeavy()
+{
+    FConfig C;
+    C.ReplyRatio = 0.7f;
+    return C;
+}
+
+bool FTwitchChatSyntheticChat::FConfig::FromName(const FString& Name, FConfig& Out)
+{
+    if (Name.Equals(TEXT("default"), ESearchCase::IgnoreCase)) { Out = FConfig(); return true; }
+    if (Name.Equals(TEXT("emote"), ESearchCase::IgnoreCase))   { Out = EmoteHeavy(); return true; }
+    if (Name.Equals(TEXT("long"), ESearchCase::IgnoreCase))    { Out = LongText(); return true; }
+    if (Name.Equals(TEXT("reply"), ESearchCase::IgnoreCase))   { Out = ReplyHeavy(); return true; }
+    return false;
+}
+
+FTwitchChatSyntheticChat::FTwitchChatSyntheticChat(const FConfig& InConfig)
+    : Config(InConfig)
+    , Random(InConfig.Seed)
+{
+    RecentMessages.Reserve(64);
+}
+
+FString FTwitchChatSyntheticChat::EscapeJson(const FString& In)
+{
+    FString Out;
+    Out.Reserve(In.Len() + 8);
+    for (TCHAR C : In)
+    {
+        switch (C)
+        {
+        case TEXT('"'):  Out += TEXT("\\\""); break;
+        case TEXT('\\'): Out += TEXT("\\\\"); break;
+        case TEXT('\n'): Out += TEXT("\\n"); break;
+        case TEXT('\r'): Out += TEXT("\\r"); break;
+        case TEXT('\t'): Out += TEXT("\\t"); break;
+        default:
+            if (C < 0x20)
+                Out += FString::Printf(TEXT("\\u%04x"), int32(C));
+            else
+                Out.AppendChar(C);
+        }
+    }
+    return Out;
+}
+
+FString FTwitchChatSyntheticChat::MakeWelcome(const FString& SessionId, int32 KeepaliveSeconds, const FString& ReconnectUrl)
+{
+    const FString Now = FDateTime::UtcNow().ToIso8601();
+    return FString::Printf(
+        TEXT("{\"metadata\":{\"message_id\":\"%s\",\"message_type\":\"session_welcome\",\"message_timestamp\":\"%s\"},")
+        TEXT("\"payload\":{\"session\":{\"id\":\"%s\",\"status\":\"connected\",\"connected_at\":\"%s\",")
+        TEXT("\"keepalive_timeout_seconds\":%d,\"reconnect_url\":%s}}}"),
+        *TwitchChatSynthetic::NewId(), *Now, *SessionId, *Now, KeepaliveSeconds,
+        ReconnectUrl.IsEmpty() ? TEXT("null") : *FString::Printf(TEXT("\"%s\""), *ReconnectUrl));
+}
+
+FString FTwitchChatSyntheticChat::MakeKeepalive()
+{
+    return FString::Printf(
+        TEXT("{\"metadata\":{\"message_id\":\"%s\",\"message_type\":\"session_keepalive\",\"message_timestamp\":\"%s\"},\"payload\":{}}"),
+        *TwitchChatSynthetic::NewId(), *FDateTime::UtcNow().ToIso8601());
+}
+
+FString FTwitchChatSyntheticChat::MakeReconnect(const FString& SessionId, const FString& ReconnectUrl)
+{
+    const FString Now = FDateTime::UtcNow().ToIso8601();
+    return FString::Printf(
+        TEXT("{\"metadata\":{\"message_id\":\"%s\",\"message_type\":\"session_reconnect\",\"message_timestamp\":\"%s\"},")
+        TEXT("\"payload\":{\"session\":{\"id\":\"%s\",\"status\":\"reconnecting\",\"keepalive_timeout_seconds\":null,")
+        TEXT("\"reconnect_url\":\"%s\",\"connected_at\":\"%s\"}}}"),
+        *TwitchChatSynthetic::NewId(), *Now, *SessionId, *ReconnectUrl, *Now);
+}
+
+FString FTwitchChatSyntheticChat::NextChatMessage(const FString& SessionId, const FChannel& Channel)
+{
+    using namespace TwitchChatSynthetic;
+
+    const int32 Chatter = Random.RandHelper(FMath::Max(1, Config.NumChatters));
+    const FString UserId = FString::FromInt(2000000 + Chatter);
+    const FString UserLogin = FString::Printf(TEXT("viewer_%d"), Chatter);
+    const FString Color = Colors[Chatter % UE_ARRAY_COUNT(Colors)];
+
+    TArray<FFragment> Fragments;
+    FString Pending;
+    const int32 NumWords = Random.RandRange(Config.MinWords, FMath::Max(Config.MinWords, Config.MaxWords));
+    for (int32 w = 0; w < NumWords; ++w)
+    {
+        if (Random.FRand() < Config.EmoteRatio)
+        {
+            if (!Pending.IsEmpty())
+            {
+                Fragments.Add({ MoveTemp(Pending), FString() });
+                Pending.Reset();
+            }
+            const FEmote& E = Emotes[Random.RandHelper(UE_ARRAY_COUNT(Emotes))];
+            Fragments.Add({ E.Code, E.Id });
+            Pending = TEXT(" ");
+        }
+        else
+        {
+            Pending += Words[Random.RandHelper(UE_ARRAY_COUNT(Words))];
+            Pending += TEXT(" ");
+        }
+    }
+    Pending.TrimEndInline();
+    if (!Pending.IsEmpty())
+    {
+        Fragments.Add({ MoveTemp(Pending), FString() });
+    }
+
+    const FParent* Parent = nullptr;
+    if (RecentMessages.Num() > 0 && Random.FRand() < Config.ReplyRatio)
+    {
+        Parent = &RecentMessages[Random.RandHelper(RecentMessages.Num())];
+    }
+
+    return BuildNotification(SessionId, Channel, UserId, UserLogin, Color, Fragments, Parent);
+}
+
+FString FTwitchChatSyntheticChat::MakeChatMessage(const FString& SessionId, const FChannel& Channel,
+    const FString& UserId, const FString& UserLogin, const FString& Text)
+{
+    TArray<FFragment> Fragments;
+    Fragments.Add({ Text, FString() });
+    return BuildNotification(SessionId, Channel, UserId, UserLogin, TEXT("#9146FF"), Fragments, nullptr);
+}
+
+FString FTwitchChatSyntheticChat::BuildNotification(const FString& SessionId, const FChannel& Channel,
+    const FString& UserId, const FString& UserLogin, const FString& Color,
+    const TArray<FFragment>& Fragments, const FParent* Parent)
+{
+    const FString MessageId = TwitchChatSynthetic::NewId();
+    const FString Now = FDateTime::UtcNow().ToIso8601();
+
+    FString Text;
+    FString FragmentJson;
+    for (const FFragment& F : Fragments)
+    {
+        const FString Escaped = EscapeJson(F.Text);
+        Text += F.Text;
+        if (!FragmentJson.IsEmpty())
+            FragmentJson += TEXT(",");
+
+        if (F.EmoteId.IsEmpty())
+        {
+            FragmentJson += FString::Printf(
+                TEXT("{\"type\":\"text\",\"text\":\"%s\",\"cheermote\":null,\"emote\":null,\"mention\":null}"), *Escaped);
+        }
+        else
+        {
+            FragmentJson += FString::Printf(
+                TEXT("{\"type\":\"emote\",\"text\":\"%s\",\"cheermote\":null,\"emote\":{\"id\":\"%s\",\"emote_set_id\":\"0\",\"owner_id\":\"0\",\"format\":[\"static\"]},\"mention\":null}"),
+                *Escaped, *F.EmoteId);
+        }
+    }
+
+    // A stable share of chatters are subscribers or moderators, so badge rendering has work to do
+    const uint32 UserHash = GetTypeHash(UserId);
+    FString BadgeJson;
+    if (UserHash % 3 == 0)
+        BadgeJson = TEXT("{\"set_id\":\"subscriber\",\"id\":\"0\",\"info\":\"1\"}");
+    if (UserHash % 10 == 0)
+        BadgeJson += FString(BadgeJson.IsEmpty() ? TEXT("") : TEXT(",")) + TEXT("{\"set_id\":\"moderator\",\"id\":\"1\",\"info\":\"\"}");
+
+    FString ReplyJson = TEXT("null");
+    if (Parent)
+    {
+        ReplyJson = FString::Printf(
+            TEXT("{\"parent_message_id\":\"%s\",\"parent_message_body\":\"%s\",\"parent_user_id\":\"%s\",\"parent_user_name\":\"%s\",\"parent_user_login\":\"%s\",")
+            TEXT("\"thread_message_id\":\"%s\",\"thread_user_id\":\"%s\",\"thread_user_name\":\"%s\",\"thread_user_login\":\"%s\"}"),
+            *Parent->MessageId, *EscapeJson(Parent->Body), *Parent->UserId, *Parent->UserLogin, *Parent->UserLogin,
+            *Parent->MessageId, *Parent->UserId, *Parent->UserLogin, *Parent->UserLogin);
+    }
+
+    FString Frame = FString::Printf(
+        TEXT("{\"metadata\":{\"message_id\":\"%s\",\"message_type\":\"notification\",\"message_timestamp\":\"%s\",")
+        TEXT("\"subscription_type\":\"channel.chat.message\",\"subscription_version\":\"1\"},")
+        TEXT("\"payload\":{\"subscription\":{\"id\":\"emulated\",\"status\":\"enabled\",\"type\":\"channel.chat.message\",\"version\":\"1\",")
+        TEXT("\"condition\":{\"broadcaster_user_id\":\"%s\",\"user_id\":\"%s\"},\"transport\":{\"method\":\"websocket\",\"session_id\":\"%s\"},")
+        TEXT("\"created_at\":\"%s\",\"cost\":0},")
+        TEXT("\"event\":{\"broadcaster_user_id\":\"%s\",\"broadcaster_user_login\":\"%s\",\"broadcaster_user_name\":\"%s\",")
+        TEXT("\"chatter_user_id\":\"%s\",\"chatter_user_login\":\"%s\",\"chatter_user_name\":\"%s\",\"message_id\":\"%s\",")
+        TEXT("\"message\":{\"text\":\"%s\",\"fragments\":[%s]},\"color\":\"%s\",")
+        TEXT("\"badges\":[%s],\"message_type\":\"text\",\"cheer\":null,\"reply\":%s,\"channel_points_custom_reward_id\":null}}}"),
+        *TwitchChatSynthetic::NewId(), *Now,
+        *Channel.BroadcasterId, *Channel.BroadcasterId, *SessionId,
+        *Now,
+        *Channel.BroadcasterId, *Channel.BroadcasterLogin, *Channel.BroadcasterLogin,
+        *UserId, *UserLogin, *UserLogin, *MessageId,
+        *EscapeJson(Text), *FragmentJson, *Color,
+        *BadgeJson, *ReplyJson);
+
+    // Remember a few recent messages as reply targets
+    FParent Recent{ MessageId, UserId, UserLogin, Text.Left(100) };
+    if (RecentMessages.Num() < 64)
+    {
+        RecentMessages.Add(MoveTemp(Recent));
+    }
+    else
+    {
+        RecentMessages[NextRecent] = MoveTemp(Recent);
+        NextRecent = (NextRecent + 1) % RecentMessages.Num();
+    }
+
+    return Frame;
+}
@@ -0,0 +1,94 @@
+#include "TwitchChatTrafficRecorder.h"
+#include "TwitchChatConnection.h"
+
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/MemoryWriter.h"
+
+FString FTwitchChatTrafficRecorder::MakeDefaultPath()
+{
+    return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("TwitchChatRecordings"),
+        FString::Printf(TEXT("Recording_%s.tcrec"), *FDateTime::Now().ToString(TEXT("%Y%m%d_%H%M%S"))));
+}
+
+FTwitchChatTrafficRecorder::~FTwitchChatTrafficRecorder()
+{
+    Close();
+}
+
+bool FTwitchChatTrafficRecorder::Open(const FString& InPath)
+{
+    FScopeLock Lock(&Mutex);
+
+    IFileManager::Get().MakeDirectory(*FPaths::GetPath(InPath), /*Tree=*/true);
+    Writer.Reset(IFileManager::Get().CreateFileWriter(*InPath));
+    if (!Writer)
+    {
+        UE_LOG(LogTwitchChat, Error, TEXT("Recorder: cannot open %s"), *InPath);
+        return false;
+    }
+
+    Path = InPath;
+    NumFrames = 0;
+    LastCycles = 0;
+    Buffer.Reset();
+    return true;
+}
+
+void FTwitchChatTrafficRecorder::Close()
+{
+    FScopeLock Lock(&Mutex);
+    if (!Writer)
+        return;
+
+    FlushBuffer();
+    Writer->Close();
+    Writer.Reset();
+    UE_LOG(LogTwitchChat, Log, TEXT("Recorder: wrote %lld frames to %s"), NumFrames, *Path);
+}
+
+void FTwitchChatTrafficRecorder::Record(const FString& Frame, uint64 Cycles)
+{
+    FScopeLock Lock(&Mutex);
+    if (!Writer)
+        return;
+
+    FMemoryWriter Ar(Buffer, /*bIsPersistent=*/true, /*bSetOffset=*/true);
+
+    if (NumFrames == 0)
+    {
+        uint32 Magic = FileMagic;
+        int32 Version = FileVersion;
+        int64 StartTicks = FDateTime::UtcNow().GetTicks();
+        Ar << Magic << Version << StartTicks;
+        LastCycles = Cycles;
+    }
+
+    const double DeltaMicros = FPlatformTime::ToMilliseconds64(Cycles - LastCycles) * 1000.0;
+    uint32 Delta = uint32(FMath::Clamp(DeltaMicros, 0.0, double(MAX_uint32)));
+    LastCycles = Cycles;
+
+    FTCHARToUTF8 Utf8(*Frame, Frame.Len());
+    uint32 Length = Utf8.Length();
+
+    Ar.SerializeIntPacked(Delta);
+    Ar.SerializeIntPacked(Length);
+    Ar.Serialize(const_cast<ANSICHAR*>(Utf8.Get()), Length);
+    ++NumFrames;
+
+    if (Buffer.Num() >= 64 * 1024)
+    {
+        FlushBuffer();
+    }
+}
+
+void FTwitchChatTrafficRecorder::FlushBuffer()
+{
+    if (Writer && Buffer.Num() > 0)
+    {
+        Writer->Serialize(Buffer.GetData(), Buffer.Num());
+        Writer->Flush();
+    }
+    Buffer.Reset();
+}
@@ -0,0 +1,163 @@
+#include "TwitchChatWarmStart.h"
+#include "TwitchChatConnection.h"
+#include "Misc/Paths.h"
+#include "Misc/FileHelper.h"
+#include "Misc/SecureHash.h"
+#include "HAL/FileManager.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/JsonSerializer.h"
+#include "HAL/IConsoleManager.h"
+
+FTwitchChatWarmStart& FTwitchChatWarmStart::Get()
+{
+    static FTwitchChatWarmStart Instance;
+    return Instance;
+}
+
+FString FTwitchChatWarmStart::GetPath()
+{
+    return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("TwitchChatWarmStart.json"));
+}
+
+FString FTwitchChatWarmStart::HashToken(const FString& AccessToken)
+{
+    FTCHARToUTF8 Utf8(*AccessToken, AccessToken.Len());
+    FSHAHash Hash;
+    FSHA1::HashBuffer(Utf8.Get(), Utf8.Length(), Hash.Hash);
+    return Hash.ToString();
+}
+
+void FTwitchChatWarmStart::Load()
+{
+    bLoaded = true;
+
+    FString Text;
+    TSharedPtr<FJsonObject> Root;
+    if (!FFileHelper::LoadFileToString(Text, *GetPath()))
+        return;
+    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Text);
+    if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid())
+    {
+        UE_LOG(LogTwitchChat, Warning, TEXT("Ignoring unreadable %s"), *GetPath());
+        return;
+    }
+
+    const TSharedPtr<FJsonObject>* TokenObj = nullptr;
+    if (Root->TryGetObjectField(TEXT("token"), TokenObj))
+    {
+        FString Expires, Validated;
+        (*TokenObj)->TryGetStringField(TEXT("hash"), TokenHash);
+        (*TokenObj)->TryGetStringField(TEXT("login"), Token.Login);
+        (*TokenObj)->TryGetStringField(TEXT("user_id"), Token.UserId);
+        (*TokenObj)->TryGetStringArrayField(TEXT("scopes"), Token.Scopes);
+        if ((*TokenObj)->TryGetStringField(TEXT("expires_at"), Expires))
+            FDateTime::ParseIso8601(*Expires, Token.ExpiresUtc);
+        if ((*TokenObj)->TryGetStringField(TEXT("validated_at"), Validated))
+            FDateTime::ParseIso8601(*Validated, Token.ValidatedUtc);
+    }
+
+    const TSharedPtr<FJsonObject>* Users = nullptr;
+    if (Root->TryGetObjectField(TEXT("user_ids"), Users))
+    {
+        for (const TPair<FString, TSharedPtr<FJsonValue>>& Pair : (*Users)->Values)
+        {
+            UserIds.Add(Pair.Key.ToLower(), Pair.Value->AsString());
+        }
+    }
+}
+
+void FTwitchChatWarmStart::Save() const
+{
+    TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+    if (!TokenHash.IsEmpty())
+    {
+        TSharedRef<FJsonObject> TokenObj = MakeShared<FJsonObject>();
+        TokenObj->SetStringField(TEXT("hash"), TokenHash);
+        TokenObj->SetStringField(TEXT("login"), Token.Login);
+        TokenObj->SetStringField(TEXT("user_id"), Token.UserId);
+        TArray<TSharedPtr<FJsonValue>> Scopes;
+        for (const FString& Scope : Token.Scopes)
+        {
+            Scopes.Add(MakeShared<FJsonValueString>(Scope));
+        }
+        TokenObj->SetArrayField(TEXT("scopes"), Scopes);
+        if (Token.ExpiresUtc.GetTicks() != 0)
+            TokenObj->SetStringField(TEXT("expires_at"), Token.ExpiresUtc.ToIso8601());
+        TokenObj->SetStringField(TEXT("validated_at"), Token.ValidatedUtc.ToIso8601());
+        Root->SetObjectField(TEXT("token"), TokenObj);
+    }
+
+    TSharedRef<FJsonObject> Users = MakeShared<FJsonObject>();
+    for (const TPair<FString, FString>& Pair : UserIds)
+    {
+        Users->SetStringField(Pair.Key, Pair.Value);
+    }
+    Root->SetObjectField(TEXT("user_ids"), Users);
+
+    FString Text;
+    TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Text);
+    FJsonSerializer::Serialize(Root, Writer);
+    if (!FFileHelper::SaveStringToFile(Text, *GetPath()))
+    {
+        UE_LOG(LogTwitchChat, Warning, TEXT("Could not write %s"), *GetPath());
+    }
+}
+
+bool FTwitchChatWarmStart::FindToken(const FString& AccessToken, FToken& OutToken)
+{
+    if (!bLoaded)
+        Load();
+    if (AccessToken.IsEmpty() || TokenHash.IsEmpty() || TokenHash != HashToken(AccessToken))
+        return false;
+    OutToken = Token;
+    return true;
+}
+
+void FTwitchChatWarmStart::StoreToken(const FString& AccessToken, const FToken& InToken)
+{
+    if (!bLoaded)
+        Load();
+    TokenHash = HashToken(AccessToken);
+    Token = InToken;
+    Save();
+}
+
+const TMap<FString, FString>& FTwitchChatWarmStart::GetUserIds()
+{
+    if (!bLoaded)
+        Load();
+    return UserIds;
+}
+
+void FTwitchChatWarmStart::StoreUserId(const FString& Login, const FString& Id)
+{
+    if (!bLoaded)
+        Load();
+    const FString Key = Login.ToLower();
+    const FString* Existing = UserIds.Find(Key);
+    if (Existing && *Existing == Id)
+        return;
+    UserIds.Add(Key, Id);
+    Save();
+}
+
+void FTwitchChatWarmStart::Clear()
+{
+    bLoaded = true;
+    TokenHash.Empty();
+    Token = FToken();
+    UserIds.Reset();
+    IFileManager::Get().Delete(*GetPath(), /*RequireExists=*/false, /*EvenReadOnly=*/true, /*Quiet=*/true);
+}
+
+static FAutoConsoleCommand GTwitchChatWarmStartClearCmd(
+    TEXT("twitchchat.warmstart.clear"),
+    TEXT("Forget the saved token metadata and user ids; the next editor run starts cold."),
+    FConsoleCommandDelegate::CreateLambda([]()
+        {
+            FTwitchChatWarmStart::Get().Clear();
+            UE_LOG(LogTwitchChat, Display, TEXT("Warm-start cache cleared"));
+        })
+);
@@ -16,6 +16,7 @@
 #include "Widgets/Images/SImage.h"
 #include "Widgets/Text/STextBlock.h"
 #include "Widgets/Input/SButton.h"
+#include "Widgets/Input/SSearchBox.h"
 #include "Widgets/Views/SListView.h"
 
 
@@ -32,6 +33,18 @@
 
 // Async
 #include "Async/Async.h"
+#include "Algo/Reverse.h"
+
+#include "TwitchChatSearchIndex.h"
+#include "TwitchChatStats.h"
+#include "TwitchChatLatency.h"
+#include "TwitchChatMemory.h"
+#include "TwitchChatRecentHistory.h"
+#include "TwitchChatImages.h"
+#include "TwitchChatMetrics.h"
+#include "TwitchChatDiagnostics.h"
+#include "Framework/Docking/TabManager.h"
+#include "Widgets/SLeafWidget.h"
 
 #if WITH_EDITOR
 #include "ISettingsModule.h"
@@ -42,6 +55,8 @@ DEFINE_LOG_CATEGORY_STATIC(LogTwitchChatWindow, Log, All);
 
 static UTexture2D* LoadTextureFromDisk(const FString& FullPath)
 {
+    SCOPE_CYCLE_COUNTER(STAT_TwitchChat_EmoteDecode);
+    FTwitchChatMetricsScope MetricsScope(ETwitchChatTimer::EmoteDecode);
     TArray<uint8> FileData;
     if (!FFileHelper::LoadFileToArray(FileData, *FullPath))
     {
@@ -67,11 +82,13 @@ static UTexture2D* LoadTextureFromDisk(const FString& FullPath)
 
     const int32 W = Wrapper->GetWidth();
     const int32 H = Wrapper->GetHeight();
+    LLM_SCOPE_BYTAG(TwitchChat_EmoteTextures);
     UTexture2D* Tex = UTexture2D::CreateTransient(W, H, PF_B8G8R8A8);
     if (!Tex)
     {
         return nullptr;
     }
+    FTwitchChatMemory::TrackEmoteTexture(Tex);
 
     Tex->AddToRoot();
     Tex->SRGB = true;
@@ -85,6 +102,38 @@ static UTexture2D* LoadTextureFromDisk(const FString& FullPath)
 }
 
 
+// 1x1 leaf placed in each chat row; reports the message's first paint to FTwitchChatLatency
+class STwitchChatPaintProbe : public SLeafWidget
+{
+public:
+    SLATE_BEGIN_ARGS(STwitchChatPaintProbe) {}
+    SLATE_END_ARGS()
+
+    void Construct(const FArguments& /*InArgs*/, TSharedPtr<FTwitchChatMessage> InMessage)
+    {
+        Message = InMessage;
+    }
+
+    virtual FVector2D ComputeDesiredSize(float) const override { return FVector2D(1.f, 1.f); }
+
+    virtual int32 OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect,
+        FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const override
+    {
+        if (TSharedPtr<FTwitchChatMessage> Pinned = Message.Pin())
+        {
+            if (!Pinned->bPaintReported)
+            {
+                Pinned->bPaintReported = true;
+                FTwitchChatLatency::Get().RecordPainted(*Pinned);
+            }
+        }
+        return LayerId;
+    }
+
+private:
+    TWeakPtr<FTwitchChatMessage> Message;
+};
+
 STwitchChatWindow::~STwitchChatWindow()
 {
     if (AnimationTimerHandle.IsValid())
@@ -92,6 +141,8 @@ STwitchChatWindow::~STwitchChatWindow()
         UnRegisterActiveTimer(AnimationTimerHandle.ToSharedRef());
     }
     FTwitchChatConnection::Get()->OnMessage.Remove(MessageHandle);
+    FTwitchChatMemory::OnCollect.Remove(MemoryHandle);
+    FTwitchChatImages::Get()->OnImagesLoaded.Remove(ImagesHandle);
 }
 
 void STwitchChatWindow::Construct(const FArguments& /*InArgs*/)
@@ -118,8 +169,14 @@ void STwitchChatWindow::Construct(const FArguments& /*InArgs*/)
         .Text(LOCTEXT("Clear", "Clear"))
         .OnClicked_Lambda([this]() { OnClearClicked(); return FReply::Handled(); });
 
+    SAssignNew(DiagnosticsButton, SButton)
+        .Text(LOCTEXT("Diagnostics", "Diagnostics"))
+        .ToolTipText(LOCTEXT("DiagnosticsTip", "Live pipeline graphs"))
+        .OnClicked_Lambda([]() { FGlobalTabmanager::Get()->TryInvokeTab(STwitchChatDiagnostics::TabName); return FReply::Handled(); });
+
     // Load table‐based emotes
     LoadEmoteBrushes();
+    RefreshChannelOptions();
 
     // Build layout
     ChildSlot
@@ -152,6 +209,42 @@ void STwitchChatWindow::Construct(const FArguments& /*InArgs*/)
                         + SHorizontalBox::Slot().AutoWidth().Padding(4, 0)[ConnectButton.ToSharedRef()]
                         + SHorizontalBox::Slot().AutoWidth().Padding(4, 0)[DisconnectButton.ToSharedRef()]
                         + SHorizontalBox::Slot().AutoWidth().Padding(4, 0)[ClearButton.ToSharedRef()]
+                        + SHorizontalBox::Slot().AutoWidth().Padding(4, 0)[DiagnosticsButton.ToSharedRef()]
+                ]
+
+                // Search row
+                + SVerticalBox::Slot().AutoHeight().Padding(2)
+                [
+                    SNew(SHorizontalBox)
+
+                        + SHorizontalBox::Slot().AutoWidth().Padding(0, 0, 4, 0)
+                        [
+                            SAssignNew(ChannelFilterCombo, SComboBox<TSharedPtr<FString>>)
+                                .OptionsSource(&ChannelOptions)
+                                .OnComboBoxOpening(this, &STwitchChatWindow::RefreshChannelOptions)
+                                .OnSelectionChanged(this, &STwitchChatWindow::OnChannelFilterChanged)
+                                .OnGenerateWidget_Lambda([](TSharedPtr<FString> Item)
+                                    {
+                                        return SNew(STextBlock).Text(Item->IsEmpty() ? LOCTEXT("AllChannels", "All channels") : FText::FromString(*Item));
+                                    })
+                                [
+                                    SNew(STextBlock)
+                                        .Text_Lambda([this]() { return ChannelFilter.IsEmpty() ? LOCTEXT("AllChannels", "All channels") : FText::FromString(ChannelFilter); })
+                                ]
+                        ]
+
+                        + SHorizontalBox::Slot().FillWidth(1)
+                        [
+                            SAssignNew(SearchBox, SSearchBox)
+                                .HintText(LOCTEXT("SearchHint", "Search chat history (words, @user, emote:id, in:channel)"))
+                                .OnTextChanged(this, &STwitchChatWindow::OnSearchTextChanged)
+                        ]
+
+                        + SHorizontalBox::Slot().AutoWidth().VAlign(VAlign_Center).Padding(6, 0, 2, 0)
+                        [
+                            SNew(STextBlock)
+                                .Text_Lambda([this]() { return IsSearching() ? SearchStatus : FText::GetEmpty(); })
+                        ]
                 ]
 
                 // Chat list
@@ -163,9 +256,19 @@ void STwitchChatWindow::Construct(const FArguments& /*InArgs*/)
                 ]
         ];
 
+    // Show what arrived before the window opened; those were painted elsewhere or never, so keep
+    // them out of the paint latency
+    for (FTwitchChatMessage& Msg : FTwitchChatRecentHistory::Get().GetRecent(GetDefault<UTwitchChatSettings>()->MaxMessages))
+    {
+        Msg.bPaintReported = true;
+        HandleIncoming(Msg);
+    }
+
     // Subscribe delegate
     MessageHandle = FTwitchChatConnection::Get()
         ->OnMessage.AddSP(this, &STwitchChatWindow::HandleIncoming);
+    MemoryHandle = FTwitchChatMemory::OnCollect.AddSP(this, &STwitchChatWindow::CollectMemory);
+    ImagesHandle = FTwitchChatImages::Get()->OnImagesLoaded.AddSPLambda(this, [this]() { bChatterImagesDirty = true; });
 
     // Start per-frame animation ticker
     AnimationTimerHandle = RegisterActiveTimer(
@@ -193,7 +296,13 @@ EActiveTimerReturnType STwitchChatWindow::HandleAnimationTick(double /*Now*/, fl
         }
     }
 
-    if (bNeedsRefresh && ListView.IsValid())
+    if (bChatterImagesDirty && ListView.IsValid())
+    {
+        // Rows already generated hold no badge slot for images that were still loading
+        bChatterImagesDirty = false;
+        ListView->RebuildList();
+    }
+    else if (bNeedsRefresh && ListView.IsValid())
     {
         ListView->RequestListRefresh();
     }
@@ -212,21 +321,90 @@ void STwitchChatWindow::Tick(const FGeometry& AllottedGeometry, double InCurrent
 //-----------------------------------------------------------------------------
 FText STwitchChatWindow::GetChannelLabel() const
 {
+    const TArray<FString> Channels = FTwitchChatConnection::Get()->GetChannels();
     return FText::Format(
         LOCTEXT("ChannelFmt", "Channel: {0}"),
-        FText::FromString(GetMutableDefault<UTwitchChatSettings>()->LastChannel)
+        FText::FromString(Channels.Num() > 0 ? FString::Join(Channels, TEXT(", ")) : GetMutableDefault<UTwitchChatSettings>()->LastChannel)
     );
 }
 
+bool STwitchChatWindow::PassesChannelFilter(const FTwitchChatMessage& Msg) const
+{
+    return ChannelFilter.IsEmpty() || Msg.ChannelLogin.Equals(ChannelFilter, ESearchCase::IgnoreCase) || Msg.ChannelId == ChannelFilter;
+}
+
+void STwitchChatWindow::RefreshChannelOptions()
+{
+    // Joined channels, plus any seen in the buffer (e.g. replayed traffic)
+    TArray<FString> Logins = FTwitchChatConnection::Get()->GetChannels();
+    for (const TSharedPtr<FTwitchChatMessage>& Msg : Messages)
+    {
+        if (!Msg->ChannelLogin.IsEmpty())
+            Logins.AddUnique(Msg->ChannelLogin.ToLower());
+    }
+
+    ChannelOptions.Reset();
+    ChannelOptions.Add(MakeShared<FString>());
+    for (const FString& Login : Logins)
+    {
+        ChannelOptions.Add(MakeShared<FString>(Login));
+    }
+    if (ChannelFilterCombo.IsValid())
+    {
+        ChannelFilterCombo->RefreshOptions();
+    }
+}
+
+void STwitchChatWindow::OnChannelFilterChanged(TSharedPtr<FString> Selected, ESelectInfo::Type /*SelectInfo*/)
+{
+    const FString NewFilter = Selected.IsValid() ? *Selected : FString();
+    if (NewFilter == ChannelFilter)
+        return;
+
+    ChannelFilter = NewFilter;
+    FilteredMessages.Reset();
+    if (!ChannelFilter.IsEmpty())
+    {
+        for (const TSharedPtr<FTwitchChatMessage>& Msg : Messages)
+        {
+            if (PassesChannelFilter(*Msg))
+                FilteredMessages.Add(Msg);
+        }
+    }
+
+    if (IsSearching())
+    {
+        ++SearchSerial;
+        RunSearch();
+        return;
+    }
+    ShowLiveMessages();
+}
+
+void STwitchChatWindow::ShowLiveMessages()
+{
+    if (!ListView.IsValid())
+        return;
+
+    TArray<TSharedPtr<FTwitchChatMessage>>& Live = GetLiveMessages();
+    ListView->SetItemsSource(&Live);
+    ListView->RequestListRefresh();
+    if (Live.Num() > 0) ListView->ScrollToBottom();
+}
+
 FSlateColor STwitchChatWindow::GetConnectionColor() const
 {
-    return FTwitchChatConnection::Get()->IsConnected()
-        ? FSlateColor(FLinearColor::Green)
+    TSharedRef<FTwitchChatConnection> Connection = FTwitchChatConnection::Get();
+    if (Connection->IsConnected())
+        return FSlateColor(FLinearColor::Green);
+    return Connection->IsConnecting()
+        ? FSlateColor(FLinearColor::Yellow)
         : FSlateColor(FLinearColor::Red);
 }
 
 void STwitchChatWindow::LoadEmoteBrushes()
 {
+    LLM_SCOPE_BYTAG(TwitchChat_EmoteCache);
     EmoteBrushes.Empty();
     if (auto Settings = GetMutableDefault<UTwitchChatSettings>())
     {
@@ -277,7 +455,7 @@ void STwitchChatWindow::OnConnectClicked()
         Async(EAsyncExecution::Thread, [S]()
             {
                 FTwitchChatConnection::Get()
-                    ->Connect(S->UserName, S->AccessToken, S->LastChannel, S->Port);
+                    ->Connect(S->UserName, S->GetAccessToken(), S->LastChannel, S->Port);
             });
     }
 }
@@ -287,34 +465,143 @@ void STwitchChatWindow::OnDisconnectClicked()
     FTwitchChatConnection::Get()->Disconnect();
 }
 
+void STwitchChatWindow::OnSearchTextChanged(const FText& InText)
+{
+    SearchQuery = InText.ToString().TrimStartAndEnd();
+    ++SearchSerial;
+
+    if (!IsSearching())
+    {
+        SearchResults.Empty();
+        ShowLiveMessages();
+        return;
+    }
+
+    RunSearch();
+}
+
+void STwitchChatWindow::RunSearch()
+{
+    // Query on a worker, one at a time; requests made meanwhile coalesce into one rerun
+    if (bSearchInFlight)
+    {
+        bSearchDirty = true;
+        return;
+    }
+    bSearchInFlight = true;
+
+    const uint32 Serial = SearchSerial;
+    TWeakPtr<SWidget> WeakSelf = AsShared();
+
+    // The index tags every message with in:<channel>, so the filter is just another term
+    const FString Query = ChannelFilter.IsEmpty() ? SearchQuery : SearchQuery + TEXT(" in:") + ChannelFilter;
+
+    Async(EAsyncExecution::ThreadPool, [WeakSelf, Serial, Query]()
+        {
+            FTwitchChatSearchIndex::FResult Result = FTwitchChatSearchIndex::Get()->Search(Query);
+            Algo::Reverse(Result.Messages);
+
+            AsyncTask(ENamedThreads::GameThread, [WeakSelf, Serial, Result = MoveTemp(Result)]() mutable
+                {
+                    TSharedPtr<SWidget> Pinned = WeakSelf.Pin();
+                    if (!Pinned.IsValid())
+                        return;
+
+                    STwitchChatWindow* Self = static_cast<STwitchChatWindow*>(Pinned.Get());
+                    Self->bSearchInFlight = false;
+                    if (Self->bSearchDirty && Self->IsSearching())
+                    {
+                        Self->bSearchDirty = false;
+                        Self->RunSearch();
+                    }
+                    if (Serial != Self->SearchSerial || !Self->IsSearching())
+                        return;
+
+                    Self->SearchResults = MoveTemp(Result.Messages);
+                    Self->SearchStatus = FText::Format(
+                        LOCTEXT("SearchStatusFmt", "{0} matches ({1} ms)"),
+                        FText::AsNumber(Result.TotalMatches),
+                        FText::AsNumber(FMath::RoundToInt(Result.Seconds * 1000.0)));
+
+                    if (Self->ListView.IsValid())
+                    {
+                        Self->ListView->SetItemsSource(&Self->SearchResults);
+                        Self->ListView->RequestListRefresh();
+                        if (Self->SearchResults.Num() > 0) Self->ListView->ScrollToBottom();
+                    }
+                });
+        });
+}
+
 void STwitchChatWindow::OnClearClicked()
 {
     Messages.Empty();
+    FilteredMessages.Empty();
     if (ListView.IsValid())
     {
         ListView->RequestListRefresh();
     }
 }
 
+void STwitchChatWindow::CollectMemory(TArray<FTwitchChatMemory::FLine>& Out) const
+{
+    FTwitchChatMemory::FLine MessageLine{ TEXT("Messages"), TEXT("chat window"), Messages.Num(), Messages.GetAllocatedSize() + FilteredMessages.GetAllocatedSize() };
+    for (const TSharedPtr<FTwitchChatMessage>& Msg : Messages)
+    {
+        MessageLine.Bytes += FTwitchChatMemory::GetMessageSize(*Msg);
+    }
+    Out.Add(MoveTemp(MessageLine));
+
+    // Brush structs only; the textures they point at are reported on their own
+    FTwitchChatMemory::FLine BrushLine{ TEXT("EmoteCache"), TEXT("chat window brushes"), EmoteBrushes.Num(), EmoteBrushes.GetAllocatedSize() };
+    for (const auto& Pair : EmoteBrushes)
+    {
+        BrushLine.Bytes += Pair.Key.GetAllocatedSize() + sizeof(FSlateDynamicImageBrush);
+    }
+    Out.Add(MoveTemp(BrushLine));
+}
+
 void STwitchChatWindow::HandleIncoming(const FTwitchChatMessage& Msg)
 {
+    LLM_SCOPE_BYTAG(TwitchChat_Messages);
     if (const auto S = GetDefault<UTwitchChatSettings>())
     {
         int32 Max = S->MaxMessages;
-        if (Max <= 0) { Messages.Empty(); }
+        if (Max <= 0) { Messages.Empty(); FilteredMessages.Empty(); }
         else
         {
-            Messages.Add(MakeShared<FTwitchChatMessage>(Msg));
+            TSharedPtr<FTwitchChatMessage> Item = MakeShared<FTwitchChatMessage>(Msg);
+            Messages.Add(Item);
             if (Messages.Num() > Max)
             {
                 Messages.RemoveAt(0, Messages.Num() - Max);
             }
+            // The filtered view keeps its own MaxMessages, so a quiet channel is not pushed out by a busy one
+            if (!ChannelFilter.IsEmpty() && PassesChannelFilter(Msg))
+            {
+                FilteredMessages.Add(MoveTemp(Item));
+                if (FilteredMessages.Num() > Max)
+                {
+                    FilteredMessages.RemoveAt(0, FilteredMessages.Num() - Max);
+                }
+            }
         }
+        SET_DWORD_STAT(STAT_TwitchChat_WindowMessages, Messages.Num());
+    }
+    if (!PassesChannelFilter(Msg))
+    {
+        return;
+    }
+    if (IsSearching())
+    {
+        // Keep live results current; the index already holds this message
+        RunSearch();
+        return;
     }
     if (ListView.IsValid())
     {
         ListView->RequestListRefresh();
-        if (Messages.Num() > 0) ListView->ScrollToBottom();
+        if (GetLiveMessages().Num() > 0) ListView->ScrollToBottom();
     }
 }
 
@@ -323,6 +610,8 @@ TSharedRef<ITableRow> STwitchChatWindow::OnGenerateRow(
     const TSharedRef<STableViewBase>& OwnerTable
 ) const
 {
+    SCOPE_CYCLE_COUNTER(STAT_TwitchChat_RowGeneration);
+
     struct FSeg { FString Id; int32 Start, End; };
     TArray<FSeg> Segs;
     for (int32 i = 0; i < Item->EmoteIds.Num(); ++i)
@@ -334,6 +623,35 @@ TSharedRef<ITableRow> STwitchChatWindow::OnGenerateRow(
     auto WrapAt = [this]() { return FMath::Max(0.f, ChatPanelWidth - 80.f); };
     TSharedRef<SWrapBox> Box = SNew(SWrapBox).UseAllottedSize(true);
 
+    Box->AddSlot()
+        [
+            SNew(STwitchChatPaintProbe, Item)
+        ];
+
+    // avatar and badges, from the shared atlas
+    if (Item->Chatter.IsValid() && GetDefault<UTwitchChatSettings>()->bShowChatterImages)
+    {
+        TSharedRef<FTwitchChatImages> Images = FTwitchChatImages::Get();
+        auto AddImage = [&Box](const FSlateBrush* Brush)
+            {
+                if (Brush)
+                {
+                    Box->AddSlot().VAlign(VAlign_Center).Padding(0, 0, 2, 0)
+                        [
+                            SNew(SBox).WidthOverride(16.f).HeightOverride(16.f)
+                                [
+                                    SNew(SImage).Image(Brush)
+                                ]
+                        ];
+                }
+            };
+        AddImage(Images->FindAvatar(Item->Chatter->UserId));
+        for (const FString& Badge : Item->Chatter->Badges)
+        {
+            AddImage(Images->FindBadge(Item->ChannelId, Badge));
+        }
+    }
+
     // username prefix
     Box->AddSlot().VAlign(VAlign_Center)
         [
@@ -360,14 +678,22 @@ TSharedRef<ITableRow> STwitchChatWindow::OnGenerateRow(
 
         // lookup brush
         TSharedPtr<FSlateBrush> Brush = EmoteBrushes.FindRef(Seg.Id);
-        if (!Brush)
+        if (Brush)
+        {
+            INC_DWORD_STAT(STAT_TwitchChat_EmoteBrushHits);
+            FTwitchChatMetrics::Inc(ETwitchChatCounter::EmoteBrushHits);
+        }
+        else
         {
+            INC_DWORD_STAT(STAT_TwitchChat_EmoteBrushMisses);
+            FTwitchChatMetrics::Inc(ETwitchChatCounter::EmoteBrushMisses);
             // fallback to disk
             const FString Path = FPaths::ProjectSavedDir() / TEXT("FetchedEmotes") / (Seg.Id + TEXT(".png"));
             if (FPaths::FileExists(Path))
             {
                 if (UTexture2D* Tex = LoadTextureFromDisk(Path))
                 {
+                    LLM_SCOPE_BYTAG(TwitchChat_EmoteCache);
                     auto NewB = MakeShared<FSlateImageBrush>(Tex, FVector2D(Tex->GetSizeX(), Tex->GetSizeY()));
                     const_cast<STwitchChatWindow*>(this)->EmoteBrushes.Add(Seg.Id, NewB);
                     Brush = NewB;
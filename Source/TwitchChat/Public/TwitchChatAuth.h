@@ -0,0 +1,104 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+
+class FJsonObject;
+
+/**
+ * Owns the user access token. Everything runs on the game thread off HTTP callbacks and a
+ * one second ticker; nothing blocks.
+ *
+ * - Device flow polling is a timer-driven state machine (authorization_pending / slow_down).
+ * - Refresh is single-flight: callers arriving while one is in flight wait for its result, and a
+ *   401 for a token that has since been replaced completes at once instead of rotating again.
+ * - The token is validated on load and hourly (as Twitch requires) and refreshed ahead of expiry,
+ *   so requests on the hot path carry a live token and do not pay for a 401 round trip.
+ */
+class TWITCHCHAT_API FTwitchChatAuth : public TSharedFromThis<FTwitchChatAuth>
+{
+public:
+    static TSharedRef<FTwitchChatAuth> Get();
+
+    static constexpr double RenewAheadSeconds = 300.0;
+    static constexpr double ValidateIntervalSeconds = 3600.0;
+
+    // Takes AccessToken/RefreshToken from settings ("oauth:" prefix allowed). Keeps the current
+    // validation if the token did not change.
+    void LoadFromSettings();
+
+    bool HasToken() const { return !AccessToken.IsEmpty(); }
+    const FString& GetAccessToken() const { return AccessToken; }
+
+    // From the last validation; empty until then
+    const FString& GetLogin() const { return Login; }
+    const FString& GetUserId() const { return UserId; }
+    const TArray<FString>& GetScopes() const { return Scopes; }
+
+    // Negative when the token does not expire or has not been validated yet
+    double GetSecondsToExpiry() const;
+
+    // Login, user id and expiry come from an earlier run's validation (see FTwitchChatWarmStart)
+    // and have not been confirmed in this one yet
+    bool IsWarm() const { return bWarm && !bValidated; }
+
+    // Calls back once the token is validated and not about to expire, validating or refreshing
+    // first if needed. False when there is no usable token.
+    void WhenValid(TFunction<void(bool)> OnReady);
+
+    // Single-flight refresh. RejectedToken is the token a request failed with; if the current
+    // token is already newer, OnComplete runs immediately with true.
+    void Refresh(TFunction<void(bool)> OnComplete, const FString& RejectedToken = FString());
+
+    // OnComplete gets true once the user approved and the tokens were saved
+    void StartDeviceFlow(TFunction<void(bool)> OnComplete);
+    void CancelDeviceFlow();
+    // From the /oauth2/device request on, so a second caller joins the flow instead of starting another
+    bool IsDeviceFlowActive() const { return bDeviceFlowActive; }
+    const FString& GetUserCode() const { return UserCode; }
+    const FString& GetVerificationUri() const { return VerificationUri; }
+
+    // Removes the ticker; called by the module before the core ticker goes away
+    void Shutdown();
+
+private:
+    void EnsureTicker();
+    bool Tick(float DeltaTime);
+
+    void Validate();
+    void StartRefresh();
+    void PollDeviceToken();
+    void StoreTokens(const FJsonObject& Json);
+    void RememberToken() const;
+    void CompleteWaiters(bool bSuccess);
+    void FinishDeviceFlow(bool bSuccess);
+
+    FString AccessToken;
+    FString RefreshToken;
+    FString Login;
+    FString UserId;
+    TArray<FString> Scopes;
+    double ExpiresAt = 0.0;             // FPlatformTime::Seconds(); 0 when unknown or never
+    double NextValidateTime = 0.0;
+    double NextRefreshTime = 0.0;       // background renewal retry after a failure
+    bool bValidated = false;
+    bool bWarm = false;
+
+    // Validate or refresh in flight; everyone in Waiters gets its outcome
+    bool bBusy = false;
+    TArray<TFunction<void(bool)>> Waiters;
+
+    // Device flow
+    FString DeviceCode;
+    FString UserCode;
+    FString VerificationUri;
+    double PollIntervalSeconds = 5.0;
+    double NextPollTime = 0.0;
+    double DeviceFlowExpiry = 0.0;
+    bool bPollInFlight = false;
+    bool bDeviceFlowActive = false;
+    uint32 DeviceFlowSerial = 0;        // bumped per flow so a cancelled flow's late /oauth2/device reply is ignored
+    TFunction<void(bool)> OnDeviceFlowDone;
+
+    FTSTicker::FDelegateHandle TickHandle;
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "TwitchChatBenchCommandlet.generated.h"
+
+/**
+ * Runs the chat ingest pipeline without the editor UI and prints a performance report.
+ *
+ *   UnrealEditor-Cmd <Project> -run=TwitchChatBench -nullrhi [-replay=File.tcrec]
+ *       [-scenarios=default,emote,long,reply] [-rates=250,1000,4000,0] [-seconds=5]
+ *       [-messages=20000] [-inflight=1024] [-out=Results.json] [-history] [-nodecode] [-noemulator]
+ *
+ * Frames come from the recording when -replay is given, otherwise from the synthetic
+ * scenarios. Emotes are fetched from the local emulator unless -noemulator is passed,
+ * then decoded on first sight; -history also writes every message to the history log.
+ */
+UCLASS()
+class UTwitchChatBenchCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UTwitchChatBenchCommandlet();
+
+    virtual int32 Main(const FString& Params) override;
+};
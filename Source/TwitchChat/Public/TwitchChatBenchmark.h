@@ -0,0 +1,111 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+#include "Containers/Ticker.h"
+#include "TwitchChatMessage.h"
+
+class FTwitchChatConnection;
+
+/**
+ * End-to-end ingest benchmark. Feeds synthetic (or recorded) EventSub frames into
+ * FTwitchChatConnection::IngestFrame at a series of target rates and measures, per
+ * scenario and rate, the sustained throughput, frame-receipt to OnMessage latency
+ * percentiles, allocations per message and peak memory. Results are written as JSON.
+ *
+ * Driven by the core ticker; the frame producer runs on its own thread.
+ */
+class TWITCHCHAT_API FTwitchChatBenchmark : public TSharedFromThis<FTwitchChatBenchmark>
+{
+public:
+    struct FOptions
+    {
+        TArray<FString> Scenarios = { TEXT("default"), TEXT("emote"), TEXT("long"), TEXT("reply") };
+        TArray<float>   Rates = { 250.f, 1000.f, 4000.f, 0.f };   // messages/s, 0 = as fast as accepted
+        float   StepSeconds = 5.f;
+        int32   MaxSpeedMessages = 20000;
+        int32   MaxInFlight = 1024;
+        FString ReplayPath;        // use frames from a .tcrec recording instead of the scenarios
+        FString OutputPath;        // defaults to Saved/TwitchChatBench/Bench_<time>.json
+        bool    bUseEmulator = true;   // serve emote downloads from the local emulator
+
+        // key=value arguments: scenarios=a,b rates=250,0 seconds=5 messages=N inflight=N replay=Path out=Path emulator=0|1
+        static FOptions FromArgs(const TArray<FString>& Args);
+    };
+
+    struct FStepResult
+    {
+        FString Scenario;
+        float   TargetRate = 0.f;
+        int32   Sent = 0;
+        int32   Delivered = 0;
+        double  Seconds = 0.0;
+        double  Throughput = 0.0;
+        double  P50Ms = 0.0;
+        double  P99Ms = 0.0;
+        double  P999Ms = 0.0;
+        double  MaxMs = 0.0;
+        double  AllocsPerMessage = -1.0;   // -1 when the allocator does not count calls
+        uint64  PeakUsedPhysical = 0;
+        int64   PeakDeltaBytes = 0;        // peak over the usage at step start
+    };
+
+    DECLARE_DELEGATE_OneParam(FOnFinished, const FTwitchChatBenchmark&);
+
+    static TSharedPtr<FTwitchChatBenchmark> GetActive();
+    static TSharedPtr<FTwitchChatBenchmark> StartActive(const FOptions& InOptions);
+
+    FTwitchChatBenchmark(TSharedRef<FTwitchChatConnection> InConnection, const FOptions& InOptions);
+    ~FTwitchChatBenchmark();
+
+    bool Start();
+    void Cancel();
+    bool IsRunning() const { return bRunning; }
+
+    const TArray<FStepResult>& GetResults() const { return Results; }
+    const FString& GetOutputPath() const { return Options.OutputPath; }
+    FString ToJson() const;
+
+    // Fired on the game thread once every step has run (or after Cancel).
+    FOnFinished OnFinished;
+
+    bool Tick(float DeltaTime);
+
+private:
+    struct FStep
+    {
+        FString Scenario;
+        float   Rate = 0.f;
+    };
+
+    void BeginStep();
+    void EndStep();
+    void Finish();
+    void HandleMessage(const FTwitchChatMessage& Msg);
+    TSharedRef<TArray<FString>> BuildFrames(const FStep& Step) const;
+
+    TSharedRef<FTwitchChatConnection> Connection;
+    FOptions Options;
+
+    TArray<FStep> Steps;
+    int32 StepIndex = INDEX_NONE;
+    TArray<FStepResult> Results;
+    TArray<FString> ReplayFrames;
+
+    // Current step
+    TArray<double> Latencies;
+    double StepStart = 0.0;
+    double LastDelivery = 0.0;
+    uint64 StepAllocs = 0;
+    uint64 StepBaseMemory = 0;
+    uint64 StepPeakMemory = 0;
+    int32  DrainTicks = 0;
+    std::atomic<int32> Sent{ 0 };
+    std::atomic<bool>  bProducerDone{ false };
+    std::atomic<bool>  bCancelled{ false };
+
+    bool bRunning = false;
+    bool bStartedEmulator = false;
+    FDelegateHandle MessageHandle;
+    FTSTicker::FDelegateHandle TickHandle;
+};
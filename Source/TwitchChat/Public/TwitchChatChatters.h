@@ -0,0 +1,78 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/LruCache.h"
+#include "Misc/DateTime.h"
+#include <atomic>
+
+/**
+ * What is known about one chatter, shared by every message they send. Immutable once
+ * published except for the last-seen time and message count; a change of name, color or
+ * badges publishes a new entry, so a message keeps the look it was sent with.
+ */
+struct TWITCHCHAT_API FTwitchChatChatter
+{
+    FString UserId;
+    FString UserName;
+    FString ColorHex;           // as sent; empty when the chatter never picked a color
+    FLinearColor Color = FLinearColor::White;
+    TArray<FString> Badges;     // "set_id/id", e.g. "subscriber/12"
+    FDateTime FirstSeen;
+
+    bool HasBadge(const FString& SetId) const;
+    FDateTime GetLastSeen() const { return FDateTime(LastSeenTicks.load(std::memory_order_relaxed)); }
+    int64 GetMessageCount() const { return MessageCount.load(std::memory_order_relaxed); }
+
+private:
+    friend class FTwitchChatChatters;
+
+    mutable std::atomic<int64> LastSeenTicks{ 0 };
+    mutable std::atomic<int64> MessageCount{ 0 };
+};
+
+using FTwitchChatChatterRef = TSharedRef<const FTwitchChatChatter, ESPMode::ThreadSafe>;
+using FTwitchChatChatterPtr = TSharedPtr<const FTwitchChatChatter, ESPMode::ThreadSafe>;
+
+/**
+ * LRU cache of chatters keyed by user id, filled from the parse workers. A chatter's color is
+ * parsed and their badges split once, not on every message, and messages point at the shared
+ * entry. Holds ChatterCacheSize entries; the least recently seen chatter is dropped first.
+ */
+class TWITCHCHAT_API FTwitchChatChatters
+{
+public:
+    static FTwitchChatChatters& Get();
+
+    static constexpr const TCHAR* DefaultColor = TEXT("#6441A4");
+
+    // Any thread. The entry for UserId, created or replaced when the name, color or badges
+    // (comma separated "set_id/id") differ from the cached ones; stamps SeenAt as last seen.
+    FTwitchChatChatterRef Touch(const FString& UserId, FStringView UserName, FStringView ColorHex, FStringView Badges, const FDateTime& SeenAt);
+
+    // Any thread; does not count as a sighting
+    FTwitchChatChatterPtr Find(const FString& UserId) const;
+
+    void Clear();
+
+    int32 Num() const;
+    SIZE_T GetAllocatedSize() const;
+
+    struct FStats
+    {
+        uint64 Hits = 0;
+        uint64 Misses = 0;      // new chatters, and known ones whose name, color or badges changed
+        uint64 Evictions = 0;
+    };
+    FStats GetStats() const;
+
+private:
+    FTwitchChatChatters();
+
+    static FTwitchChatChatterRef Make(const FString& UserId, FStringView UserName, FStringView ColorHex, FStringView Badges,
+        const FDateTime& FirstSeen);
+    static bool Matches(const FTwitchChatChatter& Chatter, FStringView UserName, FStringView ColorHex, FStringView Badges);
+
+    mutable FCriticalSection Lock;
+    TLruCache<FString, FTwitchChatChatterPtr> Cache;
+    FStats Stats;
+};
@@ -4,6 +4,7 @@
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
 #include "TwitchChatMessage.h"
+#include "TwitchChatEvents.h"
 #include "TwitchChatComponent.generated.h"
 
 
@@ -68,8 +69,29 @@ struct FBP_TwitchChatMessage
     UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Message", Meta = (DisplayName = "User Type"))
     FString               UserType;
 
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Message", Meta = (DisplayName = "Channel Id"))
+    FString               ChannelId;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Message", Meta = (DisplayName = "Channel"))
+    FString               ChannelLogin;
+
+    // "set_id/id", e.g. "subscriber/12"; see TwitchChat_GetBadgeBrush
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Message", Meta = (DisplayName = "Badges"))
+    TArray<FString> Badges;
+
     UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Message", Meta = (DisplayName = "Raw Payload"))
     FString RawPayload;
+
+    // Pipeline stamps carried through to UTwitchChatLibrary::TwitchChat_ReportMessagePainted.
+    // Times are FPlatformTime seconds; ingest is Twitch's send time to receipt, -1 when unknown.
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Message", Meta = (DisplayName = "Received Time"))
+    double ReceivedTime = 0.0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Message", Meta = (DisplayName = "Dispatch Time"))
+    double DispatchTime = 0.0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Message", Meta = (DisplayName = "Ingest Seconds"))
+    double IngestSeconds = -1.0;
 };
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(
@@ -77,6 +99,14 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(
     const FBP_TwitchChatMessage&, ChatMessage
 );
 
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnTwitchChatCheer, const FTwitchChatCheerEvent&, Event);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnTwitchChatSubscribe, const FTwitchChatSubscribeEvent&, Event);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnTwitchChatResubscribe, const FTwitchChatResubscribeEvent&, Event);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnTwitchChatGiftSubscription, const FTwitchChatGiftEvent&, Event);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnTwitchChatRaid, const FTwitchChatRaidEvent&, Event);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnTwitchChatRedemption, const FTwitchChatRedemptionEvent&, Event);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnTwitchChatNotification, const FTwitchChatNotificationEvent&, Event);
+
 
 UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
 class TWITCHCHAT_API UTwitchChatComponent : public UActorComponent
@@ -90,6 +120,45 @@ public:
     UPROPERTY(BlueprintAssignable, Category = "Twitch Chat", Meta = (DisplayName = "On New Chat Message"))
     FOnTwitchChatMessage OnChatMessageReceived;
 
+    // EventSub events; only those listed under Subscribed Events in the plugin settings arrive
+    UPROPERTY(BlueprintAssignable, Category = "Twitch Chat|Events")
+    FOnTwitchChatCheer OnCheer;
+
+    UPROPERTY(BlueprintAssignable, Category = "Twitch Chat|Events")
+    FOnTwitchChatSubscribe OnSubscribe;
+
+    UPROPERTY(BlueprintAssignable, Category = "Twitch Chat|Events")
+    FOnTwitchChatResubscribe OnResubscribe;
+
+    UPROPERTY(BlueprintAssignable, Category = "Twitch Chat|Events")
+    FOnTwitchChatGiftSubscription OnGiftSubscription;
+
+    UPROPERTY(BlueprintAssignable, Category = "Twitch Chat|Events")
+    FOnTwitchChatRaid OnRaid;
+
+    UPROPERTY(BlueprintAssignable, Category = "Twitch Chat|Events")
+    FOnTwitchChatRedemption OnRedemption;
+
+    UPROPERTY(BlueprintAssignable, Category = "Twitch Chat|Events")
+    FOnTwitchChatNotification OnChatNotification;
+
+    // Channel logins or ids to receive; empty receives every channel on the session
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Twitch Chat", Meta = (DisplayName = "Channel Filter"))
+    TArray<FString> ChannelFilter;
+
+    // Messages already received before BeginPlay to replay through On New Chat Message (oldest
+    // first, before any live one); up to Recent Messages Kept in the plugin settings
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Twitch Chat", Meta = (DisplayName = "Backfill Messages", ClampMin = "0"))
+    int32 BackfillMessages = 0;
+
+    UFUNCTION(BlueprintPure, Category = "Twitch Chat")
+    bool AcceptsChannel(const FString& ChannelLoginOrId) const;
+
+    // The newest messages this component's channel filter accepts, oldest first; User (id or
+    // name) narrows to one chatter when set
+    UFUNCTION(BlueprintCallable, Category = "Twitch Chat")
+    TArray<FBP_TwitchChatMessage> GetRecentMessages(int32 MaxMessages, const FString& User) const;
+
 protected:
     virtual void BeginPlay() override;
     virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+#include "HAL/Runnable.h"
+#include "Containers/Queue.h"
+#include "Containers/Ticker.h"
+#include "Interfaces/IHttpRequest.h"
+#include "TwitchChatConnection.h"
+
+class IWebSocket;
+class FJsonObject;
+
+/**
+ * EventSub conduit with several WebSocket shards. Subscriptions are made against the conduit
+ * and Twitch spreads their notifications over the enabled shards. Each shard parses its frames
+ * on its own worker thread. The game thread merges the results back into one stream ordered by
+ * send time, holding messages for a short reorder window.
+ *
+ * A shard that drops reconnects on its own and is then re-bound to its shard id. Subscriptions
+ * belong to the conduit rather than to a session, so nothing is resubscribed and the other
+ * shards keep delivering. Conduit calls need an app access token (client credentials).
+ */
+class TWITCHCHAT_API FTwitchChatConduit : public TSharedFromThis<FTwitchChatConduit>
+{
+public:
+    struct FShardStatus
+    {
+        int32 Index = 0;
+        FString SessionId;
+        bool bEnabled = false;
+        int64 FramesReceived = 0;
+        int32 QueueDepth = 0;
+        int32 Reconnects = 0;
+    };
+
+    // How long a parsed message may wait for earlier messages from slower shards
+    static constexpr double ReorderWindowSeconds = 0.1;
+    static constexpr int32 MaxShards = 64;
+
+    explicit FTwitchChatConduit(FTwitchChatConnection& InConnection);
+    ~FTwitchChatConduit();
+
+    // Game thread. Gets an app token, finds or creates the conduit, then opens the shards.
+    void Start(int32 InShardCount);
+    void Stop();
+
+    // True once the conduit exists and at least one shard is bound to it
+    bool IsReady() const;
+    const FString& GetConduitId() const { return ConduitId; }
+    const FString& GetAppToken() const { return AppToken; }
+
+    int32 GetNumShards() const { return Shards.Num(); }
+    int32 GetNumEnabledShards() const;
+    TArray<FShardStatus> GetShardStatus() const;
+
+private:
+    class FWorker;
+
+    struct FFrame
+    {
+        FString Text;
+        FTwitchChatConnection::FFrameStamp Stamp;
+    };
+
+    struct FShard
+    {
+        int32 Index = 0;
+        TSharedPtr<IWebSocket> Socket;
+        TSharedPtr<IWebSocket> PendingSocket;   // session_reconnect target
+        FString SessionId;
+        bool bEnabled = false;
+        bool bBackoff = false;
+        double LastActivityTime = 0.0;
+        double MigrationStartTime = 0.0;
+        double NextReconnectTime = 0.0;
+        int32 KeepaliveSeconds = 0;
+        int32 ReconnectAttempt = 0;
+        int32 Reconnects = 0;
+        std::atomic<int64> FramesReceived{ 0 };
+        TUniquePtr<FWorker> Worker;
+    };
+
+    // Ordered by send time, then receipt
+    struct FPendingMessage
+    {
+        FTwitchChatMessage Message;
+        double ReleaseTime = 0.0;
+    };
+
+    void RequestAppToken();
+    void AcquireConduit();
+    void OpenShards();
+
+    void OpenShardSocket(FShard& Shard, const FString& Url, bool bPending);
+    bool IsShardSocket(int32 Index, const TWeakPtr<IWebSocket>& InSocket) const;
+    void HandleShardFrame(int32 Index, const FString& Frame);
+    void HandleShardSession(int32 Index, const FString& MessageType, TSharedPtr<FJsonObject> Root);
+    void HandleShardLost(FShard& Shard, const FString& Reason);
+    void BindShard(FShard& Shard);
+    static void CloseShardSocket(TSharedPtr<IWebSocket>& InSocket);
+
+    TSharedRef<IHttpRequest, ESPMode::ThreadSafe> MakeHelixRequest(const FString& Verb, const FString& Path) const;
+
+    bool Tick(float DeltaTime);
+    void ReleaseMessages(bool bFlushAll);
+
+    FTwitchChatConnection& Connection;
+    int32 ShardCount = 1;
+    bool bStarted = false;
+    FString AppToken;
+    FString ConduitId;
+    TArray<TUniquePtr<FShard>> Shards;
+    FTSTicker::FDelegateHandle TickHandle;
+
+    // Shard workers produce, the game thread merges
+    TQueue<FTwitchChatMessage, EQueueMode::Mpsc> Parsed;
+    TArray<FPendingMessage> ReorderHeap;
+};
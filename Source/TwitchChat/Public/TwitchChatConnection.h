@@ -2,12 +2,47 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include <atomic>
 #include "IWebSocket.h"
 #include "Delegates/Delegate.h"
+#include "Containers/Ticker.h"
+#include "Interfaces/IHttpRequest.h"
 #include "TwitchChatMessage.h"
+#include "TwitchChatDedup.h"
+#include "TwitchChatExecutor.h"
+
+class FJsonObject;
+class FTwitchChatConduit;
+class FTwitchChatIrc;
+
+enum class ETwitchChatConnectionState : uint8
+{
+    Disconnected,
+    Authorizing,    // validating the token, refreshing it or waiting on the device flow
+    Connecting,     // socket opening, waiting for session_welcome
+    Subscribing,    // welcome received, channel.chat.message not yet accepted
+    Connected,
+    Migrating,      // session_reconnect: new socket opening while the old one still delivers
+    Backoff,        // session lost; retrying after a jittered delay
+};
+
+// Milestones of one Connect, in the order they usually happen; several overlap
+enum class ETwitchChatConnectStage : uint8
+{
+    Connect,
+    TokenReady,     // validated, refreshed or authorized; after the socket on a warm start
+    SocketOpen,     // WebSocket handshake done
+    SessionReady,   // session_welcome, or the first conduit shard bound
+    IdsResolved,    // bot and channel user ids known
+    SubscribeSent,
+    Subscribed,     // first subscription accepted
+    FirstMessage,   // first chat message dispatched
+    Num
+};
 
 DECLARE_LOG_CATEGORY_EXTERN(LogTwitchChat, Log, All);
 DECLARE_MULTICAST_DELEGATE_OneParam(FTwitchChatMessageDelegate, const FTwitchChatMessage&);
+DECLARE_MULTICAST_DELEGATE_OneParam(FTwitchChatStateDelegate, ETwitchChatConnectionState);
 
 
 class FTwitchChatConnection : public TSharedFromThis<FTwitchChatConnection>
@@ -20,16 +55,44 @@ public:
     static TSharedRef<FTwitchChatConnection> Get();
 
 
+    // InChannel may list several channels separated by commas or spaces
     bool Connect(const FString& InUser,
         const FString& InToken,
         const FString& InChannel,
         int32 InPort);
 
-    
+    // Off the game thread it is posted there, as Connect is, and takes effect on the next drain
     void Disconnect();
 
+    // Disconnects and joins the frame parser; the module calls this on shutdown
+    void Shutdown();
+
+
+    bool IsConnected() const { return State == ETwitchChatConnectionState::Connected || State == ETwitchChatConnectionState::Migrating; }
+    bool IsConnecting() const { return State != ETwitchChatConnectionState::Disconnected && !IsConnected(); }
+
+    // Channels share the one EventSub session; joining or leaving only adds or deletes a subscription.
+    // Game thread.
+    bool AddChannel(const FString& Login);
+    bool RemoveChannel(const FString& Login);
+    void SetChannels(const TArray<FString>& Logins);
+    TArray<FString> GetChannels() const;
+    bool IsChannelSubscribed(const FString& Login) const;
 
-    bool IsConnected() const { return Socket.IsValid() && bSubscribed; }
+    static TArray<FString> ParseChannelList(const FString& List);
+
+    // EventSub WebSocket limit on enabled subscriptions per session
+    static constexpr int32 MaxChannelsPerSession = 300;
+
+    ETwitchChatConnectionState GetState() const { return State; }
+    static const TCHAR* GetStateName(ETwitchChatConnectionState InState);
+    static const TCHAR* GetTransportName(ETwitchChatTransport Transport);
+
+    // True while EventSub and IRC both deliver and duplicates are being dropped
+    bool IsHedging() const { return bHedging.load(std::memory_order_relaxed); }
+
+    // Game thread
+    FTwitchChatStateDelegate OnStateChanged;
 
  
     FTwitchChatMessageDelegate OnMessage;
@@ -37,51 +100,216 @@ public:
   
     void StartDeviceFlowInteractive();
 
+    // Raw traffic capture of every frame received on the socket
+    bool StartRecording(const FString& Path);
+    void StopRecording();
+    bool IsRecording() const;
+
+    // Feeds a raw EventSub frame into the parse/dispatch pipeline as if it came off the socket.
+    void IngestFrame(const FString& Frame);
+
+    // Any thread. The message of a channel.chat.message frame, parsed token by token with arena
+    // scratch (bArena) or through the JSON DOM; false for any other frame. Touches the chatter
+    // cache but nothing else, so benchmarks can call it directly.
+    static bool ParseChatFrame(const FString& Frame, FTwitchChatMessage& Out, bool bArena);
+
+    // While replaying, welcome frames do not trigger Helix subscriptions.
+    void BeginReplay();
+    void EndReplay();
+    bool IsReplaying() const { return bReplaying.load(std::memory_order_relaxed); }
+
+    int32 GetNumFramesInFlight() const { return FramesInFlight.load(); }
+    // Results from worker and socket threads not yet applied on the game thread
+    int32 GetNumPostedTasks() const { return Executor->GetQueueDepth(); }
+
+    // Seconds from Connect to each stage of the latest connect; negative if not reached (yet)
+    double GetConnectStageTime(ETwitchChatConnectStage Stage) const;
+    static const TCHAR* GetConnectStageName(ETwitchChatConnectStage Stage);
+    // The socket was opened on a token validation and user ids saved by an earlier run
+    bool WasWarmStart() const { return bWarmStart; }
+    void LogConnectTimeline() const;
+
+    // Valid while connected through an EventSub conduit (bUseConduit)
+    TSharedPtr<FTwitchChatConduit> GetConduit() const { return Conduit; }
+
 private:
+    friend class FTwitchChatConduit;
+    friend class FTwitchChatIrc;
+
+    struct FFrameStamp
+    {
+        double ReceivedTime = 0.0;
+        FDateTime ReceivedUtc;
+        uint32 Serial = 0;
+        uint32 Epoch = 0;
+    };
 
     void BeginAuthFlow();
 
-    void StartDeviceFlow();
+    // Token is valid: look up ids and open the transports
+    void OpenSession();
 
     void SetupWebSocket();
+    TSharedPtr<IWebSocket> OpenSocket(const FString& Url);
+    void CloseSocket(TSharedPtr<IWebSocket>& InSocket);
+    bool IsCurrentSocket(const TWeakPtr<IWebSocket>& InSocket) const;
+
+    void SetState(ETwitchChatConnectionState NewState);
 
-    void PollDeviceToken();
+    // Any thread. Every change to connection state from another thread goes through here and runs
+    // on the game thread in post order; Task is dropped if Disconnect ended PostEpoch's session first.
+    void Post(uint32 PostEpoch, TUniqueFunction<void()>&& Task);
+    uint32 GetEpoch() const { return Epoch.load(std::memory_order_relaxed); }
+    // Game thread; true the first time Stage is reached after Connect
+    bool MarkConnectStage(ETwitchChatConnectStage Stage);
+    bool TickConnection(float DeltaTime);
+    void HandleSessionLost(const FString& Reason);
+    void Reconnect();
+    static double GetReconnectDelay(int32 Attempt);
 
+    // session_welcome, session_reconnect and revocation; game thread
+    void HandleSessionMessage(const FString& MessageType, TSharedPtr<FJsonObject> Root);
 
     void QueryUserId(const FString& Login, TFunction<void(const FString&)> Callback);
 
 
     void TrySubscribe();
+    void Subscribe(const FString& Login);
+    // The events chosen in settings; best effort, they do not hold up Connected
+    void SubscribeEvents(const FString& Login);
+    FString MakeSubscriptionBody(const TCHAR* Type, const TCHAR* Version, const TSharedRef<FJsonObject>& Condition) const;
+    void DeleteSubscription(const FString& SubscriptionId);
+    void AdoptSubscription(const FString& Login);
+    // Conduit subscriptions are made with the app token, websocket ones with the user token
+    void SendSubscriptionRequest(const FString& Verb, const FString& Path, const FString& Body, TFunction<void(FHttpRequestPtr, FHttpResponsePtr, bool)> OnComplete);
+    void StopConduit();
+    void ResolveChannel(const FString& Login);
+    void ResetSubscriptions();
+    void UpdateSubscribedState();
 
 
+    void HandleSocketFrame(const FString& Frame);
     void HandleWebSocketMessage(const FString& Msg);
+    // Parse worker: ProcessFrame with every result posted to the game thread
+    void ParseAndPost(const FString& MsgJson, const FFrameStamp& Stamp);
+    void CountFrame(const FString& Frame);
+
+    // Receipt stamp; every stamped frame must go through ProcessFrame exactly once
+    FFrameStamp StampFrame();
+
+    // Worker side of the pipeline: parse, index, start emote downloads. Session frames go to OnSession,
+    // chat to OnChat and other events (as their game-thread broadcast) to OnEvent, all on the calling thread.
+    void ProcessFrame(const FString& Frame, const FFrameStamp& Stamp,
+        TFunctionRef<void(const FString&, TSharedPtr<FJsonObject>)> OnSession,
+        TFunctionRef<void(FTwitchChatMessage&&)> OnChat,
+        TFunctionRef<void(TUniqueFunction<void()>&&)> OnEvent);
+
+    // Chatter name, color and badges as sent; resolved through the chatter cache once the message is admitted
+    struct FChatterFields;
+
+    // channel.chat.message from its JSON DOM; also takes the older "text"/"emotes" event shape
+    static void DecodeChat(const FJsonObject& Meta, const FJsonObject& Evt, FTwitchChatMessage& M, FChatterFields& Chatter);
+
+    // channel.chat.message without a DOM; scratch goes on the thread's FMemStack and is released in one
+    // pop per frame. The stack's pages stay with the thread, so this pays off on long-lived callers only:
+    // the parse worker and the conduit shard workers. False for anything else (or an unexpected shape),
+    // which the DOM path then handles.
+    static bool StreamChat(const FString& Frame, FTwitchChatMessage& M, FChatterFields& Chatter);
+
+    static void ResolveChatter(FTwitchChatMessage& M, const FChatterFields& Chatter);
+
+    // Worker side, shared by both parse paths: stamps, hedging, chatter cache, emote downloads, FinishMessage
+    void DeliverChat(FTwitchChatMessage& M, const FChatterFields& Chatter, const FString& MsgJson, const FFrameStamp& Stamp,
+        TFunctionRef<void(FTwitchChatMessage&&)> OnChat);
 
+    // Worker side, after parsing: history and search index
+    void FinishMessage(FTwitchChatMessage& M);
 
+    // Game thread. Dispatches M now, or parks it behind its channel's earlier messages until its
+    // emote downloads finish or EmoteRenderTimeoutSeconds pass; a channel's messages stay in order.
+    void DispatchWhenReady(FTwitchChatMessage&& M);
+    bool IsWaitingForEmotes(const FTwitchChatMessage& M) const;
+    void ReleaseParked();
+
+    // Game thread
+    void DispatchMessage(FTwitchChatMessage& M);
+
+    void StartIrc();
+    void StopIrc();
+    // IRC reader thread
+    void HandleIrcMessage(FTwitchChatMessage&& M);
+    // Parse worker: the IRC counterpart of DeliverChat's tail
+    void FinishIrcMessage(FTwitchChatMessage&& M, uint32 SessionEpoch);
+    // Game thread
+    void HandleIrcStatus(bool bJoined);
+
+    // Any thread; false when the other transport (or a redelivery) already brought this id
+    bool AdmitHedged(const FString& MessageId, ETwitchChatTransport Transport, double ReceivedTime);
+
+
+    // Any thread. True when the emote is already on disk; otherwise starts its download, or joins
+    // the one in flight, and DispatchWhenReady holds messages using it until that completes.
     bool DownloadEmoteIfNeeded(const FString& EmoteId);
-    bool AllEmotesDownloaded(const TArray<FString>& EmoteIds, double Deadline);
+
+    struct FParkedMessage
+    {
+        FTwitchChatMessage Message;
+        double Deadline = 0.0;
+    };
+    mutable FCriticalSection EmoteFetchLock;
+    TSet<FString> EmoteFetches;                 // emote ids downloading
+    TMap<FString, TArray<FParkedMessage>> ParkedByChannel;     // game thread; oldest first
+    FTSTicker::FDelegateHandle ParkedTickHandle;
 
     TSharedPtr<IWebSocket> Socket;
-    bool bSubscribed = false;
+    TSharedPtr<IWebSocket> PendingSocket;       // session_reconnect target until its welcome arrives
+    TSharedPtr<FTwitchChatConduit> Conduit;     // replaces Socket when sharding through a conduit
+    TUniquePtr<FTwitchChatIrc> Irc;             // bUseIrc; runs beside (or instead of) EventSub
+    FTwitchChatDedup Dedup;
+    std::atomic<bool> bHedging{ false };
+    TSharedRef<FTwitchChatExecutor> Executor;
+    std::atomic<uint32> Epoch{ 0 };             // bumped by Disconnect
+    ETwitchChatConnectionState State = ETwitchChatConnectionState::Disconnected;
+    FTSTicker::FDelegateHandle TickHandle;
+    double LastActivityTime = 0.0;
+    double MigrationStartTime = 0.0;
+    double NextReconnectTime = 0.0;
+    int32 SessionKeepaliveSeconds = 0;          // from session_welcome; 0 until known
+    int32 ReconnectAttempt = 0;
+    uint32 SubscriptionGeneration = 0;          // bumped per session so late Helix replies are ignored
+    double ConnectStageTimes[int32(ETwitchChatConnectStage::Num)] = {};   // FPlatformTime::Seconds(); 0 until reached
+    bool bWarmStart = false;
+    std::atomic<bool> bReplaying{ false };     // StampFrame reads it on replay and benchmark threads
+
+    TUniquePtr<class FTwitchChatTrafficRecorder> Recorder;
+    std::atomic<int32> FramesInFlight{ 0 };
+
+    // Socket and IngestFrame frames, parsed one at a time in arrival order on one long-lived thread
+    class FParseWorker;
+    TUniquePtr<FParseWorker> ParseWorker;
 
  
     FString BotLogin;
-    FString ChannelLogin;
-    FString OAuthToken;
     FString BotUserId;
-    FString BroadcasterUserId;
     FString SessionId;
     bool bGotBotId = false;
-    bool bGotBroadcasterId = false;
     bool bGotWelcome = false;
 
-    // Device flow
-    FString DeviceCode;
-    FString UserCode;
-    FString VerificationUri;
-    int32  PollIntervalSeconds = 5;
-    double DeviceFlowExpiry = 0.0;
+    struct FChannel
+    {
+        FString Login;              // lower case
+        FString BroadcasterId;      // empty until resolved
+        FString SubscriptionId;     // empty until Helix accepts the subscription on this session
+        TArray<FString> EventSubscriptionIds;
+        bool bResolving = false;
+        bool bSubscribing = false;
+    };
+    TArray<FChannel> Channels;
+
+    FChannel* FindChannel(const FString& Login);
+    const FChannel* FindChannel(const FString& Login) const;
 
-    bool bAutoConnect = false;
+    // login (lower case) -> user id; survives reconnects so resubscribing needs no Helix lookups
+    TMap<FString, FString> UserIdCache;
 
-    void RefreshOAuthToken(TFunction<void(bool)> OnComplete);
 };
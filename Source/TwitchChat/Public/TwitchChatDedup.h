@@ -0,0 +1,46 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+#include "TwitchChatMessage.h"
+
+/**
+ * Lock-free set of recently seen chat message ids, used when EventSub and IRC are hedged and
+ * the same message arrives twice. Each slot is one 64-bit word packing a 39-bit fingerprint of
+ * the id, its arrival time in 100 us ticks and the transport, so insert is a single CAS and any
+ * thread may call Admit. Slots older than the window are reused; a probe run with no free slot
+ * overwrites its oldest entry, so under extreme load a very late repeat can slip through.
+ */
+class TWITCHCHAT_API FTwitchChatDedup
+{
+public:
+    struct FRepeat
+    {
+        // By receipt time, which may differ from the order the copies reached Admit
+        ETwitchChatTransport FirstTransport = ETwitchChatTransport::EventSub;
+        double LeadSeconds = 0.0;
+        bool bSameTransport = false;    // a redelivery rather than the other leg of the hedge
+    };
+
+    static constexpr int32 MaxProbes = 8;
+
+    // 2^CapacityLog2 slots; keep it several times the messages expected within the window
+    explicit FTwitchChatDedup(int32 CapacityLog2 = 15, double InWindowSeconds = 60.0);
+
+    // True for the first arrival of Id within the window; otherwise fills OutRepeat
+    bool Admit(const FString& Id, ETwitchChatTransport Transport, double ReceivedTime, FRepeat& OutRepeat);
+
+    // Not safe against concurrent Admit
+    void Reset();
+
+private:
+    static constexpr int32 TimeBits = 24;
+    static constexpr uint64 TimeMask = (uint64(1) << TimeBits) - 1;
+    static constexpr double TicksPerSecond = 10000.0;
+    // How far ahead of the caller's stamp an entry may be and still count as live (another thread's newer frame)
+    static constexpr int32 SkewTicks = 10 * 10000;
+
+    TUniquePtr<std::atomic<uint64>[]> Slots;
+    uint32 Mask = 0;
+    uint32 WindowTicks = 0;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Widgets/SCompoundWidget.h"
+
+/**
+ * Live pipeline graphs for operators: message rate, parse/dispatch latency, queue depths,
+ * emote cache and downloads, animated texture decode/upload cost. Samples the lock-free
+ * counters (FTwitchChatMetrics, FTwitchChatLatency, FAnimatedTextureCounters) four times a
+ * second, so it can stay open during a show without touching the pipeline's hot path.
+ */
+class STwitchChatDiagnostics : public SCompoundWidget
+{
+public:
+    SLATE_BEGIN_ARGS(STwitchChatDiagnostics) {}
+    SLATE_END_ARGS()
+
+    static const FName TabName;
+
+    struct FSeries
+    {
+        FText Label;
+        int32 Decimals = 1;
+        float WarnAt = 0.f;                 // value at or above this is flagged; 0 disables
+        TArray<float> Samples;              // ring buffer, oldest at Head
+        int32 Head = 0;
+
+        void Push(float Value);
+        float Latest() const;
+        float Peak() const;
+        bool IsWarning() const { return WarnAt > 0.f && Latest() >= WarnAt; }
+    };
+
+    void Construct(const FArguments& InArgs);
+    ~STwitchChatDiagnostics();
+
+private:
+    enum ESeries
+    {
+        MessageRate,
+        ParseLatency,
+        DispatchLatency,
+        FramesInFlight,
+        HistoryQueue,
+        EmoteDiskHitRatio,
+        EmoteBrushHitRatio,
+        EmoteDownloads,
+        AnimatedTextures,
+        FramesDecodedRate,
+        FrameDecodeCost,
+        FrameUploadCost,
+        NumSeries
+    };
+
+    // Previous sample, for per-interval deltas of monotonic counters
+    struct FSnapshot
+    {
+        double Time = 0.0;
+        int64 Dispatched = 0;
+        int64 ParseCount = 0;
+        uint64 ParseSum = 0;
+        int64 DispatchCount = 0;
+        uint64 DispatchSum = 0;
+        int64 DiskHits = 0;
+        int64 DiskMisses = 0;
+        int64 BrushHits = 0;
+        int64 BrushMisses = 0;
+        uint64 FramesDecoded = 0;
+        uint64 DecodeCycles = 0;
+        uint64 FramesUploaded = 0;
+        uint64 UploadCycles = 0;
+    };
+
+    EActiveTimerReturnType Sample(double InCurrentTime, float InDeltaTime);
+    FSnapshot TakeSnapshot() const;
+    TSharedRef<SWidget> MakeRow(ESeries Index);
+    FText GetStatusText() const;
+
+    TSharedPtr<FSeries> Series[NumSeries];
+    FSnapshot Last;
+    TSharedPtr<FActiveTimerHandle> SampleTimerHandle;
+};
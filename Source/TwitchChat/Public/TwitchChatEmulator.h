@@ -0,0 +1,125 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "TwitchChatSyntheticChat.h"
+
+class IWebSocketServer;
+class INetworkingWebSocket;
+class IHttpRouter;
+struct FHttpRouteHandleInternal;
+typedef TSharedPtr<FHttpRouteHandleInternal> FHttpRouteHandle;
+
+/**
+ * In-process stand-in for Twitch: an EventSub WebSocket server (session_welcome,
+ * keepalive, session_reconnect, notifications) plus the HTTP endpoints the plugin
+ * calls (device/token/validate, Helix users, chat messages and eventsub subscriptions, emote CDN).
+ * Chat is produced by FTwitchChatSyntheticChat at a configurable rate or from a script.
+ *
+ * Everything runs on the game thread from a core ticker.
+ */
+class TWITCHCHAT_API FTwitchChatEmulator : public TSharedFromThis<FTwitchChatEmulator>
+{
+public:
+    struct FConfig
+    {
+        int32 HttpPort = 17080;
+        int32 WebSocketPort = 17081;
+        int32 KeepaliveSeconds = 10;
+        FTwitchChatSyntheticChat::FConfig Chat;
+    };
+
+    struct FSubscription
+    {
+        FString Id;
+        FString Type;
+        FString SessionId;
+        FString ConduitId;
+        FString BroadcasterId;
+    };
+
+    static TSharedPtr<FTwitchChatEmulator> GetActive();
+    static TSharedPtr<FTwitchChatEmulator> StartActive(const FConfig& InConfig);
+    static void StopActive();
+
+    FTwitchChatEmulator();
+    ~FTwitchChatEmulator();
+
+    bool Start(const FConfig& InConfig);
+    void Stop();
+    bool IsRunning() const { return bRunning; }
+
+    // Overrides the UTwitchChatSettings endpoints (and access token) with this emulator's until Stop; config is untouched.
+    void RedirectSettings();
+
+    FString GetHttpBaseUrl() const;
+    FString GetWebSocketUrl() const;
+
+    void SetChatRate(float MessagesPerSecond) { ChatRate = FMath::Max(0.f, MessagesPerSecond); }
+    float GetChatRate() const { return ChatRate; }
+    void SetChatConfig(const FTwitchChatSyntheticChat::FConfig& InChat);
+    void Burst(int32 Count) { PendingBurst += FMath::Max(0, Count); }
+    void Say(const FString& UserLogin, const FString& Text);
+    void RequestReconnect();
+
+    // One command per line: rate <n>, burst <n>, wait <seconds>, say <user> <text>, scenario <name>, reconnect
+    bool RunScript(const FString& Path);
+    bool ExecuteCommand(const FString& Line);
+    bool IsScriptRunning() const { return ScriptCursor < ScriptLines.Num(); }
+
+    int64 GetNumNotificationsSent() const { return NumNotificationsSent; }
+    const TArray<FSubscription>& GetSubscriptions() const { return Subscriptions; }
+
+    bool Tick(float DeltaTime);
+
+private:
+    struct FClient
+    {
+        TUniquePtr<INetworkingWebSocket> Socket;
+        FString SessionId;
+        double  LastSendTime = 0.0;
+        bool    bDraining = false;
+        bool    bClosed = false;
+    };
+
+    void OnClientConnected(INetworkingWebSocket* Socket);
+    void SendFrame(FClient& Client, const FString& Frame);
+    FClient* FindDeliveryClient(const FSubscription& Sub);
+    void EmitChat(int32 Count);
+    void TickScript();
+
+    void BindRoutes();
+    FString LookupUserId(const FString& Login) const;
+    FString LookupUserLogin(const FString& Id) const;
+
+    FConfig Config;
+    bool bRunning = false;
+
+    TUniquePtr<IWebSocketServer> Server;
+    TArray<TUniquePtr<FClient>> Clients;
+    TArray<FSubscription> Subscriptions;
+    TMap<FString, FString> KnownLogins;     // id -> login for users looked up by login
+    FString ConduitId;
+    TArray<FString> ConduitShards;          // shard id -> bound session, empty while disabled
+    int32 NextShard = 0;
+    FString ReconnectSessionId;
+
+    TSharedPtr<IHttpRouter> Router;
+    TArray<FHttpRouteHandle> Routes;
+    TArray<uint8> EmotePng;
+    int32 TokenSerial = 0;
+
+    TUniquePtr<FTwitchChatSyntheticChat> Chat;
+    float ChatRate = 0.f;
+    double ChatBudget = 0.0;
+    int32 PendingBurst = 0;
+    int32 NextChannel = 0;
+    int64 NumNotificationsSent = 0;
+
+    TArray<FString> ScriptLines;
+    int32 ScriptCursor = 0;
+    double ScriptWaitUntil = 0.0;
+
+    bool bRedirected = false;
+    FTSTicker::FDelegateHandle TickHandle;
+};
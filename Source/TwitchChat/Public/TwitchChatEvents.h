@@ -0,0 +1,277 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TwitchChatEvents.generated.h"
+
+class FJsonObject;
+
+// EventSub events besides chat messages. Which ones are subscribed is set in the plugin settings;
+// all but Raid and Chat Notification need the broadcaster's own token with the listed scope.
+UENUM(BlueprintType)
+enum class ETwitchChatEventType : uint8
+{
+    // channel.cheer, bits:read
+    Cheer,
+    // channel.subscribe, channel:read:subscriptions
+    Subscribe,
+    // channel.subscription.message, channel:read:subscriptions
+    Resubscribe,
+    // channel.subscription.gift, channel:read:subscriptions
+    GiftSubscription,
+    // channel.raid, incoming raids
+    Raid,
+    // channel.channel_points_custom_reward_redemption.add, channel:read:redemptions
+    Redemption,
+    // channel.chat.notification: subs, resubs, gifts, raids and announcements as shown in chat
+    ChatNotification,
+    Count UMETA(Hidden)
+};
+
+// Fields every event carries. User is who caused the event (empty when anonymous).
+USTRUCT(BlueprintType)
+struct FTwitchChatEvent
+{
+    GENERATED_BODY()
+
+    // EventSub metadata.message_id; unique per delivery
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    FString EventId;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    FDateTime Timestamp;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    FString ChannelId;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    FString ChannelLogin;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    FString UserId;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    FString UserLogin;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    FString UserName;
+};
+
+USTRUCT(BlueprintType)
+struct FTwitchChatCheerEvent : public FTwitchChatEvent
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    int32 Bits = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    FString Message;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    bool bAnonymous = false;
+};
+
+USTRUCT(BlueprintType)
+struct FTwitchChatSubscribeEvent : public FTwitchChatEvent
+{
+    GENERATED_BODY()
+
+    // "1000", "2000" or "3000"
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    FString Tier;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    bool bGift = false;
+};
+
+USTRUCT(BlueprintType)
+struct FTwitchChatResubscribeEvent : public FTwitchChatEvent
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    FString Tier;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    FString Message;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    int32 CumulativeMonths = 0;
+
+    // 0 when the subscriber chose not to share it
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    int32 StreakMonths = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    int32 DurationMonths = 0;
+};
+
+USTRUCT(BlueprintType)
+struct FTwitchChatGiftEvent : public FTwitchChatEvent
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    FString Tier;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    int32 Total = 0;
+
+    // Gifts in the channel so far; 0 when anonymous or not shared
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    int32 CumulativeTotal = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    bool bAnonymous = false;
+};
+
+// User is the raiding broadcaster, Channel the one being raided
+USTRUCT(BlueprintType)
+struct FTwitchChatRaidEvent : public FTwitchChatEvent
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    int32 Viewers = 0;
+};
+
+USTRUCT(BlueprintType)
+struct FTwitchChatRedemptionEvent : public FTwitchChatEvent
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    FString RedemptionId;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    FString RewardId;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    FString RewardTitle;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    int32 RewardCost = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    FString UserInput;
+
+    // "unfulfilled", "fulfilled" or "canceled"
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    FString Status;
+};
+
+USTRUCT(BlueprintType)
+struct FTwitchChatNotificationEvent : public FTwitchChatEvent
+{
+    GENERATED_BODY()
+
+    // sub, resub, sub_gift, community_sub_gift, raid, announcement, ...
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    FString NoticeType;
+
+    // The line Twitch shows in chat, e.g. "X subscribed for 3 months"
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    FString SystemMessage;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    FString Message;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    FLinearColor UserColor = FLinearColor::White;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat Event")
+    bool bAnonymous = false;
+};
+
+/**
+ * Registry of the EventSub types the plugin understands. Each type is a row with its
+ * subscription_type, version, subscription condition and a decoder instantiated for its payload
+ * struct. Notifications find their row through a perfect hash of subscription_type built at
+ * compile time, so one hash and one string compare route any frame, however many types exist.
+ *
+ * Decoding runs on the parse worker; the typed delegates below fire on the game thread.
+ */
+class TWITCHCHAT_API FTwitchChatEvents
+{
+public:
+    static FTwitchChatEvents& Get();
+
+    // Worker thread: decodes the event into its payload and returns the game-thread broadcast
+    using FDecodeFn = bool (*)(const FJsonObject& Metadata, const FJsonObject& Event, TUniqueFunction<void()>& OutBroadcast);
+
+    struct FType
+    {
+        ETwitchChatEventType Kind;
+        const TCHAR* Name;                  // subscription_type
+        const TCHAR* Version;
+        const TCHAR* BroadcasterCondition;  // condition field that takes the channel's id
+        bool bUserCondition;                // condition also takes the bot's user_id
+        FDecodeFn Decode;                   // null for channel.chat.message, which has its own pipeline
+    };
+
+    // Null for types the plugin does not handle
+    static const FType* Find(const FString& SubscriptionType);
+    static const FType& GetType(ETwitchChatEventType Kind);
+
+    template<typename TPayload>
+    TMulticastDelegate<void(const TPayload&)>& On();
+
+    TMulticastDelegate<void(const FTwitchChatCheerEvent&)>          OnCheer;
+    TMulticastDelegate<void(const FTwitchChatSubscribeEvent&)>      OnSubscribe;
+    TMulticastDelegate<void(const FTwitchChatResubscribeEvent&)>    OnResubscribe;
+    TMulticastDelegate<void(const FTwitchChatGiftEvent&)>           OnGiftSubscription;
+    TMulticastDelegate<void(const FTwitchChatRaidEvent&)>           OnRaid;
+    TMulticastDelegate<void(const FTwitchChatRedemptionEvent&)>     OnRedemption;
+    TMulticastDelegate<void(const FTwitchChatNotificationEvent&)>   OnChatNotification;
+};
+
+// Payload -> event type and delegate
+template<typename TPayload> struct TTwitchChatEvent;
+
+template<> struct TTwitchChatEvent<FTwitchChatCheerEvent>
+{
+    static constexpr ETwitchChatEventType Kind = ETwitchChatEventType::Cheer;
+    static constexpr auto Delegate = &FTwitchChatEvents::OnCheer;
+};
+
+template<> struct TTwitchChatEvent<FTwitchChatSubscribeEvent>
+{
+    static constexpr ETwitchChatEventType Kind = ETwitchChatEventType::Subscribe;
+    static constexpr auto Delegate = &FTwitchChatEvents::OnSubscribe;
+};
+
+template<> struct TTwitchChatEvent<FTwitchChatResubscribeEvent>
+{
+    static constexpr ETwitchChatEventType Kind = ETwitchChatEventType::Resubscribe;
+    static constexpr auto Delegate = &FTwitchChatEvents::OnResubscribe;
+};
+
+template<> struct TTwitchChatEvent<FTwitchChatGiftEvent>
+{
+    static constexpr ETwitchChatEventType Kind = ETwitchChatEventType::GiftSubscription;
+    static constexpr auto Delegate = &FTwitchChatEvents::OnGiftSubscription;
+};
+
+template<> struct TTwitchChatEvent<FTwitchChatRaidEvent>
+{
+    static constexpr ETwitchChatEventType Kind = ETwitchChatEventType::Raid;
+    static constexpr auto Delegate = &FTwitchChatEvents::OnRaid;
+};
+
+template<> struct TTwitchChatEvent<FTwitchChatRedemptionEvent>
+{
+    static constexpr ETwitchChatEventType Kind = ETwitchChatEventType::Redemption;
+    static constexpr auto Delegate = &FTwitchChatEvents::OnRedemption;
+};
+
+template<> struct TTwitchChatEvent<FTwitchChatNotificationEvent>
+{
+    static constexpr ETwitchChatEventType Kind = ETwitchChatEventType::ChatNotification;
+    static constexpr auto Delegate = &FTwitchChatEvents::OnChatNotification;
+};
+
+template<typename TPayload>
+TMulticastDelegate<void(const TPayload&)>& FTwitchChatEvents::On()
+{
+    return this->*TTwitchChatEvent<TPayload>::Delegate;
+}
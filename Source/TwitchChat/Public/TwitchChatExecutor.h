@@ -0,0 +1,39 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+#include "Containers/Queue.h"
+
+/**
+ * Serial executor (a strand) on the game thread. Any thread may Post; tasks run one at a time in
+ * post order, and a burst is drained by a single game-thread task instead of one task per post.
+ * Posting is a lock-free MPSC enqueue plus one atomic add; only the 0 -> 1 transition schedules
+ * a drain. Tasks posted while draining (including from a task) join the running drain.
+ *
+ * Tasks never run after the executor is destroyed, so they may capture its owner's this.
+ */
+class TWITCHCHAT_API FTwitchChatExecutor : public TSharedFromThis<FTwitchChatExecutor>
+{
+public:
+    // Tasks per drain before yielding the frame; the rest run on the next game-thread task
+    static constexpr int32 MaxTasksPerDrain = 4096;
+
+    void Post(TUniqueFunction<void()>&& Task);
+
+    // Game thread: runs everything posted so far, e.g. before tearing the owner down
+    void Flush();
+
+    // Posted and not yet run
+    int32 GetQueueDepth() const { return Pending.load(std::memory_order_relaxed); }
+
+    bool IsInExecutor() const { return bDraining; }
+
+private:
+    void ScheduleDrain();
+    void Drain();
+    int32 RunQueued(int32 Budget);
+
+    TQueue<TUniqueFunction<void()>, EQueueMode::Mpsc> Tasks;
+    std::atomic<int32> Pending{ 0 };
+    bool bDraining = false;     // game thread only
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Interfaces/IHttpRequest.h"
+
+class FJsonObject;
+
+// Lookups Helix can answer for many keys in one request
+enum class ETwitchHelixLookup : uint8
+{
+    UserByLogin,    // /users?login=, 100 per request
+    UserById,       // /users?id=, 100 per request
+    EmoteSet,       // /chat/emotes/set?emote_set_id=, 25 per request
+    ChannelBadges,  // /chat/badges?broadcaster_id=, one channel per request
+    GlobalBadges,   // /chat/badges/global; key is ignored
+    Num
+};
+
+// Which Twitch rate-limit bucket a request draws from
+enum class ETwitchHelixBucket : uint8
+{
+    User,   // the user token; Helix sets Client-Id and Authorization and refreshes on 401
+    App,    // the caller set an app token (conduits); no refresh
+    Num
+};
+
+/**
+ * Every Helix call goes through here. Requests wait in a FIFO per rate-limit bucket and leave it
+ * through a token bucket that follows Ratelimit-Limit / Ratelimit-Remaining / Ratelimit-Reset, so
+ * a burst is spread out instead of drawing 429s; a 429 that still happens is retried after the
+ * reset. Lookups arriving within MergeWindowSeconds of each other are merged into batched
+ * requests, and their results are cached per key (misses too) for a while.
+ *
+ * Game thread only.
+ */
+class TWITCHCHAT_API FTwitchChatHelix : public TSharedFromThis<FTwitchChatHelix>
+{
+public:
+    using FOnResponse = TFunction<void(FHttpRequestPtr, FHttpResponsePtr, bool)>;
+    // All data items for the key; empty when it does not exist or the lookup failed
+    using FOnLookup = TFunction<void(const TArray<TSharedPtr<FJsonObject>>&)>;
+
+    static TSharedRef<FTwitchChatHelix> Get();
+
+    static constexpr double MergeWindowSeconds = 0.05;
+    static constexpr double HitTtlSeconds = 3600.0;
+    static constexpr double MissTtlSeconds = 300.0;
+
+    // Req has URL, verb and body; OnComplete sees the final response after any 401/429 retries
+    void Send(TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Req, FOnResponse OnComplete, ETwitchHelixBucket Bucket = ETwitchHelixBucket::User);
+
+    // Cache hits call back immediately
+    void Lookup(ETwitchHelixLookup Kind, const FString& Key, FOnLookup OnComplete);
+
+    // Builds a user-bucket request for HelixBaseUrl + Path
+    static TSharedRef<IHttpRequest, ESPMode::ThreadSafe> MakeRequest(const FString& Verb, const FString& Path);
+
+    void ClearCache();
+
+    struct FBucketStatus
+    {
+        int32 Limit = 0;
+        double Tokens = 0.0;
+        int32 Queued = 0;
+        double BlockedFor = 0.0;
+    };
+    FBucketStatus GetBucketStatus(ETwitchHelixBucket Bucket) const;
+    int32 GetCacheSize() const;
+
+    // Removes the ticker; called by the module before the core ticker goes away
+    void Shutdown();
+
+private:
+    struct FPending
+    {
+        TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Req;
+        FOnResponse OnComplete;
+        bool bRefreshed = false;
+    };
+
+    struct FBucket
+    {
+        int32 Limit = 800;
+        double Tokens = 800.0;
+        double LastRefill = 0.0;
+        double BlockedUntil = 0.0;
+        TArray<FPending> Queue;
+    };
+
+    struct FCacheEntry
+    {
+        TArray<TSharedPtr<FJsonObject>> Items;
+        double ExpiresAt = 0.0;
+    };
+
+    struct FLookupQueue
+    {
+        TMap<FString, TArray<FOnLookup>> Waiting;   // queued or in flight
+        TArray<FString> Unsent;
+        double FlushTime = 0.0;
+    };
+
+    void EnsureTicker();
+    bool Tick(float DeltaTime);
+    void Pump(ETwitchHelixBucket Bucket);
+    void Dispatch(ETwitchHelixBucket Bucket, FPending&& Pending);
+    void ReadRateLimit(FBucket& Bucket, const FHttpResponsePtr& Resp);
+    void FlushLookups(ETwitchHelixLookup Kind);
+    void SendLookup(ETwitchHelixLookup Kind, TArray<FString>&& Keys, bool bSplitMisses);
+    void CompleteLookup(ETwitchHelixLookup Kind, const FString& Key, const TArray<TSharedPtr<FJsonObject>>& Items, double Ttl);
+
+    FBucket Buckets[int32(ETwitchHelixBucket::Num)];
+    FLookupQueue Lookups[int32(ETwitchHelixLookup::Num)];
+    TMap<FString, FCacheEntry> Cache[int32(ETwitchHelixLookup::Num)];
+    double NextPruneTime = 0.0;
+
+    FTSTicker::FDelegateHandle TickHandle;
+};
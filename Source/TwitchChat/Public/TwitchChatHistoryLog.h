@@ -0,0 +1,146 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+#include "HAL/Runnable.h"
+#include "Containers/Queue.h"
+#include "TwitchChatMessage.h"
+
+class FRunnableThread;
+class FArchive;
+
+/**
+ * Append-only chat transcript. Messages are queued from any thread and written by a
+ * background thread into segment files made of compressed blocks. Every block is listed
+ * in a sparse time index (min/max timestamp per block) and a per-user index, so range
+ * and user queries only decompress the blocks that can contain a match.
+ */
+class TWITCHCHAT_API FTwitchChatHistoryLog : public FRunnable
+{
+public:
+    struct FOptions
+    {
+        FString Directory;
+        FName   CompressionFormat = NAME_Zlib;
+        int32   BlockSizeBytes = 64 * 1024;
+        int64   SegmentSizeBytes = 64ll * 1024 * 1024;
+        float   FlushIntervalSeconds = 2.0f;
+
+        static FOptions FromSettings();
+    };
+
+    struct FQueryStats
+    {
+        int32 BlocksScanned = 0;
+        int32 BlocksRead = 0;
+        int64 BytesRead = 0;
+    };
+
+    // Shared log configured from UTwitchChatSettings
+    static TSharedRef<FTwitchChatHistoryLog> Get();
+
+    // The shared log if something already asked for it; never opens the directory or starts the writer
+    static TSharedPtr<FTwitchChatHistoryLog> GetIfCreated();
+
+    explicit FTwitchChatHistoryLog(const FOptions& InOptions);
+    virtual ~FTwitchChatHistoryLog();
+
+    void Append(const FTwitchChatMessage& Msg);
+
+    // Blocks until everything appended so far is on disk.
+    void Flush();
+
+    // Flushes, closes the current segment and joins the writer thread.
+    void Shutdown();
+
+    TArray<FTwitchChatMessage> QueryTimeRange(const FDateTime& From, const FDateTime& To, FQueryStats* OutStats = nullptr) const;
+
+    // UserKey matches either the user id or the (case-insensitive) user name.
+    TArray<FTwitchChatMessage> QueryUser(const FString& UserKey,
+        const FDateTime& From = FDateTime::MinValue(),
+        const FDateTime& To = FDateTime::MaxValue(),
+        FQueryStats* OutStats = nullptr) const;
+
+    int64 GetNumMessagesWritten() const { return NumWritten.load(); }
+    int64 GetBytesWritten() const { return BytesWritten.load(); }
+    int64 GetUncompressedBytesWritten() const { return UncompressedBytesWritten.load(); }
+    int32 GetQueueDepth() const { return QueueDepth.load(); }
+
+    //~ FRunnable
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    struct FBlockEntry
+    {
+        int64 Offset = 0;
+        int32 CompressedSize = 0;
+        int32 UncompressedSize = 0;
+        int32 NumRecords = 0;
+        int64 MinTicks = 0;
+        int64 MaxTicks = 0;
+
+        friend FArchive& operator<<(FArchive& Ar, FBlockEntry& B)
+        {
+            return Ar << B.Offset << B.CompressedSize << B.UncompressedSize << B.NumRecords << B.MinTicks << B.MaxTicks;
+        }
+    };
+
+    struct FSegment
+    {
+        FString Path;
+        FName CompressionFormat;
+        TArray<FBlockEntry> Blocks;
+        TMap<FString, TArray<int32>> UserBlocks;
+    };
+
+    struct FBlockRef
+    {
+        FString Path;
+        FName CompressionFormat;
+        FBlockEntry Block;
+    };
+
+    void LoadExistingSegments();
+    bool LoadSegmentIndex(FSegment& Segment) const;
+    bool RebuildSegmentIndex(FSegment& Segment) const;
+    void SaveSegmentIndex(const FSegment& Segment) const;
+
+    void OpenSegment();
+    void CloseSegment();
+    void DrainQueue();
+    void WriteBlock();
+
+    TArray<FTwitchChatMessage> ReadBlocks(const TArray<FBlockRef>& Refs, TFunctionRef<bool(const FTwitchChatMessage&)> Filter, FQueryStats* OutStats) const;
+    static bool DecodeBlock(const FBlockRef& Ref, const TArray<uint8>& Compressed, TArray<FTwitchChatMessage>& Out);
+
+    FOptions Options;
+
+    TQueue<FTwitchChatMessage, EQueueMode::Mpsc> Pending;
+    std::atomic<int32> QueueDepth{ 0 };
+
+    FRunnableThread* Thread = nullptr;
+    FEvent* WakeEvent = nullptr;
+    FEvent* FlushedEvent = nullptr;
+    std::atomic<bool> bStopping{ false };
+    std::atomic<int32> FlushRequested{ 0 };
+    std::atomic<int32> FlushCompleted{ 0 };
+
+    // Segment list and indexes, shared between writer and queries
+    mutable FRWLock IndexLock;
+    TArray<TSharedPtr<FSegment>> Segments;
+
+    // Writer-thread only
+    TUniquePtr<FArchive> SegmentWriter;
+    TSharedPtr<FSegment> CurrentSegment;
+    TArray<uint8> BlockBuffer;
+    int32 BlockRecords = 0;
+    int64 BlockMinTicks = 0;
+    int64 BlockMaxTicks = 0;
+    TSet<FString> BlockUsers;
+    double LastBlockTime = 0.0;
+
+    std::atomic<int64> NumWritten{ 0 };
+    std::atomic<int64> BytesWritten{ 0 };
+    std::atomic<int64> UncompressedBytesWritten{ 0 };
+};
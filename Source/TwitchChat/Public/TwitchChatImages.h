@@ -0,0 +1,89 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/LruCache.h"
+#include "Styling/SlateBrush.h"
+#include "TwitchChatConnection.h"
+
+class UTexture2D;
+class IImageWrapperModule;
+
+/**
+ * Chat badges and profile pictures, packed into a few shared atlas textures so a screen of chat
+ * lines draws from a handful of textures instead of one per image.
+ *
+ * Badge sets (global, then the channel's own on top) are resolved once per connect through
+ * Helix; profile image URLs come from batched /users?id= lookups. Images are downloaded, then
+ * decoded and scaled to one CellSize square off the game thread, and copied into a free atlas
+ * cell. Up to ChatterImageAtlasPages pages are created; after that the least recently drawn
+ * image gives up its cell.
+ *
+ * Game thread only. Each cell keeps one brush for the life of the cache, so a returned brush
+ * pointer stays valid; once evicted it shows whatever image moved into that cell.
+ */
+class TWITCHCHAT_API FTwitchChatImages : public TSharedFromThis<FTwitchChatImages>
+{
+public:
+    static TSharedRef<FTwitchChatImages> Get();
+
+    static constexpr int32 CellSize = 72;
+    static constexpr int32 PageSize = 1024;
+    static constexpr int32 CellsPerRow = PageSize / CellSize;
+    static constexpr int32 CellsPerPage = CellsPerRow * CellsPerRow;
+
+    // Null until loaded; OnImagesLoaded fires once it is. Badge is "set_id/id", as in
+    // FTwitchChatChatter::Badges.
+    const FSlateBrush* FindBadge(const FString& ChannelId, const FString& Badge);
+    const FSlateBrush* FindAvatar(const FString& UserId);
+
+    // After one or more images landed in the atlas; views that asked for them redraw
+    FSimpleMulticastDelegate OnImagesLoaded;
+
+    int32 GetPageCount() const { return Pages.Num(); }
+    int32 Num() const { return ByUrl.Num(); }
+    int32 GetLoadingCount() const { return Loading.Num(); }
+    SIZE_T GetAllocatedSize() const;
+
+    // Drops the badge sets and avatar URLs; atlas cells are kept and reused
+    void Reset();
+
+    // Releases the atlas pages; called by the module on shutdown
+    void Shutdown();
+
+private:
+    struct FCell
+    {
+        TSharedPtr<FSlateBrush> Brush;
+        FString Url;
+    };
+
+    // Badge "set_id/id" to image URL, per channel id ("" for the global sets); empty while resolving
+    struct FBadgeSets
+    {
+        TMap<FString, FString> Urls;
+        bool bResolved = false;
+    };
+
+    void EnsureBound();
+    void HandleStateChanged(ETwitchChatConnectionState State);
+    void ResolveBadges(const FString& ChannelId);
+    const FSlateBrush* FindImage(const FString& Url);
+    void Load(const FString& Url);
+    void Place(const FString& Url, TArray<uint8>&& Pixels);
+    int32 AllocateCell();
+
+    // Decodes any format the image wrapper knows, letterboxed into CellSize x CellSize BGRA
+    static bool Decode(IImageWrapperModule& ImageWrapper, const TArray<uint8>& Compressed, TArray<uint8>& OutPixels);
+
+    TMap<FString, FBadgeSets> Badges;
+    TMap<FString, FString> AvatarUrls;      // empty while resolving or when the user has none
+    TSet<FString> Loading;
+    TSet<FString> Failed;
+
+    TArray<UTexture2D*> Pages;
+    TArray<FCell> Cells;
+    TLruCache<FString, int32> ByUrl;        // image URL to index in Cells
+
+    ETwitchChatConnectionState LastState = ETwitchChatConnectionState::Disconnected;
+    FDelegateHandle StateHandle;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+#include "HAL/Runnable.h"
+#include "Containers/Queue.h"
+#include "TwitchChatMessage.h"
+
+class FSocket;
+class FTwitchChatConnection;
+
+/**
+ * Read-only Twitch IRC (TMI) client on a plain TCP socket and its own thread. Logs in
+ * anonymously, requests the tags capability and joins every channel, so PRIVMSG lines carry
+ * the same message ids as EventSub and the connection can hedge one transport with the other.
+ * Reconnects on its own with the connection's backoff; the EventSub session is not affected.
+ */
+class TWITCHCHAT_API FTwitchChatIrc : public FRunnable
+{
+public:
+    explicit FTwitchChatIrc(FTwitchChatConnection& InConnection);
+    virtual ~FTwitchChatIrc();
+
+    // Game thread
+    bool Start(const FString& InHost, int32 InPort, const TArray<FString>& InChannels);
+    void Shutdown();
+
+    // Any thread; sent by the reader thread
+    void Join(const FString& Login);
+    void Part(const FString& Login);
+
+    bool IsJoined() const { return bJoined.load(std::memory_order_relaxed); }
+
+    // Parses one IRC PRIVMSG line with tags; false for anything else. Leaves the chatter cache
+    // alone: UserName is the name as sent and Chatter stays unset.
+    static bool ParsePrivmsg(const FString& Line, FTwitchChatMessage& Out);
+
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    bool Open();
+    void Close(const FString& Reason);
+    void Send(const FString& Line);
+    void HandleLine(const FString& Line, double ReceivedTime, const FDateTime& ReceivedUtc);
+    void SetJoined(bool bInJoined);
+
+    FTwitchChatConnection& Connection;
+    FString Host;
+    int32 Port = 6667;
+    FString Nick;
+
+    FRunnableThread* Thread = nullptr;
+    std::atomic<bool> bStopping{ false };
+    std::atomic<bool> bJoined{ false };
+
+    // Filled in by the socket subsystem's resolver; shared, since it can finish after Shutdown
+    struct FResolve;
+    TSharedPtr<FResolve, ESPMode::ThreadSafe> Resolving;
+
+    // Reader thread only
+    FSocket* Socket = nullptr;
+    FSocket* Connecting = nullptr;      // non-blocking connect in progress
+    double ConnectDeadline = 0.0;
+    TArray<uint8> Pending;
+    TSet<FString> Channels;
+    double LastReceiveTime = 0.0;
+    double NextConnectTime = 0.0;
+    bool bPingSent = false;
+    int32 ReconnectAttempt = 0;
+
+    // "+login" / "-login" from Join and Part
+    TQueue<FString, EQueueMode::Mpsc> ChannelChanges;
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+#include "TwitchChatMessage.h"
+#include "TwitchChatLatency.generated.h"
+
+UENUM(BlueprintType)
+enum class ETwitchChatLatencyStage : uint8
+{
+    Ingest      UMETA(ToolTip = "Twitch send (message_timestamp) to socket receipt"),
+    Parse       UMETA(ToolTip = "Socket receipt to parsed message"),
+    Dispatch    UMETA(ToolTip = "Parsed to game-thread OnMessage broadcast, including the emote wait"),
+    Render      UMETA(ToolTip = "Broadcast to first paint"),
+    EndToEnd    UMETA(ToolTip = "Twitch send to first paint"),
+    Num         UMETA(Hidden)
+};
+
+USTRUCT(BlueprintType)
+struct FTwitchChatLatencySummary
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat|Latency") int64 Count = 0;
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat|Latency") float MeanMs = 0.f;
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat|Latency") float P50Ms = 0.f;
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat|Latency") float P90Ms = 0.f;
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat|Latency") float P99Ms = 0.f;
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat|Latency") float P999Ms = 0.f;
+    UPROPERTY(BlueprintReadOnly, Category = "Twitch Chat|Latency") float MaxMs = 0.f;
+};
+
+/**
+ * Streaming log-linear histogram of microsecond values (HDR style: 64 linear sub-buckets
+ * per power of two, so any reported percentile is within ~1.6% of the true value).
+ * Recording is a handful of relaxed atomic adds and never blocks; readers scan the buckets.
+ */
+class TWITCHCHAT_API FTwitchChatLatencyHistogram
+{
+public:
+    static constexpr int32 SubBucketBits = 6;
+    static constexpr int32 SubBuckets = 1 << SubBucketBits;
+    static constexpr int32 MaxShift = 32;   // values up to ~2^38 us (three days)
+    static constexpr int32 NumBuckets = (MaxShift + 2) * SubBuckets;
+
+    void Record(uint64 Micros);
+    void Reset();
+
+    int64 GetCount() const { return Count.load(std::memory_order_relaxed); }
+    uint64 GetMaxMicros() const { return Max.load(std::memory_order_relaxed); }
+    uint64 GetSumMicros() const { return Sum.load(std::memory_order_relaxed); }
+    double GetMeanMicros() const;
+
+    // P in [0, 1]; returns the midpoint of the bucket holding that rank.
+    uint64 GetPercentileMicros(double P) const;
+
+    // Non-cumulative bucket counts with their upper bound, for exporters.
+    void ForEachBucket(TFunctionRef<void(uint64 UpperMicros, int64 Count)> Visit) const;
+
+    FTwitchChatLatencySummary Summarize() const;
+
+    static int32 BucketIndex(uint64 Micros);
+    static uint64 BucketLowest(int32 Index);
+    static uint64 BucketWidth(int32 Index);
+
+private:
+    std::atomic<int64>  Buckets[NumBuckets] = {};
+    std::atomic<int64>  Count{ 0 };
+    std::atomic<uint64> Sum{ 0 };
+    std::atomic<uint64> Max{ 0 };
+};
+
+/**
+ * Glass-to-glass latency per pipeline stage. Stamps travel with FTwitchChatMessage
+ * (ReceivedTime, ParsedTime, DispatchTime, IngestSeconds); whoever paints a message
+ * first (the editor window, or a widget via UTwitchChatLibrary) reports the paint.
+ */
+class TWITCHCHAT_API FTwitchChatLatency
+{
+public:
+    static FTwitchChatLatency& Get();
+
+    void Record(ETwitchChatLatencyStage Stage, double Seconds);
+
+    // Ingest and Parse, on the parse thread once the message is built.
+    void RecordParsed(const FTwitchChatMessage& Msg);
+
+    // Dispatch, on the game thread right before OnMessage fires.
+    void RecordDispatched(const FTwitchChatMessage& Msg);
+
+    // Render and EndToEnd. Call once per message, when it is first drawn.
+    void RecordPainted(double ReceivedTime, double DispatchTime, double IngestSeconds);
+    void RecordPainted(const FTwitchChatMessage& Msg) { RecordPainted(Msg.ReceivedTime, Msg.DispatchTime, Msg.IngestSeconds); }
+
+    const FTwitchChatLatencyHistogram& GetHistogram(ETwitchChatLatencyStage Stage) const { return Histograms[int32(Stage)]; }
+    FTwitchChatLatencySummary Summarize(ETwitchChatLatencyStage Stage) const { return GetHistogram(Stage).Summarize(); }
+    void Reset();
+
+    static const TCHAR* GetStageName(ETwitchChatLatencyStage Stage);
+
+private:
+    FTwitchChatLatencyHistogram Histograms[int32(ETwitchChatLatencyStage::Num)];
+};
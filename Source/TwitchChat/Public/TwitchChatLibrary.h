@@ -2,10 +2,15 @@
 #pragma once
 
 #include "Kismet/BlueprintFunctionLibrary.h"
+#include "TwitchChatComponent.h"
+#include "TwitchChatLatency.h"
+#include "Styling/SlateBrush.h"
 #include "TwitchChatLibrary.generated.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogTwitchChatLibrary, Log, All);
 
+DECLARE_DYNAMIC_DELEGATE_TwoParams(FOnTwitchChatMessageSent, bool, bSent, const FString&, Reason);
+
 UCLASS()
 class TWITCHCHAT_API UTwitchChatLibrary : public UBlueprintFunctionLibrary
 {
@@ -20,13 +25,57 @@ public:
     static void TwitchChat_Disconnect();
 
 
+    // Replaces the channel set (comma separated) on the live session, or for the next connect
     UFUNCTION(BlueprintCallable, Category = "Twitch Chat")
     static void TwitchChat_ChangeChannel(const FString& NewChannel);
 
+    // Adds a channel to the session without reconnecting
+    UFUNCTION(BlueprintCallable, Category = "Twitch Chat")
+    static bool TwitchChat_JoinChannel(const FString& Channel);
+
+    UFUNCTION(BlueprintCallable, Category = "Twitch Chat")
+    static bool TwitchChat_LeaveChannel(const FString& Channel);
+
+    UFUNCTION(BlueprintPure, Category = "Twitch Chat")
+    static TArray<FString> TwitchChat_GetChannels();
+
 
     UFUNCTION(BlueprintCallable, Category = "Twitch Chat")
     static bool TwitchChat_GetEmoteTexture(const FString& EmoteID, UTexture*& OutTexture);
 
     UFUNCTION(BlueprintCallable, Category = "Twitch Chat")
     static bool TwitchChat_GetEmoteTextureFromTables(const FString& EmoteID, UTexture*& OutTexture);
+
+    // Call once when a widget first draws a chat message, to record render and end-to-end latency.
+    UFUNCTION(BlueprintCallable, Category = "Twitch Chat|Latency")
+    static void TwitchChat_ReportMessagePainted(const FBP_TwitchChatMessage& ChatMessage);
+
+    UFUNCTION(BlueprintPure, Category = "Twitch Chat|Latency")
+    static FTwitchChatLatencySummary TwitchChat_GetLatency(ETwitchChatLatencyStage Stage);
+
+    UFUNCTION(BlueprintCallable, Category = "Twitch Chat|Latency")
+    static void TwitchChat_ResetLatency();
+
+    // Queues a message as the signed-in user; returns at once. False when it was refused
+    // (sending disabled, empty, over 500 characters or the queue is full).
+    UFUNCTION(BlueprintCallable, Category = "Twitch Chat|Send", meta = (AutoCreateRefTerm = "ReplyToMessageId,OnSent"))
+    static bool TwitchChat_SendChatMessage(const FString& Channel, const FString& Message, const FString& ReplyToMessageId, const FOnTwitchChatMessageSent& OnSent);
+
+    UFUNCTION(BlueprintCallable, Category = "Twitch Chat|Send")
+    static void TwitchChat_SetModeratorOrVip(const FString& Channel, bool bModeratorOrVip);
+
+    UFUNCTION(BlueprintPure, Category = "Twitch Chat|Send")
+    static int32 TwitchChat_GetOutgoingQueueDepth();
+
+    // Send to Twitch accepting the message, time waiting for send budget included
+    UFUNCTION(BlueprintPure, Category = "Twitch Chat|Send")
+    static FTwitchChatLatencySummary TwitchChat_GetOutgoingLatency();
+
+    // A cell of the shared badge/avatar atlas. False while the image is still loading; try
+    // again on a later message or tick.
+    UFUNCTION(BlueprintCallable, Category = "Twitch Chat|Images")
+    static bool TwitchChat_GetBadgeBrush(const FString& ChannelId, const FString& Badge, FSlateBrush& OutBrush);
+
+    UFUNCTION(BlueprintCallable, Category = "Twitch Chat|Images")
+    static bool TwitchChat_GetAvatarBrush(const FString& UserId, FSlateBrush& OutBrush);
 };
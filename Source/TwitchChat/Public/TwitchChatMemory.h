@@ -0,0 +1,40 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TwitchChatMessage.h"
+
+class UTexture2D;
+
+/**
+ * Resident memory per TwitchChat subsystem and per UAnimatedTexture2D, for
+ * `twitchchat.memreport`. LLM (-llm) covers engine allocations under the TwitchChat and
+ * AnimatedTexture tags; this fills the gap for what LLM can't attribute, such as giflib
+ * and libwebp allocating through malloc.
+ */
+class TWITCHCHAT_API FTwitchChatMemory
+{
+public:
+    struct FLine
+    {
+        FString Subsystem;
+        FString Name;
+        int32 Count = 0;
+        SIZE_T Bytes = 0;
+    };
+
+    DECLARE_MULTICAST_DELEGATE_OneParam(FOnCollect, TArray<FLine>& /*Out*/);
+
+    // Views that own chat data (e.g. the editor window) add their lines here. Game thread.
+    static FOnCollect OnCollect;
+
+    // Transient emote textures created from Saved/FetchedEmotes; they are rooted, so
+    // anything still tracked here is resident until the owner removes it from root.
+    static void TrackEmoteTexture(UTexture2D* Texture);
+
+    // Struct plus owned heap (strings, arrays, tags).
+    static SIZE_T GetMessageSize(const FTwitchChatMessage& Msg);
+
+    // Game thread.
+    static TArray<FLine> Collect(bool bIncludeAnimatedTextures = true);
+    static void LogReport(bool bIncludeAnimatedTextures = true);
+};
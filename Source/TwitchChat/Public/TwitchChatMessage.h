@@ -2,18 +2,56 @@
 
 #include "CoreMinimal.h"
 #include "Styling/SlateColor.h"
+#include "TwitchChatChatters.h"
 #include "TwitchChatMessage.generated.h"
 
+// Which ingest path delivered a message; both run side by side when hedging
+enum class ETwitchChatTransport : uint8
+{
+    EventSub,
+    Irc,
+};
+
 USTRUCT(BlueprintType)
 struct FTwitchChatMessage
 {
     GENERATED_BODY()
 
+    UPROPERTY() FString               MessageId;
+
+    // Broadcaster the message was sent in; several channels can share one session.
+    UPROPERTY() FString               ChannelId;
+    UPROPERTY() FString               ChannelLogin;
+
+    UPROPERTY() FString               UserId;
     UPROPERTY() FString               UserName;
     UPROPERTY() FString               Message;
     UPROPERTY() FLinearColor          UserColor = FLinearColor::White;
+
+    // Shared per-chatter entry (badges, first/last seen); UserName and UserColor above are copied from it.
+    FTwitchChatChatterPtr             Chatter;
+
     UPROPERTY() TArray<FString>       EmoteIds;
     UPROPERTY() TArray<FIntPoint>     EmoteRanges;
     UPROPERTY() TMap<FString, FString> Tags;
     UPROPERTY() FString RawPayload;
+
+    // Time Twitch sent the message (EventSub metadata.message_timestamp), UTC.
+    UPROPERTY() FDateTime             Timestamp;
+
+    // Pipeline stamps in FPlatformTime::Seconds(): frame arrival, parse done, game-thread broadcast.
+    double                            ReceivedTime = 0.0;
+    double                            ParsedTime = 0.0;
+    double                            DispatchTime = 0.0;
+
+    // Twitch send to socket receipt; negative when unknown (e.g. replayed traffic).
+    double                            IngestSeconds = -1.0;
+
+    ETwitchChatTransport              Transport = ETwitchChatTransport::EventSub;
+
+    // Process-local sequence number; correlates TwitchChat trace events for this message.
+    uint32                            Serial = 0;
+
+    // Set by the first view that draws this message, so paint latency is recorded once.
+    bool                              bPaintReported = false;
 };
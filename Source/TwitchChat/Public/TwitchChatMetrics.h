@@ -0,0 +1,134 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+#include "Containers/Ticker.h"
+#include "TwitchChatLatency.h"
+
+class IHttpRouter;
+struct FHttpRouteHandleInternal;
+typedef TSharedPtr<FHttpRouteHandleInternal> FHttpRouteHandle;
+
+enum class ETwitchChatCounter : uint8
+{
+    FramesReceived,
+    ParseErrors,
+    MessagesDispatched,
+    ConnectAttempts,
+    Reconnects,
+    KeepaliveTimeouts,
+    SessionMigrations,
+    Revocations,
+    SocketErrors,
+    SocketClosed,
+    SubscribeFailures,
+    TokenRefreshes,
+    EmoteDiskHits,
+    EmoteDiskMisses,
+    EmoteDownloadFailures,
+    EmoteWaitTimeouts,
+    EmoteBrushHits,
+    EmoteBrushMisses,
+    ShedHistory,
+    HedgeFirstEventSub,
+    HedgeFirstIrc,
+    HedgeDuplicates,
+    IrcReconnects,
+    HelixRequests,
+    HelixThrottled,
+    HelixCacheHits,
+    HelixBatchedKeys,
+    StaleDropped,
+    EventsReceived,
+    ChatSent,
+    ChatDropped,
+    Num
+};
+
+enum class ETwitchChatGauge : uint8
+{
+    EmoteDownloadsInFlight,
+    HelixQueued,
+    ChatQueued,
+    Num
+};
+
+enum class ETwitchChatTimer : uint8
+{
+    JsonParse,
+    EmoteDecode,
+    HedgeLeadEventSub,
+    HedgeLeadIrc,
+    ChatSend,
+    Num
+};
+
+/**
+ * Process-wide pipeline counters, always on. Recording is a relaxed atomic add (timers use
+ * FTwitchChatLatencyHistogram), so it is safe on the socket, parse and game threads alike;
+ * everything else is read at scrape time. Served in Prometheus text format on
+ * http://<host>:<MetricsPort>/metrics when bEnableMetricsEndpoint is set.
+ */
+class TWITCHCHAT_API FTwitchChatMetrics
+{
+public:
+    static FTwitchChatMetrics& Get();
+
+    static void Inc(ETwitchChatCounter Counter, int64 Delta = 1)
+    {
+        Get().Counters[int32(Counter)].fetch_add(Delta, std::memory_order_relaxed);
+    }
+    static void Add(ETwitchChatGauge Gauge, int64 Delta)
+    {
+        Get().Gauges[int32(Gauge)].fetch_add(Delta, std::memory_order_relaxed);
+    }
+    static void Time(ETwitchChatTimer Timer, double Seconds)
+    {
+        Get().Timers[int32(Timer)].Record(uint64(FMath::Max(0.0, Seconds) * 1000000.0));
+    }
+
+    int64 GetCounter(ETwitchChatCounter Counter) const { return Counters[int32(Counter)].load(std::memory_order_relaxed); }
+    int64 GetGauge(ETwitchChatGauge Gauge) const { return Gauges[int32(Gauge)].load(std::memory_order_relaxed); }
+    const FTwitchChatLatencyHistogram& GetTimer(ETwitchChatTimer Timer) const { return Timers[int32(Timer)]; }
+
+    // Dispatched messages over the last full second; updated by the sampler.
+    float GetMessagesPerSecond() const { return MessagesPerSecond.load(std::memory_order_relaxed); }
+
+    // 1 Hz sampler for rate gauges. Started by the module.
+    void StartSampling();
+    void StopSampling();
+
+    bool StartEndpoint(int32 Port);
+    void StopEndpoint();
+    bool IsEndpointRunning() const { return Router.IsValid(); }
+
+    // Prometheus text exposition format 0.0.4. Game thread.
+    FString RenderPrometheus() const;
+
+    static const TCHAR* GetCounterName(ETwitchChatCounter Counter);
+
+private:
+    bool Sample(float DeltaTime);
+
+    std::atomic<int64> Counters[int32(ETwitchChatCounter::Num)] = {};
+    std::atomic<int64> Gauges[int32(ETwitchChatGauge::Num)] = {};
+    FTwitchChatLatencyHistogram Timers[int32(ETwitchChatTimer::Num)];
+
+    std::atomic<float> MessagesPerSecond{ 0.f };
+    int64 LastDispatched = 0;
+    double LastSampleTime = 0.0;
+    FTSTicker::FDelegateHandle SampleHandle;
+
+    TSharedPtr<IHttpRouter> Router;
+    TArray<FHttpRouteHandle> Routes;
+};
+
+// Scoped timer for ETwitchChatTimer; pairs with SCOPE_CYCLE_COUNTER but is always compiled in.
+struct FTwitchChatMetricsScope
+{
+    explicit FTwitchChatMetricsScope(ETwitchChatTimer InTimer) : Timer(InTimer), Start(FPlatformTime::Seconds()) {}
+    ~FTwitchChatMetricsScope() { FTwitchChatMetrics::Time(Timer, FPlatformTime::Seconds() - Start); }
+
+    ETwitchChatTimer Timer;
+    double Start;
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+
+/**
+ * Outgoing chat. Messages are sent as the token's user through Helix POST /chat/messages and
+ * wait in a FIFO until Twitch's send limit allows them: 20 messages per 30 s in channels where
+ * the bot is a regular chatter and 100 per 30 s where it is broadcaster, moderator or VIP, each
+ * budget a token bucket of its own. While messages wait, consecutive ones to the same channel
+ * are merged into one chat line (up to MaxMessageLength) when bMergeOutgoingChat is set.
+ *
+ * Game thread only; Send never blocks. Needs bEnableSendChat, which adds user:write:chat to the
+ * scopes the device flow asks for.
+ */
+class TWITCHCHAT_API FTwitchChatOutbox : public TSharedFromThis<FTwitchChatOutbox>
+{
+public:
+    // bSent is false when Twitch dropped the message or the request failed; Reason says why
+    using FOnSent = TFunction<void(bool bSent, const FString& Reason)>;
+
+    static TSharedRef<FTwitchChatOutbox> Get();
+
+    static constexpr int32 MaxMessageLength = 500;
+    static constexpr int32 MaxQueued = 500;
+    static constexpr double WindowSeconds = 30.0;
+
+    // False when refused outright (disabled, empty, too long or queue full); OnSent is not called then
+    bool Send(const FString& Channel, const FString& Text, const FString& ReplyParentMessageId = FString(), FOnSent OnSent = nullptr);
+
+    // Channels where the bot may use the moderator/VIP budget, on top of ElevatedChatChannels in
+    // settings; the broadcaster's own channel always does
+    void SetElevated(const FString& Channel, bool bElevated);
+    bool IsElevated(const FString& Channel) const;
+
+    // Waiting plus sent but not yet answered
+    int32 GetQueueDepth() const { return Queue.Num() + InFlight; }
+
+    struct FBudgetStatus
+    {
+        int32 Limit = 0;
+        double Tokens = 0.0;
+    };
+    FBudgetStatus GetBudgetStatus(bool bElevated) const;
+
+    // Drops everything still waiting; their OnSent reports "cleared"
+    void Clear();
+
+    // Removes the ticker; called by the module before the core ticker goes away
+    void Shutdown();
+
+private:
+    struct FOutgoing
+    {
+        FString Channel;            // lower case
+        FString BroadcasterId;      // empty until resolved
+        FString Text;
+        FString ReplyParentMessageId;
+        TArray<double> QueuedTimes; // one per merged message
+        TArray<FOnSent> OnSent;
+        bool bResolving = false;
+    };
+
+    // A full burst plus one window of refill stays within the limit, however the sends fall
+    struct FBucket
+    {
+        int32 Limit = 0;
+        double Tokens = 0.0;
+        double LastRefill = 0.0;
+
+        void Configure(int32 InLimit);
+        void Refill(double Now);
+    };
+
+    bool Tick(float DeltaTime);
+    void EnsureTicker();
+    void Resolve(const FString& Channel);
+    void MergeFollowing(int32 Index);
+    void Deliver(FOutgoing&& Msg);
+    void Complete(FOutgoing& Msg, bool bSent, const FString& Reason);
+    FBucket& GetBucket(const FOutgoing& Msg);
+
+    TArray<FOutgoing> Queue;
+    FBucket Buckets[2];         // regular, elevated
+    TSet<FString> Elevated;
+    int32 InFlight = 0;
+    bool bWaitingForAuth = false;
+    FTSTicker::FDelegateHandle TickHandle;
+};
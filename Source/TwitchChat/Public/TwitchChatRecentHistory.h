@@ -0,0 +1,70 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+#include "TwitchChatMessage.h"
+
+/**
+ * The last RecentHistorySize dispatched messages, kept in memory so a component or window
+ * created mid-show can show what it missed instead of starting empty.
+ *
+ * Read-copy-update: the game thread appends by publishing a new immutable snapshot (a list of
+ * shared 64-message chunks, so an append copies a handful of pointers, not messages) with one
+ * atomic store. Readers on any thread take no lock and never block the writer; they announce
+ * themselves in one of two epoch counters, and a replaced snapshot is freed only once every
+ * reader that could have seen it has left.
+ */
+class TWITCHCHAT_API FTwitchChatRecentHistory
+{
+public:
+    static FTwitchChatRecentHistory& Get();
+
+    ~FTwitchChatRecentHistory();
+
+    // Game thread; called for every dispatched message
+    void Append(const FTwitchChatMessage& Msg);
+    void Clear();
+
+    // Any thread. Up to MaxMessages of the newest messages, oldest first. Channel matches the
+    // channel login or id, User the user id or name (case-insensitive); empty matches all.
+    TArray<FTwitchChatMessage> GetRecent(int32 MaxMessages, const FString& Channel = FString(), const FString& User = FString()) const;
+
+    int32 Num() const;
+
+    // Game thread; includes replaced snapshots still waiting for readers
+    SIZE_T GetAllocatedSize() const;
+
+private:
+    static constexpr int32 ChunkSize = 64;
+
+    struct FChunk
+    {
+        FTwitchChatMessage Messages[ChunkSize];
+    };
+
+    // Messages [First, First + Count) across Chunks. Chunk references are only touched on the
+    // game thread (readers follow the raw pointers), so they need no atomic counting.
+    struct FSnapshot
+    {
+        TArray<TSharedPtr<FChunk, ESPMode::NotThreadSafe>> Chunks;
+        int32 First = 0;
+        int32 Count = 0;
+    };
+
+    // Reader side of the grace period; returns the epoch entered
+    uint32 EnterRead() const;
+    void ExitRead(uint32 ReadEpoch) const;
+
+    void Publish(FSnapshot* Snapshot);
+    void Reclaim();
+
+    std::atomic<FSnapshot*> Current{ nullptr };
+    std::atomic<uint32> Epoch{ 0 };
+    mutable std::atomic<int32> Readers[2] = {};
+
+    // Game thread: replaced snapshots not yet handed to a grace period, and the batch waiting
+    // for Readers[DrainingParity] to reach zero
+    TArray<FSnapshot*> Retiring;
+    TArray<FSnapshot*> Draining;
+    uint32 DrainingParity = 0;
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+class FTwitchChatConnection;
+
+/**
+ * Feeds a .tcrec recording back through FTwitchChatConnection::IngestFrame without any
+ * network. Speed scales the recorded inter-frame gaps; Speed <= 0 replays as fast as
+ * the pipeline accepts frames.
+ */
+class TWITCHCHAT_API FTwitchChatReplaySource : public TSharedFromThis<FTwitchChatReplaySource>
+{
+public:
+    struct FFrame
+    {
+        double  Seconds = 0.0;   // since the first frame
+        FString Payload;
+    };
+
+    struct FStats
+    {
+        int32  Frames = 0;
+        double WallSeconds = 0.0;
+        double RecordedSeconds = 0.0;
+    };
+
+    DECLARE_DELEGATE_OneParam(FOnFinished, const FStats&);
+
+    static bool LoadFile(const FString& Path, TArray<FFrame>& OutFrames, FDateTime* OutStartUtc = nullptr);
+
+    FTwitchChatReplaySource(TSharedRef<FTwitchChatConnection> InConnection, TArray<FFrame>&& InFrames);
+
+    void Start(float InSpeed);
+    void Stop();
+    bool IsRunning() const { return bRunning; }
+
+    // Fired on the game thread when the last frame has been fed or Stop was called.
+    FOnFinished OnFinished;
+
+    // Maximum frames waiting in the parse stage before a max-speed replay backs off.
+    int32 MaxInFlight = 256;
+
+private:
+    TSharedRef<FTwitchChatConnection> Connection;
+    TArray<FFrame> Frames;
+    std::atomic<bool> bRunning{ false };
+    std::atomic<bool> bStopRequested{ false };
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "TwitchChatMessage.h"
+
+/**
+ * Incremental inverted index over received chat. Messages are tokenized on arrival
+ * (lower-cased words, "emote:<id>", "from:<user>" and "in:<channel>") and kept beyond the editor
+ * window's MaxMessages, up to SearchIndexMaxMessages. Search is safe to run from any
+ * thread; all terms in a query must match.
+ */
+class TWITCHCHAT_API FTwitchChatSearchIndex
+{
+public:
+    struct FResult
+    {
+        TArray<TSharedPtr<FTwitchChatMessage>> Messages;   // newest first
+        int32 TotalMatches = 0;
+        double Seconds = 0.0;
+    };
+
+    static TSharedRef<FTwitchChatSearchIndex> Get();
+
+    explicit FTwitchChatSearchIndex(int32 InMaxMessages);
+
+    void Add(const FTwitchChatMessage& Msg);
+    void Reset();
+
+    FResult Search(const FString& Query, int32 MaxResults = 500) const;
+
+    int32 Num() const;
+
+    // Documents, postings and their keys; approximate.
+    SIZE_T GetAllocatedSize() const;
+
+    static void Tokenize(const FString& Text, TArray<FString>& OutTokens);
+
+private:
+    using FPostings = TArray<uint32>;
+
+    void Compact();
+
+    mutable FRWLock Lock;
+    TMap<FString, FPostings> Postings;
+    TArray<TSharedPtr<FTwitchChatMessage>> Docs;
+    uint32 FirstDocId = 0;
+    uint32 NextDocId = 0;
+    int32 MaxMessages = 0;
+};
@@ -3,8 +3,15 @@
 #include "CoreMinimal.h"
 #include "Engine/DeveloperSettings.h"
 #include "Engine/DataTable.h"
+#include "TwitchChatEvents.h"
 #include "TwitchChatSettings.generated.h"
 
+UENUM()
+enum class ETwitchChatHistoryCompression : uint8
+{
+    Zlib,
+    Oodle
+};
 
 UCLASS(config = EditorPerProjectUserSettings, defaultconfig, meta = (DisplayName = "Twitch Chat"))
 class TWITCHCHAT_API UTwitchChatSettings : public UDeveloperSettings
@@ -15,7 +22,8 @@ public:
     UTwitchChatSettings();
 
  
-    UPROPERTY(EditAnywhere, Config, Category = "Settings", meta = (DisplayName = "Channel"))
+    // One or more channels, comma separated; all share a single EventSub session
+    UPROPERTY(EditAnywhere, Config, Category = "Settings", meta = (DisplayName = "Channels"))
     FString LastChannel;
 
     UPROPERTY(EditAnywhere, Config, Category = "Settings", meta = (DisplayName = "Username"))
@@ -37,12 +45,85 @@ public:
     UPROPERTY(EditAnywhere, Config, Category = "Settings", meta = (DisplayName = "Keepalive Timeout Seconds", ClampMin = "10", ClampMax = "600"))
     int32 KeepaliveTimeoutSeconds = 30;
 
-    UPROPERTY(EditAnywhere, Config, Category = "Settings", meta = (DisplayName = "Port", ClampMin = "1", ClampMax = "65535"))
-    int32 Port = 6667;
+    UPROPERTY(EditAnywhere, Config, Category = "Settings", AdvancedDisplay, meta = (DisplayName = "Auto Reconnect"))
+    bool bAutoReconnect = true;
+
+    // Retry n waits Base * 2^n seconds (capped at Max), with jitter; the first retry is almost immediate
+    UPROPERTY(EditAnywhere, Config, Category = "Settings", AdvancedDisplay, meta = (DisplayName = "Reconnect Base Delay Seconds", ClampMin = "0.05", ClampMax = "30", EditCondition = "bAutoReconnect"))
+    float ReconnectBaseDelaySeconds = 0.5f;
+
+    UPROPERTY(EditAnywhere, Config, Category = "Settings", AdvancedDisplay, meta = (DisplayName = "Reconnect Max Delay Seconds", ClampMin = "1", ClampMax = "600", EditCondition = "bAutoReconnect"))
+    float ReconnectMaxDelaySeconds = 30.f;
+
+    // Distinct chatters whose name, color and badges are kept for reuse across their messages
+    UPROPERTY(EditAnywhere, Config, Category = "Settings", AdvancedDisplay, meta = (DisplayName = "Chatter Cache Size", ClampMin = "0", ClampMax = "1000000"))
+    int32 ChatterCacheSize = 20000;
 
-    UPROPERTY(Config)
+    // Read chat notifications token by token with per-frame scratch memory instead of building a JSON
+    // object tree; other frames always go through the tree
+    UPROPERTY(EditAnywhere, Config, Category = "Settings", AdvancedDisplay, meta = (DisplayName = "Arena Message Parse"))
+    bool bArenaMessageParse = true;
+
+    // Spread chat over several WebSocket shards of an EventSub conduit, each parsed on its own thread.
+    // Needs the Client Secret (conduits use an app access token) and the user:bot scope on the token.
+    UPROPERTY(EditAnywhere, Config, Category = "Conduit", AdvancedDisplay, meta = (DisplayName = "Use Conduit"))
+    bool bUseConduit = false;
+
+    UPROPERTY(EditAnywhere, Config, Category = "Conduit", AdvancedDisplay, meta = (DisplayName = "Shard Count", ClampMin = "1", ClampMax = "64", EditCondition = "bUseConduit"))
+    int32 ConduitShardCount = 4;
+
+    // With both on, chat is received over EventSub and IRC at once; the first copy of each message
+    // wins and the other is dropped (see twitchchat.hedge for which path is faster).
+    UPROPERTY(EditAnywhere, Config, Category = "Transport", meta = (DisplayName = "Use EventSub"))
     bool bUseEventSub = true;
 
+    // Read-only anonymous IRC (TMI) on a plain TCP socket; needs no token scopes
+    UPROPERTY(EditAnywhere, Config, Category = "Transport", meta = (DisplayName = "Use IRC"))
+    bool bUseIrc = false;
+
+    UPROPERTY(EditAnywhere, Config, Category = "Transport", meta = (DisplayName = "IRC Port", ClampMin = "1", ClampMax = "65535", EditCondition = "bUseIrc"))
+    int32 Port = 6667;
+
+    // EventSub events subscribed for every channel next to chat; see FTwitchChatEvents and the
+    // component's event delegates. Most need the broadcaster's token (scopes listed per type).
+    UPROPERTY(EditAnywhere, Config, Category = "Events", meta = (DisplayName = "Subscribed Events"))
+    TArray<ETwitchChatEventType> Events;
+
+    // Lets the plugin post chat (FTwitchChatOutbox, TwitchChat_SendChatMessage); the device flow then also asks for user:write:chat
+    UPROPERTY(EditAnywhere, Config, Category = "Outgoing Chat", meta = (DisplayName = "Enable Sending Chat"))
+    bool bEnableSendChat = false;
+
+    // Channels where the bot is moderator or VIP and may use the higher send budget; its own channel always does
+    UPROPERTY(EditAnywhere, Config, Category = "Outgoing Chat", meta = (DisplayName = "Moderator/VIP Channels", EditCondition = "bEnableSendChat"))
+    TArray<FString> ElevatedChatChannels;
+
+    // Messages waiting for send budget are joined into one line per channel
+    UPROPERTY(EditAnywhere, Config, Category = "Outgoing Chat", meta = (DisplayName = "Merge Queued Messages", EditCondition = "bEnableSendChat"))
+    bool bMergeOutgoingChat = true;
+
+    // Twitch allows 20 messages per 30 s, 100 where the bot is broadcaster, moderator or VIP (more for verified bots)
+    UPROPERTY(EditAnywhere, Config, Category = "Outgoing Chat", AdvancedDisplay, meta = (DisplayName = "Send Limit per 30 s", ClampMin = "2", EditCondition = "bEnableSendChat"))
+    int32 ChatSendLimit = 20;
+
+    UPROPERTY(EditAnywhere, Config, Category = "Outgoing Chat", AdvancedDisplay, meta = (DisplayName = "Moderator/VIP Send Limit per 30 s", ClampMin = "2", EditCondition = "bEnableSendChat"))
+    int32 ElevatedChatSendLimit = 100;
+
+    // Base URLs, overridable to point the plugin at a local emulator or proxy
+    UPROPERTY(EditAnywhere, Config, Category = "Endpoints", AdvancedDisplay, meta = (DisplayName = "Auth Base URL"))
+    FString AuthBaseUrl = TEXT("https://id.twitch.tv");
+
+    UPROPERTY(EditAnywhere, Config, Category = "Endpoints", AdvancedDisplay, meta = (DisplayName = "Helix Base URL"))
+    FString HelixBaseUrl = TEXT("https://api.twitch.tv/helix");
+
+    UPROPERTY(EditAnywhere, Config, Category = "Endpoints", AdvancedDisplay, meta = (DisplayName = "EventSub WebSocket URL"))
+    FString EventSubUrl = TEXT("wss://eventsub.wss.twitch.tv/ws");
+
+    UPROPERTY(EditAnywhere, Config, Category = "Endpoints", AdvancedDisplay, meta = (DisplayName = "IRC Host"))
+    FString IrcHost = TEXT("irc.chat.twitch.tv");
+
+    UPROPERTY(EditAnywhere, Config, Category = "Endpoints", AdvancedDisplay, meta = (DisplayName = "Emote CDN Base URL"))
+    FString EmoteCdnBaseUrl = TEXT("https://static-cdn.jtvnw.net");
+
     UPROPERTY(EditAnywhere, Config, Category = "Emotes", meta = (DisplayName = "Auto Download Emotes"))
     bool AutoDownloadEmotes = true;
 
@@ -60,4 +141,78 @@ public:
 
     UPROPERTY(EditAnywhere, Config, Category = "Editor Window", meta = (DisplayName = "Max Messages", ClampMin = "0"))
     int32 MaxMessages = 20;
+
+    UPROPERTY(EditAnywhere, Config, Category = "Editor Window", meta = (DisplayName = "Enable Search Index"))
+    bool bEnableSearchIndex = true;
+
+    UPROPERTY(EditAnywhere, Config, Category = "Editor Window", meta = (DisplayName = "Search Index Max Messages", ClampMin = "1000", EditCondition = "bEnableSearchIndex"))
+    int32 SearchIndexMaxMessages = 500000;
+
+    // Badges and profile pictures before each name, drawn from a shared atlas
+    UPROPERTY(EditAnywhere, Config, Category = "Editor Window", meta = (DisplayName = "Show Badges and Avatars"))
+    bool bShowChatterImages = true;
+
+    // Pages of 1024x1024 (196 images each) before the least recently drawn image is evicted
+    UPROPERTY(EditAnywhere, Config, Category = "Editor Window", AdvancedDisplay, meta = (DisplayName = "Image Atlas Pages", ClampMin = "1", ClampMax = "16"))
+    int32 ChatterImageAtlasPages = 2;
+
+    UPROPERTY(EditAnywhere, Config, Category = "History", meta = (DisplayName = "Enable History Log"))
+    bool bEnableHistoryLog = false;
+
+    // Empty means Saved/TwitchChatHistory
+    UPROPERTY(EditAnywhere, Config, Category = "History", meta = (DisplayName = "History Directory", EditCondition = "bEnableHistoryLog"))
+    FString HistoryDirectory;
+
+    UPROPERTY(EditAnywhere, Config, Category = "History", meta = (DisplayName = "Compression", EditCondition = "bEnableHistoryLog"))
+    ETwitchChatHistoryCompression HistoryCompression = ETwitchChatHistoryCompression::Zlib;
+
+    UPROPERTY(EditAnywhere, Config, Category = "History", meta = (DisplayName = "Block Size (KB)", ClampMin = "4", ClampMax = "4096", EditCondition = "bEnableHistoryLog"))
+    int32 HistoryBlockSizeKB = 64;
+
+    UPROPERTY(EditAnywhere, Config, Category = "History", meta = (DisplayName = "Segment Size (MB)", ClampMin = "1", ClampMax = "4096", EditCondition = "bEnableHistoryLog"))
+    int32 HistorySegmentSizeMB = 64;
+
+    UPROPERTY(EditAnywhere, Config, Category = "History", meta = (DisplayName = "Flush Interval Seconds", ClampMin = "0.1", ClampMax = "60", EditCondition = "bEnableHistoryLog"))
+    float HistoryFlushIntervalSeconds = 2.0f;
+
+    // Newest messages kept in memory for components and windows created mid-stream; 0 keeps none
+    UPROPERTY(EditAnywhere, Config, Category = "History", meta = (DisplayName = "Recent Messages Kept", ClampMin = "0", ClampMax = "100000"))
+    int32 RecentHistorySize = 500;
+
+    // Serves Prometheus text on http://<host>:<port>/metrics; takes effect on the next start (or `twitchchat.metrics start`)
+    UPROPERTY(EditAnywhere, Config, Category = "Metrics", meta = (DisplayName = "Enable Metrics Endpoint"))
+    bool bEnableMetricsEndpoint = false;
+
+    UPROPERTY(EditAnywhere, Config, Category = "Metrics", meta = (DisplayName = "Metrics Port", ClampMin = "1", ClampMax = "65535", EditCondition = "bEnableMetricsEndpoint"))
+    int32 MetricsPort = 9464;
+
+    // Endpoints and tokens standing in for the configured ones while set, e.g. by the local emulator.
+    // Runtime only; SaveConfig never sees them, so the configured values and credentials stay as they were.
+    struct FEndpointOverride
+    {
+        FString AuthBaseUrl;
+        FString HelixBaseUrl;
+        FString EventSubUrl;
+        FString EmoteCdnBaseUrl;
+        FString AccessToken;
+        FString RefreshToken;
+    };
+    void SetEndpointOverride(const FEndpointOverride& InOverride);
+    void ClearEndpointOverride();
+    bool HasEndpointOverride() const { return bEndpointOverride; }
+
+    // Read endpoints and tokens through these rather than the fields above
+    const FString& GetAuthBaseUrl() const { return bEndpointOverride ? EndpointOverride.AuthBaseUrl : AuthBaseUrl; }
+    const FString& GetHelixBaseUrl() const { return bEndpointOverride ? EndpointOverride.HelixBaseUrl : HelixBaseUrl; }
+    const FString& GetEventSubUrl() const { return bEndpointOverride ? EndpointOverride.EventSubUrl : EventSubUrl; }
+    const FString& GetEmoteCdnBaseUrl() const { return bEndpointOverride ? EndpointOverride.EmoteCdnBaseUrl : EmoteCdnBaseUrl; }
+    const FString& GetAccessToken() const { return bEndpointOverride ? EndpointOverride.AccessToken : AccessToken; }
+    const FString& GetRefreshToken() const { return bEndpointOverride ? EndpointOverride.RefreshToken : RefreshToken; }
+
+    // Keeps newly issued tokens: in the override while one is set, otherwise in config (saved)
+    void StoreTokens(const FString& InAccessToken, const FString& InRefreshToken);
+
+private:
+    FEndpointOverride EndpointOverride;
+    bool bEndpointOverride = false;
 };
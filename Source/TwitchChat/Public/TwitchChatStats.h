@@ -0,0 +1,53 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "HAL/LowLevelMemTracker.h"
+
+// `stat TwitchChat` in the editor or game
+DECLARE_STATS_GROUP(TEXT("TwitchChat"), STATGROUP_TwitchChat, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("JSON Parse"), STAT_TwitchChat_JsonParse, STATGROUP_TwitchChat, TWITCHCHAT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Emote Fetch"), STAT_TwitchChat_EmoteFetch, STATGROUP_TwitchChat, TWITCHCHAT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Emote Decode"), STAT_TwitchChat_EmoteDecode, STATGROUP_TwitchChat, TWITCHCHAT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Message Dispatch"), STAT_TwitchChat_Dispatch, STATGROUP_TwitchChat, TWITCHCHAT_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Row Generation"), STAT_TwitchChat_RowGeneration, STATGROUP_TwitchChat, TWITCHCHAT_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Messages Dispatched"), STAT_TwitchChat_Messages, STATGROUP_TwitchChat, TWITCHCHAT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Emote Disk Hits"), STAT_TwitchChat_EmoteDiskHits, STATGROUP_TwitchChat, TWITCHCHAT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Emote Disk Misses"), STAT_TwitchChat_EmoteDiskMisses, STATGROUP_TwitchChat, TWITCHCHAT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Emote Brush Hits"), STAT_TwitchChat_EmoteBrushHits, STATGROUP_TwitchChat, TWITCHCHAT_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Emote Brush Misses"), STAT_TwitchChat_EmoteBrushMisses, STATGROUP_TwitchChat, TWITCHCHAT_API);
+
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Frames In Flight"), STAT_TwitchChat_FramesInFlight, STATGROUP_TwitchChat, TWITCHCHAT_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("History Queue"), STAT_TwitchChat_HistoryQueue, STATGROUP_TwitchChat, TWITCHCHAT_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Window Messages"), STAT_TwitchChat_WindowMessages, STATGROUP_TwitchChat, TWITCHCHAT_API);
+
+// LLM tags (-llm); see also twitchchat.memreport
+LLM_DECLARE_TAG_API(TwitchChat, TWITCHCHAT_API);
+LLM_DECLARE_TAG_API(TwitchChat_Messages, TWITCHCHAT_API);
+LLM_DECLARE_TAG_API(TwitchChat_EmoteCache, TWITCHCHAT_API);
+LLM_DECLARE_TAG_API(TwitchChat_EmoteTextures, TWITCHCHAT_API);
+
+// Insights: run with -trace=default,twitchchat
+UE_TRACE_CHANNEL_EXTERN(TwitchChatChannel, TWITCHCHAT_API);
+
+#define TWITCHCHAT_TRACE_SCOPE(Name) TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL_STR(Name, TwitchChatChannel)
+
+enum class ETwitchChatTraceStage : uint8
+{
+    Received,
+    Parsed,
+    Dispatched,
+};
+
+namespace TwitchChatTrace
+{
+    // Process-local sequence number so the stages of one message can be correlated.
+    TWITCHCHAT_API uint32 NextMessageSerial();
+
+    // Emits a TwitchChat.MessageStage event (serial, stage, cycle) when the channel is enabled.
+    TWITCHCHAT_API void MessageStage(uint32 Serial, ETwitchChatTraceStage Stage);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+#include "Containers/Ticker.h"
+#include "TwitchChatMessage.h"
+
+class FTwitchChatConnection;
+
+/**
+ * Connect/disconnect stress run against the local emulator. Producer threads feed chat frames
+ * into IngestFrame while the game thread flips the connection between Connect and Disconnect.
+ * At the end it checks that every result from a session either reached the game thread or was
+ * dropped as stale, that nothing arrived after the final Disconnect, and that the pipeline and
+ * the connection's executor drained to empty. The verdict is logged as PASS or FAIL.
+ */
+class TWITCHCHAT_API FTwitchChatStress : public TSharedFromThis<FTwitchChatStress>
+{
+public:
+    struct FOptions
+    {
+        float   Seconds = 10.f;
+        int32   Threads = 4;
+        float   Rate = 2000.f;          // messages/s per producer thread, 0 = as fast as accepted
+        float   ToggleSeconds = 0.25f;  // between Connect and Disconnect
+        int32   MaxInFlight = 1024;
+
+        // key=value arguments: seconds=10 threads=4 rate=2000 toggle=0.25 inflight=1024
+        static FOptions FromArgs(const TArray<FString>& Args);
+    };
+
+    static TSharedPtr<FTwitchChatStress> GetActive();
+    static TSharedPtr<FTwitchChatStress> StartActive(const FOptions& InOptions);
+
+    FTwitchChatStress(TSharedRef<FTwitchChatConnection> InConnection, const FOptions& InOptions);
+    ~FTwitchChatStress();
+
+    bool Start();
+    void Cancel() { bCancelled = true; }
+    bool IsRunning() const { return bRunning; }
+    bool Passed() const { return bPassed; }
+
+    bool Tick(float DeltaTime);
+
+private:
+    void HandleMessage(const FTwitchChatMessage& Msg);
+    void Toggle();
+    void Finish();
+
+    TSharedRef<FTwitchChatConnection> Connection;
+    FOptions Options;
+
+    FTSTicker::FDelegateHandle TickHandle;
+    FDelegateHandle MessageHandle;
+
+    std::atomic<bool>  bCancelled{ false };
+    std::atomic<bool>  bStopProducers{ false };
+    std::atomic<int32> ProducersRunning{ 0 };
+    std::atomic<int64> Injected{ 0 };
+
+    bool   bRunning = false;
+    bool   bPassed = false;
+    bool   bStartedEmulator = false;
+    bool   bFinalDisconnect = false;
+    bool   bOffTheGameThread = false;
+    double StartTime = 0.0;
+    double NextToggle = 0.0;
+    double DrainStart = 0.0;
+    int32  Toggles = 0;
+    int64  Delivered = 0;
+    int64  DeliveredAfterDisconnect = 0;
+    int64  StaleAtStart = 0;
+};
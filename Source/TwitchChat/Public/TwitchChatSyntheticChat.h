@@ -0,0 +1,75 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+
+/**
+ * Builds EventSub frames (welcome, keepalive, reconnect, channel.chat.message) for
+ * offline testing. The chat mix is configurable so emote-heavy, long-text and
+ * reply-heavy traffic can be generated deterministically from a seed.
+ */
+class TWITCHCHAT_API FTwitchChatSyntheticChat
+{
+public:
+    struct FConfig
+    {
+        int32 NumChatters = 2000;
+        int32 MinWords = 2;
+        int32 MaxWords = 14;
+        float EmoteRatio = 0.3f;    // chance a word is an emote
+        float ReplyRatio = 0.05f;   // chance a message replies to an earlier one
+        int32 Seed = 1337;
+
+        static FConfig EmoteHeavy();
+        static FConfig LongText();
+        static FConfig ReplyHeavy();
+        static bool FromName(const FString& Name, FConfig& Out);
+    };
+
+    struct FChannel
+    {
+        FString BroadcasterId = TEXT("1000");
+        FString BroadcasterLogin = TEXT("emulated");
+    };
+
+    explicit FTwitchChatSyntheticChat(const FConfig& InConfig = FConfig());
+
+    const FConfig& GetConfig() const { return Config; }
+
+    // A channel.chat.message notification from a random chatter.
+    FString NextChatMessage(const FString& SessionId, const FChannel& Channel);
+
+    // A channel.chat.message notification with fixed author and text.
+    FString MakeChatMessage(const FString& SessionId, const FChannel& Channel,
+        const FString& UserId, const FString& UserLogin, const FString& Text);
+
+    static FString MakeWelcome(const FString& SessionId, int32 KeepaliveSeconds, const FString& ReconnectUrl = FString());
+    static FString MakeKeepalive();
+    static FString MakeReconnect(const FString& SessionId, const FString& ReconnectUrl);
+
+    static FString EscapeJson(const FString& In);
+
+private:
+    struct FFragment
+    {
+        FString Text;
+        FString EmoteId;   // empty for plain text
+    };
+
+    struct FParent
+    {
+        FString MessageId;
+        FString UserId;
+        FString UserLogin;
+        FString Body;
+    };
+
+    FString BuildNotification(const FString& SessionId, const FChannel& Channel,
+        const FString& UserId, const FString& UserLogin, const FString& Color,
+        const TArray<FFragment>& Fragments, const FParent* Parent);
+
+    FConfig Config;
+    FRandomStream Random;
+    TArray<FParent> RecentMessages;
+    int32 NextRecent = 0;
+};
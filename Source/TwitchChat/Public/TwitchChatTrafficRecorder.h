@@ -0,0 +1,42 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FArchive;
+
+/**
+ * Writes raw EventSub frames with their receive time to a compact file (.tcrec).
+ *
+ * Layout: uint32 magic, int32 version, int64 UTC ticks of the first frame, then per
+ * frame a packed microsecond delta since the previous frame, a packed byte length
+ * and the UTF-8 payload.
+ */
+class TWITCHCHAT_API FTwitchChatTrafficRecorder
+{
+public:
+    static const uint32 FileMagic = 0x46524354; // "TCRF"
+    static const int32  FileVersion = 1;
+
+    static FString MakeDefaultPath();
+
+    ~FTwitchChatTrafficRecorder();
+
+    bool Open(const FString& InPath);
+    void Close();
+    bool IsOpen() const { return Writer.IsValid(); }
+    const FString& GetPath() const { return Path; }
+    int64 GetNumFrames() const { return NumFrames; }
+
+    // Cycles is the FPlatformTime::Cycles64() value taken when the frame came off the socket.
+    void Record(const FString& Frame, uint64 Cycles);
+
+private:
+    void FlushBuffer();
+
+    FCriticalSection Mutex;
+    TUniquePtr<FArchive> Writer;
+    TArray<uint8> Buffer;
+    FString Path;
+    uint64 LastCycles = 0;
+    int64 NumFrames = 0;
+};
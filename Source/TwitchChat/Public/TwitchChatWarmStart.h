@@ -0,0 +1,46 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * What earlier runs learned about the session, kept in Saved/TwitchChatWarmStart.json so the
+ * next Connect can start the socket without waiting on Helix and token round trips: the token's
+ * owner, scopes and expiry (keyed by a hash of the token, never the token itself) and the
+ * login -> user id map for the bot and every channel joined so far.
+ *
+ * Game thread only. Loaded on first use, written whenever something changes.
+ */
+class TWITCHCHAT_API FTwitchChatWarmStart
+{
+public:
+    static FTwitchChatWarmStart& Get();
+
+    struct FToken
+    {
+        FString Login;
+        FString UserId;
+        TArray<FString> Scopes;
+        FDateTime ExpiresUtc;       // ticks 0 when the token does not expire
+        FDateTime ValidatedUtc;
+    };
+
+    // False when nothing was saved for this token
+    bool FindToken(const FString& AccessToken, FToken& OutToken);
+    void StoreToken(const FString& AccessToken, const FToken& InToken);
+
+    const TMap<FString, FString>& GetUserIds();
+    void StoreUserId(const FString& Login, const FString& Id);
+
+    void Clear();
+    static FString GetPath();
+
+private:
+    void Load();
+    void Save() const;
+    static FString HashToken(const FString& AccessToken);
+
+    bool bLoaded = false;
+    FString TokenHash;
+    FToken Token;
+    TMap<FString, FString> UserIds;     // lower-case login -> id
+};
@@ -9,6 +9,8 @@
 #include "Widgets/Views/SListView.h"
 #include "Widgets/Text/STextBlock.h"
 #include "Widgets/Input/SButton.h"
+#include "Widgets/Input/SSearchBox.h"
+#include "Widgets/Input/SComboBox.h"
 #include "Widgets/Images/SImage.h"
 #include "Widgets/Layout/SBorder.h"
 #include "Widgets/Layout/SBox.h"
@@ -20,6 +22,7 @@
 #include "TwitchChatMessage.h"
 #include "TwitchChatConnection.h"
 #include "TwitchChatSettings.h"
+#include "TwitchChatMemory.h"
 #include "EmoteInfo.h"
 
 class STwitchChatWindow : public SCompoundWidget
@@ -40,11 +43,29 @@ private:
     TSharedPtr<SButton>                                  ConnectButton;
     TSharedPtr<SButton>                                  DisconnectButton;
     TSharedPtr<SButton>                                  ClearButton;
+    TSharedPtr<SButton>                                  DiagnosticsButton;
+    TSharedPtr<SSearchBox>                               SearchBox;
+    TSharedPtr<SComboBox<TSharedPtr<FString>>>           ChannelFilterCombo;
     TSharedPtr<SListView<TSharedPtr<FTwitchChatMessage>>> ListView;
 
     // Data
     TArray<TSharedPtr<FTwitchChatMessage>> Messages;
     FDelegateHandle                 MessageHandle;
+    FDelegateHandle                 MemoryHandle;
+    FDelegateHandle                 ImagesHandle;
+
+    // Channel filter; empty shows every channel. FilteredMessages shares items with Messages.
+    FString                                ChannelFilter;
+    TArray<TSharedPtr<FTwitchChatMessage>> FilteredMessages;
+    TArray<TSharedPtr<FString>>            ChannelOptions;     // first entry is "all channels"
+
+    // Search
+    FString                                SearchQuery;
+    TArray<TSharedPtr<FTwitchChatMessage>> SearchResults;
+    FText                                  SearchStatus;
+    uint32                                 SearchSerial = 0;
+    bool                                   bSearchInFlight = false;
+    bool                                   bSearchDirty = false;
 
     // Animation‐timer handle
     TSharedPtr<FActiveTimerHandle> AnimationTimerHandle;
@@ -52,6 +73,9 @@ private:
     // Emote brushes
     TMap<FString, TSharedPtr<FSlateBrush>> EmoteBrushes;
 
+    // Set when badges or avatars arrived; rows are rebuilt once on the next animation tick
+    bool bChatterImagesDirty = false;
+
     // Cached width for wrapping
     float ChatPanelWidth = 0.f;
 
@@ -59,12 +83,21 @@ private:
     FText       GetChannelLabel() const;
     FSlateColor GetConnectionColor() const;
     void        LoadEmoteBrushes();
+    void        CollectMemory(TArray<FTwitchChatMemory::FLine>& Out) const;
+    TArray<TSharedPtr<FTwitchChatMessage>>& GetLiveMessages() { return ChannelFilter.IsEmpty() ? Messages : FilteredMessages; }
+    bool        PassesChannelFilter(const FTwitchChatMessage& Msg) const;
+    void        RefreshChannelOptions();
+    void        OnChannelFilterChanged(TSharedPtr<FString> Selected, ESelectInfo::Type SelectInfo);
+    void        ShowLiveMessages();
 
     FReply OnSetChannelClicked();
     void   OnConnectClicked();
     void   OnDisconnectClicked();
     void   OnClearClicked();
     void   HandleIncoming(const FTwitchChatMessage& Msg);
+    void   OnSearchTextChanged(const FText& InText);
+    void   RunSearch();
+    bool   IsSearching() const { return !SearchQuery.IsEmpty(); }
 
     TSharedRef<ITableRow> OnGenerateRow(
         TSharedPtr<FTwitchChatMessage> Item,
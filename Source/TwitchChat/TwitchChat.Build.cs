@@ -21,7 +21,7 @@ public class TwitchChat : ModuleRules
         PrivateDependencyModuleNames.AddRange(new string[]
         {
             "Sockets", "Networking", "Projects", "Slate",      
-                "SlateCore"
+                "SlateCore", "HTTPServer", "WebSocketNetworking"
         });
 
         // Editor-only dependencies